@@ -0,0 +1,160 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "Backup.hpp"
+
+#include <cstdio>
+#include <thread>
+
+namespace oatpp { namespace sqlite {
+
+bool Backup::run(sqlite3* source, sqlite3* destination, const Config& config, const ProgressCallback& callback) {
+
+  auto backup = sqlite3_backup_init(destination, "main", source, "main");
+  if(!backup) {
+    throw std::runtime_error("[oatpp::sqlite::Backup::run()]: Error. Can't init backup. " + std::string(sqlite3_errmsg(destination)));
+  }
+
+  Progress progress;
+  progress.restarts = 0;
+  v_int64 lastRemaining = -1;
+
+  while(true) {
+
+    auto res = sqlite3_backup_step(backup, config.pagesPerStep);
+
+    progress.remainingPages = sqlite3_backup_remaining(backup);
+    progress.totalPages = sqlite3_backup_pagecount(backup);
+
+    if(res == SQLITE_DONE) {
+      if(callback) {
+        callback(progress);
+      }
+      break;
+    }
+
+    if(res != SQLITE_OK && res != SQLITE_BUSY && res != SQLITE_LOCKED) {
+      sqlite3_backup_finish(backup);
+      throw std::runtime_error("[oatpp::sqlite::Backup::run()]: Error. Backup step failed. " + std::string(sqlite3_errstr(res)));
+    }
+
+    /* a successful step always copies pages - if remaining pages didn't decrease the copy was restarted */
+    if(res == SQLITE_OK && lastRemaining >= 0 && progress.remainingPages >= lastRemaining) {
+      progress.restarts ++;
+      if(progress.restarts > config.maxRestarts) {
+        sqlite3_backup_finish(backup);
+        throw std::runtime_error("[oatpp::sqlite::Backup::run()]: Error. Too many restarts - source is modified too often.");
+      }
+    }
+    lastRemaining = progress.remainingPages;
+
+    if(callback && !callback(progress)) {
+      sqlite3_backup_finish(backup);
+      return false;
+    }
+
+    if(config.stepInterval.count() > 0) {
+      std::this_thread::sleep_for(config.stepInterval);
+    }
+
+  }
+
+  auto res = sqlite3_backup_finish(backup);
+  if(res != SQLITE_OK) {
+    throw std::runtime_error("[oatpp::sqlite::Backup::run()]: Error. Can't finish backup. " + std::string(sqlite3_errmsg(destination)));
+  }
+
+  return true;
+
+}
+
+bool Backup::copy(const provider::ResourceHandle<orm::Connection>& source,
+                  const provider::ResourceHandle<orm::Connection>& destination,
+                  const Config& config,
+                  const ProgressCallback& callback)
+{
+  if(!source || !destination) {
+    throw std::runtime_error("[oatpp::sqlite::Backup::copy()]: Error. Connection is null.");
+  }
+  auto src = std::static_pointer_cast<Connection>(source.object);
+  auto dst = std::static_pointer_cast<Connection>(destination.object);
+  return run(src->getHandle(), dst->getHandle(), config, callback);
+}
+
+bool Backup::copyToFile(const provider::ResourceHandle<orm::Connection>& source,
+                        const oatpp::String& path,
+                        const Config& config,
+                        const ProgressCallback& callback)
+{
+
+  if(!source) {
+    throw std::runtime_error("[oatpp::sqlite::Backup::copyToFile()]: Error. Connection is null.");
+  }
+
+  if(!path) {
+    throw std::runtime_error("[oatpp::sqlite::Backup::copyToFile()]: Error. Path is null.");
+  }
+
+  auto src = std::static_pointer_cast<Connection>(source.object);
+  std::string tmpPath = *path + ".tmp";
+  std::remove(tmpPath.c_str());
+
+  sqlite3* destination = nullptr;
+  auto res = sqlite3_open(tmpPath.c_str(), &destination);
+  if(res != SQLITE_OK) {
+    std::string errMsg = sqlite3_errmsg(destination);
+    sqlite3_close(destination);
+    throw std::runtime_error("[oatpp::sqlite::Backup::copyToFile()]: Error. Can't open destination file. " + errMsg);
+  }
+
+  bool complete;
+  try {
+    complete = run(src->getHandle(), destination, config, callback);
+  } catch (...) {
+    sqlite3_close(destination);
+    std::remove(tmpPath.c_str());
+    throw;
+  }
+
+  sqlite3_close(destination);
+
+  if(!complete) {
+    std::remove(tmpPath.c_str());
+    return false;
+  }
+
+  if(std::rename(tmpPath.c_str(), path->c_str()) != 0) {
+    std::remove(tmpPath.c_str());
+    throw std::runtime_error("[oatpp::sqlite::Backup::copyToFile()]: Error. Can't rename '" + tmpPath + "' to '" + *path + "'.");
+  }
+
+  return true;
+
+}
+
+bool Backup::copyToFile(const provider::ResourceHandle<orm::Connection>& source, const oatpp::String& path) {
+  return copyToFile(source, path, Config());
+}
+
+}}
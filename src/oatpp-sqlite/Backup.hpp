@@ -0,0 +1,143 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef oatpp_sqlite_Backup_hpp
+#define oatpp_sqlite_Backup_hpp
+
+#include "Connection.hpp"
+
+#include <chrono>
+#include <functional>
+
+namespace oatpp { namespace sqlite {
+
+/**
+ * Online backup. <br>
+ * Copies a live database with `sqlite3_backup_step` - N pages at a time, sleeping between steps,
+ * so that writers are not blocked for the duration of the whole copy. <br>
+ * If the source database is modified by another connection during the backup, SQLite restarts the copy
+ * automatically on the next step. Changes made through the source connection itself are applied to the copy
+ * without restart.
+ */
+class Backup {
+public:
+
+  /**
+   * Backup config.
+   */
+  struct Config {
+
+    /**
+     * Number of pages copied per step. Negative - copy all pages in one step.
+     */
+    v_int32 pagesPerStep = 256;
+
+    /**
+     * Sleep time between steps.
+     */
+    std::chrono::milliseconds stepInterval = std::chrono::milliseconds(10);
+
+    /**
+     * Max number of restarts caused by concurrent writes. Backup fails once exceeded.
+     */
+    v_int64 maxRestarts = 100;
+
+  };
+
+  /**
+   * Backup progress.
+   */
+  struct Progress {
+
+    /**
+     * Number of pages still to be copied.
+     */
+    v_int64 remainingPages;
+
+    /**
+     * Total number of pages in the source database.
+     */
+    v_int64 totalPages;
+
+    /**
+     * Number of times the backup was restarted because of concurrent writes.
+     */
+    v_int64 restarts;
+
+  };
+
+  /**
+   * Progress callback. Called after every step.
+   * Return `false` to cancel the backup.
+   */
+  typedef std::function<bool(const Progress& progress)> ProgressCallback;
+
+private:
+  static bool run(sqlite3* source, sqlite3* destination, const Config& config, const ProgressCallback& callback);
+public:
+
+  /**
+   * Copy `main` database of the source connection to `main` database of the destination connection.
+   * Destination may be an in-memory database.
+   * @param source - source connection.
+   * @param destination - destination connection.
+   * @param config - &l:Backup::Config;.
+   * @param callback - &l:Backup::ProgressCallback;. May be `nullptr`.
+   * @return - `true` if the backup is complete. `false` if cancelled by the callback.
+   * @throws - `std::runtime_error` on error.
+   */
+  static bool copy(const provider::ResourceHandle<orm::Connection>& source,
+                   const provider::ResourceHandle<orm::Connection>& destination,
+                   const Config& config,
+                   const ProgressCallback& callback = nullptr);
+
+  /**
+   * Copy `main` database of the source connection to a file. <br>
+   * The copy is written to a temporary file `<path>.tmp` which is renamed to `path` once the backup is complete.
+   * @param source - source connection.
+   * @param path - destination file path.
+   * @param config - &l:Backup::Config;.
+   * @param callback - &l:Backup::ProgressCallback;. May be `nullptr`.
+   * @return - `true` if the backup is complete. `false` if cancelled by the callback.
+   * @throws - `std::runtime_error` on error.
+   */
+  static bool copyToFile(const provider::ResourceHandle<orm::Connection>& source,
+                         const oatpp::String& path,
+                         const Config& config,
+                         const ProgressCallback& callback = nullptr);
+
+  /**
+   * Copy `main` database of the source connection to a file using default &l:Backup::Config;.
+   * @param source - source connection.
+   * @param path - destination file path.
+   * @return - `true` if the backup is complete.
+   * @throws - `std::runtime_error` on error.
+   */
+  static bool copyToFile(const provider::ResourceHandle<orm::Connection>& source, const oatpp::String& path);
+
+};
+
+}}
+
+#endif // oatpp_sqlite_Backup_hpp
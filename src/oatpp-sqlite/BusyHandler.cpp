@@ -0,0 +1,132 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#include "BusyHandler.hpp"
+
+#include "oatpp/Environment.hpp"
+
+#include <thread>
+
+namespace oatpp { namespace sqlite {
+
+namespace {
+
+  /* a thread waits for one lock at a time - wait state can be thread-local */
+  thread_local const char* currentQuery = nullptr;
+  thread_local v_int64 waitStart = 0;
+  thread_local v_int64 waitBackoff = 0;
+
+}
+
+BusyHandler::QueryScope::QueryScope(const char* queryName)
+  : m_previous(currentQuery)
+{
+  currentQuery = queryName;
+}
+
+BusyHandler::QueryScope::~QueryScope() {
+  currentQuery = m_previous;
+}
+
+BusyHandler::BusyHandler(const Config& config)
+  : m_config(config)
+{}
+
+BusyHandler::BusyHandler()
+  : BusyHandler(Config())
+{}
+
+void BusyHandler::install(sqlite3* handle) {
+  sqlite3_busy_handler(handle, &BusyHandler::onBusy, this);
+}
+
+int BusyHandler::onBusy(void* data, int count) {
+
+  auto handler = static_cast<BusyHandler*>(data);
+  v_int64 now = oatpp::Environment::getMicroTickCount();
+
+  /* count == 0 - first call for this lock */
+  if(count == 0) {
+    waitStart = now;
+    waitBackoff = handler->m_config.initialBackoff.count();
+  }
+
+  v_int64 waited = now - waitStart;
+  v_int64 remaining = handler->m_config.maxWait.count() - waited;
+
+  if(remaining <= 0) {
+    handler->onWait(count == 0, waited, 0, true);
+    return 0;
+  }
+
+  v_int64 sleepTime = waitBackoff;
+  if(sleepTime > remaining) {
+    sleepTime = remaining;
+  }
+
+  handler->onWait(count == 0, waited, sleepTime, false);
+
+  std::this_thread::sleep_for(std::chrono::microseconds(sleepTime));
+
+  waitBackoff = static_cast<v_int64>(waitBackoff * handler->m_config.multiplier);
+  if(waitBackoff > handler->m_config.maxBackoff.count()) {
+    waitBackoff = handler->m_config.maxBackoff.count();
+  }
+
+  return 1;
+
+}
+
+void BusyHandler::onWait(bool firstCall, v_int64 waitedTime, v_int64 sleepTime, bool timeout) {
+
+  std::lock_guard<std::mutex> lock(m_statsMutex);
+
+  auto& stats = m_stats[currentQuery ? currentQuery : "<unknown>"];
+
+  if(firstCall) {
+    stats.waitsCount ++;
+  }
+  if(timeout) {
+    stats.timeoutsCount ++;
+  }
+
+  stats.totalWaitTime += sleepTime;
+  if(waitedTime + sleepTime > stats.maxWaitTime) {
+    stats.maxWaitTime = waitedTime + sleepTime;
+  }
+
+}
+
+std::unordered_map<std::string, BusyHandler::WaitStats> BusyHandler::getStats() {
+  std::lock_guard<std::mutex> lock(m_statsMutex);
+  return m_stats;
+}
+
+void BusyHandler::resetStats() {
+  std::lock_guard<std::mutex> lock(m_statsMutex);
+  m_stats.clear();
+}
+
+}}
@@ -0,0 +1,172 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#ifndef oatpp_sqlite_BusyHandler_hpp
+#define oatpp_sqlite_BusyHandler_hpp
+
+#include "oatpp/Types.hpp"
+
+#include <sqlite3.h>
+
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+
+namespace oatpp { namespace sqlite {
+
+/**
+ * SQLite busy handler with exponential backoff and lock-wait statistics. <br>
+ * Installed on connections by &id:oatpp::sqlite::ConnectionProvider::setBusyHandler;. When a connection can't get
+ * a lock it sleeps with growing intervals until the lock is available or &l:BusyHandler::Config::maxWait; is reached -
+ * then the statement fails with `SQLITE_BUSY`. <br>
+ * Waits are attributed to the query template being executed by &id:oatpp::sqlite::Executor; on the waiting thread.
+ */
+class BusyHandler {
+public:
+
+  /**
+   * Handler config.
+   */
+  struct Config {
+
+    /**
+     * First sleep interval.
+     */
+    std::chrono::microseconds initialBackoff = std::chrono::microseconds(100);
+
+    /**
+     * Max sleep interval.
+     */
+    std::chrono::microseconds maxBackoff = std::chrono::milliseconds(20);
+
+    /**
+     * Backoff multiplier applied after each sleep.
+     */
+    v_float64 multiplier = 2.0;
+
+    /**
+     * Max total wait for a lock. Statement fails with `SQLITE_BUSY` after this time.
+     */
+    std::chrono::microseconds maxWait = std::chrono::seconds(5);
+
+  };
+
+  /**
+   * Lock-wait statistics of a query.
+   */
+  struct WaitStats {
+
+    /**
+     * Number of times the query waited for a lock.
+     */
+    v_int64 waitsCount;
+
+    /**
+     * Number of waits which reached &l:BusyHandler::Config::maxWait; - query failed with `SQLITE_BUSY`.
+     */
+    v_int64 timeoutsCount;
+
+    /**
+     * Total wait time in microseconds.
+     */
+    v_int64 totalWaitTime;
+
+    /**
+     * Max single wait time in microseconds.
+     */
+    v_int64 maxWaitTime;
+
+  };
+
+  /**
+   * Sets name of the query executed by the calling thread - waits are attributed to it.
+   * Used by &id:oatpp::sqlite::Executor;.
+   */
+  class QueryScope {
+  private:
+    const char* m_previous;
+  public:
+
+    /**
+     * Constructor.
+     * @param queryName - name of the query. Must outlive the scope.
+     */
+    QueryScope(const char* queryName);
+
+    /**
+     * Non-virtual destructor. Restores previous query name.
+     */
+    ~QueryScope();
+
+    QueryScope(const QueryScope&) = delete;
+    QueryScope& operator = (const QueryScope&) = delete;
+
+  };
+
+private:
+  static int onBusy(void* data, int count);
+private:
+  void onWait(bool firstCall, v_int64 waitedTime, v_int64 sleepTime, bool timeout);
+private:
+  Config m_config;
+  std::mutex m_statsMutex;
+  std::unordered_map<std::string, WaitStats> m_stats;
+public:
+
+  /**
+   * Constructor.
+   * @param config - &l:BusyHandler::Config;.
+   */
+  BusyHandler(const Config& config);
+
+  /**
+   * Constructor with default config.
+   */
+  BusyHandler();
+
+  /**
+   * Install handler on the connection. Replaces busy timeout and any other busy handler of the connection. <br>
+   * Handler must outlive the connection.
+   * @param handle - SQLite connection.
+   */
+  void install(sqlite3* handle);
+
+  /**
+   * Get lock-wait statistics per query name. Waits outside of &id:oatpp::sqlite::Executor; queries are
+   * reported under `"<unknown>"`.
+   * @return - map of query name to &l:BusyHandler::WaitStats;.
+   */
+  std::unordered_map<std::string, WaitStats> getStats();
+
+  /**
+   * Reset statistics.
+   */
+  void resetStats();
+
+};
+
+}}
+
+#endif // oatpp_sqlite_BusyHandler_hpp
@@ -0,0 +1,338 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "ChangeFeed.hpp"
+
+#include "oatpp/base/Log.hpp"
+
+#include <cctype>
+
+namespace oatpp { namespace sqlite {
+
+ChangeFeed::ChangeFeed()
+  : ChangeFeed(Config())
+{}
+
+ChangeFeed::ChangeFeed(const Config& config)
+  : m_config(config)
+  , m_running(true)
+  , m_sequence(0)
+  , m_subscriberIdCounter(0)
+{
+#ifndef SQLITE_ENABLE_PREUPDATE_HOOK
+  if(m_config.captureValues) {
+    OATPP_LOGw("[oatpp::sqlite::ChangeFeed::ChangeFeed()]",
+               "Warning. SQLite is built without SQLITE_ENABLE_PREUPDATE_HOOK. Values will not be captured.");
+    m_config.captureValues = false;
+  }
+#endif
+  m_thread = std::thread([this]{
+    run();
+  });
+}
+
+ChangeFeed::~ChangeFeed() {
+  stop();
+}
+
+std::string ChangeFeed::toLowerCase(const char* text) {
+  std::string result = text;
+  for(auto& c : result) {
+    c = (char) std::tolower((unsigned char) c);
+  }
+  return result;
+}
+
+void ChangeFeed::addChange(sqlite3* handle, RowChange&& change) {
+
+  std::lock_guard<std::mutex> lock(m_transactionsMutex);
+  auto& transaction = m_transactions[handle];
+
+  transaction.tables.insert(toLowerCase(change.table->c_str()));
+
+  if(transaction.overflow) {
+    return;
+  }
+
+  if((v_int64) transaction.changes.size() >= m_config.maxTransactionChanges) {
+    transaction.overflow = true;
+    transaction.changes.clear();
+    transaction.changes.shrink_to_fit();
+    return;
+  }
+
+  transaction.changes.push_back(std::move(change));
+
+}
+
+void ChangeFeed::deliver(const Batch& batch) {
+
+  std::vector<Subscriber> subscribers;
+  {
+    std::lock_guard<std::mutex> lock(m_subscribersMutex);
+    subscribers.assign(m_subscribers.begin(), m_subscribers.end());
+  }
+
+  for(auto& subscriber : subscribers) {
+
+    try {
+
+      if(subscriber.tables.empty()) {
+        subscriber.callback(batch);
+        continue;
+      }
+
+      Batch filtered;
+      filtered.sequence = batch.sequence;
+      filtered.overflow = batch.overflow;
+
+      for(auto& table : batch.tables) {
+        if(subscriber.tables.find(table) != subscriber.tables.end()) {
+          filtered.tables.insert(table);
+        }
+      }
+
+      if(filtered.tables.empty()) {
+        continue;
+      }
+
+      for(auto& change : batch.changes) {
+        if(subscriber.tables.find(toLowerCase(change.table->c_str())) != subscriber.tables.end()) {
+          filtered.changes.push_back(change);
+        }
+      }
+
+      subscriber.callback(filtered);
+
+    } catch (std::exception& e) {
+      OATPP_LOGe("[oatpp::sqlite::ChangeFeed::deliver()]", "Error. Subscriber {} failed. {}", subscriber.id, e.what());
+    }
+
+  }
+
+}
+
+void ChangeFeed::run() {
+
+  while(true) {
+
+    Batch batch;
+
+    {
+      std::unique_lock<std::mutex> lock(m_queueMutex);
+      m_queueCondition.wait(lock, [this]{
+        return !m_running || !m_queue.empty();
+      });
+      if(m_queue.empty()) {
+        return;
+      }
+      batch = std::move(m_queue.front());
+      m_queue.pop_front();
+    }
+
+    deliver(batch);
+
+  }
+
+}
+
+v_int64 ChangeFeed::subscribe(const std::vector<oatpp::String>& tables, const Callback& callback) {
+  Subscriber subscriber;
+  for(auto& table : tables) {
+    subscriber.tables.insert(toLowerCase(table->c_str()));
+  }
+  subscriber.callback = callback;
+  std::lock_guard<std::mutex> lock(m_subscribersMutex);
+  subscriber.id = ++ m_subscriberIdCounter;
+  m_subscribers.push_back(subscriber);
+  return subscriber.id;
+}
+
+void ChangeFeed::unsubscribe(v_int64 subscriptionId) {
+  std::lock_guard<std::mutex> lock(m_subscribersMutex);
+  for(auto it = m_subscribers.begin(); it != m_subscribers.end(); ++ it) {
+    if(it->id == subscriptionId) {
+      m_subscribers.erase(it);
+      break;
+    }
+  }
+}
+
+v_int64 ChangeFeed::getQueueSize() {
+  std::lock_guard<std::mutex> lock(m_queueMutex);
+  return m_queue.size();
+}
+
+void ChangeFeed::stop() {
+  {
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    m_running = false;
+  }
+  m_queueCondition.notify_all();
+  if(m_thread.joinable()) {
+    m_thread.join();
+  }
+}
+
+bool ChangeFeed::isPreUpdateEnabled() {
+  return m_config.captureValues;
+}
+
+void ChangeFeed::onPreUpdate(sqlite3* handle, int operation, const char* database, const char* table,
+                             sqlite3_int64 oldRowId, sqlite3_int64 newRowId)
+{
+
+#ifdef SQLITE_ENABLE_PREUPDATE_HOOK
+
+  RowChange change;
+  change.operation = operation;
+  change.database = database;
+  change.table = table;
+  change.rowId = operation == SQLITE_DELETE ? oldRowId : newRowId;
+  change.oldRowId = oldRowId;
+
+  auto count = sqlite3_preupdate_count(handle);
+
+  if(operation == SQLITE_UPDATE || operation == SQLITE_DELETE) {
+    change.oldValues.reserve(count);
+    for(int i = 0; i < count; i ++) {
+      sqlite3_value* value = nullptr;
+      sqlite3_preupdate_old(handle, i, &value);
+      change.oldValues.push_back(mapping::ResultSet::readValue(value));
+    }
+  }
+
+  if(operation == SQLITE_UPDATE || operation == SQLITE_INSERT) {
+    change.newValues.reserve(count);
+    for(int i = 0; i < count; i ++) {
+      sqlite3_value* value = nullptr;
+      sqlite3_preupdate_new(handle, i, &value);
+      change.newValues.push_back(mapping::ResultSet::readValue(value));
+    }
+  }
+
+  addChange(handle, std::move(change));
+
+#else
+  (void) handle;
+  (void) operation;
+  (void) database;
+  (void) table;
+  (void) oldRowId;
+  (void) newRowId;
+#endif
+
+}
+
+void ChangeFeed::onChange(sqlite3* handle, int operation, const char* database, const char* table, sqlite3_int64 rowId) {
+
+  /* with values capture, changes are recorded by the preupdate hook */
+  if(m_config.captureValues) {
+    return;
+  }
+
+  RowChange change;
+  change.operation = operation;
+  change.database = database;
+  change.table = table;
+  change.rowId = rowId;
+  change.oldRowId = rowId;
+
+  addChange(handle, std::move(change));
+
+}
+
+void ChangeFeed::onCommit(sqlite3* handle) {
+
+  /* the commit may still fail - keep the batch until onCommitComplete() */
+
+  std::lock_guard<std::mutex> lock(m_transactionsMutex);
+  auto it = m_transactions.find(handle);
+  if(it == m_transactions.end()) {
+    return;
+  }
+
+  auto committed = m_committedTransactions.find(handle);
+  if(committed == m_committedTransactions.end()) {
+    m_committedTransactions.insert({handle, std::move(it->second)});
+    m_transactions.erase(it);
+    return;
+  }
+
+  /* COMMIT is retried after a failure - changes made in between belong to the same transaction */
+  auto& pending = committed->second;
+  pending.tables.insert(it->second.tables.begin(), it->second.tables.end());
+  pending.overflow = pending.overflow || it->second.overflow;
+  if(!pending.overflow && (v_int64) (pending.changes.size() + it->second.changes.size()) > m_config.maxTransactionChanges) {
+    pending.overflow = true;
+  }
+  if(pending.overflow) {
+    pending.changes.clear();
+    pending.changes.shrink_to_fit();
+  } else {
+    for(auto& change : it->second.changes) {
+      pending.changes.push_back(std::move(change));
+    }
+  }
+  m_transactions.erase(it);
+
+}
+
+void ChangeFeed::onCommitComplete(sqlite3* handle) {
+
+  Transaction transaction;
+  {
+    std::lock_guard<std::mutex> lock(m_transactionsMutex);
+    auto it = m_committedTransactions.find(handle);
+    if(it == m_committedTransactions.end()) {
+      return;
+    }
+    transaction = std::move(it->second);
+    m_committedTransactions.erase(it);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    if(!m_running) {
+      return;
+    }
+    Batch batch;
+    batch.sequence = ++ m_sequence;
+    batch.changes = std::move(transaction.changes);
+    batch.tables = std::move(transaction.tables);
+    batch.overflow = transaction.overflow;
+    m_queue.push_back(std::move(batch));
+  }
+
+  m_queueCondition.notify_one();
+
+}
+
+void ChangeFeed::onRollback(sqlite3* handle) {
+  std::lock_guard<std::mutex> lock(m_transactionsMutex);
+  m_transactions.erase(handle);
+  m_committedTransactions.erase(handle);
+}
+
+}}
@@ -0,0 +1,250 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef oatpp_sqlite_ChangeFeed_hpp
+#define oatpp_sqlite_ChangeFeed_hpp
+
+#include "Connection.hpp"
+#include "mapping/ResultSet.hpp"
+
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace oatpp { namespace sqlite {
+
+/**
+ * Change-data-capture feed. <br>
+ * Buffers row changes made through connections per transaction and publishes them to in-process subscribers
+ * once the transaction is committed. Rolled back changes are discarded. <br>
+ * Add the feed to connections with &id:oatpp::sqlite::ConnectionProvider::addChangeListener;. <br>
+ * Batches are delivered from a dedicated thread in commit order - subscribers may query the database. <br>
+ * Limitations of SQLite hooks apply:
+ * <ul>
+ *   <li>Changes made by other processes or by connections not opened by the provider are not captured.</li>
+ *   <li>Without values capture, changes to `WITHOUT ROWID` tables, rows deleted by the truncate optimization
+ *   and rows replaced by `ON CONFLICT REPLACE` are not reported.</li>
+ *   <li>Changes of a statement that failed inside an explicit transaction are reported if the transaction is committed.</li>
+ *   <li>Batch is published once the statement which committed the transaction is complete.
+ *   For statements stepped outside of &id:oatpp::sqlite::Executor; (ex.: `INSERT ... RETURNING` which commits
+ *   when its result is released) the batch is published after the next statement executed on the connection.</li>
+ * </ul>
+ */
+class ChangeFeed : public Connection::ChangeListener {
+public:
+
+  /**
+   * Feed config.
+   */
+  struct Config {
+
+    /**
+     * Capture old and new column values using `sqlite3_preupdate_hook`. <br>
+     * Requires SQLite built with `SQLITE_ENABLE_PREUPDATE_HOOK`. Ignored otherwise.
+     */
+    bool captureValues = false;
+
+    /**
+     * Max number of row changes buffered per transaction. <br>
+     * Once exceeded, row changes of the transaction are dropped and the batch is published
+     * with &l:ChangeFeed::Batch::overflow; set to `true`.
+     */
+    v_int64 maxTransactionChanges = 10000;
+
+  };
+
+  /**
+   * Single row change.
+   */
+  struct RowChange {
+
+    /**
+     * `SQLITE_INSERT`, `SQLITE_UPDATE` or `SQLITE_DELETE`.
+     */
+    v_int32 operation;
+
+    /**
+     * Database name.
+     */
+    oatpp::String database;
+
+    /**
+     * Table name.
+     */
+    oatpp::String table;
+
+    /**
+     * Rowid of the row. For `SQLITE_DELETE` - rowid of the deleted row.
+     */
+    v_int64 rowId;
+
+    /**
+     * Rowid of the row before the change. Differs from `rowId` only if `UPDATE` changed the rowid.
+     */
+    v_int64 oldRowId;
+
+    /**
+     * Column values before the change. Captured only for `SQLITE_UPDATE` and `SQLITE_DELETE` with &l:ChangeFeed::Config::captureValues;.
+     */
+    mapping::ResultSet::Row oldValues;
+
+    /**
+     * Column values after the change. Captured only for `SQLITE_INSERT` and `SQLITE_UPDATE` with &l:ChangeFeed::Config::captureValues;.
+     */
+    mapping::ResultSet::Row newValues;
+
+  };
+
+  /**
+   * Changes of a single committed transaction.
+   */
+  struct Batch {
+
+    /**
+     * Sequence number of the batch. Increments by one for every published batch.
+     */
+    v_int64 sequence;
+
+    /**
+     * Row changes in the order they were made.
+     */
+    std::vector<RowChange> changes;
+
+    /**
+     * Names of changed tables (lowercase).
+     */
+    std::unordered_set<std::string> tables;
+
+    /**
+     * `true` if the transaction had more than &l:ChangeFeed::Config::maxTransactionChanges; changes. <br>
+     * In this case `changes` is empty and only `tables` is set - subscribers should reload changed tables.
+     */
+    bool overflow;
+
+  };
+
+  /**
+   * Subscriber callback.
+   */
+  typedef std::function<void(const Batch& batch)> Callback;
+
+private:
+
+  struct Subscriber {
+    v_int64 id;
+    std::unordered_set<std::string> tables;
+    Callback callback;
+  };
+
+  struct Transaction {
+    std::vector<RowChange> changes;
+    std::unordered_set<std::string> tables;
+    bool overflow = false;
+  };
+
+private:
+  static std::string toLowerCase(const char* text);
+private:
+  void addChange(sqlite3* handle, RowChange&& change);
+  void deliver(const Batch& batch);
+  void run();
+private:
+  Config m_config;
+  std::atomic<bool> m_running;
+  v_int64 m_sequence;
+  std::thread m_thread;
+private:
+  std::mutex m_transactionsMutex;
+  std::unordered_map<sqlite3*, Transaction> m_transactions;
+  std::unordered_map<sqlite3*, Transaction> m_committedTransactions;
+private:
+  std::mutex m_queueMutex;
+  std::condition_variable m_queueCondition;
+  std::list<Batch> m_queue;
+private:
+  std::mutex m_subscribersMutex;
+  std::list<Subscriber> m_subscribers;
+  v_int64 m_subscriberIdCounter;
+public:
+
+  /**
+   * Constructor with default config. Starts the delivery thread.
+   */
+  ChangeFeed();
+
+  /**
+   * Constructor. Starts the delivery thread.
+   * @param config - &l:ChangeFeed::Config;.
+   */
+  ChangeFeed(const Config& config);
+
+  /**
+   * Virtual destructor. Calls &l:ChangeFeed::stop ();.
+   */
+  ~ChangeFeed();
+
+  /**
+   * Subscribe to committed changes.
+   * @param tables - names of tables to receive changes of (case insensitive). Empty - receive changes of all tables.
+   * @param callback - &l:ChangeFeed::Callback;. Called from the delivery thread.
+   * Batch passed to the callback contains only changes of the subscribed tables.
+   * @return - subscription id.
+   */
+  v_int64 subscribe(const std::vector<oatpp::String>& tables, const Callback& callback);
+
+  /**
+   * Cancel subscription.
+   * @param subscriptionId - id returned by &l:ChangeFeed::subscribe ();.
+   */
+  void unsubscribe(v_int64 subscriptionId);
+
+  /**
+   * Get number of committed batches waiting for delivery.
+   * @return
+   */
+  v_int64 getQueueSize();
+
+  /**
+   * Deliver batches which are already in the queue and stop the delivery thread. <br>
+   * Changes committed after the stop are not published.
+   */
+  void stop();
+
+  bool isPreUpdateEnabled() override;
+  void onPreUpdate(sqlite3* handle, int operation, const char* database, const char* table,
+                   sqlite3_int64 oldRowId, sqlite3_int64 newRowId) override;
+  void onChange(sqlite3* handle, int operation, const char* database, const char* table, sqlite3_int64 rowId) override;
+  void onCommit(sqlite3* handle) override;
+  void onCommitComplete(sqlite3* handle) override;
+  void onRollback(sqlite3* handle) override;
+
+};
+
+}}
+
+#endif // oatpp_sqlite_ChangeFeed_hpp
@@ -0,0 +1,242 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "CheckpointManager.hpp"
+
+#include "oatpp/base/Log.hpp"
+#include "oatpp/Environment.hpp"
+
+namespace oatpp { namespace sqlite {
+
+CheckpointManager::CheckpointManager(const std::shared_ptr<provider::Provider<Connection>>& connectionProvider, const Config& config)
+  : m_config(config)
+  , m_connectionProvider(connectionProvider)
+  , m_pageSize(0)
+  , m_triggered(false)
+  , m_running(true)
+{
+  m_stats.walFrames = 0;
+  m_stats.walSize = 0;
+  m_stats.passiveCount = 0;
+  m_stats.restartCount = 0;
+  m_stats.truncateCount = 0;
+  m_stats.busyCount = 0;
+  m_stats.errorCount = 0;
+  m_stats.lastDuration = 0;
+  m_stats.maxDuration = 0;
+  m_stats.totalDuration = 0;
+  m_thread = std::thread([this]{
+    run();
+  });
+}
+
+CheckpointManager::CheckpointManager(const std::shared_ptr<provider::Provider<Connection>>& connectionProvider)
+  : CheckpointManager(connectionProvider, Config())
+{}
+
+CheckpointManager::~CheckpointManager() {
+  stop();
+}
+
+void CheckpointManager::run() {
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  while(m_running) {
+
+    m_condition.wait_for(lock, m_config.interval, [this]{
+      return !m_running || m_triggered;
+    });
+
+    if(!m_running) {
+      break;
+    }
+
+    m_triggered = false;
+
+    v_int64 maxFrames = 0;
+    for(auto& db : m_walFrames) {
+      if(db.second > maxFrames) {
+        maxFrames = db.second;
+      }
+    }
+
+    if(maxFrames == 0) {
+      continue;
+    }
+
+    int mode = SQLITE_CHECKPOINT_PASSIVE;
+    if(maxFrames >= m_config.truncateFrames) {
+      mode = SQLITE_CHECKPOINT_TRUNCATE;
+    } else if(maxFrames >= m_config.restartFrames) {
+      mode = SQLITE_CHECKPOINT_RESTART;
+    }
+
+    lock.unlock();
+    checkpoint(mode);
+    lock.lock();
+
+  }
+
+}
+
+int CheckpointManager::checkpointDatabase(sqlite3* handle, const std::string& database, int mode) {
+
+  int walFrames = 0;
+  int checkpointedFrames = 0;
+
+  v_int64 startTime = oatpp::Environment::getMicroTickCount();
+  auto res = sqlite3_wal_checkpoint_v2(handle, database.c_str(), mode, &walFrames, &checkpointedFrames);
+  v_int64 duration = oatpp::Environment::getMicroTickCount() - startTime;
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  switch(mode) {
+    case SQLITE_CHECKPOINT_RESTART: m_stats.restartCount ++; break;
+    case SQLITE_CHECKPOINT_TRUNCATE: m_stats.truncateCount ++; break;
+    default: m_stats.passiveCount ++;
+  }
+
+  m_stats.lastDuration = duration;
+  m_stats.totalDuration += duration;
+  if(duration > m_stats.maxDuration) {
+    m_stats.maxDuration = duration;
+  }
+
+  if(res == SQLITE_BUSY) {
+    m_stats.busyCount ++;
+  } else if(res != SQLITE_OK) {
+    m_stats.errorCount ++;
+    OATPP_LOGe("[oatpp::sqlite::CheckpointManager::checkpointDatabase()]", "Error. Checkpoint of '{}' failed. {}",
+               database, sqlite3_errmsg(handle));
+    return res;
+  }
+
+  if(walFrames >= 0 && walFrames == checkpointedFrames) {
+    /* all frames are in the database - the WAL will be reset by the next writer */
+    m_walFrames[database] = 0;
+  } else if(walFrames >= 0) {
+    m_walFrames[database] = walFrames;
+  }
+
+  return res;
+
+}
+
+int CheckpointManager::checkpoint(int mode) {
+
+  auto connectionProvider = m_connectionProvider.lock();
+  if(!connectionProvider) {
+    return SQLITE_MISUSE;
+  }
+
+  std::vector<std::string> databases;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for(auto& db : m_walFrames) {
+      databases.push_back(db.first);
+    }
+  }
+  if(databases.empty()) {
+    databases.push_back("main");
+  }
+
+  provider::ResourceHandle<Connection> connection;
+  try {
+    connection = connectionProvider->get();
+  } catch (std::exception& e) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.errorCount ++;
+    OATPP_LOGe("[oatpp::sqlite::CheckpointManager::checkpoint()]", "Error. Can't get connection. {}", e.what());
+    return SQLITE_CANTOPEN;
+  }
+
+  if(!connection) {
+    return SQLITE_CANTOPEN;
+  }
+
+  auto handle = connection.object->getHandle();
+
+  if(m_pageSize == 0) {
+    sqlite3_stmt* stmt = nullptr;
+    if(sqlite3_prepare_v2(handle, "PRAGMA main.page_size", -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW) {
+      m_pageSize = sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+  }
+
+  int result = SQLITE_OK;
+  for(auto& database : databases) {
+    auto res = checkpointDatabase(handle, database, mode);
+    if(res != SQLITE_OK && result == SQLITE_OK) {
+      result = res;
+    }
+  }
+
+  return result;
+
+}
+
+CheckpointManager::Stats CheckpointManager::getStats() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  Stats stats = m_stats;
+  stats.walFrames = 0;
+  for(auto& db : m_walFrames) {
+    stats.walFrames += db.second;
+  }
+  /* WAL header is 32 bytes, each frame has 24 bytes header */
+  stats.walSize = stats.walFrames > 0 ? 32 + stats.walFrames * (m_pageSize.load() + 24) : 0;
+  return stats;
+}
+
+void CheckpointManager::stop() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_running = false;
+  }
+  m_condition.notify_all();
+  if(m_thread.joinable()) {
+    m_thread.join();
+  }
+}
+
+bool CheckpointManager::isWalHookEnabled() {
+  return true;
+}
+
+void CheckpointManager::onWalCommit(sqlite3* handle, const char* database, int walFrames) {
+  (void) handle;
+  bool notify;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_walFrames[database] = walFrames;
+    notify = walFrames >= m_config.passiveFrames;
+    m_triggered = m_triggered || notify;
+  }
+  if(notify) {
+    m_condition.notify_one();
+  }
+}
+
+}}
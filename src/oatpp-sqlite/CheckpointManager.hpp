@@ -0,0 +1,199 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef oatpp_sqlite_CheckpointManager_hpp
+#define oatpp_sqlite_CheckpointManager_hpp
+
+#include "Connection.hpp"
+
+#include "oatpp/provider/Provider.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace oatpp { namespace sqlite {
+
+/**
+ * Background WAL checkpoint scheduler. <br>
+ * Tracks WAL size via `sqlite3_wal_hook` and runs checkpoints from a dedicated thread, so that
+ * checkpoint cost is moved off the request path. <br>
+ * Add it to connections with &id:oatpp::sqlite::ConnectionProvider::addChangeListener; -
+ * SQLite auto-checkpoint is disabled on connections the manager is attached to. <br>
+ * - `PASSIVE` checkpoint is run when the WAL reaches &l:CheckpointManager::Config::passiveFrames; or
+ * once per &l:CheckpointManager::Config::interval; if the WAL is not empty. <br>
+ * - Escalates to `RESTART` and `TRUNCATE` when the WAL passes &l:CheckpointManager::Config::restartFrames; and
+ * &l:CheckpointManager::Config::truncateFrames; respectively.
+ */
+class CheckpointManager : public Connection::ChangeListener {
+public:
+
+  /**
+   * Manager config.
+   */
+  struct Config {
+
+    /**
+     * Number of WAL frames triggering `PASSIVE` checkpoint.
+     */
+    v_int64 passiveFrames = 1000;
+
+    /**
+     * Number of WAL frames triggering `RESTART` checkpoint. `RESTART` waits for readers and resets the WAL.
+     */
+    v_int64 restartFrames = 10000;
+
+    /**
+     * Number of WAL frames triggering `TRUNCATE` checkpoint. `TRUNCATE` also truncates the WAL file to zero bytes.
+     */
+    v_int64 truncateFrames = 50000;
+
+    /**
+     * Interval of regular `PASSIVE` checkpoints.
+     */
+    std::chrono::milliseconds interval = std::chrono::milliseconds(1000);
+
+  };
+
+  /**
+   * Checkpoint statistics.
+   */
+  struct Stats {
+
+    /**
+     * Number of frames in WAL as of the last commit or checkpoint.
+     */
+    v_int64 walFrames;
+
+    /**
+     * Approximate size of the WAL in bytes.
+     */
+    v_int64 walSize;
+
+    /**
+     * Number of `PASSIVE` checkpoints run.
+     */
+    v_int64 passiveCount;
+
+    /**
+     * Number of `RESTART` checkpoints run.
+     */
+    v_int64 restartCount;
+
+    /**
+     * Number of `TRUNCATE` checkpoints run.
+     */
+    v_int64 truncateCount;
+
+    /**
+     * Number of checkpoints which could not complete because of readers or writers (`SQLITE_BUSY`).
+     */
+    v_int64 busyCount;
+
+    /**
+     * Number of failed checkpoints.
+     */
+    v_int64 errorCount;
+
+    /**
+     * Duration of the last checkpoint in microseconds.
+     */
+    v_int64 lastDuration;
+
+    /**
+     * Max duration of a checkpoint in microseconds.
+     */
+    v_int64 maxDuration;
+
+    /**
+     * Total duration of all checkpoints in microseconds.
+     */
+    v_int64 totalDuration;
+
+  };
+
+private:
+  void run();
+  int checkpointDatabase(sqlite3* handle, const std::string& database, int mode);
+private:
+  Config m_config;
+  std::weak_ptr<provider::Provider<Connection>> m_connectionProvider;
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  std::unordered_map<std::string, v_int64> m_walFrames;
+  std::atomic<v_int64> m_pageSize;
+  bool m_triggered;
+  Stats m_stats;
+  bool m_running;
+  std::thread m_thread;
+public:
+
+  /**
+   * Constructor. Starts the checkpoint thread.
+   * @param connectionProvider - provider of connections used to run checkpoints. Connection is acquired
+   * for the duration of a checkpoint only.
+   * @param config - &l:CheckpointManager::Config;.
+   */
+  CheckpointManager(const std::shared_ptr<provider::Provider<Connection>>& connectionProvider, const Config& config);
+
+  /**
+   * Constructor with default config. Starts the checkpoint thread.
+   * @param connectionProvider - provider of connections used to run checkpoints.
+   */
+  CheckpointManager(const std::shared_ptr<provider::Provider<Connection>>& connectionProvider);
+
+  /**
+   * Virtual destructor. Calls &l:CheckpointManager::stop ();.
+   */
+  ~CheckpointManager();
+
+  /**
+   * Run checkpoint of all databases now - in the calling thread.
+   * @param mode - `SQLITE_CHECKPOINT_PASSIVE`, `SQLITE_CHECKPOINT_FULL`, `SQLITE_CHECKPOINT_RESTART` or `SQLITE_CHECKPOINT_TRUNCATE`.
+   * @return - `SQLITE_OK`, `SQLITE_BUSY` or an error code.
+   */
+  int checkpoint(int mode);
+
+  /**
+   * Get checkpoint statistics.
+   * @return - &l:CheckpointManager::Stats;.
+   */
+  Stats getStats();
+
+  /**
+   * Stop the checkpoint thread.
+   */
+  void stop();
+
+  bool isWalHookEnabled() override;
+  void onWalCommit(sqlite3* handle, const char* database, int walFrames) override;
+
+};
+
+}}
+
+#endif // oatpp_sqlite_CheckpointManager_hpp
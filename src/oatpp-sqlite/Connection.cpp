@@ -23,7 +23,11 @@
  ***************************************************************************/
 
 #include "Connection.hpp"
+
 #include "oatpp/base/Log.hpp"
+#include "oatpp/Environment.hpp"
+
+#include <cstring>
 
 namespace oatpp { namespace sqlite {
 
@@ -35,11 +39,136 @@ std::shared_ptr<provider::Invalidator<Connection>> Connection::getInvalidator()
   return m_invalidator;
 }
 
+v_int64 Connection::getCacheUsed() {
+  int current = 0;
+  int highwater = 0;
+  if(sqlite3_db_status(getHandle(), SQLITE_DBSTATUS_CACHE_USED, &current, &highwater, 0) != SQLITE_OK) {
+    return 0;
+  }
+  return current;
+}
+
+v_int64 Connection::releaseMemory() {
+  auto before = getCacheUsed();
+  sqlite3_db_release_memory(getHandle());
+  auto after = getCacheUsed();
+  return before > after ? before - after : 0;
+}
+
+void ConnectionImpl::onUpdateHook(void* data, int operation, const char* database, const char* table, sqlite3_int64 rowId) {
+  auto _this = static_cast<ConnectionImpl*>(data);
+  std::lock_guard<std::mutex> lock(_this->m_changeListenersMutex);
+  for(auto& listener : _this->m_changeListeners) {
+    listener->onChange(_this->m_connection, operation, database, table, rowId);
+  }
+}
+
+int ConnectionImpl::onCommitHook(void* data) {
+  auto _this = static_cast<ConnectionImpl*>(data);
+  std::lock_guard<std::mutex> lock(_this->m_changeListenersMutex);
+  _this->m_commitPending = true;
+  for(auto& listener : _this->m_changeListeners) {
+    listener->onCommit(_this->m_connection);
+  }
+  return 0;
+}
+
+void ConnectionImpl::onRollbackHook(void* data) {
+  auto _this = static_cast<ConnectionImpl*>(data);
+  std::lock_guard<std::mutex> lock(_this->m_changeListenersMutex);
+  _this->m_commitPending = false;
+  for(auto& listener : _this->m_changeListeners) {
+    listener->onRollback(_this->m_connection);
+  }
+}
+
+int ConnectionImpl::onWalHook(void* data, sqlite3* handle, const char* database, int walFrames) {
+  auto _this = static_cast<ConnectionImpl*>(data);
+  std::lock_guard<std::mutex> lock(_this->m_changeListenersMutex);
+  for(auto& listener : _this->m_changeListeners) {
+    if(listener->isWalHookEnabled()) {
+      listener->onWalCommit(handle, database, walFrames);
+    }
+  }
+  return SQLITE_OK;
+}
+
+int ConnectionImpl::onAuthorizer(void* data, int action, const char* arg1, const char* arg2, const char* database, const char* trigger) {
+
+  auto _this = static_cast<ConnectionImpl*>(data);
+  std::lock_guard<std::mutex> lock(_this->m_authorizerMutex);
+
+  /* DROP checks SQLITE_DELETE on the dropped table right after the drop action - it must not be ignored */
+  std::string droppedTable;
+  std::swap(droppedTable, _this->m_droppedTable);
+  if(action == SQLITE_DROP_TABLE || action == SQLITE_DROP_TEMP_TABLE || action == SQLITE_DROP_VIEW ||
+     action == SQLITE_DROP_TEMP_VIEW || action == SQLITE_DROP_VTABLE)
+  {
+    _this->m_droppedTable = arg1 ? arg1 : "";
+  }
+
+  int result = SQLITE_OK;
+  if(_this->m_authorizer) {
+    result = _this->m_authorizer(action, arg1, arg2, database, trigger);
+    if(result != SQLITE_OK) {
+      return result;
+    }
+  }
+  if(_this->m_statementAuthorizer) {
+    result = _this->m_statementAuthorizer(action, arg1, arg2, database, trigger);
+  }
+
+  /*
+   * Rows deleted by the truncate optimization (DELETE without WHERE) aren't reported to the update hook.
+   * SQLITE_IGNORE disables the optimization for ordinary tables while change listeners are installed.
+   */
+  if(result == SQLITE_OK && action == SQLITE_DELETE && _this->m_changeHooksInstalled && arg1 &&
+     std::strncmp(arg1, "sqlite_", 7) != 0 && droppedTable != arg1)
+  {
+    result = SQLITE_IGNORE;
+  }
+
+  return result;
+
+}
+
+int ConnectionImpl::onProgressHandler(void* data) {
+  auto handler = static_cast<ProgressHandler*>(data);
+  return handler->callback();
+}
+
+#ifdef SQLITE_ENABLE_PREUPDATE_HOOK
+void ConnectionImpl::onPreUpdateHook(void* data, sqlite3* handle, int operation, const char* database, const char* table,
+                                     sqlite3_int64 oldRowId, sqlite3_int64 newRowId)
+{
+  auto _this = static_cast<ConnectionImpl*>(data);
+  std::lock_guard<std::mutex> lock(_this->m_changeListenersMutex);
+  for(auto& listener : _this->m_changeListeners) {
+    if(listener->isPreUpdateEnabled()) {
+      listener->onPreUpdate(handle, operation, database, table, oldRowId, newRowId);
+    }
+  }
+}
+#endif
+
 ConnectionImpl::ConnectionImpl(sqlite3* connection)
   : m_connection(connection)
-{}
+  , m_idleSince(-1)
+  , m_transactionDepth(0)
+  , m_changeHooksInstalled(false)
+  , m_preUpdateHookInstalled(false)
+  , m_walHookInstalled(false)
+  , m_commitPending(false)
+{
+  if(m_connection) {
+    sqlite3_set_authorizer(m_connection, &ConnectionImpl::onAuthorizer, this);
+  }
+}
 
 ConnectionImpl::~ConnectionImpl() {
+  for(auto& pair : m_statements) {
+    sqlite3_finalize(pair.second);
+  }
   auto res = sqlite3_close(m_connection);
   if(res != SQLITE_OK) {
     OATPP_LOGe("[oatpp::sqlite::ConnectionImpl::~ConnectionImpl()]", "Error. Can't close database connection!");
@@ -59,4 +188,175 @@ bool ConnectionImpl::isPrepared(const oatpp::String& statementName) {
   return it != m_prepared.end();
 }
 
+void ConnectionImpl::setIdle(bool idle) {
+  if(idle) {
+    m_idleSince = oatpp::Environment::getMicroTickCount();
+  } else {
+    m_idleSince = -1;
+  }
+}
+
+bool ConnectionImpl::isIdle() {
+  return m_idleSince >= 0;
+}
+
+v_int64 ConnectionImpl::getIdleSince() {
+  return m_idleSince;
+}
+
+sqlite3_stmt* ConnectionImpl::getCachedStatement(const oatpp::String& sql) {
+  std::lock_guard<std::mutex> lock(m_statementsMutex);
+  auto it = m_statements.find(sql);
+  if(it == m_statements.end()) {
+    return nullptr;
+  }
+  auto stmt = it->second;
+  m_statements.erase(it);
+  return stmt;
+}
+
+void ConnectionImpl::putCachedStatement(const oatpp::String& sql, sqlite3_stmt* stmt) {
+  if(stmt == nullptr) {
+    return;
+  }
+  sqlite3_reset(stmt);
+  sqlite3_clear_bindings(stmt);
+  {
+    std::lock_guard<std::mutex> lock(m_statementsMutex);
+    if(m_statements.size() < STATEMENT_CACHE_SIZE && m_statements.insert({sql, stmt}).second) {
+      return;
+    }
+  }
+  sqlite3_finalize(stmt);
+}
+
+bool ConnectionImpl::hasCachedStatement(const oatpp::String& sql) {
+  std::lock_guard<std::mutex> lock(m_statementsMutex);
+  return m_statements.find(sql) != m_statements.end();
+}
+
+void ConnectionImpl::setBusyHandler(const std::shared_ptr<BusyHandler>& handler) {
+  std::lock_guard<std::mutex> lock(m_busyHandlerMutex);
+  /* sqlite3_busy_handler waits for the running callback - old handler can be released after it */
+  if(handler) {
+    handler->install(m_connection);
+  } else {
+    sqlite3_busy_handler(m_connection, nullptr, nullptr);
+  }
+  m_busyHandler = handler;
+}
+
+void ConnectionImpl::setAuthorizer(const Authorizer& authorizer) {
+  std::lock_guard<std::mutex> lock(m_authorizerMutex);
+  m_authorizer = authorizer;
+}
+
+void ConnectionImpl::setStatementAuthorizer(const Authorizer& authorizer) {
+  std::lock_guard<std::mutex> lock(m_authorizerMutex);
+  m_statementAuthorizer = authorizer;
+}
+
+Connection::ProgressHandler ConnectionImpl::setProgressHandler(const ProgressHandler& handler) {
+
+  std::lock_guard<std::mutex> lock(m_progressHandlerMutex);
+
+  std::shared_ptr<ProgressHandler> newHandler;
+  if(handler.callback) {
+    newHandler = std::make_shared<ProgressHandler>(handler);
+  }
+
+  /* sqlite3_progress_handler waits for the running callback - old handler can be released after it */
+  if(newHandler) {
+    sqlite3_progress_handler(m_connection, newHandler->instructions, &ConnectionImpl::onProgressHandler, newHandler.get());
+  } else {
+    sqlite3_progress_handler(m_connection, 0, nullptr, nullptr);
+  }
+
+  ProgressHandler previous;
+  if(m_progressHandler) {
+    previous = *m_progressHandler;
+  }
+  m_progressHandler = newHandler;
+
+  return previous;
+
+}
+
+void ConnectionImpl::setTransactionDepth(v_int32 depth) {
+  m_transactionDepth = depth;
+}
+
+v_int32 ConnectionImpl::getTransactionDepth() {
+  return m_transactionDepth;
+}
+
+void ConnectionImpl::addChangeListener(const std::shared_ptr<ChangeListener>& listener) {
+
+  /*
+   * Hooks are installed outside of the listeners mutex -
+   * hooks are called holding the connection mutex and they lock the listeners mutex.
+   * Once installed, hooks stay installed for the lifetime of the connection.
+   */
+
+  if(!m_changeHooksInstalled.exchange(true)) {
+    sqlite3_update_hook(m_connection, &ConnectionImpl::onUpdateHook, this);
+    sqlite3_commit_hook(m_connection, &ConnectionImpl::onCommitHook, this);
+    sqlite3_rollback_hook(m_connection, &ConnectionImpl::onRollbackHook, this);
+  }
+
+  if(listener->isWalHookEnabled() && !m_walHookInstalled.exchange(true)) {
+    sqlite3_wal_hook(m_connection, &ConnectionImpl::onWalHook, this);
+  }
+
+#ifdef SQLITE_ENABLE_PREUPDATE_HOOK
+  if(listener->isPreUpdateEnabled() && !m_preUpdateHookInstalled.exchange(true)) {
+    sqlite3_preupdate_hook(m_connection, &ConnectionImpl::onPreUpdateHook, this);
+  }
+#endif
+
+  std::lock_guard<std::mutex> lock(m_changeListenersMutex);
+  for(auto& l : m_changeListeners) {
+    if(l == listener) {
+      return;
+    }
+  }
+  m_changeListeners.push_back(listener);
+
+}
+
+void ConnectionImpl::removeChangeListener(const std::shared_ptr<ChangeListener>& listener) {
+  std::lock_guard<std::mutex> lock(m_changeListenersMutex);
+  for(auto it = m_changeListeners.begin(); it != m_changeListeners.end(); ++ it) {
+    if(*it == listener) {
+      m_changeListeners.erase(it);
+      break;
+    }
+  }
+}
+
+void ConnectionImpl::completeCommit(bool success) {
+
+  if(!m_commitPending) {
+    return;
+  }
+
+  /* commit failed but the transaction is still open - COMMIT may be retried */
+  if(!sqlite3_get_autocommit(m_connection)) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(m_changeListenersMutex);
+  if(!m_commitPending.exchange(false)) {
+    return;
+  }
+  for(auto& listener : m_changeListeners) {
+    if(success) {
+      listener->onCommitComplete(m_connection);
+    } else {
+      listener->onRollback(m_connection);
+    }
+  }
+
+}
+
 }}
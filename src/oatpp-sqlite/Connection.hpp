@@ -25,18 +25,164 @@
 #ifndef oatpp_sqlite_Connection_hpp
 #define oatpp_sqlite_Connection_hpp
 
+#include "BusyHandler.hpp"
+
 #include "oatpp/orm/Connection.hpp"
 #include "oatpp/provider/Pool.hpp"
 #include "oatpp/Types.hpp"
 
 #include <sqlite3.h>
 
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 namespace oatpp { namespace sqlite {
 
 /**
  * Implementation of &id:oatpp::orm::Connection; for SQLite.
  */
 class Connection : public orm::Connection {
+public:
+
+  /**
+   * Listener of data changes made through the connection. <br>
+   * Fed by native `sqlite3_update_hook`, `sqlite3_commit_hook` and `sqlite3_rollback_hook`. <br>
+   * If SQLite is built with `SQLITE_ENABLE_PREUPDATE_HOOK` - also by `sqlite3_preupdate_hook`. <br>
+   * WAL commits are reported via `sqlite3_wal_hook` - see &l:Connection::ChangeListener::isWalHookEnabled ();. <br>
+   * While listeners are installed the truncate optimization is disabled - `DELETE` without `WHERE` reports every row. <br>
+   * *Methods are called from within SQLite hooks - implementations must not use the connection.*
+   */
+  class ChangeListener {
+  public:
+
+    /**
+     * Default virtual destructor.
+     */
+    virtual ~ChangeListener() = default;
+
+    /**
+     * Row was inserted, updated or deleted.
+     * @param handle - native connection handle.
+     * @param operation - `SQLITE_INSERT`, `SQLITE_UPDATE` or `SQLITE_DELETE`.
+     * @param database - database name.
+     * @param table - table name.
+     * @param rowId - rowid of the affected row.
+     */
+    virtual void onChange(sqlite3* handle, int operation, const char* database, const char* table, sqlite3_int64 rowId) {
+      (void) handle;
+      (void) operation;
+      (void) database;
+      (void) table;
+      (void) rowId;
+    }
+
+    /**
+     * Transaction is about to be committed. The commit may still fail (ex.: `SQLITE_BUSY`).
+     * @param handle - native connection handle.
+     */
+    virtual void onCommit(sqlite3* handle) {
+      (void) handle;
+    }
+
+    /**
+     * Transaction is committed - the statement which committed it returned successfully. <br>
+     * Called by &id:oatpp::sqlite::Executor; via &l:Connection::completeCommit ();, not from SQLite hooks -
+     * *implementations still must not use the connection.*
+     * @param handle - native connection handle.
+     */
+    virtual void onCommitComplete(sqlite3* handle) {
+      (void) handle;
+    }
+
+    /**
+     * Transaction was rolled back.
+     * @param handle - native connection handle.
+     */
+    virtual void onRollback(sqlite3* handle) {
+      (void) handle;
+    }
+
+    /**
+     * Check if the listener wants &l:Connection::ChangeListener::onPreUpdate (); to be called. <br>
+     * The preupdate hook is installed only if at least one listener of the connection wants it.
+     * @return - `false` by default.
+     */
+    virtual bool isPreUpdateEnabled() {
+      return false;
+    }
+
+    /**
+     * Row is about to be inserted, updated or deleted. Called only if SQLite is built with `SQLITE_ENABLE_PREUPDATE_HOOK`. <br>
+     * Old and new values of the row can be read with `sqlite3_preupdate_old`/`sqlite3_preupdate_new`.
+     * @param handle - native connection handle.
+     * @param operation - `SQLITE_INSERT`, `SQLITE_UPDATE` or `SQLITE_DELETE`.
+     * @param database - database name.
+     * @param table - table name.
+     * @param oldRowId - rowid of the row before the change.
+     * @param newRowId - rowid of the row after the change.
+     */
+    virtual void onPreUpdate(sqlite3* handle, int operation, const char* database, const char* table,
+                             sqlite3_int64 oldRowId, sqlite3_int64 newRowId)
+    {
+      (void) handle;
+      (void) operation;
+      (void) database;
+      (void) table;
+      (void) oldRowId;
+      (void) newRowId;
+    }
+
+    /**
+     * Check if the listener wants &l:Connection::ChangeListener::onWalCommit (); to be called. <br>
+     * *Note: the WAL hook replaces SQLite auto-checkpoint on the connection - the listener becomes responsible
+     * for running checkpoints.*
+     * @return - `false` by default.
+     */
+    virtual bool isWalHookEnabled() {
+      return false;
+    }
+
+    /**
+     * Transaction was committed to the WAL (database is in WAL mode).
+     * @param handle - native connection handle.
+     * @param database - database name.
+     * @param walFrames - number of frames currently in the WAL file.
+     */
+    virtual void onWalCommit(sqlite3* handle, const char* database, int walFrames) {
+      (void) handle;
+      (void) database;
+      (void) walFrames;
+    }
+
+  };
+
+  /**
+   * Authorizer of statements prepared on the connection - same arguments and return codes as the callback of
+   * `sqlite3_set_authorizer`: action code, two action arguments, database name and name of the trigger or view.
+   */
+  typedef std::function<int(int action, const char* arg1, const char* arg2, const char* database, const char* trigger)> Authorizer;
+
+  /**
+   * Progress handler of the connection - see `sqlite3_progress_handler`.
+   */
+  struct ProgressHandler {
+
+    /**
+     * Approximate number of virtual machine instructions between calls of the callback.
+     */
+    int instructions = 0;
+
+    /**
+     * Callback. Non-zero result interrupts the running statement. `nullptr` - no handler.
+     */
+    std::function<int()> callback;
+
+  };
+
 private:
   std::shared_ptr<provider::Invalidator<Connection>> m_invalidator;
 public:
@@ -50,15 +196,170 @@ public:
   virtual void setPrepared(const oatpp::String& statementName) = 0;
   virtual bool isPrepared(const oatpp::String& statementName) = 0;
 
+  /**
+   * Mark connection as idle (returned to the pool) or as acquired by the user.
+   * @param idle
+   */
+  virtual void setIdle(bool idle) = 0;
+
+  /**
+   * Check if connection is idle.
+   * @return
+   */
+  virtual bool isIdle() = 0;
+
+  /**
+   * Get time (in microseconds, &id:oatpp::Environment::getMicroTickCount;) since when the connection is idle.
+   * @return - tick count or `-1` if connection is not idle.
+   */
+  virtual v_int64 getIdleSince() = 0;
+
+  /**
+   * Set depth of the current transaction. Used by &id:oatpp::sqlite::Executor; for nested transactions.
+   * @param depth - `0` - no transaction, `1` - transaction, `>1` - nested transactions (savepoints).
+   */
+  virtual void setTransactionDepth(v_int32 depth) = 0;
+
+  /**
+   * Get depth of the current transaction.
+   * @return - `0` - no transaction, `1` - transaction, `>1` - nested transactions (savepoints).
+   */
+  virtual v_int32 getTransactionDepth() = 0;
+
+  /**
+   * Get number of bytes of heap memory used by the page cache of this connection. <br>
+   * Uses `sqlite3_db_status(SQLITE_DBSTATUS_CACHE_USED)`.
+   * @return
+   */
+  v_int64 getCacheUsed();
+
+  /**
+   * Free as much heap memory as possible from this connection. <br>
+   * Uses `sqlite3_db_release_memory`.
+   * @return - number of bytes freed.
+   */
+  v_int64 releaseMemory();
+
+  /**
+   * Take prepared statement out of the statement cache of this connection. <br>
+   * The statement stays owned by the caller until it is returned with &l:Connection::putCachedStatement ();.
+   * @param sql - statement text.
+   * @return - prepared statement or `nullptr` if there is no cached statement for this text.
+   */
+  virtual sqlite3_stmt* getCachedStatement(const oatpp::String& sql) = 0;
+
+  /**
+   * Reset prepared statement and put it to the statement cache of this connection. <br>
+   * If the cache is full or already has a statement for this text the statement is finalized.
+   * @param sql - statement text.
+   * @param stmt - statement prepared on this connection.
+   */
+  virtual void putCachedStatement(const oatpp::String& sql, sqlite3_stmt* stmt) = 0;
+
+  /**
+   * Check if the statement cache of this connection has a statement for this text.
+   * @param sql - statement text.
+   * @return
+   */
+  virtual bool hasCachedStatement(const oatpp::String& sql) = 0;
+
+  /**
+   * Add &l:Connection::ChangeListener;. Adding the same listener twice has no effect.
+   * @param listener
+   */
+  virtual void addChangeListener(const std::shared_ptr<ChangeListener>& listener) = 0;
+
+  /**
+   * Remove &l:Connection::ChangeListener;.
+   * @param listener
+   */
+  virtual void removeChangeListener(const std::shared_ptr<ChangeListener>& listener) = 0;
+
+  /**
+   * Report the end of a statement executed on this connection. <br>
+   * If the statement committed a transaction - calls &l:Connection::ChangeListener::onCommitComplete (); of listeners
+   * on success, and &l:Connection::ChangeListener::onRollback (); if the commit failed and the transaction was rolled back.
+   * If the commit failed and the transaction is still open (ex.: `SQLITE_BUSY`) - nothing is called until `COMMIT` is retried.
+   * @param success - `true` if the statement returned successfully.
+   */
+  virtual void completeCommit(bool success) = 0;
+
+  /**
+   * Set application &l:Connection::Authorizer;. <br>
+   * The connection owns the native authorizer of the handle and chains the application authorizer
+   * with the statement authorizer - see &l:Connection::setStatementAuthorizer ();. <br>
+   * *Don't call `sqlite3_set_authorizer` on the handle directly - it replaces the authorizer of the connection.*
+   * @param authorizer - authorizer. `nullptr` - remove authorizer.
+   */
+  virtual void setAuthorizer(const Authorizer& authorizer) = 0;
+
+  /**
+   * Set &l:Connection::Authorizer; called for statements prepared on this connection after the application authorizer.
+   * Used by &id:oatpp::sqlite::Executor; to collect tables accessed by a statement. <br>
+   * Its result is used only if the application authorizer allowed the action.
+   * @param authorizer - authorizer. `nullptr` - remove authorizer.
+   */
+  virtual void setStatementAuthorizer(const Authorizer& authorizer) = 0;
+
+  /**
+   * Set &l:Connection::ProgressHandler;. <br>
+   * *Don't call `sqlite3_progress_handler` on the handle directly - the connection keeps its handler
+   * so that a temporary handler can be replaced by the previous one.*
+   * @param handler - progress handler. Handler without callback - remove handler.
+   * @return - previous progress handler.
+   */
+  virtual ProgressHandler setProgressHandler(const ProgressHandler& handler) = 0;
+
   void setInvalidator(const std::shared_ptr<provider::Invalidator<Connection>>& invalidator);
   std::shared_ptr<provider::Invalidator<Connection>> getInvalidator();
 
 };
 
 class ConnectionImpl : public Connection {
+public:
+
+  /**
+   * Max number of prepared statements kept in the statement cache of the connection.
+   */
+  static constexpr v_int32 STATEMENT_CACHE_SIZE = 128;
+
+private:
+  static void onUpdateHook(void* data, int operation, const char* database, const char* table, sqlite3_int64 rowId);
+  static int onCommitHook(void* data);
+  static void onRollbackHook(void* data);
+  static int onWalHook(void* data, sqlite3* handle, const char* database, int walFrames);
+  static int onAuthorizer(void* data, int action, const char* arg1, const char* arg2, const char* database, const char* trigger);
+  static int onProgressHandler(void* data);
+#ifdef SQLITE_ENABLE_PREUPDATE_HOOK
+  static void onPreUpdateHook(void* data, sqlite3* handle, int operation, const char* database, const char* table,
+                              sqlite3_int64 oldRowId, sqlite3_int64 newRowId);
+#endif
 private:
   sqlite3* m_connection;
   std::unordered_set<oatpp::String> m_prepared;
+  std::atomic<v_int64> m_idleSince;
+  std::atomic<v_int32> m_transactionDepth;
+private:
+  std::mutex m_changeListenersMutex;
+  std::vector<std::shared_ptr<ChangeListener>> m_changeListeners;
+  std::atomic<bool> m_changeHooksInstalled;
+  std::atomic<bool> m_preUpdateHookInstalled;
+  std::atomic<bool> m_walHookInstalled;
+  std::atomic<bool> m_commitPending;
+private:
+  std::mutex m_busyHandlerMutex;
+  std::shared_ptr<BusyHandler> m_busyHandler;
+private:
+  std::mutex m_authorizerMutex;
+  Authorizer m_authorizer;
+  Authorizer m_statementAuthorizer;
+  std::string m_droppedTable;
+private:
+  std::mutex m_progressHandlerMutex;
+  std::shared_ptr<ProgressHandler> m_progressHandler;
+private:
+  std::mutex m_statementsMutex;
+  std::unordered_map<oatpp::String, sqlite3_stmt*> m_statements;
 public:
 
   ConnectionImpl(sqlite3* connection);
@@ -69,6 +370,32 @@ public:
   void setPrepared(const oatpp::String& statementName) override;
   bool isPrepared(const oatpp::String& statementName) override;
 
+  void setIdle(bool idle) override;
+  bool isIdle() override;
+  v_int64 getIdleSince() override;
+
+  void setTransactionDepth(v_int32 depth) override;
+  v_int32 getTransactionDepth() override;
+
+  sqlite3_stmt* getCachedStatement(const oatpp::String& sql) override;
+  void putCachedStatement(const oatpp::String& sql, sqlite3_stmt* stmt) override;
+  bool hasCachedStatement(const oatpp::String& sql) override;
+
+  void addChangeListener(const std::shared_ptr<ChangeListener>& listener) override;
+  void removeChangeListener(const std::shared_ptr<ChangeListener>& listener) override;
+
+  void completeCommit(bool success) override;
+
+  void setAuthorizer(const Authorizer& authorizer) override;
+  void setStatementAuthorizer(const Authorizer& authorizer) override;
+  ProgressHandler setProgressHandler(const ProgressHandler& handler) override;
+
+  /**
+   * Install &id:oatpp::sqlite::BusyHandler; on this connection. Connection keeps the handler alive.
+   * @param handler - busy handler. `nullptr` - remove handler.
+   */
+  void setBusyHandler(const std::shared_ptr<BusyHandler>& handler);
+
 };
 
 struct ConnectionAcquisitionProxy : public provider::AcquisitionProxy<Connection, ConnectionAcquisitionProxy> {
@@ -76,7 +403,13 @@ struct ConnectionAcquisitionProxy : public provider::AcquisitionProxy<Connection
   ConnectionAcquisitionProxy(const provider::ResourceHandle<Connection> &resource,
                              const std::shared_ptr<PoolInstance> &pool)
     : provider::AcquisitionProxy<Connection, ConnectionAcquisitionProxy>(resource, pool)
-  {}
+  {
+    _handle.object->setIdle(false);
+  }
+
+  ~ConnectionAcquisitionProxy() {
+    _handle.object->setIdle(true);
+  }
 
   sqlite3* getHandle() override {
     return _handle.object->getHandle();
@@ -90,6 +423,62 @@ struct ConnectionAcquisitionProxy : public provider::AcquisitionProxy<Connection
     return _handle.object->isPrepared(statementName);
   }
 
+  void setIdle(bool idle) override {
+    _handle.object->setIdle(idle);
+  }
+
+  bool isIdle() override {
+    return _handle.object->isIdle();
+  }
+
+  v_int64 getIdleSince() override {
+    return _handle.object->getIdleSince();
+  }
+
+  void setTransactionDepth(v_int32 depth) override {
+    _handle.object->setTransactionDepth(depth);
+  }
+
+  v_int32 getTransactionDepth() override {
+    return _handle.object->getTransactionDepth();
+  }
+
+  sqlite3_stmt* getCachedStatement(const oatpp::String& sql) override {
+    return _handle.object->getCachedStatement(sql);
+  }
+
+  void putCachedStatement(const oatpp::String& sql, sqlite3_stmt* stmt) override {
+    _handle.object->putCachedStatement(sql, stmt);
+  }
+
+  bool hasCachedStatement(const oatpp::String& sql) override {
+    return _handle.object->hasCachedStatement(sql);
+  }
+
+  void addChangeListener(const std::shared_ptr<ChangeListener>& listener) override {
+    _handle.object->addChangeListener(listener);
+  }
+
+  void removeChangeListener(const std::shared_ptr<ChangeListener>& listener) override {
+    _handle.object->removeChangeListener(listener);
+  }
+
+  void completeCommit(bool success) override {
+    _handle.object->completeCommit(success);
+  }
+
+  void setAuthorizer(const Authorizer& authorizer) override {
+    _handle.object->setAuthorizer(authorizer);
+  }
+
+  void setStatementAuthorizer(const Authorizer& authorizer) override {
+    _handle.object->setStatementAuthorizer(authorizer);
+  }
+
+  ProgressHandler setProgressHandler(const ProgressHandler& handler) override {
+    return _handle.object->setProgressHandler(handler);
+  }
+
 };
 
 }}
@@ -24,22 +24,96 @@
 
 #include "ConnectionProvider.hpp"
 
+#include "oatpp/Environment.hpp"
+
 namespace oatpp { namespace sqlite {
 
+ConnectionProvider::ConnectionInvalidator::ConnectionInvalidator(const std::shared_ptr<PoolMetrics>& metrics)
+  : m_metrics(metrics)
+{}
+
 void ConnectionProvider::ConnectionInvalidator::invalidate(const std::shared_ptr<Connection> &connection) {
   (void) connection;
-  // DO nothing
+  /* called by the pool when connection is dropped - TTL expired, connection invalidated or pool stopped */
+  m_metrics->recordClose();
 }
 
 ConnectionProvider::ConnectionProvider(const oatpp::String& connectionString)
-  : m_invalidator(std::make_shared<ConnectionInvalidator>())
+  : ConnectionProvider(connectionString, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE)
+{}
+
+ConnectionProvider::ConnectionProvider(const oatpp::String& connectionString, int openFlags)
+  : m_poolMetrics(std::make_shared<PoolMetrics>())
+  , m_invalidator(std::make_shared<ConnectionInvalidator>(m_poolMetrics))
   , m_connectionString(connectionString)
+  , m_openFlags(openFlags)
+  , m_heapAlarmThreshold(0)
 {}
 
+std::shared_ptr<ConnectionProvider> ConnectionProvider::createImmutable(const oatpp::String& filePath) {
+  return std::make_shared<ConnectionProvider>(getImmutableUri(filePath), SQLITE_OPEN_READONLY | SQLITE_OPEN_URI);
+}
+
+oatpp::String ConnectionProvider::getImmutableUri(const oatpp::String& filePath) {
+  std::string uri = "file:";
+  for(auto c : *filePath) {
+    switch(c) {
+      case '%': uri += "%25"; break;
+      case '?': uri += "%3f"; break;
+      case '#': uri += "%23"; break;
+#if defined(WIN32) || defined(_WIN32)
+      case '\\': uri += '/'; break;
+#endif
+      default: uri += c;
+    }
+  }
+  uri += "?immutable=1";
+  return uri;
+}
+
+oatpp::String ConnectionProvider::getConnectionString() const {
+  return m_connectionString;
+}
+
+int ConnectionProvider::getOpenFlags() const {
+  return m_openFlags;
+}
+
+void ConnectionProvider::registerConnection(const std::shared_ptr<ConnectionImpl>& connection) {
+  std::lock_guard<std::mutex> lock(m_connectionsMutex);
+  auto it = m_connections.begin();
+  while(it != m_connections.end()) {
+    if(it->expired()) {
+      it = m_connections.erase(it);
+    } else {
+      ++ it;
+    }
+  }
+  m_connections.push_back(connection);
+}
+
+std::list<std::shared_ptr<ConnectionImpl>> ConnectionProvider::getConnections() {
+  std::list<std::shared_ptr<ConnectionImpl>> result;
+  std::lock_guard<std::mutex> lock(m_connectionsMutex);
+  auto it = m_connections.begin();
+  while(it != m_connections.end()) {
+    auto connection = it->lock();
+    if(connection) {
+      result.push_back(connection);
+      ++ it;
+    } else {
+      it = m_connections.erase(it);
+    }
+  }
+  return result;
+}
+
 provider::ResourceHandle<Connection> ConnectionProvider::get() {
 
   sqlite3* handle;
-  auto res = sqlite3_open(m_connectionString->c_str(), &handle);
+  v_int64 openStart = oatpp::Environment::getMicroTickCount();
+  auto res = sqlite3_open_v2(m_connectionString->c_str(), &handle, m_openFlags, nullptr);
+  m_poolMetrics->recordOpen(oatpp::Environment::getMicroTickCount() - openStart, res == SQLITE_OK);
   auto connection = std::make_shared<ConnectionImpl>(handle);
 
   if(res != SQLITE_OK) {
@@ -48,6 +122,33 @@ provider::ResourceHandle<Connection> ConnectionProvider::get() {
                              "Error. Can't connect. " + errMsg);
   }
 
+  runInitHooks(handle);
+
+  registerConnection(connection);
+  checkHeapLimit();
+
+  {
+    std::lock_guard<std::mutex> lock(m_changeListenersMutex);
+    for(auto& listener : m_changeListeners) {
+      connection->addChangeListener(listener);
+    }
+  }
+
+  {
+    /* connection is registered - handler set concurrently by setBusyHandler() can't be overwritten by a stale one */
+    std::lock_guard<std::mutex> lock(m_busyHandlerMutex);
+    if(m_busyHandler) {
+      connection->setBusyHandler(m_busyHandler);
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_authorizerMutex);
+    if(m_authorizer) {
+      connection->setAuthorizer(m_authorizer);
+    }
+  }
+
   return provider::ResourceHandle<Connection>(connection, m_invalidator);
 
 }
@@ -60,4 +161,282 @@ void ConnectionProvider::stop() {
   // DO nothing
 }
 
+ConnectionProvider::MemoryStats ConnectionProvider::getMemoryStats() {
+
+  MemoryStats stats;
+  stats.connectionsCount = 0;
+  stats.idleConnectionsCount = 0;
+  stats.cacheUsed = 0;
+  stats.idleCacheUsed = 0;
+
+  for(auto& connection : getConnections()) {
+    auto cacheUsed = connection->getCacheUsed();
+    stats.connectionsCount ++;
+    stats.cacheUsed += cacheUsed;
+    if(connection->isIdle()) {
+      stats.idleConnectionsCount ++;
+      stats.idleCacheUsed += cacheUsed;
+    }
+  }
+
+  stats.heapUsed = sqlite3_memory_used();
+  stats.softHeapLimit = sqlite3_soft_heap_limit64(-1);
+
+  return stats;
+
+}
+
+v_int64 ConnectionProvider::releaseIdleMemory(const std::chrono::duration<v_int64, std::micro>& minIdleTime) {
+
+  bool underPressure = checkHeapLimit();
+  v_int64 now = oatpp::Environment::getMicroTickCount();
+  v_int64 freed = 0;
+
+  for(auto& connection : getConnections()) {
+    /* connection might be acquired right after this check - SQLite serializes access to the connection */
+    auto idleSince = connection->getIdleSince();
+    if(idleSince >= 0 && (underPressure || now - idleSince >= minIdleTime.count())) {
+      freed += connection->releaseMemory();
+    }
+  }
+
+  return freed;
+
+}
+
+void ConnectionProvider::setSoftHeapLimit(v_int64 limit, v_float64 alarmThreshold, const HeapAlarmCallback& callback) {
+  sqlite3_soft_heap_limit64(limit);
+  std::lock_guard<std::mutex> lock(m_heapAlarmMutex);
+  m_heapAlarmThreshold = alarmThreshold;
+  m_heapAlarmCallback = callback;
+}
+
+bool ConnectionProvider::checkHeapLimit() {
+
+  auto limit = sqlite3_soft_heap_limit64(-1);
+  if(limit <= 0) {
+    return false;
+  }
+
+  HeapAlarmCallback callback;
+  v_float64 threshold;
+  {
+    std::lock_guard<std::mutex> lock(m_heapAlarmMutex);
+    callback = m_heapAlarmCallback;
+    threshold = m_heapAlarmThreshold;
+  }
+
+  auto used = sqlite3_memory_used();
+  if(used < (v_int64)(limit * threshold)) {
+    return false;
+  }
+
+  if(callback) {
+    callback(used, limit);
+  }
+
+  return true;
+
+}
+
+void ConnectionProvider::addChangeListener(const std::shared_ptr<Connection::ChangeListener>& listener) {
+  {
+    std::lock_guard<std::mutex> lock(m_changeListenersMutex);
+    for(auto& l : m_changeListeners) {
+      if(l == listener) {
+        return;
+      }
+    }
+    m_changeListeners.push_back(listener);
+  }
+  for(auto& connection : getConnections()) {
+    connection->addChangeListener(listener);
+  }
+}
+
+void ConnectionProvider::removeChangeListener(const std::shared_ptr<Connection::ChangeListener>& listener) {
+  {
+    std::lock_guard<std::mutex> lock(m_changeListenersMutex);
+    for(auto it = m_changeListeners.begin(); it != m_changeListeners.end(); ++ it) {
+      if(*it == listener) {
+        m_changeListeners.erase(it);
+        break;
+      }
+    }
+  }
+  for(auto& connection : getConnections()) {
+    connection->removeChangeListener(listener);
+  }
+}
+
+void ConnectionProvider::setBusyHandler(const std::shared_ptr<BusyHandler>& handler) {
+  std::lock_guard<std::mutex> lock(m_busyHandlerMutex);
+  m_busyHandler = handler;
+  for(auto& connection : getConnections()) {
+    connection->setBusyHandler(handler);
+  }
+}
+
+std::shared_ptr<BusyHandler> ConnectionProvider::getBusyHandler() {
+  std::lock_guard<std::mutex> lock(m_busyHandlerMutex);
+  return m_busyHandler;
+}
+
+void ConnectionProvider::setAuthorizer(const Connection::Authorizer& authorizer) {
+  std::lock_guard<std::mutex> lock(m_authorizerMutex);
+  m_authorizer = authorizer;
+  for(auto& connection : getConnections()) {
+    connection->setAuthorizer(authorizer);
+  }
+}
+
+int ConnectionProvider::onCollationCompare(void* data, int aSize, const void* a, int bSize, const void* b) {
+  auto collation = static_cast<Collation*>(data);
+  return (*collation)(static_cast<const char*>(a), aSize, static_cast<const char*>(b), bSize);
+}
+
+void ConnectionProvider::onCollationDestroy(void* data) {
+  delete static_cast<Collation*>(data);
+}
+
+void ConnectionProvider::runInitHooks(sqlite3* handle) {
+
+  std::vector<std::shared_ptr<InitHookEntry>> hooks;
+  {
+    std::lock_guard<std::mutex> lock(m_initHooksMutex);
+    hooks = m_initHooks;
+  }
+
+  for(auto& entry : hooks) {
+
+    v_int64 startTime = oatpp::Environment::getMicroTickCount();
+    bool success = false;
+    std::string errorMessage;
+
+    try {
+      entry->hook(handle);
+      success = true;
+    } catch (std::exception& e) {
+      errorMessage = e.what();
+    }
+
+    v_int64 time = oatpp::Environment::getMicroTickCount() - startTime;
+    entry->runsCount ++;
+    entry->totalTime += time;
+    v_int64 max = entry->maxTime.load();
+    while(time > max && !entry->maxTime.compare_exchange_weak(max, time)) {}
+
+    if(!success) {
+      entry->failuresCount ++;
+      throw std::runtime_error("[oatpp::sqlite::ConnectionProvider::runInitHooks()]: "
+                               "Error. Init hook '" + *entry->name + "' failed. " + errorMessage);
+    }
+
+  }
+
+}
+
+void ConnectionProvider::addInitHook(const oatpp::String& name, const InitHook& hook) {
+  auto entry = std::make_shared<InitHookEntry>();
+  entry->name = name;
+  entry->hook = hook;
+  entry->runsCount = 0;
+  entry->failuresCount = 0;
+  entry->totalTime = 0;
+  entry->maxTime = 0;
+  std::lock_guard<std::mutex> lock(m_initHooksMutex);
+  m_initHooks.push_back(entry);
+}
+
+void ConnectionProvider::addFunction(const std::shared_ptr<Function>& function) {
+  addInitHook("function:" + function->getName(), [function](sqlite3* handle) {
+    function->install(handle);
+  });
+}
+
+void ConnectionProvider::addVirtualTable(const std::shared_ptr<VirtualTable>& table) {
+  addInitHook("vtab:" + table->getName(), [table](sqlite3* handle) {
+    table->install(handle);
+  });
+}
+
+void ConnectionProvider::addEmbeddingFunctions() {
+  addInitHook("embedding_functions", &EmbeddingFunctions::install);
+}
+
+void ConnectionProvider::addCollation(const oatpp::String& name, const Collation& collation) {
+  addInitHook("collation:" + name, [name, collation](sqlite3* handle) {
+    auto data = new Collation(collation);
+    auto res = sqlite3_create_collation_v2(handle, name->c_str(), SQLITE_UTF8, data,
+                                           &onCollationCompare, &onCollationDestroy);
+    if(res != SQLITE_OK) {
+      /* destructor is not called if sqlite3_create_collation_v2 fails */
+      delete data;
+      throw std::runtime_error("Can't create collation. " + std::string(sqlite3_errmsg(handle)));
+    }
+  });
+}
+
+void ConnectionProvider::addExtension(const oatpp::String& path, const oatpp::String& entryPoint) {
+  addInitHook("extension:" + path, [path, entryPoint](sqlite3* handle) {
+    sqlite3_db_config(handle, SQLITE_DBCONFIG_ENABLE_LOAD_EXTENSION, 1, nullptr);
+    char* errMsg = nullptr;
+    auto res = sqlite3_load_extension(handle, path->c_str(), entryPoint ? entryPoint->c_str() : nullptr, &errMsg);
+    sqlite3_db_config(handle, SQLITE_DBCONFIG_ENABLE_LOAD_EXTENSION, 0, nullptr);
+    if(res != SQLITE_OK) {
+      std::string message = errMsg ? errMsg : sqlite3_errstr(res);
+      sqlite3_free(errMsg);
+      throw std::runtime_error("Can't load extension. " + message);
+    }
+  });
+}
+
+void ConnectionProvider::addAttachedDatabase(const oatpp::String& fileName, const oatpp::String& schemaName) {
+  addInitHook("attach:" + schemaName, [fileName, schemaName](sqlite3* handle) {
+    sqlite3_stmt* stmt = nullptr;
+    auto res = sqlite3_prepare_v2(handle, "ATTACH DATABASE ? AS ?", -1, &stmt, nullptr);
+    if(res == SQLITE_OK) {
+      sqlite3_bind_text(stmt, 1, fileName->c_str(), fileName->size(), SQLITE_TRANSIENT);
+      sqlite3_bind_text(stmt, 2, schemaName->c_str(), schemaName->size(), SQLITE_TRANSIENT);
+      res = sqlite3_step(stmt);
+    }
+    sqlite3_finalize(stmt);
+    if(res != SQLITE_DONE) {
+      throw std::runtime_error("Can't attach database. " + std::string(sqlite3_errmsg(handle)));
+    }
+  });
+}
+
+std::vector<ConnectionProvider::InitHookStats> ConnectionProvider::getInitHookStats() {
+  std::vector<InitHookStats> result;
+  std::lock_guard<std::mutex> lock(m_initHooksMutex);
+  for(auto& entry : m_initHooks) {
+    InitHookStats stats;
+    stats.name = entry->name;
+    stats.runsCount = entry->runsCount;
+    stats.failuresCount = entry->failuresCount;
+    stats.totalTime = entry->totalTime;
+    stats.maxTime = entry->maxTime;
+    result.push_back(stats);
+  }
+  return result;
+}
+
+std::shared_ptr<PoolMetrics> ConnectionProvider::getPoolMetrics() const {
+  return m_poolMetrics;
+}
+
+PoolMetrics::Snapshot ConnectionProvider::getPoolStats() {
+  auto stats = m_poolMetrics->getSnapshot();
+  for(auto& connection : getConnections()) {
+    stats.connectionsCount ++;
+    if(connection->isIdle()) {
+      stats.idleCount ++;
+    } else {
+      stats.activeCount ++;
+    }
+  }
+  return stats;
+}
+
 }}
@@ -26,26 +26,188 @@
 #define oatpp_sqlite_ConnectionProvider_hpp
 
 #include "Connection.hpp"
+#include "EmbeddingFunctions.hpp"
+#include "Function.hpp"
+#include "PoolMetrics.hpp"
+#include "VirtualTable.hpp"
 
 #include "oatpp/provider/Pool.hpp"
 #include "oatpp/Types.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <list>
+#include <mutex>
+
 namespace oatpp { namespace sqlite {
 
+/**
+ * Interface of connection providers whose connections may point to different databases,
+ * or to different versions of the database over time (ex.: tenants, hot-swapped files). <br>
+ * &id:oatpp::sqlite::Executor; shares results (result cache, request coalescing) only between queries of the same scope.
+ */
+class DatabaseScopeProvider {
+public:
+
+  /**
+   * Default virtual destructor.
+   */
+  virtual ~DatabaseScopeProvider() = default;
+
+  /**
+   * Get scope of the database a connection requested by the calling thread would be connected to now.
+   * @return - scope. Results of queries of different scopes are never shared.
+   */
+  virtual oatpp::String getDatabaseScope() = 0;
+
+};
+
 /**
  * Connection provider.
  */
 class ConnectionProvider : public provider::Provider<Connection> {
+public:
+
+  /**
+   * Memory usage of connections opened by this provider.
+   */
+  struct MemoryStats {
+
+    /**
+     * Number of open connections.
+     */
+    v_int64 connectionsCount;
+
+    /**
+     * Number of idle connections (sitting in the pool).
+     */
+    v_int64 idleConnectionsCount;
+
+    /**
+     * Bytes used by the page caches of all open connections.
+     */
+    v_int64 cacheUsed;
+
+    /**
+     * Bytes used by the page caches of idle connections.
+     */
+    v_int64 idleCacheUsed;
+
+    /**
+     * Bytes of heap memory currently used by SQLite (process-wide).
+     */
+    v_int64 heapUsed;
+
+    /**
+     * Current SQLite soft heap limit (process-wide). `0` - no limit.
+     */
+    v_int64 softHeapLimit;
+
+  };
+
+  /**
+   * Callback called when SQLite heap usage approaches the soft heap limit. <br>
+   * Arguments are `heapUsed` and `softHeapLimit`.
+   */
+  typedef std::function<void(v_int64, v_int64)> HeapAlarmCallback;
+
+  /**
+   * Hook initializing a new connection - ex.: registering functions, collations or attaching databases. <br>
+   * Throw to fail the connection.
+   */
+  typedef std::function<void(sqlite3* handle)> InitHook;
+
+  /**
+   * Collation function. Arguments are UTF-8 strings with their sizes in bytes. <br>
+   * Returns negative, zero or positive number if the first string is less than, equal to or greater than the second one.
+   */
+  typedef std::function<int(const char* a, v_int32 aSize, const char* b, v_int32 bSize)> Collation;
+
+  /**
+   * Stats of the &l:ConnectionProvider::InitHook;.
+   */
+  struct InitHookStats {
+
+    /**
+     * Hook name.
+     */
+    oatpp::String name;
+
+    /**
+     * Number of runs.
+     */
+    v_int64 runsCount;
+
+    /**
+     * Number of runs which threw.
+     */
+    v_int64 failuresCount;
+
+    /**
+     * Total run time in microseconds.
+     */
+    v_int64 totalTime;
+
+    /**
+     * Max run time in microseconds.
+     */
+    v_int64 maxTime;
+
+  };
+
+private:
+
+  struct InitHookEntry {
+    oatpp::String name;
+    InitHook hook;
+    std::atomic<v_int64> runsCount;
+    std::atomic<v_int64> failuresCount;
+    std::atomic<v_int64> totalTime;
+    std::atomic<v_int64> maxTime;
+  };
+
+private:
+  static int onCollationCompare(void* data, int aSize, const void* a, int bSize, const void* b);
+  static void onCollationDestroy(void* data);
 private:
 
   class ConnectionInvalidator : public provider::Invalidator<Connection> {
+  private:
+    std::shared_ptr<PoolMetrics> m_metrics;
   public:
+    ConnectionInvalidator(const std::shared_ptr<PoolMetrics>& metrics);
     void invalidate(const std::shared_ptr<Connection>& connection) override;
   };
 
 private:
+  std::shared_ptr<PoolMetrics> m_poolMetrics;
   std::shared_ptr<ConnectionInvalidator> m_invalidator;
   oatpp::String m_connectionString;
+  int m_openFlags;
+private:
+  std::mutex m_connectionsMutex;
+  std::list<std::weak_ptr<ConnectionImpl>> m_connections;
+private:
+  std::mutex m_heapAlarmMutex;
+  v_float64 m_heapAlarmThreshold;
+  HeapAlarmCallback m_heapAlarmCallback;
+private:
+  std::mutex m_changeListenersMutex;
+  std::vector<std::shared_ptr<Connection::ChangeListener>> m_changeListeners;
+private:
+  std::mutex m_busyHandlerMutex;
+  std::shared_ptr<BusyHandler> m_busyHandler;
+private:
+  std::mutex m_authorizerMutex;
+  Connection::Authorizer m_authorizer;
+private:
+  std::mutex m_initHooksMutex;
+  std::vector<std::shared_ptr<InitHookEntry>> m_initHooks;
+private:
+  void runInitHooks(sqlite3* handle);
+  void registerConnection(const std::shared_ptr<ConnectionImpl>& connection);
+  std::list<std::shared_ptr<ConnectionImpl>> getConnections();
 public:
 
   /**
@@ -54,6 +216,44 @@ public:
    */
   ConnectionProvider(const oatpp::String& connectionString);
 
+  /**
+   * Constructor.
+   * @param connectionString - file name or URI (with `SQLITE_OPEN_URI` flag).
+   * @param openFlags - flags for `sqlite3_open_v2`. Ex.: `SQLITE_OPEN_READONLY | SQLITE_OPEN_URI`.
+   */
+  ConnectionProvider(const oatpp::String& connectionString, int openFlags);
+
+  /**
+   * Create provider of immutable connections. <br>
+   * Database is opened read-only with the `immutable=1` URI parameter - SQLite skips file locking and
+   * change detection on every read transaction. <br>
+   * &id:oatpp::sqlite::Executor; rejects writes to read-only connections up front and doesn't create
+   * the schema version table. <br>
+   * *Note:* the file must not be modified while it is open in immutable mode - readers may get wrong results or errors.
+   * @param filePath - path to the database file.
+   * @return - `std::shared_ptr` to &l:ConnectionProvider;.
+   */
+  static std::shared_ptr<ConnectionProvider> createImmutable(const oatpp::String& filePath);
+
+  /**
+   * Get `file:` URI opening the database in immutable mode. Use with `SQLITE_OPEN_READONLY | SQLITE_OPEN_URI` flags.
+   * @param filePath - path to the database file.
+   * @return - URI.
+   */
+  static oatpp::String getImmutableUri(const oatpp::String& filePath);
+
+  /**
+   * Get connection string.
+   * @return
+   */
+  oatpp::String getConnectionString() const;
+
+  /**
+   * Get flags connections are opened with.
+   * @return
+   */
+  int getOpenFlags() const;
+
   /**
    * Get Connection.
    * @return - resource.
@@ -71,6 +271,145 @@ public:
    */
   void stop() override;
 
+  /**
+   * Get memory usage of connections opened by this provider.
+   * @return - &l:ConnectionProvider::MemoryStats;.
+   */
+  MemoryStats getMemoryStats();
+
+  /**
+   * Release page cache memory of connections which are idle for at least `minIdleTime`. <br>
+   * If SQLite heap usage is above the soft heap limit alarm threshold, memory of all idle connections is released
+   * regardless of `minIdleTime`. <br>
+   * Call it periodically (ex.: from a timer) to keep memory flat after traffic spikes.
+   * @param minIdleTime - minimum time connection should sit in the pool before its memory is released.
+   * @return - number of bytes freed.
+   */
+  v_int64 releaseIdleMemory(const std::chrono::duration<v_int64, std::micro>& minIdleTime = std::chrono::microseconds::zero());
+
+  /**
+   * Set process-wide SQLite soft heap limit. <br>
+   * Uses `sqlite3_soft_heap_limit64`.
+   * @param limit - soft heap limit in bytes. `0` - no limit.
+   * @param alarmThreshold - fraction of the limit at which `callback` is called. Ex.: `0.9`.
+   * @param callback - &l:ConnectionProvider::HeapAlarmCallback;. Called from &l:ConnectionProvider::get (); and
+   * &l:ConnectionProvider::releaseIdleMemory (); when the heap usage is above the alarm threshold.
+   */
+  void setSoftHeapLimit(v_int64 limit, v_float64 alarmThreshold = 0.9, const HeapAlarmCallback& callback = nullptr);
+
+  /**
+   * Check if SQLite heap usage is above the soft heap limit alarm threshold. Calls alarm callback if so.
+   * @return - `true` if heap usage is above the alarm threshold.
+   */
+  bool checkHeapLimit();
+
+  /**
+   * Add &id:oatpp::sqlite::Connection::ChangeListener; to all connections opened by this provider -
+   * both already open and opened in future. <br>
+   * Ex.: &id:oatpp::sqlite::ChangeFeed;.
+   * @param listener
+   */
+  void addChangeListener(const std::shared_ptr<Connection::ChangeListener>& listener);
+
+  /**
+   * Remove &id:oatpp::sqlite::Connection::ChangeListener; from all connections opened by this provider.
+   * @param listener
+   */
+  void removeChangeListener(const std::shared_ptr<Connection::ChangeListener>& listener);
+
+  /**
+   * Set &id:oatpp::sqlite::BusyHandler; installed on all connections opened by this provider -
+   * both already open and opened in future. <br>
+   * Without busy handler a statement fails with `SQLITE_BUSY` right away if the database is locked.
+   * @param handler - busy handler. `nullptr` - remove handler.
+   */
+  void setBusyHandler(const std::shared_ptr<BusyHandler>& handler);
+
+  /**
+   * Get busy handler.
+   * @return - &id:oatpp::sqlite::BusyHandler; or `nullptr`.
+   */
+  std::shared_ptr<BusyHandler> getBusyHandler();
+
+  /**
+   * Set &id:oatpp::sqlite::Connection::Authorizer; installed on all connections opened by this provider -
+   * both already open and opened in future. See &id:oatpp::sqlite::Connection::setAuthorizer ();. <br>
+   * *Use this method instead of calling `sqlite3_set_authorizer` in an init hook.*
+   * @param authorizer - authorizer. `nullptr` - remove authorizer.
+   */
+  void setAuthorizer(const Connection::Authorizer& authorizer);
+
+  /**
+   * Add hook run once on each new connection opened by this provider, before the connection is returned. <br>
+   * Hooks are run in the order they were added. Connections which are already open are not affected -
+   * add hooks before the provider is used. <br>
+   * *Authorizer of the connection is owned by the connection - set it with &l:ConnectionProvider::setAuthorizer ();.*
+   * @param name - hook name - for stats and error messages.
+   * @param hook - &l:ConnectionProvider::InitHook;.
+   */
+  void addInitHook(const oatpp::String& name, const InitHook& hook);
+
+  /**
+   * Register SQL function on each new connection. See &l:ConnectionProvider::addInitHook ();.
+   * @param function - &id:oatpp::sqlite::Function;. Ex.: &id:oatpp::sqlite::ScalarFunction;, &id:oatpp::sqlite::AggregateFunction;.
+   */
+  void addFunction(const std::shared_ptr<Function>& function);
+
+  /**
+   * Register virtual table module on each new connection. See &l:ConnectionProvider::addInitHook ();. <br>
+   * The table is eponymous - it is available in SQL by its name without `CREATE VIRTUAL TABLE`.
+   * @param table - &id:oatpp::sqlite::VirtualTable;.
+   */
+  void addVirtualTable(const std::shared_ptr<VirtualTable>& table);
+
+  /**
+   * Register embedding SQL functions on each new connection - `vec_dot`, `vec_cosine`, `vec_l2`.
+   * See &id:oatpp::sqlite::EmbeddingFunctions;.
+   */
+  void addEmbeddingFunctions();
+
+  /**
+   * Register collation on each new connection. See &l:ConnectionProvider::addInitHook ();.
+   * @param name - collation name. Ex.: `ORDER BY f_name COLLATE <name>`.
+   * @param collation - &l:ConnectionProvider::Collation;.
+   */
+  void addCollation(const oatpp::String& name, const Collation& collation);
+
+  /**
+   * Load SQLite extension on each new connection. See &l:ConnectionProvider::addInitHook ();. <br>
+   * Loading is enabled for the C API only while the extension is loaded - SQL `load_extension()` stays disabled.
+   * @param path - path to the shared library.
+   * @param entryPoint - name of the entry point. `nullptr` - let SQLite guess it.
+   */
+  void addExtension(const oatpp::String& path, const oatpp::String& entryPoint = nullptr);
+
+  /**
+   * Attach database on each new connection. See &l:ConnectionProvider::addInitHook ();.
+   * @param fileName - database file name or URI.
+   * @param schemaName - schema name. Ex.: `SELECT * FROM <schemaName>.<table>`.
+   */
+  void addAttachedDatabase(const oatpp::String& fileName, const oatpp::String& schemaName);
+
+  /**
+   * Get stats of init hooks.
+   * @return - &l:ConnectionProvider::InitHookStats; in the order the hooks are run.
+   */
+  std::vector<InitHookStats> getInitHookStats();
+
+  /**
+   * Get pool metrics of this provider. <br>
+   * Open latency and connection churn are recorded by the provider. To record acquisition wait time pass
+   * the metrics to &id:oatpp::sqlite::Executor::setPoolMetrics;.
+   * @return - &id:oatpp::sqlite::PoolMetrics;.
+   */
+  std::shared_ptr<PoolMetrics> getPoolMetrics() const;
+
+  /**
+   * Get snapshot of pool metrics together with current counts of active and idle connections.
+   * @return - &id:oatpp::sqlite::PoolMetrics::Snapshot;.
+   */
+  PoolMetrics::Snapshot getPoolStats();
+
 };
 
 /**
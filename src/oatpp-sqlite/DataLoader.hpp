@@ -0,0 +1,329 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef oatpp_sqlite_DataLoader_hpp
+#define oatpp_sqlite_DataLoader_hpp
+
+#include "oatpp/json/ObjectMapper.hpp"
+#include "oatpp/Types.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace oatpp { namespace sqlite {
+
+/**
+ * Batched key lookups. <br>
+ * Collects single-key lookups and resolves them with one query - turns N round-trips into one. <br>
+ * Keys are passed to the batch function as a vector. Use &l:DataLoader::toJsonArray (); to pass them
+ * to a single query parameter and expand them with `json_each`:
+ * ```cpp
+ * QUERY(getUsersByIds,
+ *       "SELECT * FROM users WHERE id IN (SELECT value FROM json_each(:ids))",
+ *       PARAM(String, ids))
+ * ```
+ * ```cpp
+ * typedef oatpp::sqlite::DataLoader<oatpp::Int64, oatpp::Object<UserDto>> UserLoader;
+ * UserLoader loader([&](const oatpp::Vector<oatpp::Int64>& ids) {
+ *   return client.getUsersByIds(UserLoader::toJsonArray(ids))->fetch<oatpp::Vector<oatpp::Object<UserDto>>>();
+ * }, [](const oatpp::Object<UserDto>& user) {
+ *   return user->id;
+ * });
+ *
+ * for(auto& post : posts) {
+ *   authors.push_back(loader.load(post->authorId));
+ * }
+ * loader.dispatch(); // one query for all authors
+ * ```
+ * Loaded rows are memoized by key until &l:DataLoader::clear (); - create a loader per request (scope)
+ * to avoid serving stale data.
+ * @tparam Key - key type. Ex.: `oatpp::Int64`, `oatpp::String`.
+ * @tparam Row - row type. Ex.: `oatpp::Object<UserDto>`.
+ */
+template<class Key, class Row>
+class DataLoader {
+public:
+
+  /**
+   * Function loading rows for the batch of keys. Returned rows may come in any order.
+   */
+  typedef std::function<oatpp::Vector<Row>(const oatpp::Vector<Key>& keys)> BatchFunction;
+
+  /**
+   * Function extracting key from the loaded row.
+   */
+  typedef std::function<Key(const Row& row)> KeyFunction;
+
+  /**
+   * Loader config.
+   */
+  struct Config {
+
+    /**
+     * Max number of keys in one batch. When reached - the batch is dispatched immediately.
+     */
+    v_int64 maxBatchSize = 500;
+
+    /**
+     * Batching window. <br>
+     * If zero - batches are dispatched only by &l:DataLoader::dispatch (); or when the batch is full. <br>
+     * If non-zero - a batch is dispatched by the loader thread once `window` has passed since its first key,
+     * so lookups from concurrent threads are batched together.
+     */
+    std::chrono::microseconds window = std::chrono::microseconds::zero();
+
+  };
+
+private:
+
+  struct Batch {
+    oatpp::Vector<Key> keys = oatpp::Vector<Key>::createShared();
+    std::unordered_map<Key, std::shared_ptr<std::promise<Row>>> promises;
+    std::chrono::steady_clock::time_point startTime;
+  };
+
+private:
+
+  void dispatchBatch(const std::shared_ptr<Batch>& batch) {
+
+    oatpp::Vector<Row> rows;
+
+    try {
+      rows = m_batchFunction(batch->keys);
+    } catch (...) {
+      auto e = std::current_exception();
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for(auto& p : batch->promises) {
+          m_loaded.erase(p.first);
+        }
+      }
+      for(auto& p : batch->promises) {
+        p.second->set_exception(e);
+      }
+      return;
+    }
+
+    std::unordered_map<Key, Row> found;
+    if(rows) {
+      for(auto& row : *rows) {
+        found[m_keyFunction(row)] = row;
+      }
+    }
+
+    for(auto& p : batch->promises) {
+      auto it = found.find(p.first);
+      if(it != found.end()) {
+        p.second->set_value(it->second);
+      } else {
+        p.second->set_value(nullptr);
+      }
+    }
+
+  }
+
+  std::shared_ptr<Batch> takeBatch() {
+    auto batch = m_batch;
+    m_batch = nullptr;
+    return batch;
+  }
+
+  void run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while(m_running) {
+      if(!m_batch) {
+        m_condition.wait(lock);
+        continue;
+      }
+      auto deadline = m_batch->startTime + m_config.window;
+      if(std::chrono::steady_clock::now() < deadline) {
+        m_condition.wait_until(lock, deadline);
+        continue;
+      }
+      auto batch = takeBatch();
+      lock.unlock();
+      dispatchBatch(batch);
+      lock.lock();
+    }
+  }
+
+private:
+  Config m_config;
+  BatchFunction m_batchFunction;
+  KeyFunction m_keyFunction;
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  std::shared_ptr<Batch> m_batch;
+  std::unordered_map<Key, std::shared_future<Row>> m_loaded;
+  bool m_running;
+  std::thread m_thread;
+public:
+
+  /**
+   * Constructor.
+   * @param batchFunction - &l:DataLoader::BatchFunction;.
+   * @param keyFunction - &l:DataLoader::KeyFunction;.
+   * @param config - &l:DataLoader::Config;.
+   */
+  DataLoader(const BatchFunction& batchFunction, const KeyFunction& keyFunction, const Config& config)
+    : m_config(config)
+    , m_batchFunction(batchFunction)
+    , m_keyFunction(keyFunction)
+    , m_running(true)
+  {
+    if(m_config.window.count() > 0) {
+      m_thread = std::thread([this]{
+        run();
+      });
+    }
+  }
+
+  /**
+   * Constructor with default config.
+   * @param batchFunction - &l:DataLoader::BatchFunction;.
+   * @param keyFunction - &l:DataLoader::KeyFunction;.
+   */
+  DataLoader(const BatchFunction& batchFunction, const KeyFunction& keyFunction)
+    : DataLoader(batchFunction, keyFunction, Config())
+  {}
+
+  /**
+   * Non-virtual destructor. Dispatches pending keys.
+   */
+  ~DataLoader() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_running = false;
+    }
+    m_condition.notify_all();
+    if(m_thread.joinable()) {
+      m_thread.join();
+    }
+    dispatch();
+  }
+
+  /**
+   * Schedule lookup of the key. <br>
+   * Repeated lookups of the same key share the same result.
+   * @param key
+   * @return - future row. `nullptr` row if not found.
+   */
+  std::shared_future<Row> load(const Key& key) {
+
+    std::shared_ptr<Batch> fullBatch;
+    std::shared_future<Row> result;
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      auto it = m_loaded.find(key);
+      if(it != m_loaded.end()) {
+        return it->second;
+      }
+
+      if(!m_batch) {
+        m_batch = std::make_shared<Batch>();
+        m_batch->startTime = std::chrono::steady_clock::now();
+        m_condition.notify_all();
+      }
+
+      auto promise = std::make_shared<std::promise<Row>>();
+      result = promise->get_future().share();
+      m_batch->keys->push_back(key);
+      m_batch->promises.insert({key, promise});
+      m_loaded.insert({key, result});
+
+      if((v_int64) m_batch->keys->size() >= m_config.maxBatchSize) {
+        fullBatch = takeBatch();
+      }
+    }
+
+    if(fullBatch) {
+      dispatchBatch(fullBatch);
+    }
+
+    return result;
+
+  }
+
+  /**
+   * Load the key - dispatch pending keys and wait for the row.
+   * @param key
+   * @return - row or `nullptr` if not found.
+   */
+  Row get(const Key& key) {
+    auto result = load(key);
+    dispatch();
+    return result.get();
+  }
+
+  /**
+   * Dispatch pending keys now - in the calling thread.
+   */
+  void dispatch() {
+    std::shared_ptr<Batch> batch;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      batch = takeBatch();
+    }
+    if(batch) {
+      dispatchBatch(batch);
+    }
+  }
+
+  /**
+   * Forget loaded rows. Pending keys are not affected.
+   */
+  void clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_loaded.begin();
+    while(it != m_loaded.end()) {
+      if(m_batch && m_batch->promises.find(it->first) != m_batch->promises.end()) {
+        ++ it;
+      } else {
+        it = m_loaded.erase(it);
+      }
+    }
+  }
+
+  /**
+   * Serialize keys to JSON array - to pass them to a query as a single parameter.
+   * @param keys
+   * @return - JSON array. Ex.: `[1,2,3]`.
+   */
+  static oatpp::String toJsonArray(const oatpp::Vector<Key>& keys) {
+    static json::ObjectMapper mapper;
+    return mapper.writeToString(keys);
+  }
+
+};
+
+}}
+
+#endif // oatpp_sqlite_DataLoader_hpp
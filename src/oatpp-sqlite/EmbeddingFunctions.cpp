@@ -0,0 +1,228 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#include "EmbeddingFunctions.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace oatpp { namespace sqlite {
+
+namespace {
+
+  thread_local std::vector<v_float32> alignedA;
+  thread_local std::vector<v_float32> alignedB;
+
+  /* column values point into the page buffer and may be misaligned for float loads */
+  const v_float32* getAligned(const void* data, v_buff_size size, std::vector<v_float32>& buffer) {
+    if(reinterpret_cast<std::uintptr_t>(data) % alignof(v_float32) == 0) {
+      return static_cast<const v_float32*>(data);
+    }
+    buffer.resize(size);
+    std::memcpy(buffer.data(), data, size * sizeof(v_float32));
+    return buffer.data();
+  }
+
+}
+
+bool EmbeddingFunctions::readArgs(sqlite3_context* context, sqlite3_value** argv,
+                                  const v_float32** a, const v_float32** b, v_buff_size& size)
+{
+
+  if(sqlite3_value_type(argv[0]) == SQLITE_NULL || sqlite3_value_type(argv[1]) == SQLITE_NULL) {
+    sqlite3_result_null(context);
+    return false;
+  }
+
+  if(sqlite3_value_type(argv[0]) != SQLITE_BLOB || sqlite3_value_type(argv[1]) != SQLITE_BLOB) {
+    sqlite3_result_error(context, "[oatpp::sqlite::EmbeddingFunctions]: Error. Arguments must be BLOBs.", -1);
+    return false;
+  }
+
+  auto dataA = sqlite3_value_blob(argv[0]);
+  auto bytesA = sqlite3_value_bytes(argv[0]);
+  auto dataB = sqlite3_value_blob(argv[1]);
+  auto bytesB = sqlite3_value_bytes(argv[1]);
+
+  if(bytesA != bytesB || bytesA % sizeof(v_float32) != 0) {
+    sqlite3_result_error(context, "[oatpp::sqlite::EmbeddingFunctions]: Error. Embeddings sizes don't match.", -1);
+    return false;
+  }
+
+  size = bytesA / sizeof(v_float32);
+  *a = getAligned(dataA, size, alignedA);
+  *b = getAligned(dataB, size, alignedB);
+
+  return true;
+
+}
+
+void EmbeddingFunctions::onDot(sqlite3_context* context, int argc, sqlite3_value** argv) {
+  (void) argc;
+  const v_float32* a;
+  const v_float32* b;
+  v_buff_size size;
+  if(readArgs(context, argv, &a, &b, size)) {
+    sqlite3_result_double(context, dot(a, b, size));
+  }
+}
+
+void EmbeddingFunctions::onCosine(sqlite3_context* context, int argc, sqlite3_value** argv) {
+  (void) argc;
+  const v_float32* a;
+  const v_float32* b;
+  v_buff_size size;
+  if(readArgs(context, argv, &a, &b, size)) {
+    auto result = cosine(a, b, size);
+    if(std::isnan(result)) {
+      sqlite3_result_null(context);
+    } else {
+      sqlite3_result_double(context, result);
+    }
+  }
+}
+
+void EmbeddingFunctions::onL2(sqlite3_context* context, int argc, sqlite3_value** argv) {
+  (void) argc;
+  const v_float32* a;
+  const v_float32* b;
+  v_buff_size size;
+  if(readArgs(context, argv, &a, &b, size)) {
+    sqlite3_result_double(context, l2(a, b, size));
+  }
+}
+
+v_float64 EmbeddingFunctions::dot(const v_float32* a, const v_float32* b, v_buff_size size) {
+
+  v_float32 acc[LANES] = {};
+
+  v_buff_size i = 0;
+  for(; i + LANES <= size; i += LANES) {
+    for(v_int32 j = 0; j < LANES; j ++) {
+      acc[j] += a[i + j] * b[i + j];
+    }
+  }
+
+  v_float64 result = 0;
+  for(v_int32 j = 0; j < LANES; j ++) {
+    result += acc[j];
+  }
+  for(; i < size; i ++) {
+    result += (v_float64) a[i] * b[i];
+  }
+
+  return result;
+
+}
+
+v_float64 EmbeddingFunctions::cosine(const v_float32* a, const v_float32* b, v_buff_size size) {
+
+  v_float32 accAB[LANES] = {};
+  v_float32 accAA[LANES] = {};
+  v_float32 accBB[LANES] = {};
+
+  v_buff_size i = 0;
+  for(; i + LANES <= size; i += LANES) {
+    for(v_int32 j = 0; j < LANES; j ++) {
+      accAB[j] += a[i + j] * b[i + j];
+      accAA[j] += a[i + j] * a[i + j];
+      accBB[j] += b[i + j] * b[i + j];
+    }
+  }
+
+  v_float64 ab = 0;
+  v_float64 aa = 0;
+  v_float64 bb = 0;
+  for(v_int32 j = 0; j < LANES; j ++) {
+    ab += accAB[j];
+    aa += accAA[j];
+    bb += accBB[j];
+  }
+  for(; i < size; i ++) {
+    ab += (v_float64) a[i] * b[i];
+    aa += (v_float64) a[i] * a[i];
+    bb += (v_float64) b[i] * b[i];
+  }
+
+  if(aa == 0 || bb == 0) {
+    return std::nan("");
+  }
+
+  return ab / std::sqrt(aa * bb);
+
+}
+
+v_float64 EmbeddingFunctions::l2(const v_float32* a, const v_float32* b, v_buff_size size) {
+
+  v_float32 acc[LANES] = {};
+
+  v_buff_size i = 0;
+  for(; i + LANES <= size; i += LANES) {
+    for(v_int32 j = 0; j < LANES; j ++) {
+      v_float32 d = a[i + j] - b[i + j];
+      acc[j] += d * d;
+    }
+  }
+
+  v_float64 result = 0;
+  for(v_int32 j = 0; j < LANES; j ++) {
+    result += acc[j];
+  }
+  for(; i < size; i ++) {
+    v_float64 d = (v_float64) a[i] - b[i];
+    result += d * d;
+  }
+
+  return std::sqrt(result);
+
+}
+
+void EmbeddingFunctions::install(sqlite3* handle) {
+
+  struct Entry {
+    const char* name;
+    void (*func)(sqlite3_context*, int, sqlite3_value**);
+  };
+
+  static const Entry entries[] = {
+    {"vec_dot", &onDot},
+    {"vec_cosine", &onCosine},
+    {"vec_l2", &onL2}
+  };
+
+  for(auto& entry : entries) {
+    auto res = sqlite3_create_function_v2(handle, entry.name, 2, SQLITE_UTF8 | SQLITE_DETERMINISTIC,
+                                          nullptr, entry.func, nullptr, nullptr, nullptr);
+    if(res != SQLITE_OK) {
+      throw std::runtime_error("[oatpp::sqlite::EmbeddingFunctions::install()]: Error. Can't create function '" +
+                               std::string(entry.name) + "'. " + sqlite3_errmsg(handle));
+    }
+  }
+
+}
+
+}}
@@ -0,0 +1,95 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#ifndef oatpp_sqlite_EmbeddingFunctions_hpp
+#define oatpp_sqlite_EmbeddingFunctions_hpp
+
+#include "Types.hpp"
+
+#include <sqlite3.h>
+
+namespace oatpp { namespace sqlite {
+
+/**
+ * SQL functions comparing &id:oatpp::sqlite::Embedding; values: <br>
+ * <ul>
+ *   <li>`vec_dot(a, b)` - dot product.</li>
+ *   <li>`vec_cosine(a, b)` - cosine similarity. `NULL` if one of the vectors is zero.</li>
+ *   <li>`vec_l2(a, b)` - euclidean distance.</li>
+ * </ul>
+ * Arguments are BLOBs of packed floats of the same size, `NULL` argument gives `NULL`. <br>
+ * Install with &id:oatpp::sqlite::ConnectionProvider::addEmbeddingFunctions;.
+ * Top-k search is a plain query - SQLite keeps only `LIMIT` best rows while sorting: <br>
+ * `SELECT * FROM docs ORDER BY vec_cosine(f_embedding, :query) DESC LIMIT 10`.
+ */
+class EmbeddingFunctions {
+private:
+  /* independent accumulators - lets the compiler vectorize the loops without relaxing FP semantics */
+  static constexpr v_int32 LANES = 16;
+private:
+  static bool readArgs(sqlite3_context* context, sqlite3_value** argv, const v_float32** a, const v_float32** b, v_buff_size& size);
+  static void onDot(sqlite3_context* context, int argc, sqlite3_value** argv);
+  static void onCosine(sqlite3_context* context, int argc, sqlite3_value** argv);
+  static void onL2(sqlite3_context* context, int argc, sqlite3_value** argv);
+public:
+
+  /**
+   * Dot product.
+   * @param a
+   * @param b
+   * @param size - number of components.
+   * @return
+   */
+  static v_float64 dot(const v_float32* a, const v_float32* b, v_buff_size size);
+
+  /**
+   * Cosine similarity.
+   * @param a
+   * @param b
+   * @param size - number of components.
+   * @return - NaN if one of the vectors is zero.
+   */
+  static v_float64 cosine(const v_float32* a, const v_float32* b, v_buff_size size);
+
+  /**
+   * Euclidean distance.
+   * @param a
+   * @param b
+   * @param size - number of components.
+   * @return
+   */
+  static v_float64 l2(const v_float32* a, const v_float32* b, v_buff_size size);
+
+  /**
+   * Register functions on the connection.
+   * @param handle - native connection handle.
+   */
+  static void install(sqlite3* handle);
+
+};
+
+}}
+
+#endif // oatpp_sqlite_EmbeddingFunctions_hpp
@@ -24,18 +24,23 @@
 
 #include "Executor.hpp"
 
-#include "ql_template/Parser.hpp"
 #include "ql_template/TemplateValueProvider.hpp"
 
 #include "QueryResult.hpp"
 #include "Types.hpp"
+#include "Utils.hpp"
+#include "VirtualTable.hpp"
 
 #include "oatpp/orm/Transaction.hpp"
 
 #include "oatpp/base/Log.hpp"
 #include "oatpp/macro/codegen.hpp"
+#include "oatpp/Environment.hpp"
 
 
+#include <algorithm>
+#include <random>
+#include <thread>
 #include <vector>
 
 namespace oatpp { namespace sqlite {
@@ -54,6 +59,58 @@ class VersionRow : public oatpp::DTO {
 
 #include OATPP_CODEGEN_END(DTO)
 
+void addTable(std::vector<std::string>* tables, const char* database, const char* table) {
+  auto key = ResultCache::getTableKey(database, table);
+  if(std::find(tables->begin(), tables->end(), key) == tables->end()) {
+    tables->push_back(key);
+  }
+}
+
+/*
+ * Statement authorizer collecting tables read and written by the statement being prepared.
+ * readsVirtualTable is set if the statement reads a table installed as VirtualTable.
+ * Any of the out params may be nullptr.
+ */
+Connection::Authorizer collectTables(std::vector<std::string>* readTables,
+                                     std::vector<std::string>* writtenTables,
+                                     bool* readsVirtualTable)
+{
+  return [readTables, writtenTables, readsVirtualTable](int action, const char* arg1, const char* arg2, const char* database, const char* trigger) {
+    (void) trigger;
+    switch(action) {
+      case SQLITE_READ:
+        if(readTables && arg1) {
+          addTable(readTables, database, arg1);
+        }
+        if(readsVirtualTable && VirtualTable::isInstalled(arg1)) {
+          *readsVirtualTable = true;
+        }
+        break;
+      case SQLITE_INSERT:
+      case SQLITE_UPDATE:
+      case SQLITE_DELETE:
+      case SQLITE_DROP_TABLE:
+      case SQLITE_DROP_TEMP_TABLE:
+      case SQLITE_DROP_VIEW:
+      case SQLITE_DROP_TEMP_VIEW:
+      case SQLITE_DROP_VTABLE:
+        if(writtenTables && arg1) {
+          addTable(writtenTables, database, arg1);
+        }
+        break;
+      case SQLITE_ALTER_TABLE:
+        /* arg1 - database name, arg2 - table name */
+        if(writtenTables && arg2) {
+          addTable(writtenTables, arg1, arg2);
+        }
+        break;
+      default:
+        break;
+    }
+    return SQLITE_OK;
+  };
+}
+
 }
 
 void Executor::ConnectionInvalidator::invalidate(const std::shared_ptr<orm::Connection>& connection) {
@@ -69,17 +126,52 @@ void Executor::ConnectionInvalidator::invalidate(const std::shared_ptr<orm::Conn
 Executor::Executor(const std::shared_ptr<provider::Provider<Connection>>& connectionProvider)
   : m_connectionInvalidator(std::make_shared<ConnectionInvalidator>())
   , m_connectionProvider(connectionProvider)
+  , m_databaseScopeProvider(std::dynamic_pointer_cast<DatabaseScopeProvider>(connectionProvider))
   , m_resultMapper(std::make_shared<mapping::ResultMapper>())
+  , m_defaultTransactionMode(static_cast<v_int32>(TransactionMode::DEFERRED))
+  , m_variableNumberLimit(-1)
+  , m_requestCoalescing(false)
 {
   m_defaultTypeResolver->addKnownClasses({
-    Blob::Class::CLASS_ID
+    Blob::Class::CLASS_ID,
+    Embedding::Class::CLASS_ID
   });
+  m_keyMapper.serializerConfig().mapper.enabledInterpretations = {"sqlite"};
+}
+
+void Executor::setRequestCoalescing(bool enabled) {
+  m_requestCoalescing = enabled;
+}
+
+bool Executor::isRequestCoalescing() const {
+  return m_requestCoalescing;
+}
+
+void Executor::setPoolMetrics(const std::shared_ptr<PoolMetrics>& poolMetrics) {
+  m_poolMetrics = poolMetrics;
+}
+
+std::shared_ptr<PoolMetrics> Executor::getPoolMetrics() const {
+  return m_poolMetrics;
+}
+
+void Executor::setResultCache(const std::shared_ptr<ResultCache>& resultCache) {
+  m_resultCache = resultCache;
+}
+
+std::shared_ptr<ResultCache> Executor::getResultCache() const {
+  return m_resultCache;
+}
+
+void Executor::setDatabaseScopeProvider(const std::shared_ptr<DatabaseScopeProvider>& databaseScopeProvider) {
+  m_databaseScopeProvider = databaseScopeProvider;
 }
 
 std::shared_ptr<data::mapping::TypeResolver> Executor::createTypeResolver() {
   auto typeResolver = std::make_shared<data::mapping::TypeResolver>();
   typeResolver->addKnownClasses({
-    Blob::Class::CLASS_ID
+    Blob::Class::CLASS_ID,
+    Embedding::Class::CLASS_ID
   });
   return typeResolver;
 }
@@ -102,21 +194,46 @@ data::share::StringTemplate Executor::parseQueryTemplate(const oatpp::String& na
   ql_template::TemplateValueProvider valueProvider;
   extra->preparedTemplate = t.format(&valueProvider);
 
+  {
+    std::lock_guard<std::mutex> lock(m_templatesMutex);
+    std::pair<std::string, std::string> key(name ? *name : std::string(), *extra->preparedTemplate);
+    m_templates.insert({key, extra});
+  }
+
   return t;
 
 }
 
 provider::ResourceHandle<orm::Connection> Executor::getConnection() {
-  auto connection = m_connectionProvider->get();
+
+  provider::ResourceHandle<Connection> connection;
+
+  if(m_poolMetrics) {
+    v_int64 waitStart = oatpp::Environment::getMicroTickCount();
+    try {
+      connection = m_connectionProvider->get();
+    } catch (...) {
+      m_poolMetrics->recordAcquire(oatpp::Environment::getMicroTickCount() - waitStart, false);
+      throw;
+    }
+    m_poolMetrics->recordAcquire(oatpp::Environment::getMicroTickCount() - waitStart, connection.object != nullptr);
+  } else {
+    connection = m_connectionProvider->get();
+  }
+
   if(connection) {
     /* set correct invalidator before cast */
     connection.object->setInvalidator(connection.invalidator);
+    if(m_resultCache) {
+      connection.object->addChangeListener(m_resultCache);
+    }
     return provider::ResourceHandle<orm::Connection>(
       connection.object,
       m_connectionInvalidator
     );
   }
   throw std::runtime_error("[oatpp::sqlite::Executor::getConnection()]: Error. Can't connect.");
+
 }
 
 Executor::QueryParameter Executor::parseQueryParameter(const oatpp::String& paramName) {
@@ -145,10 +262,9 @@ Executor::QueryParameter Executor::parseQueryParameter(const oatpp::String& para
 
 }
 
-void Executor::bindParams(sqlite3_stmt* stmt,
-                          const StringTemplate& queryTemplate,
-                          const std::unordered_map<oatpp::String, oatpp::Void>& params,
-                          const std::shared_ptr<const data::mapping::TypeResolver>& typeResolver)
+std::vector<oatpp::Void> Executor::resolveParams(const StringTemplate& queryTemplate,
+                                                 const std::unordered_map<oatpp::String, oatpp::Void>& params,
+                                                 const std::shared_ptr<const data::mapping::TypeResolver>& typeResolver)
 {
 
   data::mapping::TypeResolver::Cache cache;
@@ -162,6 +278,9 @@ void Executor::bindParams(sqlite3_stmt* stmt,
 
   auto count = queryTemplate.getTemplateVariables().size();
 
+  std::vector<oatpp::Void> result;
+  result.reserve(count);
+
   for(v_uint32 i = 0; i < count; i ++) {
     const auto& var = queryTemplate.getTemplateVariables()[i];
     auto it = params.find(var.name);
@@ -179,7 +298,7 @@ void Executor::bindParams(sqlite3_stmt* stmt,
                                    "', parameter '" + *var.name +
                                    "' - property not found or its type is unknown.");
         }
-        m_serializer.serialize(stmt, i + 1, value);
+        result.push_back(value);
         continue;
       }
 
@@ -190,40 +309,406 @@ void Executor::bindParams(sqlite3_stmt* stmt,
 
   }
 
+  return result;
+
+}
+
+void Executor::bindParams(sqlite3_stmt* stmt, const std::vector<oatpp::Void>& values) {
+  for(v_uint32 i = 0; i < values.size(); i ++) {
+    m_serializer.serialize(stmt, i + 1, values[i]);
+  }
+}
+
+bool Executor::isReadOnly(sqlite3* handle) {
+  return sqlite3_db_readonly(handle, "main") == 1;
 }
 
-std::shared_ptr<orm::QueryResult> Executor::execute(const StringTemplate& queryTemplate,
-                                                    const std::unordered_map<oatpp::String, oatpp::Void>& params,
-                                                    const std::shared_ptr<const data::mapping::TypeResolver>& typeResolver,
-                                                    const provider::ResourceHandle<orm::Connection>& connection)
-{
+void Executor::checkWritable(sqlite3* handle, sqlite3_stmt* stmt) {
+  if(stmt && !sqlite3_stmt_readonly(stmt) && isReadOnly(handle)) {
+    std::string sql = sqlite3_sql(stmt);
+    sqlite3_finalize(stmt);
+    throw std::runtime_error("[oatpp::sqlite::Executor::checkWritable()]: "
+                             "Error. Database is read-only - statement is rejected: " + sql);
+  }
+}
+
+bool Executor::isCollection(const oatpp::Type* type) {
+  auto id = type->classId.id;
+  return id == data::type::__class::AbstractVector::CLASS_ID.id ||
+         id == data::type::__class::AbstractList::CLASS_ID.id ||
+         id == data::type::__class::AbstractUnorderedSet::CLASS_ID.id;
+}
+
+v_int64 Executor::getVariableNumberLimit(const provider::ResourceHandle<orm::Connection>& connection) {
+
+  v_int64 limit = m_variableNumberLimit;
+  if(limit > 0) {
+    return limit;
+  }
 
   auto conn = connection;
   if(!conn) {
     conn = getConnection();
   }
 
+  limit = sqlite3_limit(std::static_pointer_cast<sqlite::Connection>(conn.object)->getHandle(), SQLITE_LIMIT_VARIABLE_NUMBER, -1);
+  m_variableNumberLimit = limit;
+  return limit;
+
+}
+
+oatpp::String Executor::expandCollectionParams(const StringTemplate& queryTemplate,
+                                               std::vector<oatpp::Void>& values,
+                                               const provider::ResourceHandle<orm::Connection>& connection)
+{
+
+  auto extra = std::static_pointer_cast<ql_template::Parser::TemplateExtra>(queryTemplate.getExtraData());
+
+  std::vector<v_int64> sizes(values.size(), -1);
+  std::vector<v_int64> arities(values.size(), -1);
+  bool hasCollections = false;
+  v_int64 variablesCount = 0;
+
+  for(v_uint32 i = 0; i < values.size(); i ++) {
+    const auto& value = values[i];
+    if(isCollection(value.getValueType())) {
+      hasCollections = true;
+      v_int64 size = 0;
+      if(value) {
+        auto dispatcher = static_cast<const data::type::__class::Collection::PolymorphicDispatcher*>(value.getValueType()->polymorphicDispatcher);
+        size = dispatcher->getCollectionSize(value);
+      }
+      /* round up to power of two - to keep the number of distinct statements small */
+      v_int64 arity = 0;
+      if(size > 0) {
+        arity = 1;
+        while(arity < size) {
+          arity <<= 1;
+        }
+      }
+      sizes[i] = size;
+      arities[i] = arity;
+      variablesCount += arity;
+    } else {
+      variablesCount ++;
+    }
+  }
+
+  if(!hasCollections) {
+    return extra->preparedTemplate;
+  }
+
+  /* padded statement would exceed the max number of variables - bind exact sizes */
+  if(variablesCount > getVariableNumberLimit(connection)) {
+    arities = sizes;
+  }
+
+  std::vector<oatpp::Void> flatValues;
+  data::stream::BufferOutputStream keyStream;
+
+  for(v_uint32 i = 0; i < values.size(); i ++) {
+
+    keyStream << arities[i] << ",";
+
+    if(arities[i] < 0) {
+      flatValues.push_back(values[i]);
+      continue;
+    }
+
+    if(arities[i] == 0) {
+      continue;
+    }
+
+    auto dispatcher = static_cast<const data::type::__class::Collection::PolymorphicDispatcher*>(values[i].getValueType()->polymorphicDispatcher);
+    auto iterator = dispatcher->beginIteration(values[i]);
+    oatpp::Void item;
+    v_int64 count = 0;
+    while(!iterator->finished()) {
+      item = iterator->get();
+      flatValues.push_back(item);
+      iterator->next();
+      count ++;
+    }
+
+    /* pad with the last item - duplicates don't change the result of IN (...) */
+    for(; count < arities[i]; count ++) {
+      flatValues.push_back(item);
+    }
+
+  }
+
+  values = std::move(flatValues);
+
+  auto key = keyStream.toString();
+
+  std::lock_guard<std::mutex> lock(extra->expandedTemplatesMutex);
+  auto it = extra->expandedTemplates.find(*key);
+  if(it != extra->expandedTemplates.end()) {
+    return it->second;
+  }
+
+  ql_template::TemplateValueProvider valueProvider(&arities);
+  auto query = queryTemplate.format(&valueProvider);
+  extra->expandedTemplates.insert({*key, query});
+  return query;
+
+}
+
+oatpp::String Executor::getDatabaseScope(const provider::ResourceHandle<orm::Connection>& connection) {
+  /* connection requested from the provider may be routed to another database (ex.: by the current tenant) */
+  std::string scope = m_databaseScopeProvider ? *m_databaseScopeProvider->getDatabaseScope() : "";
+  if(connection) {
+    /* the file tells the database of the connection, the provider scope tells its version (ex.: reloaded image) */
+    auto fileName = sqlite3_db_filename(std::static_pointer_cast<sqlite::Connection>(connection.object)->getHandle(), "main");
+    scope = (fileName ? fileName : "") + std::string("|") + scope;
+  }
+  return scope;
+}
+
+oatpp::String Executor::getQueryKey(const oatpp::String& scope, const oatpp::String& query, const std::vector<oatpp::Void>& values) {
+  data::stream::BufferOutputStream stream;
+  stream << scope << "\n" << query;
+  for(auto& value : values) {
+    stream << "\n" << m_keyMapper.writeToString(value);
+  }
+  return stream.toString();
+}
+
+bool Executor::isCoalescable(const oatpp::String& query) {
+  std::lock_guard<std::mutex> lock(m_inFlightMutex);
+  return m_nonCoalescableQueries.find(*query) == m_nonCoalescableQueries.end();
+}
+
+bool Executor::isShareChecked(const oatpp::String& query) {
+  std::lock_guard<std::mutex> lock(m_inFlightMutex);
+  return m_shareCheckedQueries.find(*query) != m_shareCheckedQueries.end();
+}
+
+void Executor::finishFlight(const oatpp::String& key,
+                            const std::shared_ptr<std::promise<std::shared_ptr<const mapping::ResultSet>>>& flight,
+                            const std::shared_ptr<const mapping::ResultSet>& resultSet)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_inFlightMutex);
+    m_inFlight.erase(*key);
+  }
+  flight->set_value(resultSet);
+}
+
+std::shared_ptr<orm::QueryResult> Executor::executeShared(const oatpp::String& query,
+                                                          const std::vector<oatpp::Void>& values,
+                                                          const std::shared_ptr<const data::mapping::TypeResolver>& typeResolver,
+                                                          const provider::ResourceHandle<orm::Connection>& connection,
+                                                          bool cache,
+                                                          bool coalesce)
+{
+
+  auto key = getQueryKey(getDatabaseScope(connection), query, values);
+
+  std::shared_ptr<const mapping::ResultSet> resultSet;
+
+  if(cache) {
+    resultSet = m_resultCache->get(key);
+    if(resultSet) {
+      return std::make_shared<QueryResult>(resultSet, connection, m_resultMapper, typeResolver);
+    }
+  }
+
+  std::shared_ptr<std::promise<std::shared_ptr<const mapping::ResultSet>>> flight;
+
+  if(coalesce) {
+
+    std::shared_future<std::shared_ptr<const mapping::ResultSet>> sharedResult;
+
+    {
+      std::lock_guard<std::mutex> lock(m_inFlightMutex);
+      auto it = m_inFlight.find(*key);
+      if(it != m_inFlight.end()) {
+        sharedResult = it->second;
+      } else {
+        flight = std::make_shared<std::promise<std::shared_ptr<const mapping::ResultSet>>>();
+        m_inFlight.insert({*key, flight->get_future().share()});
+      }
+    }
+
+    if(!flight) {
+      /* identical query is already running - wait for its result */
+      resultSet = sharedResult.get();
+      if(resultSet) {
+        return std::make_shared<QueryResult>(resultSet, connection, m_resultMapper, typeResolver);
+      }
+      /* the query failed or can't be shared - run it on our own */
+      flight = nullptr;
+      coalesce = false;
+    }
+
+  }
+
+  try {
+
+    auto conn = connection;
+    if(!conn) {
+      conn = getConnection();
+    }
+
+    auto sqliteConn = std::static_pointer_cast<sqlite::Connection>(conn.object);
+
+    /* tables read by the query are collected once - together with the check for virtual tables */
+    std::vector<std::string> tables;
+    bool tablesKnown = cache ? m_resultCache->getQueryTables(query, tables) : isShareChecked(query);
+    bool readsVirtualTable = false;
+
+    auto stmt = prepareQuery(sqliteConn->getHandle(), sqliteConn, query, tablesKnown ? nullptr : &tables, &readsVirtualTable);
+    if(stmt == nullptr) {
+      /* result reports the prepare error of the connection */
+      if(flight) {
+        finishFlight(key, flight, nullptr);
+      }
+      return std::make_shared<QueryResult>(stmt, conn, m_resultMapper, typeResolver);
+    }
+
+    checkWritable(sqliteConn->getHandle(), stmt);
+    bindParams(stmt, values);
+
+    if(!sqlite3_stmt_readonly(stmt)) {
+
+      if(cache) {
+        m_resultCache->setNonCacheable(query);
+      }
+      if(coalesce) {
+        std::lock_guard<std::mutex> lock(m_inFlightMutex);
+        m_nonCoalescableQueries.insert(*query);
+      }
+
+      if(flight) {
+        finishFlight(key, flight, nullptr);
+      }
+
+      auto result = std::make_shared<QueryResult>(stmt, query, conn, m_resultMapper, typeResolver);
+      if(m_resultCache) {
+        m_resultCache->flush(sqliteConn->getHandle());
+      }
+      sqliteConn->completeCommit(result->isSuccess());
+      return result;
+
+    }
+
+    if(readsVirtualTable) {
+
+      /* data of virtual tables may be scoped to the calling thread - results can't be shared */
+      if(m_resultCache) {
+        m_resultCache->setNonCacheable(query);
+      }
+      {
+        std::lock_guard<std::mutex> lock(m_inFlightMutex);
+        m_nonCoalescableQueries.insert(*query);
+      }
+
+      if(flight) {
+        finishFlight(key, flight, nullptr);
+      }
+
+      return std::make_shared<QueryResult>(stmt, query, conn, m_resultMapper, typeResolver);
+
+    }
+
+    if(!tablesKnown && !cache) {
+      std::lock_guard<std::mutex> lock(m_inFlightMutex);
+      m_shareCheckedQueries.insert(*query);
+    }
+
+    if(cache && tables.empty()) {
+      m_resultCache->setNonCacheable(query);
+      cache = false;
+    } else if(cache && !tablesKnown) {
+      m_resultCache->setQueryTables(query, tables);
+    }
+
+    /* take generations before the first step - changes committed during the query will drop the result */
+    std::vector<v_uint64> generations;
+    if(cache) {
+      generations = m_resultCache->getGenerations(tables);
+    }
+
+    /* statement goes back to the statement cache of the connection once the rows are read */
+    auto result = std::make_shared<QueryResult>(stmt, query, conn, m_resultMapper, typeResolver);
+    resultSet = result->materialize();
+
+    if(flight) {
+      finishFlight(key, flight, resultSet);
+    }
+
+    if(!resultSet) {
+      return result;
+    }
+
+    if(cache) {
+      m_resultCache->put(key, tables, generations, resultSet);
+    }
+
+    return std::make_shared<QueryResult>(resultSet, conn, m_resultMapper, typeResolver);
+
+  } catch (...) {
+    if(flight) {
+      finishFlight(key, flight, nullptr);
+    }
+    throw;
+  }
+
+}
+
+std::shared_ptr<orm::QueryResult> Executor::execute(const StringTemplate& queryTemplate,
+                                                    const std::unordered_map<oatpp::String, oatpp::Void>& params,
+                                                    const std::shared_ptr<const data::mapping::TypeResolver>& typeResolver,
+                                                    const provider::ResourceHandle<orm::Connection>& connection)
+{
+
   std::shared_ptr<const data::mapping::TypeResolver> tr = typeResolver;
   if(!tr) {
     tr = m_defaultTypeResolver;
   }
 
-  auto sqliteConn = std::static_pointer_cast<sqlite::Connection>(conn.object);
-
   auto extra = std::static_pointer_cast<ql_template::Parser::TemplateExtra>(queryTemplate.getExtraData());
 
-  sqlite3_stmt* stmt = nullptr;
-  auto res = sqlite3_prepare_v2(sqliteConn->getHandle(),
-                                extra->preparedTemplate->c_str(),
-                                extra->preparedTemplate->size(),
-                                &stmt,
-                                nullptr);
+  /* lock waits of this query are attributed to the template */
+  BusyHandler::QueryScope busyScope(extra->templateName ? extra->templateName->c_str() : nullptr);
+
+  auto values = resolveParams(queryTemplate, params, tr);
+  auto query = expandCollectionParams(queryTemplate, values, connection);
+
+  bool cache = m_resultCache && m_resultCache->isCacheable(extra->templateName, query);
+  /* waiting for another caller's result while holding a connection may deadlock - coalesce only pooled reads */
+  bool coalesce = m_requestCoalescing && !connection && isCoalescable(query);
+
+  if(cache || coalesce) {
+    /* results read inside a transaction may include its uncommitted changes - don't share them */
+    if(!connection || sqlite3_get_autocommit(std::static_pointer_cast<sqlite::Connection>(connection.object)->getHandle())) {
+      return executeShared(query, values, tr, connection, cache, coalesce);
+    }
+  }
+
+  auto conn = connection;
+  if(!conn) {
+    conn = getConnection();
+  }
 
-  (void) res; // TODO check for res
+  auto sqliteConn = std::static_pointer_cast<sqlite::Connection>(conn.object);
 
-  bindParams(stmt, queryTemplate, params, tr);
+  auto stmt = prepareQuery(sqliteConn->getHandle(), sqliteConn, query, nullptr, nullptr);
+  if(stmt == nullptr) {
+    /* result reports the prepare error of the connection */
+    return std::make_shared<QueryResult>(stmt, conn, m_resultMapper, tr);
+  }
 
-  return std::make_shared<QueryResult>(stmt, conn, m_resultMapper, tr);
+  checkWritable(sqliteConn->getHandle(), stmt);
+  bindParams(stmt, values);
+
+  auto result = std::make_shared<QueryResult>(stmt, query, conn, m_resultMapper, tr);
+  if(m_resultCache) {
+    m_resultCache->flush(sqliteConn->getHandle());
+  }
+  sqliteConn->completeCommit(result->isSuccess());
+  return result;
 
 }
 
@@ -237,31 +722,394 @@ std::shared_ptr<orm::QueryResult> Executor::exec(const oatpp::String& statement,
   }
 
   auto sqliteConn = std::static_pointer_cast<sqlite::Connection>(conn.object);
-  sqlite3_stmt* stmt;
+  BusyHandler::QueryScope busyScope(statement->c_str());
+  sqlite3_stmt* stmt = nullptr;
   auto res = sqlite3_prepare_v2(sqliteConn->getHandle(), statement->c_str(), -1, &stmt, nullptr);
-  (void) res; // TODO - check for res
-  return std::make_shared<QueryResult>(stmt, conn, m_resultMapper, m_defaultTypeResolver);
+  if(res != SQLITE_OK) {
+    /* result reports the prepare error of the connection */
+    sqlite3_finalize(stmt);
+    return std::make_shared<QueryResult>(nullptr, conn, m_resultMapper, m_defaultTypeResolver);
+  }
+  checkWritable(sqliteConn->getHandle(), stmt);
+  auto result = std::make_shared<QueryResult>(stmt, conn, m_resultMapper, m_defaultTypeResolver);
+  if(m_resultCache) {
+    m_resultCache->flush(sqliteConn->getHandle());
+  }
+  sqliteConn->completeCommit(result->isSuccess());
+  return result;
 
 }
 
+sqlite3_stmt* Executor::prepareStatement(sqlite3* handle, const std::shared_ptr<Connection>& connection, const oatpp::String& query) {
+
+  auto stmt = connection->getCachedStatement(query);
+  if(stmt) {
+    return stmt;
+  }
+
+  auto res = sqlite3_prepare_v2(handle,
+                                query->c_str(),
+                                query->size(),
+                                &stmt,
+                                nullptr);
+
+  if(res != SQLITE_OK) {
+    sqlite3_finalize(stmt);
+    return nullptr;
+  }
+
+  return stmt;
+
+}
+
+sqlite3_stmt* Executor::prepareQuery(sqlite3* handle,
+                                   const std::shared_ptr<Connection>& connection,
+                                   const oatpp::String& query,
+                                   std::vector<std::string>* readTables,
+                                   bool* readsVirtualTable)
+{
+
+  std::vector<std::string> writtenTables;
+  bool writesKnown = !m_resultCache || m_resultCache->getWrittenTables(query, writtenTables);
+
+  sqlite3_stmt* stmt = nullptr;
+
+  if(writesKnown && readTables == nullptr) {
+    stmt = prepareStatement(handle, connection, query);
+  } else {
+
+    /* the authorizer isn't called for a cached statement - prepare it fresh to collect tables */
+    connection->setStatementAuthorizer(collectTables(readTables, writesKnown ? nullptr : &writtenTables, readsVirtualTable));
+    auto res = sqlite3_prepare_v2(handle,
+                                  query->c_str(),
+                                  query->size(),
+                                  &stmt,
+                                  nullptr);
+    connection->setStatementAuthorizer(nullptr);
+
+    if(res != SQLITE_OK) {
+      sqlite3_finalize(stmt);
+      stmt = nullptr;
+    } else if(!writesKnown) {
+      m_resultCache->setWrittenTables(query, writtenTables);
+    }
+
+  }
+
+  /* the update hook misses some writes (ex.: WITHOUT ROWID tables, DDL) - tables are invalidated on commit */
+  if(stmt && !writtenTables.empty()) {
+    m_resultCache->addChanges(handle, writtenTables);
+  }
+
+  return stmt;
+
+}
+
+std::vector<std::shared_ptr<ql_template::Parser::TemplateExtra>> Executor::getTemplates() {
+  std::vector<std::shared_ptr<ql_template::Parser::TemplateExtra>> result;
+  std::lock_guard<std::mutex> lock(m_templatesMutex);
+  result.reserve(m_templates.size());
+  for(auto& pair : m_templates) {
+    result.push_back(pair.second);
+  }
+  return result;
+}
+
+bool Executor::isBusy(sqlite3* handle) {
+  auto code = sqlite3_errcode(handle) & 0xFF;
+  return code == SQLITE_BUSY || code == SQLITE_LOCKED;
+}
+
+oatpp::String Executor::getSavepointName(v_int32 depth) {
+  return "oatpp_savepoint_" + std::to_string(depth);
+}
+
+void Executor::setDefaultTransactionMode(TransactionMode mode) {
+  m_defaultTransactionMode = static_cast<v_int32>(mode);
+}
+
+Executor::TransactionMode Executor::getDefaultTransactionMode() const {
+  return static_cast<TransactionMode>(m_defaultTransactionMode.load());
+}
+
 std::shared_ptr<orm::QueryResult> Executor::begin(const provider::ResourceHandle<orm::Connection>& connection) {
-  return exec("BEGIN", connection);
+  return begin(getDefaultTransactionMode(), connection);
+}
+
+std::shared_ptr<orm::QueryResult> Executor::begin(TransactionMode mode, const provider::ResourceHandle<orm::Connection>& connection) {
+
+  auto conn = connection;
+  if(!conn) {
+    conn = getConnection();
+  }
+
+  auto sqliteConn = std::static_pointer_cast<sqlite::Connection>(conn.object);
+
+  auto depth = sqliteConn->getTransactionDepth();
+  if(depth > 0 && sqlite3_get_autocommit(sqliteConn->getHandle())) {
+    /* transaction was ended by SQLite itself - ex.: rolled back on error */
+    depth = 0;
+  }
+
+  std::shared_ptr<orm::QueryResult> result;
+
+  if(depth == 0) {
+    switch(mode) {
+      case TransactionMode::IMMEDIATE: result = exec("BEGIN IMMEDIATE", conn); break;
+      case TransactionMode::EXCLUSIVE: result = exec("BEGIN EXCLUSIVE", conn); break;
+      default: result = exec("BEGIN DEFERRED", conn);
+    }
+  } else {
+    result = exec("SAVEPOINT " + *getSavepointName(depth), conn);
+  }
+
+  if(result->isSuccess()) {
+    sqliteConn->setTransactionDepth(depth + 1);
+  }
+
+  return result;
+
 }
 
 std::shared_ptr<orm::QueryResult> Executor::commit(const provider::ResourceHandle<orm::Connection>& connection) {
+
   if(!connection) {
     throw std::runtime_error("[oatpp::sqlite::Executor::commit()]: "
                              "Error. Can't COMMIT - NULL connection.");
   }
-  return exec("COMMIT", connection);
+
+  auto sqliteConn = std::static_pointer_cast<sqlite::Connection>(connection.object);
+  auto depth = sqliteConn->getTransactionDepth();
+
+  if(depth <= 1 || sqlite3_get_autocommit(sqliteConn->getHandle())) {
+    auto result = exec("COMMIT", connection);
+    if(result->isSuccess()) {
+      sqliteConn->setTransactionDepth(0);
+    }
+    return result;
+  }
+
+  auto result = exec("RELEASE SAVEPOINT " + *getSavepointName(depth - 1), connection);
+  if(result->isSuccess()) {
+    sqliteConn->setTransactionDepth(depth - 1);
+  }
+  return result;
+
 }
 
 std::shared_ptr<orm::QueryResult> Executor::rollback(const provider::ResourceHandle<orm::Connection>& connection) {
+
   if(!connection) {
-    throw std::runtime_error("[oatpp::sqlite::Executor::commit()]: "
+    throw std::runtime_error("[oatpp::sqlite::Executor::rollback()]: "
                              "Error. Can't ROLLBACK - NULL connection.");
   }
-  return exec("ROLLBACK", connection);
+
+  auto sqliteConn = std::static_pointer_cast<sqlite::Connection>(connection.object);
+  auto depth = sqliteConn->getTransactionDepth();
+
+  if(depth <= 1 || sqlite3_get_autocommit(sqliteConn->getHandle())) {
+    /* transaction is over even if ROLLBACK fails */
+    sqliteConn->setTransactionDepth(0);
+    return exec("ROLLBACK", connection);
+  }
+
+  auto savepoint = getSavepointName(depth - 1);
+  sqliteConn->setTransactionDepth(depth - 1);
+
+  /* ROLLBACK TO keeps the savepoint on the stack - release it as well */
+  auto result = exec("ROLLBACK TO SAVEPOINT " + *savepoint, connection);
+  if(!result->isSuccess()) {
+    return result;
+  }
+  return exec("RELEASE SAVEPOINT " + *savepoint, connection);
+
+}
+
+bool Executor::runTransaction(const TransactionBody& body, TransactionMode mode, const RetryPolicy& policy) {
+
+  static thread_local std::mt19937_64 random(std::random_device{}());
+
+  auto connection = getConnection();
+  auto handle = std::static_pointer_cast<sqlite::Connection>(connection.object)->getHandle();
+
+  auto backoff = policy.initialBackoff;
+
+  for(v_int32 attempt = 1; ; attempt ++) {
+
+    auto result = begin(mode, connection);
+
+    if(!result->isSuccess()) {
+
+      if(!isBusy(handle)) {
+        throw std::runtime_error("[oatpp::sqlite::Executor::runTransaction()]: "
+                                 "Error. Can't begin transaction. " + result->getErrorMessage());
+      }
+
+    } else {
+
+      bool doCommit = false;
+      bool busy = false;
+
+      try {
+        doCommit = body(connection);
+      } catch (...) {
+        busy = isBusy(handle);
+        rollback(connection);
+        if(!busy || attempt >= policy.maxAttempts) {
+          throw;
+        }
+      }
+
+      if(!busy) {
+
+        if(!doCommit) {
+          rollback(connection);
+          return false;
+        }
+
+        result = commit(connection);
+        if(result->isSuccess()) {
+          return true;
+        }
+
+        busy = isBusy(handle);
+        rollback(connection);
+        if(!busy) {
+          throw std::runtime_error("[oatpp::sqlite::Executor::runTransaction()]: "
+                                   "Error. Can't commit. " + result->getErrorMessage());
+        }
+
+      }
+
+    }
+
+    if(attempt >= policy.maxAttempts) {
+      throw std::runtime_error("[oatpp::sqlite::Executor::runTransaction()]: "
+                               "Error. Database is busy - transaction failed after " + std::to_string(attempt) + " attempts.");
+    }
+
+    /* jitter - concurrent writers don't retry in lockstep */
+    std::uniform_int_distribution<v_int64> distribution(backoff.count() / 2, backoff.count());
+    std::this_thread::sleep_for(std::chrono::microseconds(distribution(random)));
+
+    backoff = std::chrono::microseconds(static_cast<v_int64>(backoff.count() * policy.multiplier));
+    if(backoff > policy.maxBackoff) {
+      backoff = policy.maxBackoff;
+    }
+
+  }
+
+}
+
+bool Executor::runTransaction(const TransactionBody& body, TransactionMode mode) {
+  return runTransaction(body, mode, RetryPolicy());
+}
+
+std::vector<Executor::TemplateInfo> Executor::prepareTemplates(const provider::ResourceHandle<orm::Connection>& connection) {
+
+  auto conn = connection;
+  if(!conn) {
+    conn = getConnection();
+  }
+
+  auto sqliteConn = std::static_pointer_cast<sqlite::Connection>(conn.object);
+  auto handle = sqliteConn->getHandle();
+
+  std::vector<TemplateInfo> result;
+
+  for(auto& extra : getTemplates()) {
+
+    TemplateInfo info;
+    info.name = extra->templateName;
+    info.text = extra->preparedTemplate;
+    info.isValid = false;
+    info.isReadOnly = false;
+    info.paramsCount = 0;
+
+    auto stmt = prepareStatement(handle, sqliteConn, extra->preparedTemplate);
+
+    if(stmt) {
+
+      info.isValid = true;
+      info.isReadOnly = sqlite3_stmt_readonly(stmt) != 0;
+      info.paramsCount = sqlite3_bind_parameter_count(stmt);
+
+      auto colCount = sqlite3_column_count(stmt);
+      for(v_int32 i = 0; i < colCount; i ++) {
+        ColumnInfo column;
+        column.name = (const char*) sqlite3_column_name(stmt, i);
+        auto declaredType = sqlite3_column_decltype(stmt, i);
+        if(declaredType) {
+          column.declaredType = declaredType;
+        }
+        info.columns.push_back(column);
+      }
+
+      sqliteConn->putCachedStatement(extra->preparedTemplate, stmt);
+
+    } else {
+      info.errorMessage = sqlite3_errmsg(handle);
+    }
+
+    result.push_back(info);
+
+  }
+
+  return result;
+
+}
+
+std::vector<Executor::TemplateInfo> Executor::validateTemplates(const provider::ResourceHandle<orm::Connection>& connection) {
+
+  auto result = prepareTemplates(connection);
+
+  data::stream::BufferOutputStream stream;
+  v_int32 errorsCount = 0;
+
+  for(auto& info : result) {
+    if(!info.isValid) {
+      stream << "\n  '" << (info.name ? info.name : oatpp::String("<unnamed>")) << "': " << info.errorMessage;
+      errorsCount ++;
+    }
+  }
+
+  if(errorsCount > 0) {
+    throw std::runtime_error("[oatpp::sqlite::Executor::validateTemplates()]: Error. "
+                             "Invalid query templates (" + std::to_string(errorsCount) + "):" + *stream.toString());
+  }
+
+  return result;
+
+}
+
+void Executor::warmUp(const WarmUpConfig& config) {
+
+  v_int64 count = config.connectionsCount;
+  if(count > config.maxConnections) {
+    count = config.maxConnections;
+  }
+  if(count < 1) {
+    count = 1;
+  }
+
+  /* hold all connections until warm-up is done - so that the pool opens a new connection each time */
+  std::vector<provider::ResourceHandle<orm::Connection>> connections;
+
+  for(v_int64 i = 0; i < count; i ++) {
+
+    auto conn = getConnection();
+    auto sqliteConn = std::static_pointer_cast<sqlite::Connection>(conn.object);
+
+    Utils::warmUpConnection(sqliteConn->getHandle(), config.queries);
+
+    if(config.prepareTemplates) {
+      validateTemplates(conn);
+    }
+
+    connections.push_back(conn);
+
+  }
+
 }
 
 oatpp::String Executor::getSchemaVersionTableName(const oatpp::String& suffix) {
@@ -291,19 +1139,42 @@ v_int64 Executor::getSchemaVersion(const oatpp::String& suffix,
 
   std::shared_ptr<orm::QueryResult> result;
 
-  {
+  auto conn = connection;
+  if(!conn) {
+    conn = getConnection();
+  }
+
+  bool readOnly = isReadOnly(std::static_pointer_cast<sqlite::Connection>(conn.object)->getHandle());
+
+  if(readOnly) {
+
+    /* don't create the version table - database can't be modified. No table - version 0 */
+    data::stream::BufferOutputStream stream;
+    stream << "SELECT name FROM sqlite_master WHERE type='table' AND name='" << getSchemaVersionTableName(suffix) << "'";
+    result = exec(stream.toString(), conn);
+    if(!result->isSuccess()) {
+      throw std::runtime_error("[oatpp::sqlite::Executor::getSchemaVersion()]: "
+                               "Error. Can't check schema version table. " + result->getErrorMessage());
+    }
+    if(!result->hasMoreToFetch()) {
+      return 0;
+    }
+
+  } else {
+
     data::stream::BufferOutputStream stream;
     stream << "CREATE TABLE IF NOT EXISTS " << getSchemaVersionTableName(suffix) << " (version BIGINT)";
-    result = exec(stream.toString(), connection);
+    result = exec(stream.toString(), conn);
     if(!result->isSuccess()) {
       throw std::runtime_error("[oatpp::sqlite::Executor::getSchemaVersion()]: "
                                "Error. Can't create schema version table. " + result->getErrorMessage());
     }
+
   }
 
   data::stream::BufferOutputStream stream;
   stream << "SELECT * FROM " << getSchemaVersionTableName(suffix);
-  result = exec(stream.toString(), result->getConnection());
+  result = exec(stream.toString(), conn);
   if(!result->isSuccess()) {
     throw std::runtime_error("[oatpp::sqlite::Executor::getSchemaVersion()]: "
                              "Error. Can't get schema version. " + result->getErrorMessage());
@@ -311,7 +1182,9 @@ v_int64 Executor::getSchemaVersion(const oatpp::String& suffix,
 
   auto rows = result->fetch<oatpp::Vector<oatpp::Object<VersionRow>>>();
 
-  if(rows->size() == 0) {
+  if(rows->size() == 0 && readOnly) {
+    return 0;
+  } else if(rows->size() == 0) {
 
     stream.setCurrentPosition(0);
     stream << "INSERT INTO " << getSchemaVersionTableName(suffix) << " (version) VALUES (0)";
@@ -364,6 +1237,11 @@ void Executor::migrateSchema(const oatpp::String& script,
     throw std::runtime_error("[oatpp::sqlite::Executor::migrateSchema()]: Error. +1 version increment is allowed only.");
   }
 
+  if(isReadOnly(std::static_pointer_cast<sqlite::Connection>(connection.object)->getHandle())) {
+    throw std::runtime_error("[oatpp::sqlite::Executor::migrateSchema()]: "
+                             "Error. Database is read-only - can't migrate to version " + std::to_string(newVersion) + ".");
+  }
+
   if(script->size() == 0) {
     OATPP_LOGw("[oatpp::sqlite::Executor::migrateSchema()]", "Warning. Executing empty script for version {}", newVersion);
   }
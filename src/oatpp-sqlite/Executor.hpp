@@ -27,13 +27,23 @@
 
 #include "ConnectionProvider.hpp"
 #include "QueryResult.hpp"
+#include "ResultCache.hpp"
 
 #include "mapping/Serializer.hpp"
 #include "mapping/ResultMapper.hpp"
+#include "ql_template/Parser.hpp"
 
+#include "oatpp/json/ObjectMapper.hpp"
 #include "oatpp/orm/Executor.hpp"
 #include "oatpp/utils/parser/Caret.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <unordered_set>
 #include <vector>
 
 namespace oatpp { namespace sqlite {
@@ -42,6 +52,152 @@ namespace oatpp { namespace sqlite {
  * Implementation of &id:oatpp::orm::Executor;. for SQLite.
  */
 class Executor : public orm::Executor {
+public:
+
+  /**
+   * Mode of the transaction begin statement.
+   */
+  enum class TransactionMode : v_int32 {
+
+    /**
+     * `BEGIN DEFERRED` - locks are acquired by the first read or write.
+     * Deferred read transaction which later writes may fail with `SQLITE_BUSY` and has to be restarted.
+     */
+    DEFERRED = 0,
+
+    /**
+     * `BEGIN IMMEDIATE` - write lock is acquired right away. Use it for transactions which write.
+     */
+    IMMEDIATE = 1,
+
+    /**
+     * `BEGIN EXCLUSIVE` - same as `IMMEDIATE` in WAL mode. Otherwise also prevents readers.
+     */
+    EXCLUSIVE = 2
+
+  };
+
+  /**
+   * Retry policy of &l:Executor::runTransaction ();.
+   */
+  struct RetryPolicy {
+
+    /**
+     * Max number of attempts to run the transaction.
+     */
+    v_int32 maxAttempts = 10;
+
+    /**
+     * Backoff before the second attempt. Actual sleep time is a random value in `[backoff / 2, backoff]`.
+     */
+    std::chrono::microseconds initialBackoff = std::chrono::milliseconds(1);
+
+    /**
+     * Max backoff.
+     */
+    std::chrono::microseconds maxBackoff = std::chrono::milliseconds(100);
+
+    /**
+     * Backoff multiplier applied after each attempt.
+     */
+    v_float64 multiplier = 2.0;
+
+  };
+
+  /**
+   * Body of the transaction run by &l:Executor::runTransaction ();. <br>
+   * Return `true` to commit, `false` to rollback. Throw to rollback - the transaction is retried if the last
+   * error of the connection is `SQLITE_BUSY` or `SQLITE_LOCKED`.
+   */
+  typedef std::function<bool(const provider::ResourceHandle<orm::Connection>&)> TransactionBody;
+
+  /**
+   * Metadata of a result column of the query template.
+   */
+  struct ColumnInfo {
+
+    /**
+     * Column name - `sqlite3_column_name`.
+     */
+    oatpp::String name;
+
+    /**
+     * Declared type of the table column - `sqlite3_column_decltype`. `nullptr` if the column is an expression.
+     */
+    oatpp::String declaredType;
+
+  };
+
+  /**
+   * Result of preparation of the query template - see &l:Executor::prepareTemplates ();.
+   */
+  struct TemplateInfo {
+
+    /**
+     * Template name - name of the DbClient method.
+     */
+    oatpp::String name;
+
+    /**
+     * Statement text.
+     */
+    oatpp::String text;
+
+    /**
+     * `true` if the statement was prepared successfully.
+     */
+    bool isValid;
+
+    /**
+     * Error message if the statement can't be prepared.
+     */
+    oatpp::String errorMessage;
+
+    /**
+     * `true` if the statement doesn't write to the database - `sqlite3_stmt_readonly`.
+     */
+    bool isReadOnly;
+
+    /**
+     * Number of statement parameters.
+     */
+    v_int32 paramsCount;
+
+    /**
+     * Result columns.
+     */
+    std::vector<ColumnInfo> columns;
+
+  };
+
+  /**
+   * Config of &l:Executor::warmUp ();.
+   */
+  struct WarmUpConfig {
+
+    /**
+     * Number of connections to open. Clamped to `[1, maxConnections]`.
+     */
+    v_int64 connectionsCount = 1;
+
+    /**
+     * Max size of the connection pool of the executor. <br>
+     * Connections are held at the same time - the pool would block forever if `connectionsCount` exceeded it.
+     */
+    v_int64 maxConnections = 1;
+
+    /**
+     * Queries or `PRAGMA`s run on each connection. Ex.: `PRAGMA mmap_size=268435456`.
+     */
+    std::vector<oatpp::String> queries;
+
+    /**
+     * Prepare all query templates registered with this executor and put them to the statement cache of each connection.
+     */
+    bool prepareTemplates = true;
+
+  };
+
 private:
 
   /*
@@ -63,14 +219,86 @@ private:
 
 private:
 
-  void bindParams(sqlite3_stmt* stmt,
-                  const StringTemplate& queryTemplate,
-                  const std::unordered_map<oatpp::String, oatpp::Void>& params,
-                  const std::shared_ptr<const data::mapping::TypeResolver>& typeResolver);
+  std::vector<oatpp::Void> resolveParams(const StringTemplate& queryTemplate,
+                                         const std::unordered_map<oatpp::String, oatpp::Void>& params,
+                                         const std::shared_ptr<const data::mapping::TypeResolver>& typeResolver);
+
+  static bool isCollection(const oatpp::Type* type);
+
+  /*
+   * Max number of variables in a statement - `SQLITE_LIMIT_VARIABLE_NUMBER`. Read once from the first connection.
+   */
+  v_int64 getVariableNumberLimit(const provider::ResourceHandle<orm::Connection>& connection);
+
+  /*
+   * Expand collection parameters to lists of placeholders. Flattens collection values.
+   * Returns query text.
+   */
+  oatpp::String expandCollectionParams(const StringTemplate& queryTemplate,
+                                       std::vector<oatpp::Void>& values,
+                                       const provider::ResourceHandle<orm::Connection>& connection);
+
+  /*
+   * Database the query runs on - results of different databases (ex.: tenants) must not be shared.
+   */
+  oatpp::String getDatabaseScope(const provider::ResourceHandle<orm::Connection>& connection);
+
+  oatpp::String getQueryKey(const oatpp::String& scope, const oatpp::String& query, const std::vector<oatpp::Void>& values);
+
+  /*
+   * Check if query was checked not to read virtual tables. See m_shareCheckedQueries.
+   */
+  bool isShareChecked(const oatpp::String& query);
+
+  void finishFlight(const oatpp::String& key,
+                    const std::shared_ptr<std::promise<std::shared_ptr<const mapping::ResultSet>>>& flight,
+                    const std::shared_ptr<const mapping::ResultSet>& resultSet);
+
+  /*
+   * Execute read-only query materializing its result - for result cache and request coalescing.
+   */
+  std::shared_ptr<orm::QueryResult> executeShared(const oatpp::String& query,
+                                                  const std::vector<oatpp::Void>& values,
+                                                  const std::shared_ptr<const data::mapping::TypeResolver>& typeResolver,
+                                                  const provider::ResourceHandle<orm::Connection>& connection,
+                                                  bool cache,
+                                                  bool coalesce);
+
+  void bindParams(sqlite3_stmt* stmt, const std::vector<oatpp::Void>& values);
+
+  static bool isReadOnly(sqlite3* handle);
+
+  /*
+   * Finalize statement and throw if it writes to a read-only (ex.: immutable) database.
+   */
+  static void checkWritable(sqlite3* handle, sqlite3_stmt* stmt);
 
   std::shared_ptr<orm::QueryResult> exec(const oatpp::String& statement,
                                          const provider::ResourceHandle<orm::Connection>& connection = nullptr);
 
+  static bool isBusy(sqlite3* handle);
+
+  /*
+   * Take statement from the connection statement cache or prepare a new one.
+   * Returns nullptr if statement can't be prepared - error is left on the connection.
+   */
+  static sqlite3_stmt* prepareStatement(sqlite3* handle, const std::shared_ptr<Connection>& connection, const oatpp::String& query);
+
+  /*
+   * Prepare statement of the query about to run - see prepareStatement().
+   * With the result cache - tables written by the statement are reported to the cache as changes of the connection.
+   * If readTables is not nullptr - statement is prepared fresh and tables it reads are collected,
+   * readsVirtualTable is set if it reads a &id:oatpp::sqlite::VirtualTable;.
+   */
+  sqlite3_stmt* prepareQuery(sqlite3* handle,
+                             const std::shared_ptr<Connection>& connection,
+                             const oatpp::String& query,
+                             std::vector<std::string>* readTables,
+                             bool* readsVirtualTable);
+
+  std::vector<std::shared_ptr<ql_template::Parser::TemplateExtra>> getTemplates();
+  static oatpp::String getSavepointName(v_int32 depth);
+
   oatpp::String getSchemaVersionTableName(const oatpp::String& suffix);
   std::shared_ptr<orm::QueryResult> updateSchemaVersion(v_int64 newVersion,
                                                         const oatpp::String& suffix,
@@ -79,12 +307,90 @@ private:
 private:
   std::shared_ptr<ConnectionInvalidator> m_connectionInvalidator;
   std::shared_ptr<provider::Provider<Connection>> m_connectionProvider;
+  /* set if the provider routes connections to different databases - see DatabaseScopeProvider */
+  std::shared_ptr<DatabaseScopeProvider> m_databaseScopeProvider;
   std::shared_ptr<mapping::ResultMapper> m_resultMapper;
   mapping::Serializer m_serializer;
+  std::shared_ptr<ResultCache> m_resultCache;
+  std::shared_ptr<PoolMetrics> m_poolMetrics;
+  json::ObjectMapper m_keyMapper;
+private:
+  std::mutex m_templatesMutex;
+  /* key - {template name, template text}. DbClient parses its templates each time it's created */
+  std::map<std::pair<std::string, std::string>, std::shared_ptr<ql_template::Parser::TemplateExtra>> m_templates;
+private:
+  std::atomic<v_int32> m_defaultTransactionMode;
+  std::atomic<v_int64> m_variableNumberLimit;
+private:
+  std::atomic<bool> m_requestCoalescing;
+  std::mutex m_inFlightMutex;
+  std::unordered_map<std::string, std::shared_future<std::shared_ptr<const mapping::ResultSet>>> m_inFlight;
+  std::unordered_set<std::string> m_nonCoalescableQueries;
+  /* read-only queries checked not to read virtual tables - when the result cache doesn't track them */
+  std::unordered_set<std::string> m_shareCheckedQueries;
 public:
 
   Executor(const std::shared_ptr<provider::Provider<Connection>>& connectionProvider);
 
+  /**
+   * Enable caching of read-only query results. <br>
+   * Must be set before the executor is used.
+   * @param resultCache - &id:oatpp::sqlite::ResultCache;. `nullptr` to disable caching.
+   */
+  void setResultCache(const std::shared_ptr<ResultCache>& resultCache);
+
+  /**
+   * Get result cache.
+   * @return - &id:oatpp::sqlite::ResultCache; or `nullptr` if caching is disabled.
+   */
+  std::shared_ptr<ResultCache> getResultCache() const;
+
+  /**
+   * Set &id:oatpp::sqlite::DatabaseScopeProvider; used to key shared results (result cache, request coalescing). <br>
+   * Set automatically if the connection provider of the executor implements it. Set it explicitly if such provider
+   * is wrapped in a pool - ex.: &id:oatpp::sqlite::ImageConnectionProvider; in &id:oatpp::sqlite::ConnectionPool;. <br>
+   * Must be set before the executor is used.
+   * @param databaseScopeProvider - &id:oatpp::sqlite::DatabaseScopeProvider;. `nullptr` - single scope.
+   */
+  void setDatabaseScopeProvider(const std::shared_ptr<DatabaseScopeProvider>& databaseScopeProvider);
+
+  /**
+   * Enable/disable coalescing of identical concurrent reads. <br>
+   * When enabled, if a read-only query with the same text and the same parameter values is already running,
+   * the caller waits for its materialized result instead of running the query once again. <br>
+   * Queries executed on an explicit connection (ex.: inside a transaction) and queries reading
+   * a &id:oatpp::sqlite::VirtualTable; (its data may be scoped to the calling thread) are never coalesced.
+   * @param enabled
+   */
+  void setRequestCoalescing(bool enabled);
+
+  /**
+   * Check if request coalescing is enabled.
+   * @return
+   */
+  bool isRequestCoalescing() const;
+
+  /**
+   * Check if query may be coalesced. Queries found to write are never coalesced.
+   * @param query - query text with collection parameters expanded.
+   * @return
+   */
+  bool isCoalescable(const oatpp::String& query);
+
+  /**
+   * Record connection acquisition wait time in &id:oatpp::sqlite::PoolMetrics;. <br>
+   * Must be set before the executor is used. <br>
+   * Ex.: `executor->setPoolMetrics(connectionProvider->getPoolMetrics())`.
+   * @param poolMetrics - &id:oatpp::sqlite::PoolMetrics;. `nullptr` to disable.
+   */
+  void setPoolMetrics(const std::shared_ptr<PoolMetrics>& poolMetrics);
+
+  /**
+   * Get pool metrics.
+   * @return - &id:oatpp::sqlite::PoolMetrics; or `nullptr`.
+   */
+  std::shared_ptr<PoolMetrics> getPoolMetrics() const;
+
   std::shared_ptr<data::mapping::TypeResolver> createTypeResolver() override;
 
   StringTemplate parseQueryTemplate(const oatpp::String& name,
@@ -99,12 +405,95 @@ public:
                                             const std::shared_ptr<const data::mapping::TypeResolver>& typeResolver,
                                             const provider::ResourceHandle<orm::Connection>& connection) override;
 
+  /**
+   * Set mode used by &l:Executor::begin (); when no mode is specified - ex.: by `oatpp::orm::Transaction`. <br>
+   * Default - &l:Executor::TransactionMode::DEFERRED;.
+   * @param mode - &l:Executor::TransactionMode;.
+   */
+  void setDefaultTransactionMode(TransactionMode mode);
+
+  /**
+   * Get default transaction mode.
+   * @return - &l:Executor::TransactionMode;.
+   */
+  TransactionMode getDefaultTransactionMode() const;
+
+  /**
+   * Begin transaction in the default mode. See &l:Executor::begin (TransactionMode mode, ...);.
+   */
   std::shared_ptr<orm::QueryResult> begin(const provider::ResourceHandle<orm::Connection>& connection = nullptr) override;
 
+  /**
+   * Begin transaction. <br>
+   * If the connection is already in a transaction - begin nested transaction (`SAVEPOINT`); `mode` is ignored.
+   * @param mode - &l:Executor::TransactionMode;.
+   * @param connection
+   * @return - query result.
+   */
+  std::shared_ptr<orm::QueryResult> begin(TransactionMode mode, const provider::ResourceHandle<orm::Connection>& connection = nullptr);
+
+  /**
+   * Commit transaction or release the innermost nested transaction (`RELEASE SAVEPOINT`).
+   * @param connection
+   * @return - query result.
+   */
   std::shared_ptr<orm::QueryResult> commit(const provider::ResourceHandle<orm::Connection>& connection) override;
 
+  /**
+   * Rollback transaction or the innermost nested transaction (`ROLLBACK TO SAVEPOINT`).
+   * @param connection
+   * @return - query result.
+   */
   std::shared_ptr<orm::QueryResult> rollback(const provider::ResourceHandle<orm::Connection>& connection) override;
 
+  /**
+   * Run transaction on a new connection, retrying it with jittered exponential backoff if it fails
+   * with `SQLITE_BUSY` or `SQLITE_LOCKED`. <br>
+   * *Note:* don't call it within another transaction - nested transaction can't be restarted alone.
+   * @param body - &l:Executor::TransactionBody;. May be called several times.
+   * @param mode - &l:Executor::TransactionMode;.
+   * @param policy - &l:Executor::RetryPolicy;.
+   * @return - `true` if committed, `false` if body requested rollback.
+   * @throws - `std::runtime_error` if attempts are exhausted or on a non-busy error.
+   */
+  bool runTransaction(const TransactionBody& body, TransactionMode mode, const RetryPolicy& policy);
+
+  /**
+   * Run transaction with default &l:Executor::RetryPolicy;. See &l:Executor::runTransaction (const TransactionBody& body, TransactionMode mode, const RetryPolicy& policy);.
+   * @param body - &l:Executor::TransactionBody;.
+   * @param mode - &l:Executor::TransactionMode;.
+   * @return - `true` if committed, `false` if body requested rollback.
+   */
+  bool runTransaction(const TransactionBody& body, TransactionMode mode = TransactionMode::IMMEDIATE);
+
+  /**
+   * Prepare all query templates registered with this executor (by DbClients created with it) against the live schema. <br>
+   * Prepared statements are kept in the statement cache of the connection. <br>
+   * Call it after all DbClients are created and the database schema is migrated.
+   * @param connection - connection to prepare statements on. If `nullptr` - a new connection is acquired.
+   * @return - &l:Executor::TemplateInfo; for each template - errors and column metadata.
+   */
+  std::vector<TemplateInfo> prepareTemplates(const provider::ResourceHandle<orm::Connection>& connection = nullptr);
+
+  /**
+   * Prepare all registered query templates and fail if any of them is invalid. See &l:Executor::prepareTemplates ();.
+   * @param connection - connection to prepare statements on. If `nullptr` - a new connection is acquired.
+   * @return - &l:Executor::TemplateInfo; for each template.
+   * @throws - `std::runtime_error` listing names and errors of all invalid templates.
+   */
+  std::vector<TemplateInfo> validateTemplates(const provider::ResourceHandle<orm::Connection>& connection = nullptr);
+
+  /**
+   * Warm up connections before the server starts serving requests. <br>
+   * Opens `connectionsCount` connections, loads the database schema, runs warm-up queries and prepares
+   * all query templates registered with this executor (by DbClients created with it) on each connection. <br>
+   * Call it after all DbClients are created and the database schema is migrated. <br>
+   * *Note:* connections are warm only while they stay in the pool - set pool TTL accordingly.
+   * @param config - &l:Executor::WarmUpConfig;.
+   * @throws - `std::runtime_error` if warm-up query fails or template can't be prepared.
+   */
+  void warmUp(const WarmUpConfig& config);
+
   v_int64 getSchemaVersion(const oatpp::String& suffix = nullptr,
                            const provider::ResourceHandle<orm::Connection>& connection = nullptr) override;
 
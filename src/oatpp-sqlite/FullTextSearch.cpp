@@ -0,0 +1,253 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#include "FullTextSearch.hpp"
+
+#include "Utils.hpp"
+
+#include "oatpp/data/stream/BufferStream.hpp"
+
+namespace oatpp { namespace sqlite {
+
+FullTextSearch::FullTextSearch(const Config& config)
+  : m_config(config)
+{
+
+  if(!m_config.table || !m_config.contentTable) {
+    throw std::runtime_error("[oatpp::sqlite::FullTextSearch::FullTextSearch()]: Error. Table names must be set.");
+  }
+
+  if(!m_config.contentRowId) {
+    throw std::runtime_error("[oatpp::sqlite::FullTextSearch::FullTextSearch()]: Error. Content rowid must be set.");
+  }
+
+  if(m_config.columns.empty()) {
+    throw std::runtime_error("[oatpp::sqlite::FullTextSearch::FullTextSearch()]: Error. No columns.");
+  }
+
+}
+
+oatpp::String FullTextSearch::quoteLiteral(const oatpp::String& value) {
+  std::string result = "'";
+  for(auto c : *value) {
+    if(c == '\'') {
+      result += '\'';
+    }
+    result += c;
+  }
+  result += "'";
+  return result;
+}
+
+v_int32 FullTextSearch::getColumnIndex(const oatpp::String& name) const {
+  for(v_uint32 i = 0; i < m_config.columns.size(); i ++) {
+    if(m_config.columns[i] == name) {
+      return (v_int32) i;
+    }
+  }
+  throw std::runtime_error("[oatpp::sqlite::FullTextSearch::getColumnIndex()]: Error. "
+                           "Column '" + *name + "' is not indexed.");
+}
+
+oatpp::String FullTextSearch::getColumnsList(const char* prefix) const {
+  data::stream::BufferOutputStream stream;
+  for(v_uint32 i = 0; i < m_config.columns.size(); i ++) {
+    if(i > 0) {
+      stream << ", ";
+    }
+    stream << prefix << Utils::quoteIdentifier(m_config.columns[i]);
+  }
+  return stream.toString();
+}
+
+const FullTextSearch::Config& FullTextSearch::getConfig() const {
+  return m_config;
+}
+
+oatpp::String FullTextSearch::getCreateScript() const {
+
+  auto table = Utils::quoteIdentifier(m_config.table);
+  auto contentTable = Utils::quoteIdentifier(m_config.contentTable);
+  auto columns = getColumnsList("");
+
+  data::stream::BufferOutputStream stream;
+
+  stream << "CREATE VIRTUAL TABLE " << table << " USING fts5(" << columns
+         << ", content=" << quoteLiteral(m_config.contentTable)
+         << ", content_rowid=" << quoteLiteral(m_config.contentRowId);
+  if(m_config.tokenize) {
+    stream << ", tokenize=" << quoteLiteral(m_config.tokenize);
+  }
+  if(m_config.prefix) {
+    stream << ", prefix=" << quoteLiteral(m_config.prefix);
+  }
+  stream << ");\n";
+
+  stream << "CREATE TRIGGER " << Utils::quoteIdentifier(*m_config.table + "_ai") << " AFTER INSERT ON " << contentTable << " BEGIN\n"
+         << "  INSERT INTO " << table << "(rowid, " << columns << ") VALUES (" << Utils::getRowId(m_config.contentRowId, "new.") << ", " << getColumnsList("new.") << ");\n"
+         << "END;\n";
+
+  stream << "CREATE TRIGGER " << Utils::quoteIdentifier(*m_config.table + "_ad") << " AFTER DELETE ON " << contentTable << " BEGIN\n"
+         << "  INSERT INTO " << table << "(" << table << ", rowid, " << columns << ") "
+         << "VALUES ('delete', " << Utils::getRowId(m_config.contentRowId, "old.") << ", " << getColumnsList("old.") << ");\n"
+         << "END;\n";
+
+  /* fire only when indexed columns change - updates of other columns don't touch the index */
+  stream << "CREATE TRIGGER " << Utils::quoteIdentifier(*m_config.table + "_au") << " AFTER UPDATE OF " << columns;
+  if(m_config.contentRowId != "rowid") {
+    stream << ", " << Utils::quoteIdentifier(m_config.contentRowId);
+  }
+  stream << " ON " << contentTable << " BEGIN\n"
+         << "  INSERT INTO " << table << "(" << table << ", rowid, " << columns << ") "
+         << "VALUES ('delete', " << Utils::getRowId(m_config.contentRowId, "old.") << ", " << getColumnsList("old.") << ");\n"
+         << "  INSERT INTO " << table << "(rowid, " << columns << ") VALUES (" << Utils::getRowId(m_config.contentRowId, "new.") << ", " << getColumnsList("new.") << ");\n"
+         << "END;\n";
+
+  stream << getRebuildScript();
+
+  return stream.toString();
+
+}
+
+oatpp::String FullTextSearch::getDropScript() const {
+  data::stream::BufferOutputStream stream;
+  stream << "DROP TRIGGER IF EXISTS " << Utils::quoteIdentifier(*m_config.table + "_ai") << ";\n";
+  stream << "DROP TRIGGER IF EXISTS " << Utils::quoteIdentifier(*m_config.table + "_ad") << ";\n";
+  stream << "DROP TRIGGER IF EXISTS " << Utils::quoteIdentifier(*m_config.table + "_au") << ";\n";
+  stream << "DROP TABLE IF EXISTS " << Utils::quoteIdentifier(m_config.table) << ";\n";
+  return stream.toString();
+}
+
+oatpp::String FullTextSearch::getRebuildScript() const {
+  auto table = Utils::quoteIdentifier(m_config.table);
+  return "INSERT INTO " + *table + "(" + *table + ") VALUES ('rebuild');\n";
+}
+
+oatpp::String FullTextSearch::getOptimizeScript() const {
+  auto table = Utils::quoteIdentifier(m_config.table);
+  return "INSERT INTO " + *table + "(" + *table + ") VALUES ('optimize');\n";
+}
+
+oatpp::String FullTextSearch::getSearchQuery(const SearchOptions& options) const {
+
+  if(!options.queryParam) {
+    throw std::runtime_error("[oatpp::sqlite::FullTextSearch::getSearchQuery()]: Error. Query parameter must be set.");
+  }
+
+  if(!options.weights.empty() && options.weights.size() != m_config.columns.size()) {
+    throw std::runtime_error("[oatpp::sqlite::FullTextSearch::getSearchQuery()]: Error. "
+                             "Number of weights doesn't match number of columns.");
+  }
+
+  if(options.snippetTokens < 1 || options.snippetTokens > 64) {
+    throw std::runtime_error("[oatpp::sqlite::FullTextSearch::getSearchQuery()]: Error. Snippet tokens must be in 1..64.");
+  }
+
+  auto table = Utils::quoteIdentifier(m_config.table);
+
+  data::stream::BufferOutputStream stream;
+
+  stream << "SELECT " << options.resultColumns;
+
+  stream << ", bm25(" << table;
+  for(auto weight : options.weights) {
+    stream << ", " << weight;
+  }
+  stream << ") AS " << Utils::quoteIdentifier(options.rankAlias);
+
+  if(options.snippetColumn) {
+    stream << ", snippet(" << table << ", " << getColumnIndex(options.snippetColumn) << ", "
+           << quoteLiteral(options.open) << ", " << quoteLiteral(options.close) << ", "
+           << quoteLiteral(options.ellipsis) << ", " << options.snippetTokens << ") AS "
+           << Utils::quoteIdentifier(options.snippetAlias);
+  }
+
+  if(options.highlightColumn) {
+    stream << ", highlight(" << table << ", " << getColumnIndex(options.highlightColumn) << ", "
+           << quoteLiteral(options.open) << ", " << quoteLiteral(options.close) << ") AS "
+           << Utils::quoteIdentifier(options.highlightAlias);
+  }
+
+  stream << " FROM " << table
+         << " JOIN " << Utils::quoteIdentifier(m_config.contentTable) << " c ON " << Utils::getRowId(m_config.contentRowId, "c.") << " = " << table << ".rowid"
+         << " WHERE " << table << " MATCH :" << options.queryParam
+         << " ORDER BY " << Utils::quoteIdentifier(options.rankAlias);
+
+  if(options.limitParam) {
+    stream << " LIMIT :" << options.limitParam;
+    if(options.offsetParam) {
+      stream << " OFFSET :" << options.offsetParam;
+    }
+  }
+
+  return stream.toString();
+
+}
+
+oatpp::String FullTextSearch::getSearchQuery() const {
+  return getSearchQuery(SearchOptions());
+}
+
+oatpp::String FullTextSearch::escapeQuery(const oatpp::String& text, bool prefix) {
+
+  if(!text) {
+    return "";
+  }
+
+  std::string result;
+  std::string word;
+
+  auto flush = [&result, &word]() {
+    if(!word.empty()) {
+      if(!result.empty()) {
+        result += ' ';
+      }
+      result += '"';
+      result += word;
+      result += '"';
+      word.clear();
+    }
+  };
+
+  for(auto c : *text) {
+    if(c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+      flush();
+    } else if(c == '"') {
+      word += "\"\"";
+    } else {
+      word += c;
+    }
+  }
+  flush();
+
+  if(prefix && !result.empty()) {
+    result += '*';
+  }
+
+  return result;
+
+}
+
+}}
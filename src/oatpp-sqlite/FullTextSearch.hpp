@@ -0,0 +1,247 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#ifndef oatpp_sqlite_FullTextSearch_hpp
+#define oatpp_sqlite_FullTextSearch_hpp
+
+#include "oatpp/Types.hpp"
+
+#include <vector>
+
+namespace oatpp { namespace sqlite {
+
+/**
+ * FTS5 index over a regular table - external-content FTS5 table kept in sync by triggers. <br>
+ * Generates migration scripts and search query templates. Ex.:
+ * ```cpp
+ * oatpp::sqlite::FullTextSearch::Config config;
+ * config.table = "docs_fts";
+ * config.contentTable = "docs";
+ * config.contentRowId = "id";
+ * config.columns = {"title", "body"};
+ *
+ * oatpp::sqlite::FullTextSearch fts(config);
+ * migration.addText(2, fts.getCreateScript());
+ * ...
+ * oatpp::sqlite::FullTextSearch::SearchOptions options;
+ * options.weights = {10.0, 1.0};
+ * options.snippetColumn = "body";
+ * QUERY(search, getFts().getSearchQuery(options), PARAM(String, query), PARAM(Int64, limit))
+ * ...
+ * client.search(oatpp::sqlite::FullTextSearch::escapeQuery(userInput, true), 20);
+ * ```
+ * FTS5 must be enabled in SQLite - `SQLITE_ENABLE_FTS5`.
+ */
+class FullTextSearch {
+public:
+
+  /**
+   * Index configuration.
+   */
+  struct Config {
+
+    /**
+     * Name of the FTS5 table.
+     */
+    oatpp::String table;
+
+    /**
+     * Name of the content table.
+     */
+    oatpp::String contentTable;
+
+    /**
+     * Integer primary key of the content table.
+     */
+    oatpp::String contentRowId = "rowid";
+
+    /**
+     * Indexed columns of the content table.
+     */
+    std::vector<oatpp::String> columns;
+
+    /**
+     * FTS5 `tokenize` option. Ex.: `"porter unicode61"`. `nullptr` - FTS5 default.
+     */
+    oatpp::String tokenize;
+
+    /**
+     * FTS5 `prefix` option - lengths of prefix indexes. Ex.: `"2 3"`. `nullptr` - no prefix indexes.
+     */
+    oatpp::String prefix;
+
+  };
+
+  /**
+   * Options of the search query.
+   */
+  struct SearchOptions {
+
+    /**
+     * Columns selected from the content table. Content table is aliased as `c`.
+     */
+    oatpp::String resultColumns = "c.*";
+
+    /**
+     * Name of the query parameter holding the `MATCH` expression.
+     */
+    oatpp::String queryParam = "query";
+
+    /**
+     * Name of the `LIMIT` parameter. `nullptr` - no limit.
+     */
+    oatpp::String limitParam = "limit";
+
+    /**
+     * Name of the `OFFSET` parameter. `nullptr` - no offset.
+     */
+    oatpp::String offsetParam;
+
+    /**
+     * `bm25` weights of the columns in the order of &l:FullTextSearch::Config::columns;. Empty - equal weights.
+     */
+    std::vector<v_float64> weights;
+
+    /**
+     * Alias of the rank column. Rows are ordered by rank - lower is better.
+     */
+    oatpp::String rankAlias = "rank";
+
+    /**
+     * Column to take snippet from. `nullptr` - no snippet.
+     */
+    oatpp::String snippetColumn;
+
+    /**
+     * Alias of the snippet column.
+     */
+    oatpp::String snippetAlias = "snippet";
+
+    /**
+     * Max number of tokens in snippet. 1..64.
+     */
+    v_int32 snippetTokens = 16;
+
+    /**
+     * Column to highlight. `nullptr` - no highlight.
+     */
+    oatpp::String highlightColumn;
+
+    /**
+     * Alias of the highlight column.
+     */
+    oatpp::String highlightAlias = "highlight";
+
+    /**
+     * Text inserted before matched terms.
+     */
+    oatpp::String open = "<b>";
+
+    /**
+     * Text inserted after matched terms.
+     */
+    oatpp::String close = "</b>";
+
+    /**
+     * Text marking truncated snippet.
+     */
+    oatpp::String ellipsis = "...";
+
+  };
+
+private:
+  static oatpp::String quoteLiteral(const oatpp::String& value);
+private:
+  v_int32 getColumnIndex(const oatpp::String& name) const;
+  oatpp::String getColumnsList(const char* prefix) const;
+private:
+  Config m_config;
+public:
+
+  /**
+   * Constructor.
+   * @param config - &l:FullTextSearch::Config;.
+   */
+  FullTextSearch(const Config& config);
+
+  /**
+   * Get config.
+   * @return - &l:FullTextSearch::Config;.
+   */
+  const Config& getConfig() const;
+
+  /**
+   * Script creating the FTS5 table, the sync triggers and indexing the existing content. <br>
+   * Use as schema migration - `SchemaMigration::addText`.
+   * @return
+   */
+  oatpp::String getCreateScript() const;
+
+  /**
+   * Script dropping the triggers and the FTS5 table.
+   * @return
+   */
+  oatpp::String getDropScript() const;
+
+  /**
+   * Script rebuilding the index from the content table. Needed if the content was changed with triggers disabled.
+   * @return
+   */
+  oatpp::String getRebuildScript() const;
+
+  /**
+   * Script merging index segments. Run after bulk loads.
+   * @return
+   */
+  oatpp::String getOptimizeScript() const;
+
+  /**
+   * Query template of the ranked search - `MATCH` with `bm25` ordering, optional limit, snippet and highlight. <br>
+   * Use as `QUERY` text or with `DbClient::executeQuery`.
+   * @param options - &l:FullTextSearch::SearchOptions;.
+   * @return
+   */
+  oatpp::String getSearchQuery(const SearchOptions& options) const;
+
+  /**
+   * Query template of the ranked search with default &l:FullTextSearch::SearchOptions;.
+   * @return
+   */
+  oatpp::String getSearchQuery() const;
+
+  /**
+   * Turn free text into the FTS5 query - every word is quoted so user input can't break the query syntax.
+   * Words are combined with implicit `AND`.
+   * @param text - user input.
+   * @param prefix - match last word as prefix - for search-as-you-type.
+   * @return - FTS5 query. Empty string if there are no words.
+   */
+  static oatpp::String escapeQuery(const oatpp::String& text, bool prefix = false);
+
+};
+
+}}
+
+#endif // oatpp_sqlite_FullTextSearch_hpp
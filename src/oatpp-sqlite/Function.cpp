@@ -0,0 +1,221 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#include "Function.hpp"
+
+#include "Types.hpp"
+
+namespace oatpp { namespace sqlite {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Function
+
+Function::Function(const oatpp::String& name, const std::vector<const Type*>& argTypes, bool deterministic)
+  : m_name(name)
+  , m_argTypes(argTypes)
+  , m_deterministic(deterministic)
+  , m_typeResolver(std::make_shared<data::mapping::TypeResolver>())
+{
+  m_typeResolver->addKnownClasses({
+    Blob::Class::CLASS_ID,
+    Embedding::Class::CLASS_ID
+  });
+}
+
+void Function::onDestroy(void* data) {
+  delete static_cast<std::shared_ptr<Function>*>(data);
+}
+
+void Function::setError(sqlite3_context* context, const char* message) {
+  sqlite3_result_error(context, message, -1);
+}
+
+std::vector<oatpp::Void> Function::readArgs(int argc, sqlite3_value** argv) const {
+  std::vector<oatpp::Void> args;
+  args.reserve(argc);
+  for(int i = 0; i < argc; i ++) {
+    mapping::Deserializer::InData inData(argv[i], m_typeResolver);
+    args.push_back(m_deserializer.deserialize(inData, m_argTypes[i]));
+  }
+  return args;
+}
+
+int Function::getFlags() const {
+  int flags = SQLITE_UTF8;
+  if(m_deterministic) {
+    flags |= SQLITE_DETERMINISTIC;
+  }
+  return flags;
+}
+
+void* Function::createUserData() {
+  return new std::shared_ptr<Function>(shared_from_this());
+}
+
+oatpp::String Function::getName() const {
+  return m_name;
+}
+
+const std::vector<const Function::Type*>& Function::getArgTypes() const {
+  return m_argTypes;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ScalarFunction
+
+ScalarFunction::ScalarFunction(const oatpp::String& name, const std::vector<const Type*>& argTypes, bool deterministic)
+  : Function(name, argTypes, deterministic)
+{}
+
+void ScalarFunction::onCall(sqlite3_context* context, int argc, sqlite3_value** argv) {
+  auto function = static_cast<ScalarFunction*>(static_cast<std::shared_ptr<Function>*>(sqlite3_user_data(context))->get());
+  try {
+    auto result = function->call(function->readArgs(argc, argv));
+    function->m_serializer.serialize(context, result);
+  } catch (std::exception& e) {
+    setError(context, e.what());
+  }
+}
+
+void ScalarFunction::install(sqlite3* handle) {
+  auto res = sqlite3_create_function_v2(handle, getName()->c_str(), (int) getArgTypes().size(), getFlags(),
+                                        createUserData(), &onCall, nullptr, nullptr, &onDestroy);
+  if(res != SQLITE_OK) {
+    throw std::runtime_error("[oatpp::sqlite::ScalarFunction::install()]: Error. Can't create function '" +
+                             *getName() + "'. " + sqlite3_errmsg(handle));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// AggregateFunction
+
+AggregateFunction::AggregateFunction(const oatpp::String& name, const std::vector<const Type*>& argTypes, bool deterministic)
+  : Function(name, argTypes, deterministic)
+{}
+
+AggregateFunction::Accumulator* AggregateFunction::getAccumulator(sqlite3_context* context, bool create) {
+  /* aggregate context is zeroed on the first call - it holds pointer to the accumulator of the group */
+  auto slot = static_cast<Accumulator**>(sqlite3_aggregate_context(context, create ? sizeof(Accumulator*) : 0));
+  if(slot == nullptr) {
+    return nullptr;
+  }
+  if(*slot == nullptr && create) {
+    auto function = static_cast<AggregateFunction*>(static_cast<std::shared_ptr<Function>*>(sqlite3_user_data(context))->get());
+    *slot = function->createAccumulator().release();
+  }
+  return *slot;
+}
+
+void AggregateFunction::onStep(sqlite3_context* context, int argc, sqlite3_value** argv) {
+  auto function = static_cast<AggregateFunction*>(static_cast<std::shared_ptr<Function>*>(sqlite3_user_data(context))->get());
+  try {
+    auto accumulator = getAccumulator(context, true);
+    if(accumulator == nullptr) {
+      sqlite3_result_error_nomem(context);
+      return;
+    }
+    accumulator->step(function->readArgs(argc, argv));
+  } catch (std::exception& e) {
+    setError(context, e.what());
+  }
+}
+
+void AggregateFunction::onFinal(sqlite3_context* context) {
+
+  auto function = static_cast<AggregateFunction*>(static_cast<std::shared_ptr<Function>*>(sqlite3_user_data(context))->get());
+
+  /* no rows in the group - result of the empty accumulator */
+  std::unique_ptr<Accumulator> accumulator(getAccumulator(context, false));
+
+  try {
+    if(!accumulator) {
+      accumulator = function->createAccumulator();
+    }
+    function->m_serializer.serialize(context, accumulator->getResult());
+  } catch (std::exception& e) {
+    setError(context, e.what());
+  }
+
+}
+
+void AggregateFunction::onValue(sqlite3_context* context) {
+  auto function = static_cast<AggregateFunction*>(static_cast<std::shared_ptr<Function>*>(sqlite3_user_data(context))->get());
+  try {
+    auto accumulator = getAccumulator(context, true);
+    if(accumulator == nullptr) {
+      sqlite3_result_error_nomem(context);
+      return;
+    }
+    function->m_serializer.serialize(context, accumulator->getResult());
+  } catch (std::exception& e) {
+    setError(context, e.what());
+  }
+}
+
+void AggregateFunction::install(sqlite3* handle) {
+  auto res = sqlite3_create_function_v2(handle, getName()->c_str(), (int) getArgTypes().size(), getFlags(),
+                                        createUserData(), nullptr, &onStep, &onFinal, &onDestroy);
+  if(res != SQLITE_OK) {
+    throw std::runtime_error("[oatpp::sqlite::AggregateFunction::install()]: Error. Can't create function '" +
+                             *getName() + "'. " + sqlite3_errmsg(handle));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// WindowFunction
+
+WindowFunction::WindowFunction(const oatpp::String& name, const std::vector<const Type*>& argTypes, bool deterministic)
+  : AggregateFunction(name, argTypes, deterministic)
+{}
+
+void WindowFunction::onInverse(sqlite3_context* context, int argc, sqlite3_value** argv) {
+  auto function = static_cast<WindowFunction*>(static_cast<std::shared_ptr<Function>*>(sqlite3_user_data(context))->get());
+  try {
+    /* accumulator is always created by WindowFunction::createAccumulator() */
+    auto accumulator = static_cast<WindowAccumulator*>(getAccumulator(context, true));
+    if(accumulator == nullptr) {
+      sqlite3_result_error_nomem(context);
+      return;
+    }
+    accumulator->inverse(function->readArgs(argc, argv));
+  } catch (std::exception& e) {
+    setError(context, e.what());
+  }
+}
+
+std::unique_ptr<AggregateFunction::Accumulator> WindowFunction::createAccumulator() {
+  return createWindowAccumulator();
+}
+
+void WindowFunction::install(sqlite3* handle) {
+  auto res = sqlite3_create_window_function(handle, getName()->c_str(), (int) getArgTypes().size(), getFlags(),
+                                            createUserData(), &onStep, &onFinal, &onValue, &onInverse, &onDestroy);
+  if(res != SQLITE_OK) {
+    throw std::runtime_error("[oatpp::sqlite::WindowFunction::install()]: Error. Can't create function '" +
+                             *getName() + "'. " + sqlite3_errmsg(handle));
+  }
+}
+
+}}
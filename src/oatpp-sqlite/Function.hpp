@@ -0,0 +1,543 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#ifndef oatpp_sqlite_Function_hpp
+#define oatpp_sqlite_Function_hpp
+
+#include "mapping/Deserializer.hpp"
+#include "mapping/Serializer.hpp"
+
+#include "oatpp/data/mapping/TypeResolver.hpp"
+#include "oatpp/Types.hpp"
+
+#include <sqlite3.h>
+
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace oatpp { namespace sqlite {
+
+/**
+ * SQL function implemented in C++. <br>
+ * Arguments are mapped to oatpp types with &id:oatpp::sqlite::mapping::Deserializer;,
+ * the result is mapped back with &id:oatpp::sqlite::mapping::Serializer;. <br>
+ * Register with &id:oatpp::sqlite::ConnectionProvider::addFunction; - the function is installed on every new connection.
+ */
+class Function : public std::enable_shared_from_this<Function> {
+public:
+  typedef oatpp::data::type::Type Type;
+protected:
+
+  /*
+   * Signature of lambda or function pointer - as `std::function` type.
+   */
+  template<class F>
+  struct Signature : Signature<decltype(&F::operator())> {};
+
+  template<class C, class R, class ... Args>
+  struct Signature<R(C::*)(Args...) const> {
+    typedef R Result;
+    typedef std::function<R(Args...)> Type;
+  };
+
+  template<class C, class R, class ... Args>
+  struct Signature<R(C::*)(Args...)> {
+    typedef R Result;
+    typedef std::function<R(Args...)> Type;
+  };
+
+  template<class R, class ... Args>
+  struct Signature<R(*)(Args...)> {
+    typedef R Result;
+    typedef std::function<R(Args...)> Type;
+  };
+
+  template<class T>
+  static const Type* getArgType() {
+    return std::decay<T>::type::Class::getType();
+  }
+
+  template<class T>
+  static typename std::decay<T>::type getArg(const oatpp::Void& arg) {
+    return arg.template cast<typename std::decay<T>::type>();
+  }
+
+protected:
+  static void onDestroy(void* data);
+  static void setError(sqlite3_context* context, const char* message);
+private:
+  oatpp::String m_name;
+  std::vector<const Type*> m_argTypes;
+  bool m_deterministic;
+protected:
+  mapping::Serializer m_serializer;
+  mapping::Deserializer m_deserializer;
+  std::shared_ptr<data::mapping::TypeResolver> m_typeResolver;
+protected:
+
+  /**
+   * Map SQLite arguments to oatpp values of declared types.
+   * @param argc
+   * @param argv
+   * @return
+   */
+  std::vector<oatpp::Void> readArgs(int argc, sqlite3_value** argv) const;
+
+  /**
+   * Flags for `sqlite3_create_function_v2`.
+   * @return
+   */
+  int getFlags() const;
+
+  /**
+   * Get pointer passed as user data to `sqlite3_create_function_v2`. Released with &l:Function::onDestroy ();.
+   * @return
+   */
+  void* createUserData();
+
+public:
+
+  /**
+   * Constructor.
+   * @param name - SQL name of the function.
+   * @param argTypes - oatpp types of arguments. Ex.: `{oatpp::Int64::Class::getType(), oatpp::String::Class::getType()}`.
+   * @param deterministic - function always returns the same result for the same arguments (`SQLITE_DETERMINISTIC`).
+   * Deterministic functions may be used in indexes and are optimized by the query planner.
+   */
+  Function(const oatpp::String& name, const std::vector<const Type*>& argTypes, bool deterministic);
+
+  /**
+   * Virtual destructor.
+   */
+  virtual ~Function() = default;
+
+  /**
+   * Get SQL name of the function.
+   * @return
+   */
+  oatpp::String getName() const;
+
+  /**
+   * Get types of arguments.
+   * @return
+   */
+  const std::vector<const Type*>& getArgTypes() const;
+
+  /**
+   * Register function on the connection.
+   * @param handle - native connection handle.
+   */
+  virtual void install(sqlite3* handle) = 0;
+
+};
+
+/**
+ * Scalar SQL function.
+ */
+class ScalarFunction : public Function {
+private:
+
+  template<class R, class ... Args>
+  class Lambda;
+
+private:
+
+  template<class R, class ... Args>
+  static std::shared_ptr<ScalarFunction> createLambda(const oatpp::String& name,
+                                                      const std::function<R(Args...)>& lambda,
+                                                      bool deterministic)
+  {
+    return std::make_shared<Lambda<R, Args...>>(name, lambda, deterministic);
+  }
+
+private:
+  static void onCall(sqlite3_context* context, int argc, sqlite3_value** argv);
+public:
+
+  /**
+   * Create scalar function from lambda. Argument and result types are oatpp types deduced from the lambda signature. <br>
+   * Ex.: `ScalarFunction::createShared("add_tax", [](const oatpp::Float64& price) -> oatpp::Float64 { ... })`.
+   * @tparam F - lambda type.
+   * @param name - SQL name of the function.
+   * @param lambda - lambda.
+   * @param deterministic - see &l:Function::Function ();.
+   * @return - `std::shared_ptr` to &l:ScalarFunction;.
+   */
+  template<class F>
+  static std::shared_ptr<ScalarFunction> createShared(const oatpp::String& name, const F& lambda, bool deterministic = true) {
+    return createLambda(name, typename Signature<F>::Type(lambda), deterministic);
+  }
+
+  /**
+   * Constructor.
+   * @param name - SQL name of the function.
+   * @param argTypes - oatpp types of arguments.
+   * @param deterministic - see &l:Function::Function ();.
+   */
+  ScalarFunction(const oatpp::String& name, const std::vector<const Type*>& argTypes, bool deterministic = true);
+
+  /**
+   * Compute the function.
+   * @param args - arguments mapped to declared types.
+   * @return - result. Its type must be supported by &id:oatpp::sqlite::mapping::Serializer;.
+   */
+  virtual oatpp::Void call(const std::vector<oatpp::Void>& args) = 0;
+
+  void install(sqlite3* handle) override;
+
+};
+
+template<class R, class ... Args>
+class ScalarFunction::Lambda : public ScalarFunction {
+private:
+  std::function<R(Args...)> m_lambda;
+private:
+
+  template<std::size_t ... I>
+  oatpp::Void invoke(const std::vector<oatpp::Void>& args, std::index_sequence<I...>) {
+    (void) args;
+    return m_lambda(getArg<Args>(args[I])...);
+  }
+
+public:
+
+  Lambda(const oatpp::String& name, const std::function<R(Args...)>& lambda, bool deterministic)
+    : ScalarFunction(name, {getArgType<Args>()...}, deterministic)
+    , m_lambda(lambda)
+  {}
+
+  oatpp::Void call(const std::vector<oatpp::Void>& args) override {
+    return invoke(args, std::index_sequence_for<Args...>());
+  }
+
+};
+
+/**
+ * Aggregate SQL function.
+ */
+class AggregateFunction : public Function {
+public:
+
+  /**
+   * State of the aggregate for a single group of rows.
+   */
+  class Accumulator {
+  public:
+
+    /**
+     * Virtual destructor.
+     */
+    virtual ~Accumulator() = default;
+
+    /**
+     * Add row to the aggregate.
+     * @param args - arguments mapped to declared types.
+     */
+    virtual void step(const std::vector<oatpp::Void>& args) = 0;
+
+    /**
+     * Get value of the aggregate.
+     * @return - result. Its type must be supported by &id:oatpp::sqlite::mapping::Serializer;.
+     */
+    virtual oatpp::Void getResult() = 0;
+
+  };
+
+private:
+
+  template<class State, class R, class ... Args>
+  class Lambda;
+
+private:
+
+  template<class State, class R, class FinalArg, class ... Args>
+  static std::shared_ptr<AggregateFunction> createLambda(const oatpp::String& name,
+                                                         const std::function<void(State&, Args...)>& step,
+                                                         const std::function<R(FinalArg)>& result,
+                                                         bool deterministic)
+  {
+    return std::make_shared<Lambda<State, R, Args...>>(name, step, result, deterministic);
+  }
+
+protected:
+  static Accumulator* getAccumulator(sqlite3_context* context, bool create);
+  static void onStep(sqlite3_context* context, int argc, sqlite3_value** argv);
+  static void onFinal(sqlite3_context* context);
+  static void onValue(sqlite3_context* context);
+public:
+
+  /**
+   * Create aggregate function from lambdas. State is a default-constructed C++ object created for each group of rows. <br>
+   * Argument and result types are oatpp types deduced from the lambda signatures. Ex.:
+   * ```cpp
+   * AggregateFunction::createShared("sum_sq",
+   *   [](v_float64& sum, const oatpp::Float64& x) { if(x) sum += *x * *x; },
+   *   [](const v_float64& sum) -> oatpp::Float64 { return sum; }
+   * );
+   * ```
+   * @tparam Step - step lambda type - `void(State&, Args...)`.
+   * @tparam Result - result lambda type - `R(const State&)`.
+   * @param name - SQL name of the function.
+   * @param step - called for each row.
+   * @param result - called to get the value of the aggregate.
+   * @param deterministic - see &l:Function::Function ();.
+   * @return - `std::shared_ptr` to &l:AggregateFunction;.
+   */
+  template<class Step, class Result>
+  static std::shared_ptr<AggregateFunction> createShared(const oatpp::String& name,
+                                                         const Step& step,
+                                                         const Result& result,
+                                                         bool deterministic = true)
+  {
+    return createLambda(name, typename Signature<Step>::Type(step), typename Signature<Result>::Type(result), deterministic);
+  }
+
+  /**
+   * Constructor.
+   * @param name - SQL name of the function.
+   * @param argTypes - oatpp types of arguments.
+   * @param deterministic - see &l:Function::Function ();.
+   */
+  AggregateFunction(const oatpp::String& name, const std::vector<const Type*>& argTypes, bool deterministic = true);
+
+  /**
+   * Create state for a new group of rows.
+   * @return - &l:AggregateFunction::Accumulator;.
+   */
+  virtual std::unique_ptr<Accumulator> createAccumulator() = 0;
+
+  void install(sqlite3* handle) override;
+
+};
+
+template<class State, class R, class ... Args>
+class AggregateFunction::Lambda : public AggregateFunction {
+private:
+
+  class LambdaAccumulator : public Accumulator {
+  private:
+    Lambda* m_function;
+    State m_state;
+  private:
+
+    template<std::size_t ... I>
+    void invoke(const std::vector<oatpp::Void>& args, std::index_sequence<I...>) {
+      (void) args;
+      m_function->m_step(m_state, getArg<Args>(args[I])...);
+    }
+
+  public:
+
+    LambdaAccumulator(Lambda* function)
+      : m_function(function)
+      , m_state()
+    {}
+
+    void step(const std::vector<oatpp::Void>& args) override {
+      invoke(args, std::index_sequence_for<Args...>());
+    }
+
+    oatpp::Void getResult() override {
+      return m_function->m_result(m_state);
+    }
+
+  };
+
+private:
+  std::function<void(State&, Args...)> m_step;
+  std::function<R(State&)> m_result;
+public:
+
+  template<class FinalArg>
+  Lambda(const oatpp::String& name,
+         const std::function<void(State&, Args...)>& step,
+         const std::function<R(FinalArg)>& result,
+         bool deterministic)
+    : AggregateFunction(name, {getArgType<Args>()...}, deterministic)
+    , m_step(step)
+    , m_result(result)
+  {}
+
+  std::unique_ptr<Accumulator> createAccumulator() override {
+    return std::unique_ptr<Accumulator>(new LambdaAccumulator(this));
+  }
+
+};
+
+/**
+ * Aggregate window SQL function - can be used as `<function>(...) OVER (...)`. <br>
+ * Rows leaving the window frame are removed from the aggregate with &l:WindowFunction::WindowAccumulator::inverse ();.
+ */
+class WindowFunction : public AggregateFunction {
+public:
+
+  /**
+   * State of the aggregate for a window frame.
+   */
+  class WindowAccumulator : public Accumulator {
+  public:
+
+    /**
+     * Remove row from the aggregate.
+     * @param args - arguments mapped to declared types.
+     */
+    virtual void inverse(const std::vector<oatpp::Void>& args) = 0;
+
+  };
+
+private:
+
+  template<class State, class R, class ... Args>
+  class Lambda;
+
+private:
+
+  template<class State, class R, class FinalArg, class ... Args>
+  static std::shared_ptr<WindowFunction> createLambda(const oatpp::String& name,
+                                                      const std::function<void(State&, Args...)>& step,
+                                                      const std::function<void(State&, Args...)>& inverse,
+                                                      const std::function<R(FinalArg)>& result,
+                                                      bool deterministic)
+  {
+    return std::make_shared<Lambda<State, R, Args...>>(name, step, inverse, result, deterministic);
+  }
+
+private:
+  static void onInverse(sqlite3_context* context, int argc, sqlite3_value** argv);
+public:
+
+  /**
+   * Constructor.
+   * @param name - SQL name of the function.
+   * @param argTypes - oatpp types of arguments.
+   * @param deterministic - see &l:Function::Function ();.
+   */
+  WindowFunction(const oatpp::String& name, const std::vector<const Type*>& argTypes, bool deterministic = true);
+
+  /**
+   * Create window function from lambdas. See &l:AggregateFunction::createShared ();. <br>
+   * `inverse` has the same signature as `step` and removes the row from the state.
+   * @tparam Step - step lambda type - `void(State&, Args...)`.
+   * @tparam Inverse - inverse lambda type - `void(State&, Args...)`.
+   * @tparam Result - result lambda type - `R(const State&)`.
+   * @param name - SQL name of the function.
+   * @param step - called for each row entering the window frame.
+   * @param inverse - called for each row leaving the window frame.
+   * @param result - called to get the value of the aggregate. Must not modify the state.
+   * @param deterministic - see &l:Function::Function ();.
+   * @return - `std::shared_ptr` to &l:WindowFunction;.
+   */
+  template<class Step, class Inverse, class Result>
+  static std::shared_ptr<WindowFunction> createShared(const oatpp::String& name,
+                                                      const Step& step,
+                                                      const Inverse& inverse,
+                                                      const Result& result,
+                                                      bool deterministic = true)
+  {
+    return createLambda(name,
+                        typename Signature<Step>::Type(step),
+                        typename Signature<Inverse>::Type(inverse),
+                        typename Signature<Result>::Type(result),
+                        deterministic);
+  }
+
+  /**
+   * Create state for a new window.
+   * @return - &l:WindowFunction::WindowAccumulator;.
+   */
+  virtual std::unique_ptr<WindowAccumulator> createWindowAccumulator() = 0;
+
+  std::unique_ptr<Accumulator> createAccumulator() override;
+
+  void install(sqlite3* handle) override;
+
+};
+
+template<class State, class R, class ... Args>
+class WindowFunction::Lambda : public WindowFunction {
+private:
+
+  class LambdaAccumulator : public WindowAccumulator {
+  private:
+    Lambda* m_function;
+    State m_state;
+  private:
+
+    template<std::size_t ... I>
+    void invoke(const std::function<void(State&, Args...)>& lambda, const std::vector<oatpp::Void>& args, std::index_sequence<I...>) {
+      (void) args;
+      lambda(m_state, getArg<Args>(args[I])...);
+    }
+
+  public:
+
+    LambdaAccumulator(Lambda* function)
+      : m_function(function)
+      , m_state()
+    {}
+
+    void step(const std::vector<oatpp::Void>& args) override {
+      invoke(m_function->m_step, args, std::index_sequence_for<Args...>());
+    }
+
+    void inverse(const std::vector<oatpp::Void>& args) override {
+      invoke(m_function->m_inverse, args, std::index_sequence_for<Args...>());
+    }
+
+    oatpp::Void getResult() override {
+      return m_function->m_result(m_state);
+    }
+
+  };
+
+private:
+  std::function<void(State&, Args...)> m_step;
+  std::function<void(State&, Args...)> m_inverse;
+  std::function<R(State&)> m_result;
+public:
+
+  template<class FinalArg>
+  Lambda(const oatpp::String& name,
+         const std::function<void(State&, Args...)>& step,
+         const std::function<void(State&, Args...)>& inverse,
+         const std::function<R(FinalArg)>& result,
+         bool deterministic)
+    : WindowFunction(name, {getArgType<Args>()...}, deterministic)
+    , m_step(step)
+    , m_inverse(inverse)
+    , m_result(result)
+  {}
+
+  std::unique_ptr<WindowAccumulator> createWindowAccumulator() override {
+    return std::unique_ptr<WindowAccumulator>(new LambdaAccumulator(this));
+  }
+
+};
+
+}}
+
+#endif // oatpp_sqlite_Function_hpp
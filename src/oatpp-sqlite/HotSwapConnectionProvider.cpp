@@ -0,0 +1,323 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#include "HotSwapConnectionProvider.hpp"
+#include "Utils.hpp"
+
+#include "oatpp/base/Log.hpp"
+#include "oatpp/Environment.hpp"
+
+#include <sys/stat.h>
+
+namespace oatpp { namespace sqlite {
+
+bool HotSwapConnectionProvider::FileVersion::operator == (const FileVersion& other) const {
+  return modified == other.modified && size == other.size && inode == other.inode;
+}
+
+HotSwapConnectionProvider::HotSwapConnectionProvider(const oatpp::String& filePath, const Config& config)
+  : m_filePath(filePath)
+  , m_config(config)
+  , m_running(true)
+{
+
+  m_stats.generation = 0;
+  m_stats.swapsCount = 0;
+  m_stats.failedSwapsCount = 0;
+  m_stats.lastWarmUpDuration = 0;
+
+  FileVersion version;
+  if(!readFileVersion(m_filePath, version)) {
+    throw std::runtime_error("[oatpp::sqlite::HotSwapConnectionProvider::HotSwapConnectionProvider()]: "
+                             "Error. Can't stat file '" + *m_filePath + "'.");
+  }
+
+  auto generation = createGeneration(m_filePath, version);
+  generation->id = 0;
+  try {
+    warmUp(generation);
+  } catch (...) {
+    generation->pool->stop();
+    throw;
+  }
+  m_generation = generation;
+
+  if(m_config.pollInterval.count() > 0) {
+    m_thread = std::thread([this]{
+      run();
+    });
+  }
+
+}
+
+HotSwapConnectionProvider::HotSwapConnectionProvider(const oatpp::String& filePath)
+  : HotSwapConnectionProvider(filePath, Config())
+{}
+
+HotSwapConnectionProvider::~HotSwapConnectionProvider() {
+  stop();
+}
+
+bool HotSwapConnectionProvider::readFileVersion(const oatpp::String& filePath, FileVersion& version) {
+  struct stat info;
+  if(::stat(filePath->c_str(), &info) != 0) {
+    return false;
+  }
+  version.modified = static_cast<v_int64>(info.st_mtime);
+  version.size = static_cast<v_int64>(info.st_size);
+  version.inode = static_cast<v_int64>(info.st_ino);
+  return true;
+}
+
+std::shared_ptr<HotSwapConnectionProvider::Generation>
+HotSwapConnectionProvider::createGeneration(const oatpp::String& filePath, const FileVersion& version) {
+  auto generation = std::make_shared<Generation>();
+  generation->id = -1;
+  generation->version = version;
+  if(m_config.immutable) {
+    generation->provider = ConnectionProvider::createImmutable(filePath);
+  } else {
+    generation->provider = std::make_shared<ConnectionProvider>(filePath, m_config.openFlags);
+  }
+  if(m_config.providerConfigurator) {
+    m_config.providerConfigurator(generation->provider);
+  }
+  generation->pool = ConnectionPool::createShared(generation->provider, m_config.maxConnections, m_config.maxConnectionTTL);
+  return generation;
+}
+
+void HotSwapConnectionProvider::warmUp(const std::shared_ptr<Generation>& generation) {
+
+  v_int64 count = m_config.warmUpConnections;
+  if(count > m_config.maxConnections) {
+    count = m_config.maxConnections;
+  }
+  if(count < 1) {
+    count = 1;
+  }
+
+  /* hold all connections until warm-up is done so that each query runs on a different connection */
+  std::vector<provider::ResourceHandle<Connection>> connections;
+
+  for(v_int64 i = 0; i < count; i ++) {
+
+    auto connection = generation->pool->get();
+    if(!connection) {
+      throw std::runtime_error("[oatpp::sqlite::HotSwapConnectionProvider::warmUp()]: Error. Can't get connection.");
+    }
+
+    Utils::warmUpConnection(connection.object->getHandle(), m_config.warmUpQueries);
+
+    connections.push_back(connection);
+
+  }
+
+}
+
+bool HotSwapConnectionProvider::install(const oatpp::String& filePath, const FileVersion& version) {
+
+  std::shared_ptr<Generation> generation;
+  v_int64 startTime = oatpp::Environment::getMicroTickCount();
+
+  try {
+    generation = createGeneration(filePath, version);
+    warmUp(generation);
+  } catch (std::exception& e) {
+    if(generation) {
+      generation->pool->stop();
+    }
+    std::lock_guard<std::mutex> lock(m_generationMutex);
+    m_stats.failedSwapsCount ++;
+    OATPP_LOGe("[oatpp::sqlite::HotSwapConnectionProvider::install()]", "Error. Can't swap to '{}'. {}", filePath, e.what());
+    return false;
+  }
+
+  v_int64 duration = oatpp::Environment::getMicroTickCount() - startTime;
+
+  std::shared_ptr<Generation> oldGeneration;
+  SwapCallback callback;
+  v_int64 id;
+
+  {
+    std::lock_guard<std::mutex> lock(m_generationMutex);
+    oldGeneration = m_generation;
+    generation->id = oldGeneration->id + 1;
+    m_generation = generation;
+    m_filePath = filePath;
+    m_stats.generation = generation->id;
+    m_stats.swapsCount ++;
+    m_stats.lastWarmUpDuration = duration;
+    callback = m_swapCallback;
+    id = generation->id;
+  }
+
+  /*
+   * Stopped pool closes its idle connections and invalidates connections returned to it later -
+   * the old generation drains as its ResourceHandles are released.
+   */
+  oldGeneration->pool->stop();
+
+  OATPP_LOGd("[oatpp::sqlite::HotSwapConnectionProvider::install()]", "Swapped to generation {}, file='{}', warm-up={}us.",
+             id, filePath, duration);
+
+  if(callback) {
+    callback(id);
+  }
+
+  return true;
+
+}
+
+void HotSwapConnectionProvider::run() {
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  while(m_running) {
+
+    m_condition.wait_for(lock, m_config.pollInterval, [this]{
+      return !m_running;
+    });
+
+    if(!m_running) {
+      break;
+    }
+
+    lock.unlock();
+    swap();
+    lock.lock();
+
+  }
+
+}
+
+bool HotSwapConnectionProvider::swap() {
+
+  std::lock_guard<std::mutex> swapLock(m_swapMutex);
+
+  oatpp::String filePath;
+  FileVersion currentVersion;
+  {
+    std::lock_guard<std::mutex> lock(m_generationMutex);
+    filePath = m_filePath;
+    currentVersion = m_generation->version;
+  }
+
+  FileVersion version;
+  if(!readFileVersion(filePath, version) || version == currentVersion) {
+    return false;
+  }
+
+  return install(filePath, version);
+
+}
+
+bool HotSwapConnectionProvider::swap(const oatpp::String& filePath) {
+
+  std::lock_guard<std::mutex> swapLock(m_swapMutex);
+
+  FileVersion version;
+  if(!readFileVersion(filePath, version)) {
+    std::lock_guard<std::mutex> lock(m_generationMutex);
+    m_stats.failedSwapsCount ++;
+    OATPP_LOGe("[oatpp::sqlite::HotSwapConnectionProvider::swap()]", "Error. Can't stat file '{}'.", filePath);
+    return false;
+  }
+
+  return install(filePath, version);
+
+}
+
+void HotSwapConnectionProvider::setSwapCallback(const SwapCallback& callback) {
+  std::lock_guard<std::mutex> lock(m_generationMutex);
+  m_swapCallback = callback;
+}
+
+std::shared_ptr<ConnectionProvider> HotSwapConnectionProvider::getConnectionProvider() {
+  std::lock_guard<std::mutex> lock(m_generationMutex);
+  return m_generation->provider;
+}
+
+HotSwapConnectionProvider::Stats HotSwapConnectionProvider::getStats() {
+  std::lock_guard<std::mutex> lock(m_generationMutex);
+  return m_stats;
+}
+
+oatpp::String HotSwapConnectionProvider::getDatabaseScope() {
+  std::lock_guard<std::mutex> lock(m_generationMutex);
+  return "generation:" + std::to_string(m_generation->id);
+}
+
+provider::ResourceHandle<Connection> HotSwapConnectionProvider::get() {
+
+  while(true) {
+
+    std::shared_ptr<Generation> generation;
+    {
+      std::lock_guard<std::mutex> lock(m_generationMutex);
+      generation = m_generation;
+    }
+
+    auto connection = generation->pool->get();
+    if(connection) {
+      return connection;
+    }
+
+    /* pool was stopped by a swap in between - retry with the new generation */
+    std::lock_guard<std::mutex> lock(m_generationMutex);
+    if(m_generation == generation) {
+      return connection;
+    }
+
+  }
+
+}
+
+async::CoroutineStarterForResult<const provider::ResourceHandle<Connection>&> HotSwapConnectionProvider::getAsync() {
+  throw std::runtime_error("[oatpp::sqlite::HotSwapConnectionProvider::getAsync()]: Error. Not implemented!");
+}
+
+void HotSwapConnectionProvider::stop() {
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_running = false;
+  }
+  m_condition.notify_all();
+  if(m_thread.joinable()) {
+    m_thread.join();
+  }
+
+  std::shared_ptr<Generation> generation;
+  {
+    std::lock_guard<std::mutex> lock(m_generationMutex);
+    generation = m_generation;
+  }
+  if(generation) {
+    generation->pool->stop();
+  }
+
+}
+
+}}
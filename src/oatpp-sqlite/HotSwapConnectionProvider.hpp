@@ -0,0 +1,254 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#ifndef oatpp_sqlite_HotSwapConnectionProvider_hpp
+#define oatpp_sqlite_HotSwapConnectionProvider_hpp
+
+#include "ConnectionProvider.hpp"
+
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+namespace oatpp { namespace sqlite {
+
+/**
+ * Pooled connection provider for a read-only database file which is periodically replaced. <br>
+ * Watches the file and, once a new version appears, opens connections to it in the background, warms them up
+ * and atomically switches to the new generation of the pool. <br>
+ * Connections of the old generation are closed as their `ResourceHandle`s are released. <br>
+ * *Note:* replace the file atomically (write to a temporary file and `rename` it over the watched path) -
+ * connections of the old generation keep reading the old file. Do not overwrite the file in place.
+ */
+class HotSwapConnectionProvider : public provider::Provider<Connection>, public DatabaseScopeProvider {
+public:
+
+  /**
+   * Configures provider of a new generation before its connections are opened. <br>
+   * Ex.: add init hooks, functions, change listeners or busy handler here.
+   */
+  typedef std::function<void(const std::shared_ptr<ConnectionProvider>&)> ProviderConfigurator;
+
+  /**
+   * Provider config.
+   */
+  struct Config {
+
+    /**
+     * Max number of connections in the pool of each generation.
+     */
+    v_int64 maxConnections = 10;
+
+    /**
+     * Max time an idle connection stays in the pool.
+     */
+    std::chrono::duration<v_int64, std::micro> maxConnectionTTL = std::chrono::seconds(5);
+
+    /**
+     * Interval of file version checks. `0` - don't watch the file, swap only with &l:HotSwapConnectionProvider::swap ();.
+     */
+    std::chrono::duration<v_int64, std::micro> pollInterval = std::chrono::seconds(1);
+
+    /**
+     * Number of connections opened and warmed up before the new generation is switched to.
+     */
+    v_int64 warmUpConnections = 1;
+
+    /**
+     * Queries run on each warm-up connection. Ex.: `SELECT count(*) FROM my_index_table`. <br>
+     * Database schema is always loaded during the warm-up.
+     */
+    std::vector<oatpp::String> warmUpQueries;
+
+    /**
+     * Flags for `sqlite3_open_v2`. Ignored if &l:HotSwapConnectionProvider::Config::immutable; is `true`.
+     */
+    int openFlags = SQLITE_OPEN_READONLY;
+
+    /**
+     * Open files in immutable mode - see &id:oatpp::sqlite::ConnectionProvider::createImmutable;.
+     */
+    bool immutable = false;
+
+    /**
+     * &l:HotSwapConnectionProvider::ProviderConfigurator;. Applied to the provider of each generation. `nullptr` - none.
+     */
+    ProviderConfigurator providerConfigurator;
+
+  };
+
+  /**
+   * Callback called after a new generation is switched to. Argument is the generation number. <br>
+   * Ex.: clear &id:oatpp::sqlite::ResultCache; here.
+   */
+  typedef std::function<void(v_int64)> SwapCallback;
+
+  /**
+   * Hot-swap statistics.
+   */
+  struct Stats {
+
+    /**
+     * Current generation number. Initial generation is `0`.
+     */
+    v_int64 generation;
+
+    /**
+     * Number of successful swaps.
+     */
+    v_int64 swapsCount;
+
+    /**
+     * Number of swaps which failed to open or warm up the new file.
+     */
+    v_int64 failedSwapsCount;
+
+    /**
+     * Duration of the last successful warm-up in microseconds.
+     */
+    v_int64 lastWarmUpDuration;
+
+  };
+
+private:
+
+  struct FileVersion {
+    v_int64 modified;
+    v_int64 size;
+    v_int64 inode;
+    bool operator == (const FileVersion& other) const;
+  };
+
+  struct Generation {
+    v_int64 id;
+    FileVersion version;
+    std::shared_ptr<ConnectionProvider> provider;
+    std::shared_ptr<ConnectionPool> pool;
+  };
+
+private:
+  static bool readFileVersion(const oatpp::String& filePath, FileVersion& version);
+private:
+  std::shared_ptr<Generation> createGeneration(const oatpp::String& filePath, const FileVersion& version);
+  void warmUp(const std::shared_ptr<Generation>& generation);
+  bool install(const oatpp::String& filePath, const FileVersion& version);
+  void run();
+private:
+  oatpp::String m_filePath;
+  Config m_config;
+private:
+  std::mutex m_generationMutex;
+  std::shared_ptr<Generation> m_generation;
+  SwapCallback m_swapCallback;
+  Stats m_stats;
+private:
+  /* serializes swaps - only one new generation is being opened at a time */
+  std::mutex m_swapMutex;
+private:
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  bool m_running;
+  std::thread m_thread;
+public:
+
+  /**
+   * Constructor. Opens the initial generation and starts the watcher thread.
+   * @param filePath - path to the database file.
+   * @param config - &l:HotSwapConnectionProvider::Config;.
+   */
+  HotSwapConnectionProvider(const oatpp::String& filePath, const Config& config);
+
+  /**
+   * Constructor with default config.
+   * @param filePath - path to the database file.
+   */
+  HotSwapConnectionProvider(const oatpp::String& filePath);
+
+  /**
+   * Virtual destructor. Calls &l:HotSwapConnectionProvider::stop ();.
+   */
+  ~HotSwapConnectionProvider();
+
+  /**
+   * Check the watched file now and swap to it if its version has changed. Runs in the calling thread.
+   * @return - `true` if swapped.
+   */
+  bool swap();
+
+  /**
+   * Open, warm up and swap to the given file. The watched file is changed to `filePath`.
+   * @param filePath - path to the new database file.
+   * @return - `true` if swapped. `false` if the new file can't be opened or warmed up -
+   * the current generation stays active.
+   */
+  bool swap(const oatpp::String& filePath);
+
+  /**
+   * Set &l:HotSwapConnectionProvider::SwapCallback;.
+   * @param callback
+   */
+  void setSwapCallback(const SwapCallback& callback);
+
+  /**
+   * Get provider of the current generation. <br>
+   * Use it for memory stats. Change listeners added to it are not carried over to the next generation.
+   * @return - &id:oatpp::sqlite::ConnectionProvider;.
+   */
+  std::shared_ptr<ConnectionProvider> getConnectionProvider();
+
+  /**
+   * Get hot-swap statistics.
+   * @return - &l:HotSwapConnectionProvider::Stats;.
+   */
+  Stats getStats();
+
+  /**
+   * Get database scope - the current generation. See &id:oatpp::sqlite::DatabaseScopeProvider;.
+   * @return
+   */
+  oatpp::String getDatabaseScope() override;
+
+  /**
+   * Get Connection from the pool of the current generation.
+   * @return - resource.
+   */
+  provider::ResourceHandle<Connection> get() override;
+
+  /**
+   * Get Connection in Async manner.
+   * @return - &id:oatpp::async::CoroutineStarterForResult; of `Connection`.
+   */
+  async::CoroutineStarterForResult<const provider::ResourceHandle<Connection>&> getAsync() override;
+
+  /**
+   * Stop the watcher thread and the pool of the current generation.
+   */
+  void stop() override;
+
+};
+
+}}
+
+#endif // oatpp_sqlite_HotSwapConnectionProvider_hpp
@@ -0,0 +1,194 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#include "ImageConnectionProvider.hpp"
+
+#include <atomic>
+#include <cstdio>
+
+namespace oatpp { namespace sqlite {
+
+oatpp::String ImageConnectionProvider::createImageUri(const oatpp::String& imageName) {
+  static std::atomic<v_int64> imageCounter(0);
+  std::string name;
+  if(imageName) {
+    name = *imageName;
+  } else {
+    name = "oatpp-sqlite-image-" + std::to_string(imageCounter ++);
+  }
+  /* leading '/' makes memdb database shared between connections */
+  return "file:/" + name + "?vfs=memdb";
+}
+
+ImageConnectionProvider::ImageConnectionProvider(const oatpp::String& filePath, const oatpp::String& imageName)
+  : ConnectionProvider(createImageUri(imageName), SQLITE_OPEN_READONLY | SQLITE_OPEN_URI)
+  , m_imageSize(0)
+  , m_generation(0)
+{
+  loadImage(filePath);
+}
+
+void ImageConnectionProvider::loadImage(const oatpp::String& filePath) {
+
+#ifdef SQLITE_OMIT_DESERIALIZE
+  throw std::runtime_error("[oatpp::sqlite::ImageConnectionProvider::loadImage()]: "
+                           "Error. SQLite is compiled with SQLITE_OMIT_DESERIALIZE.");
+#else
+
+  std::FILE* file = std::fopen(filePath->c_str(), "rb");
+  if(!file) {
+    throw std::runtime_error("[oatpp::sqlite::ImageConnectionProvider::loadImage()]: "
+                             "Error. Can't open file '" + *filePath + "'.");
+  }
+
+  std::fseek(file, 0, SEEK_END);
+  v_int64 size = std::ftell(file);
+  std::fseek(file, 0, SEEK_SET);
+
+  if(size <= 0) {
+    std::fclose(file);
+    throw std::runtime_error("[oatpp::sqlite::ImageConnectionProvider::loadImage()]: "
+                             "Error. File '" + *filePath + "' is empty.");
+  }
+
+  auto data = static_cast<unsigned char*>(sqlite3_malloc64(static_cast<sqlite3_uint64>(size)));
+  if(!data) {
+    std::fclose(file);
+    throw std::runtime_error("[oatpp::sqlite::ImageConnectionProvider::loadImage()]: "
+                             "Error. Can't allocate " + std::to_string(size) + " bytes.");
+  }
+
+  auto read = std::fread(data, 1, static_cast<size_t>(size), file);
+  std::fclose(file);
+
+  if(static_cast<v_int64>(read) != size) {
+    sqlite3_free(data);
+    throw std::runtime_error("[oatpp::sqlite::ImageConnectionProvider::loadImage()]: "
+                             "Error. Can't read file '" + *filePath + "'.");
+  }
+
+  /* memdb doesn't support WAL - switch header to the rollback-journal mode */
+  if(size >= 100 && data[18] == 2 && data[19] == 2) {
+    data[18] = 1;
+    data[19] = 1;
+  }
+
+  /*
+   * sqlite3_deserialize always attaches a private memdb, so the image is deserialized into a staging connection
+   * and then copied to the shared memdb with the backup API.
+   */
+  sqlite3* staging;
+  auto res = sqlite3_open_v2(":memory:", &staging, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr);
+  if(res != SQLITE_OK) {
+    sqlite3_free(data);
+    sqlite3_close(staging);
+    throw std::runtime_error("[oatpp::sqlite::ImageConnectionProvider::loadImage()]: "
+                             "Error. Can't open staging connection. " + std::string(sqlite3_errstr(res)));
+  }
+
+  /* on failure data is freed by SQLite because of SQLITE_DESERIALIZE_FREEONCLOSE */
+  res = sqlite3_deserialize(staging, "main", data, size, size,
+                            SQLITE_DESERIALIZE_FREEONCLOSE | SQLITE_DESERIALIZE_READONLY);
+  if(res != SQLITE_OK) {
+    std::string errMsg = sqlite3_errmsg(staging);
+    sqlite3_close(staging);
+    throw std::runtime_error("[oatpp::sqlite::ImageConnectionProvider::loadImage()]: "
+                             "Error. Can't deserialize file '" + *filePath + "'. " + errMsg);
+  }
+
+  bool created = false;
+  if(!m_holder) {
+    sqlite3* handle;
+    res = sqlite3_open_v2(getConnectionString()->c_str(), &handle,
+                          SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_URI, nullptr);
+    m_holder = std::make_shared<ConnectionImpl>(handle);
+    created = true;
+    if(res != SQLITE_OK) {
+      std::string errMsg = sqlite3_errmsg(handle);
+      sqlite3_close(staging);
+      m_holder.reset();
+      throw std::runtime_error("[oatpp::sqlite::ImageConnectionProvider::loadImage()]: "
+                               "Error. Can't open in-memory image. " + errMsg);
+    }
+  }
+
+  auto handle = m_holder->getHandle();
+
+  /* copy is a single write transaction - wait for readers of the current image */
+  auto backup = sqlite3_backup_init(handle, "main", staging, "main");
+  if(backup) {
+    do {
+      res = sqlite3_backup_step(backup, -1);
+      if(res == SQLITE_BUSY || res == SQLITE_LOCKED) {
+        sqlite3_sleep(10);
+      }
+    } while(res == SQLITE_OK || res == SQLITE_BUSY || res == SQLITE_LOCKED);
+    res = sqlite3_backup_finish(backup);
+  } else {
+    res = sqlite3_errcode(handle);
+  }
+  sqlite3_close(staging);
+
+  if(res != SQLITE_OK) {
+    std::string errMsg = sqlite3_errmsg(handle);
+    if(created) {
+      m_holder.reset();
+    }
+    throw std::runtime_error("[oatpp::sqlite::ImageConnectionProvider::loadImage()]: "
+                             "Error. Can't copy image of '" + *filePath + "'. " + errMsg);
+  }
+
+  m_imageSize = size;
+
+#endif
+
+}
+
+void ImageConnectionProvider::reload(const oatpp::String& filePath) {
+  std::lock_guard<std::mutex> lock(m_loadMutex);
+  if(!m_holder) {
+    throw std::runtime_error("[oatpp::sqlite::ImageConnectionProvider::reload()]: "
+                             "Error. Provider is stopped.");
+  }
+  loadImage(filePath);
+  /* incremented once the new image is visible - results read before can't be shared with later reads */
+  m_generation ++;
+}
+
+v_int64 ImageConnectionProvider::getImageSize() const {
+  return m_imageSize;
+}
+
+oatpp::String ImageConnectionProvider::getDatabaseScope() {
+  return "image:" + *getConnectionString() + ":" + std::to_string(m_generation.load());
+}
+
+void ImageConnectionProvider::stop() {
+  ConnectionProvider::stop();
+  std::lock_guard<std::mutex> lock(m_loadMutex);
+  m_holder.reset();
+}
+
+}}
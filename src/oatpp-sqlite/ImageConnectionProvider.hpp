@@ -0,0 +1,99 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#ifndef oatpp_sqlite_ImageConnectionProvider_hpp
+#define oatpp_sqlite_ImageConnectionProvider_hpp
+
+#include "ConnectionProvider.hpp"
+
+#include <atomic>
+#include <mutex>
+
+namespace oatpp { namespace sqlite {
+
+/**
+ * Connection provider serving a read-only in-memory image of a database file. <br>
+ * The file is read once, deserialized with `sqlite3_deserialize` and copied to a shared `memdb` database -
+ * all connections opened by this provider read the same image. No disk I/O happens after construction. <br>
+ * Use it for read-mostly datasets that fit in RAM (lookup tables, geo data, etc.). <br>
+ * *Note:* the image is allocated with `sqlite3_malloc64` and counts towards SQLite heap usage -
+ * see &id:oatpp::sqlite::ConnectionProvider::setSoftHeapLimit;. Twice the file size is used while loading. <br>
+ * *Note:* only the main database file is read - checkpoint a WAL-mode database before loading it. <br>
+ * *Note:* if the provider is wrapped in a pool and results are shared (result cache, request coalescing) - pass it to
+ * &id:oatpp::sqlite::Executor::setDatabaseScopeProvider; so that results of the old image aren't served after reload.
+ */
+class ImageConnectionProvider : public ConnectionProvider, public DatabaseScopeProvider {
+private:
+  static oatpp::String createImageUri(const oatpp::String& imageName);
+private:
+  void loadImage(const oatpp::String& filePath);
+private:
+  /* keeps the shared memdb alive while the pool opens and closes connections */
+  std::shared_ptr<ConnectionImpl> m_holder;
+  std::mutex m_loadMutex;
+  std::atomic<v_int64> m_imageSize;
+  std::atomic<v_int64> m_generation;
+public:
+
+  /**
+   * Constructor.
+   * @param filePath - path to the database file.
+   * @param imageName - name of the shared in-memory database. Must be unique per process.
+   * If `nullptr` - unique name is generated.
+   */
+  ImageConnectionProvider(const oatpp::String& filePath, const oatpp::String& imageName = nullptr);
+
+  /**
+   * Replace the in-memory image with the content of the file. <br>
+   * The image is replaced in a single transaction - waits for running reads of the current image.
+   * Connections see the new content with their next read.
+   * @param filePath - path to the database file.
+   */
+  void reload(const oatpp::String& filePath);
+
+  /**
+   * Get size of the in-memory image in bytes.
+   * @return
+   */
+  v_int64 getImageSize() const;
+
+  /**
+   * Get database scope - the generation of the image, incremented by each &l:ImageConnectionProvider::reload ();.
+   * See &id:oatpp::sqlite::DatabaseScopeProvider;.
+   * @return
+   */
+  oatpp::String getDatabaseScope() override;
+
+  /**
+   * Stop provider and release the in-memory image. <br>
+   * The image is freed once all connections opened by this provider are closed.
+   */
+  void stop() override;
+
+};
+
+}}
+
+#endif // oatpp_sqlite_ImageConnectionProvider_hpp
@@ -0,0 +1,272 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "MaintenanceScheduler.hpp"
+
+#include "oatpp/base/Log.hpp"
+#include "oatpp/Environment.hpp"
+
+#include <algorithm>
+
+namespace oatpp { namespace sqlite {
+
+MaintenanceScheduler::MaintenanceScheduler(const std::shared_ptr<Executor>& executor, const Config& config)
+  : m_config(config)
+  , m_executor(executor)
+  , m_lastActivity(oatpp::Environment::getMicroTickCount())
+  , m_ownHandle(nullptr)
+  , m_deadline(0)
+  , m_lastOptimize(oatpp::Environment::getMicroTickCount())
+  , m_running(true)
+{
+  m_stats.vacuumSlices = 0;
+  m_stats.vacuumedPages = 0;
+  m_stats.optimizeCount = 0;
+  m_stats.interruptedCount = 0;
+  m_stats.errorCount = 0;
+  m_stats.lastOptimizeDuration = 0;
+  m_thread = std::thread([this]{
+    run();
+  });
+}
+
+MaintenanceScheduler::MaintenanceScheduler(const std::shared_ptr<Executor>& executor)
+  : MaintenanceScheduler(executor, Config())
+{}
+
+MaintenanceScheduler::~MaintenanceScheduler() {
+  stop();
+}
+
+Connection::ProgressHandler MaintenanceScheduler::createProgressHandler() {
+  Connection::ProgressHandler handler;
+  handler.instructions = 1000;
+  handler.callback = [this]() {
+    return oatpp::Environment::getMicroTickCount() > m_deadline ? 1 : 0;
+  };
+  return handler;
+}
+
+int MaintenanceScheduler::runStatement(sqlite3* handle, const char* sql, v_int64* result) {
+
+  sqlite3_stmt* stmt = nullptr;
+  auto res = sqlite3_prepare_v2(handle, sql, -1, &stmt, nullptr);
+
+  if(res == SQLITE_OK) {
+    while((res = sqlite3_step(stmt)) == SQLITE_ROW) {
+      if(result) {
+        *result = sqlite3_column_int64(stmt, 0);
+      }
+    }
+    if(res == SQLITE_DONE) {
+      res = SQLITE_OK;
+    }
+  }
+
+  sqlite3_finalize(stmt);
+
+  if(res != SQLITE_OK) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(res == SQLITE_INTERRUPT) {
+      m_stats.interruptedCount ++;
+    } else {
+      m_stats.errorCount ++;
+      OATPP_LOGe("[oatpp::sqlite::MaintenanceScheduler::runStatement()]", "Error. '{}' failed. {}", sql, sqlite3_errmsg(handle));
+    }
+  }
+
+  return res;
+
+}
+
+v_int64 MaintenanceScheduler::runIncrementalVacuum() {
+
+  std::lock_guard<std::mutex> runLock(m_runMutex);
+
+  auto executor = m_executor.lock();
+  if(!executor) {
+    return 0;
+  }
+
+  auto connection = executor->getConnection();
+  auto sqliteConnection = std::static_pointer_cast<Connection>(connection.object);
+  auto handle = sqliteConnection->getHandle();
+
+  m_ownHandle = handle;
+  m_deadline = oatpp::Environment::getMicroTickCount() + std::chrono::microseconds(m_config.timeBudget).count();
+  /* the connection goes back to the pool - its own progress handler is restored afterwards */
+  auto previousHandler = sqliteConnection->setProgressHandler(createProgressHandler());
+
+  v_int64 freed = 0;
+  v_int64 autoVacuum = 0;
+
+  /* 2 - INCREMENTAL */
+  if(runStatement(handle, "PRAGMA auto_vacuum", &autoVacuum) == SQLITE_OK && autoVacuum == 2) {
+
+    std::string sql = "PRAGMA incremental_vacuum(" + std::to_string(m_config.vacuumPagesPerSlice) + ")";
+    v_int64 threshold = m_config.vacuumMinFreePages;
+
+    while(oatpp::Environment::getMicroTickCount() < m_deadline) {
+
+      v_int64 freePages = 0;
+      if(runStatement(handle, "PRAGMA freelist_count", &freePages) != SQLITE_OK || freePages == 0 || freePages < threshold) {
+        break;
+      }
+
+      /* once started - vacuum until free pages are exhausted or the budget is over */
+      threshold = 1;
+
+      if(runStatement(handle, sql.c_str(), nullptr) != SQLITE_OK) {
+        break;
+      }
+
+      auto slicePages = std::min(freePages, m_config.vacuumPagesPerSlice);
+      freed += slicePages;
+
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stats.vacuumSlices ++;
+      m_stats.vacuumedPages += slicePages;
+
+    }
+
+  }
+
+  sqliteConnection->setProgressHandler(previousHandler);
+  m_ownHandle = nullptr;
+
+  return freed;
+
+}
+
+bool MaintenanceScheduler::runOptimize() {
+
+  std::lock_guard<std::mutex> runLock(m_runMutex);
+
+  auto executor = m_executor.lock();
+  if(!executor) {
+    return false;
+  }
+
+  auto connection = executor->getConnection();
+  auto sqliteConnection = std::static_pointer_cast<Connection>(connection.object);
+  auto handle = sqliteConnection->getHandle();
+
+  v_int64 startTime = oatpp::Environment::getMicroTickCount();
+
+  m_ownHandle = handle;
+  m_deadline = startTime + std::chrono::microseconds(m_config.timeBudget).count();
+  auto previousHandler = sqliteConnection->setProgressHandler(createProgressHandler());
+
+  v_int64 analysisLimit = 0;
+  bool limitSet = runStatement(handle, "PRAGMA analysis_limit", &analysisLimit) == SQLITE_OK;
+
+  std::string sql = "PRAGMA analysis_limit=" + std::to_string(m_config.analysisLimit);
+  limitSet = limitSet && runStatement(handle, sql.c_str(), nullptr) == SQLITE_OK;
+  bool success = limitSet && runStatement(handle, "PRAGMA optimize", nullptr) == SQLITE_OK;
+
+  /* the connection goes back to the pool - restore its own settings, the handler first so the budget can't interrupt it */
+  sqliteConnection->setProgressHandler(previousHandler);
+  if(limitSet) {
+    sql = "PRAGMA analysis_limit=" + std::to_string(analysisLimit);
+    runStatement(handle, sql.c_str(), nullptr);
+  }
+
+  m_ownHandle = nullptr;
+
+  v_int64 endTime = oatpp::Environment::getMicroTickCount();
+  m_lastOptimize = endTime;
+
+  if(success) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.optimizeCount ++;
+    m_stats.lastOptimizeDuration = endTime - startTime;
+  }
+
+  return success;
+
+}
+
+void MaintenanceScheduler::run() {
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  while(m_running) {
+
+    m_condition.wait_for(lock, m_config.checkInterval, [this]{
+      return !m_running;
+    });
+
+    if(!m_running) {
+      break;
+    }
+
+    lock.unlock();
+
+    try {
+
+      v_int64 now = oatpp::Environment::getMicroTickCount();
+
+      if(now - m_lastActivity >= std::chrono::microseconds(m_config.idleTime).count()) {
+        if(m_config.optimizeInterval.count() > 0 &&
+           now - m_lastOptimize >= std::chrono::microseconds(m_config.optimizeInterval).count())
+        {
+          runOptimize();
+        } else {
+          runIncrementalVacuum();
+        }
+      }
+
+    } catch (std::exception& e) {
+      OATPP_LOGe("[oatpp::sqlite::MaintenanceScheduler::run()]", "Error. {}", e.what());
+    }
+
+    lock.lock();
+
+  }
+
+}
+
+MaintenanceScheduler::Stats MaintenanceScheduler::getStats() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stats;
+}
+
+void MaintenanceScheduler::stop() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_running = false;
+  }
+  m_condition.notify_all();
+  if(m_thread.joinable()) {
+    m_thread.join();
+  }
+}
+
+void MaintenanceScheduler::onCommit(sqlite3* handle) {
+  if(handle != m_ownHandle) {
+    m_lastActivity = oatpp::Environment::getMicroTickCount();
+  }
+}
+
+}}
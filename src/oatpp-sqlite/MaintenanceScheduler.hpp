@@ -0,0 +1,199 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef oatpp_sqlite_MaintenanceScheduler_hpp
+#define oatpp_sqlite_MaintenanceScheduler_hpp
+
+#include "Executor.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace oatpp { namespace sqlite {
+
+/**
+ * Database maintenance scheduler. <br>
+ * Runs from a dedicated thread:
+ * <ul>
+ *   <li>`PRAGMA incremental_vacuum(N)` in small slices when the database is idle (no commits for
+ *   &l:MaintenanceScheduler::Config::idleTime;). Each slice is a separate transaction, so the write lock is held
+ *   only for `N` pages. Requires `PRAGMA auto_vacuum=INCREMENTAL`.</li>
+ *   <li>`PRAGMA optimize` with `PRAGMA analysis_limit` once per &l:MaintenanceScheduler::Config::optimizeInterval;.</li>
+ * </ul>
+ * Every run is limited by &l:MaintenanceScheduler::Config::timeBudget; - statements exceeding the budget are
+ * interrupted with the progress handler. <br>
+ * Add the scheduler to connections with &id:oatpp::sqlite::ConnectionProvider::addChangeListener; to detect idle windows.
+ */
+class MaintenanceScheduler : public Connection::ChangeListener {
+public:
+
+  /**
+   * Scheduler config.
+   */
+  struct Config {
+
+    /**
+     * Number of pages freed by one `PRAGMA incremental_vacuum(N)` slice.
+     */
+    v_int64 vacuumPagesPerSlice = 64;
+
+    /**
+     * Run incremental vacuum only if the number of free pages is at least this value.
+     */
+    v_int64 vacuumMinFreePages = 256;
+
+    /**
+     * Database is considered idle if nothing was committed for this time.
+     */
+    std::chrono::milliseconds idleTime = std::chrono::milliseconds(500);
+
+    /**
+     * Interval of checks for idle windows.
+     */
+    std::chrono::milliseconds checkInterval = std::chrono::milliseconds(1000);
+
+    /**
+     * Interval of `PRAGMA optimize` runs. Zero - don't run.
+     */
+    std::chrono::milliseconds optimizeInterval = std::chrono::hours(1);
+
+    /**
+     * `PRAGMA analysis_limit` used for `PRAGMA optimize`.
+     */
+    v_int64 analysisLimit = 400;
+
+    /**
+     * Max time of a single maintenance run.
+     */
+    std::chrono::milliseconds timeBudget = std::chrono::milliseconds(20);
+
+  };
+
+  /**
+   * Maintenance statistics.
+   */
+  struct Stats {
+
+    /**
+     * Number of `incremental_vacuum` slices run.
+     */
+    v_int64 vacuumSlices;
+
+    /**
+     * Number of pages freed by incremental vacuum.
+     */
+    v_int64 vacuumedPages;
+
+    /**
+     * Number of `PRAGMA optimize` runs.
+     */
+    v_int64 optimizeCount;
+
+    /**
+     * Number of statements interrupted because of the time budget.
+     */
+    v_int64 interruptedCount;
+
+    /**
+     * Number of failed statements.
+     */
+    v_int64 errorCount;
+
+    /**
+     * Duration of the last `PRAGMA optimize` in microseconds.
+     */
+    v_int64 lastOptimizeDuration;
+
+  };
+
+private:
+  Connection::ProgressHandler createProgressHandler();
+  int runStatement(sqlite3* handle, const char* sql, v_int64* result);
+  void run();
+private:
+  Config m_config;
+  std::weak_ptr<Executor> m_executor;
+  std::atomic<v_int64> m_lastActivity;
+  std::atomic<sqlite3*> m_ownHandle;
+  v_int64 m_deadline;
+  std::atomic<v_int64> m_lastOptimize;
+  std::mutex m_runMutex;
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  Stats m_stats;
+  bool m_running;
+  std::thread m_thread;
+public:
+
+  /**
+   * Constructor. Starts the maintenance thread.
+   * @param executor - &id:oatpp::sqlite::Executor; to get connections from.
+   * @param config - &l:MaintenanceScheduler::Config;.
+   */
+  MaintenanceScheduler(const std::shared_ptr<Executor>& executor, const Config& config);
+
+  /**
+   * Constructor with default config. Starts the maintenance thread.
+   * @param executor - &id:oatpp::sqlite::Executor; to get connections from.
+   */
+  MaintenanceScheduler(const std::shared_ptr<Executor>& executor);
+
+  /**
+   * Virtual destructor. Calls &l:MaintenanceScheduler::stop ();.
+   */
+  ~MaintenanceScheduler();
+
+  /**
+   * Run incremental vacuum slices until free pages are below &l:MaintenanceScheduler::Config::vacuumMinFreePages;
+   * or the time budget is exhausted.
+   * @return - number of pages freed.
+   */
+  v_int64 runIncrementalVacuum();
+
+  /**
+   * Run `PRAGMA optimize` within the time budget.
+   * @return - `true` on success.
+   */
+  bool runOptimize();
+
+  /**
+   * Get maintenance statistics.
+   * @return - &l:MaintenanceScheduler::Stats;.
+   */
+  Stats getStats();
+
+  /**
+   * Stop the maintenance thread.
+   */
+  void stop();
+
+  void onCommit(sqlite3* handle) override;
+
+};
+
+}}
+
+#endif // oatpp_sqlite_MaintenanceScheduler_hpp
@@ -0,0 +1,112 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#include "PoolMetrics.hpp"
+
+namespace oatpp { namespace sqlite {
+
+const v_int64 PoolMetrics::BUCKET_BOUNDS[BUCKETS_COUNT] = {
+  10, 100, 1000, 10000, 100000, 1000000, 10000000, -1
+};
+
+PoolMetrics::Histogram::Histogram()
+  : m_count(0)
+  , m_totalTime(0)
+  , m_maxTime(0)
+{
+  for(v_int32 i = 0; i < BUCKETS_COUNT; i ++) {
+    m_buckets[i] = 0;
+  }
+}
+
+void PoolMetrics::Histogram::record(v_int64 time) {
+
+  v_int32 bucket = BUCKETS_COUNT - 1;
+  for(v_int32 i = 0; i < BUCKETS_COUNT - 1; i ++) {
+    if(time < BUCKET_BOUNDS[i]) {
+      bucket = i;
+      break;
+    }
+  }
+
+  m_buckets[bucket] ++;
+  m_count ++;
+  m_totalTime += time;
+
+  v_int64 max = m_maxTime.load();
+  while(time > max && !m_maxTime.compare_exchange_weak(max, time)) {}
+
+}
+
+PoolMetrics::HistogramSnapshot PoolMetrics::Histogram::getSnapshot() const {
+  HistogramSnapshot snapshot;
+  snapshot.count = m_count;
+  snapshot.totalTime = m_totalTime;
+  snapshot.maxTime = m_maxTime;
+  snapshot.buckets.reserve(BUCKETS_COUNT);
+  for(v_int32 i = 0; i < BUCKETS_COUNT; i ++) {
+    snapshot.buckets.push_back(m_buckets[i]);
+  }
+  return snapshot;
+}
+
+PoolMetrics::PoolMetrics()
+  : m_acquireFailures(0)
+  , m_openFailures(0)
+  , m_closes(0)
+{}
+
+void PoolMetrics::recordAcquire(v_int64 waitTime, bool success) {
+  m_acquireWait.record(waitTime);
+  if(!success) {
+    m_acquireFailures ++;
+  }
+}
+
+void PoolMetrics::recordOpen(v_int64 openTime, bool success) {
+  m_open.record(openTime);
+  if(!success) {
+    m_openFailures ++;
+  }
+}
+
+void PoolMetrics::recordClose() {
+  m_closes ++;
+}
+
+PoolMetrics::Snapshot PoolMetrics::getSnapshot() const {
+  Snapshot snapshot;
+  snapshot.acquireWait = m_acquireWait.getSnapshot();
+  snapshot.acquireFailures = m_acquireFailures;
+  snapshot.open = m_open.getSnapshot();
+  snapshot.openFailures = m_openFailures;
+  snapshot.closes = m_closes;
+  snapshot.connectionsCount = 0;
+  snapshot.activeCount = 0;
+  snapshot.idleCount = 0;
+  return snapshot;
+}
+
+}}
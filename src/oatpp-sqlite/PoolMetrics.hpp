@@ -0,0 +1,202 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#ifndef oatpp_sqlite_PoolMetrics_hpp
+#define oatpp_sqlite_PoolMetrics_hpp
+
+#include "oatpp/Types.hpp"
+
+#include <atomic>
+#include <vector>
+
+namespace oatpp { namespace sqlite {
+
+/**
+ * Connection pool metrics - acquisition wait time, open latency and connection churn. <br>
+ * Owned by &id:oatpp::sqlite::ConnectionProvider; - see &id:oatpp::sqlite::ConnectionProvider::getPoolStats;.
+ * Acquisition wait time is recorded by &id:oatpp::sqlite::Executor; when the metrics are set with
+ * &id:oatpp::sqlite::Executor::setPoolMetrics;. <br>
+ * All counters are lock-free.
+ */
+class PoolMetrics {
+public:
+
+  /**
+   * Number of histogram buckets.
+   */
+  static constexpr v_int32 BUCKETS_COUNT = 8;
+
+  /**
+   * Upper bounds of histogram buckets in microseconds: `10us, 100us, 1ms, 10ms, 100ms, 1s, 10s, +inf`.
+   */
+  static const v_int64 BUCKET_BOUNDS[BUCKETS_COUNT];
+
+  /**
+   * Snapshot of a latency histogram.
+   */
+  struct HistogramSnapshot {
+
+    /**
+     * Number of recorded values.
+     */
+    v_int64 count;
+
+    /**
+     * Sum of recorded values in microseconds.
+     */
+    v_int64 totalTime;
+
+    /**
+     * Max recorded value in microseconds.
+     */
+    v_int64 maxTime;
+
+    /**
+     * Number of values per bucket - see &l:PoolMetrics::BUCKET_BOUNDS;.
+     */
+    std::vector<v_int64> buckets;
+
+  };
+
+  /**
+   * Lock-free latency histogram.
+   */
+  class Histogram {
+  private:
+    std::atomic<v_int64> m_buckets[BUCKETS_COUNT];
+    std::atomic<v_int64> m_count;
+    std::atomic<v_int64> m_totalTime;
+    std::atomic<v_int64> m_maxTime;
+  public:
+
+    /**
+     * Constructor.
+     */
+    Histogram();
+
+    /**
+     * Record value.
+     * @param time - time in microseconds.
+     */
+    void record(v_int64 time);
+
+    /**
+     * Get snapshot.
+     * @return - &l:PoolMetrics::HistogramSnapshot;.
+     */
+    HistogramSnapshot getSnapshot() const;
+
+  };
+
+  /**
+   * Pool stats snapshot.
+   */
+  struct Snapshot {
+
+    /**
+     * Time waited for a connection by &id:oatpp::sqlite::Executor::getConnection;.
+     */
+    HistogramSnapshot acquireWait;
+
+    /**
+     * Number of failed acquisitions (pool timeout or can't connect).
+     */
+    v_int64 acquireFailures;
+
+    /**
+     * Latency of `sqlite3_open` in &id:oatpp::sqlite::ConnectionProvider::get;.
+     */
+    HistogramSnapshot open;
+
+    /**
+     * Number of failed opens.
+     */
+    v_int64 openFailures;
+
+    /**
+     * Number of connections dropped by the pool - TTL expiry, invalidation or pool stop.
+     */
+    v_int64 closes;
+
+    /**
+     * Number of open connections.
+     */
+    v_int64 connectionsCount;
+
+    /**
+     * Number of connections acquired from the pool.
+     */
+    v_int64 activeCount;
+
+    /**
+     * Number of idle connections in the pool.
+     */
+    v_int64 idleCount;
+
+  };
+
+private:
+  Histogram m_acquireWait;
+  std::atomic<v_int64> m_acquireFailures;
+  Histogram m_open;
+  std::atomic<v_int64> m_openFailures;
+  std::atomic<v_int64> m_closes;
+public:
+
+  /**
+   * Constructor.
+   */
+  PoolMetrics();
+
+  /**
+   * Record connection acquisition.
+   * @param waitTime - time waited in microseconds.
+   * @param success - `false` if no connection was acquired.
+   */
+  void recordAcquire(v_int64 waitTime, bool success);
+
+  /**
+   * Record connection open.
+   * @param openTime - open latency in microseconds.
+   * @param success - `false` if connection could not be opened.
+   */
+  void recordOpen(v_int64 openTime, bool success);
+
+  /**
+   * Record connection dropped by the pool.
+   */
+  void recordClose();
+
+  /**
+   * Get snapshot of metrics. Connection counts are not filled - see &id:oatpp::sqlite::ConnectionProvider::getPoolStats;.
+   * @return - &l:PoolMetrics::Snapshot;.
+   */
+  Snapshot getSnapshot() const;
+
+};
+
+}}
+
+#endif // oatpp_sqlite_PoolMetrics_hpp
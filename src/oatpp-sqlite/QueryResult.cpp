@@ -37,10 +37,50 @@ QueryResult::QueryResult(sqlite3_stmt* stmt,
 {
   auto sqliteConn = std::static_pointer_cast<Connection>(m_connection.object);
   m_errorMessage = sqlite3_errmsg(sqliteConn->getHandle());
+  m_errorCode = m_resultData.isSuccess ? SQLITE_OK : sqlite3_extended_errcode(sqliteConn->getHandle());
 }
 
+QueryResult::QueryResult(sqlite3_stmt* stmt,
+                         const oatpp::String& cacheKey,
+                         const provider::ResourceHandle<orm::Connection>& connection,
+                         const std::shared_ptr<mapping::ResultMapper>& resultMapper,
+                         const std::shared_ptr<const data::mapping::TypeResolver>& typeResolver)
+  : QueryResult(stmt, connection, resultMapper, typeResolver)
+{
+  m_cacheKey = cacheKey;
+}
+
+QueryResult::QueryResult(const std::shared_ptr<const mapping::ResultSet>& resultSet,
+                         const provider::ResourceHandle<orm::Connection>& connection,
+                         const std::shared_ptr<mapping::ResultMapper>& resultMapper,
+                         const std::shared_ptr<const data::mapping::TypeResolver>& typeResolver)
+  : m_stmt(nullptr)
+  , m_connection(connection)
+  , m_resultMapper(resultMapper)
+  , m_resultData(resultSet, typeResolver)
+  , m_errorCode(SQLITE_OK)
+{}
+
 QueryResult::~QueryResult() {
-  sqlite3_finalize(m_stmt);
+  if(m_cacheKey && m_stmt) {
+    std::static_pointer_cast<Connection>(m_connection.object)->putCachedStatement(m_cacheKey, m_stmt);
+  } else {
+    sqlite3_finalize(m_stmt);
+  }
+}
+
+std::shared_ptr<const mapping::ResultSet> QueryResult::materialize() {
+  if(!m_resultData.isSuccess) {
+    return nullptr;
+  }
+  auto result = m_resultData.materialize();
+  if(!m_resultData.isSuccess) {
+    auto sqliteConn = std::static_pointer_cast<Connection>(m_connection.object);
+    m_errorMessage = sqlite3_errmsg(sqliteConn->getHandle());
+    m_errorCode = sqlite3_extended_errcode(sqliteConn->getHandle());
+    return nullptr;
+  }
+  return result;
 }
 
 provider::ResourceHandle<orm::Connection> QueryResult::getConnection() const {
@@ -55,11 +95,18 @@ oatpp::String QueryResult::getErrorMessage() const {
   return m_errorMessage;
 }
 
+v_int32 QueryResult::getErrorCode() const {
+  return m_errorCode;
+}
+
 v_int64 QueryResult::getPosition() const {
   return m_resultData.rowIndex;
 }
 
 v_int64 QueryResult::getKnownCount() const {
+  if(m_resultData.resultSet) {
+    return m_resultData.resultSet->getRowCount();
+  }
   return -1;
 }
 
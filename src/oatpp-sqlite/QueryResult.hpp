@@ -38,10 +38,12 @@ namespace oatpp { namespace sqlite {
 class QueryResult : public orm::QueryResult {
 private:
   sqlite3_stmt* m_stmt;
+  oatpp::String m_cacheKey;
   provider::ResourceHandle<orm::Connection> m_connection;
   std::shared_ptr<mapping::ResultMapper> m_resultMapper;
   mapping::ResultMapper::ResultData m_resultData;
   oatpp::String m_errorMessage;
+  v_int32 m_errorCode;
 public:
 
   QueryResult(sqlite3_stmt* stmt,
@@ -49,14 +51,54 @@ public:
               const std::shared_ptr<mapping::ResultMapper>& resultMapper,
               const std::shared_ptr<const data::mapping::TypeResolver>& typeResolver);
 
+  /**
+   * Constructor of the result over statement taken from the connection statement cache. <br>
+   * The statement is returned to the cache (see &id:oatpp::sqlite::Connection::putCachedStatement;)
+   * instead of being finalized when the result is destroyed.
+   * @param stmt - prepared statement.
+   * @param cacheKey - statement text - key in the statement cache.
+   * @param connection
+   * @param resultMapper
+   * @param typeResolver
+   */
+  QueryResult(sqlite3_stmt* stmt,
+              const oatpp::String& cacheKey,
+              const provider::ResourceHandle<orm::Connection>& connection,
+              const std::shared_ptr<mapping::ResultMapper>& resultMapper,
+              const std::shared_ptr<const data::mapping::TypeResolver>& typeResolver);
+
+  /**
+   * Constructor of the result over already materialized rows.
+   * @param resultSet - &id:oatpp::sqlite::mapping::ResultSet;.
+   * @param connection - connection the result is associated with. May be `nullptr`.
+   * @param resultMapper
+   * @param typeResolver
+   */
+  QueryResult(const std::shared_ptr<const mapping::ResultSet>& resultSet,
+              const provider::ResourceHandle<orm::Connection>& connection,
+              const std::shared_ptr<mapping::ResultMapper>& resultMapper,
+              const std::shared_ptr<const data::mapping::TypeResolver>& typeResolver);
+
   ~QueryResult();
 
+  /**
+   * Read all remaining rows to &id:oatpp::sqlite::mapping::ResultSet;.
+   * @return - materialized rows or `nullptr` if the query failed.
+   */
+  std::shared_ptr<const mapping::ResultSet> materialize();
+
   provider::ResourceHandle<orm::Connection> getConnection() const override;
 
   bool isSuccess() const override;
 
   oatpp::String getErrorMessage() const override;
 
+  /**
+   * Get SQLite extended result code of the error. Ex.: `SQLITE_BUSY` - database is locked.
+   * @return - result code. `SQLITE_OK` if there was no error.
+   */
+  v_int32 getErrorCode() const;
+
   v_int64 getPosition() const override;
 
   v_int64 getKnownCount() const override;
@@ -0,0 +1,286 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "ResultCache.hpp"
+
+#include <cctype>
+
+namespace oatpp { namespace sqlite {
+
+ResultCache::ResultCache()
+  : ResultCache(Config())
+{}
+
+ResultCache::ResultCache(const Config& config)
+  : m_config(config)
+  , m_dataSize(0)
+{
+  m_stats.hits = 0;
+  m_stats.misses = 0;
+  m_stats.evictions = 0;
+  m_stats.invalidations = 0;
+  m_stats.entriesCount = 0;
+  m_stats.dataSize = 0;
+}
+
+std::string ResultCache::getTableKey(const char* database, const char* table) {
+  std::string result = database ? database : "main";
+  result.push_back('.');
+  result.append(table);
+  for(auto& c : result) {
+    c = (char) std::tolower((unsigned char) c);
+  }
+  return result;
+}
+
+void ResultCache::removeEntry(std::unordered_map<std::string, Entry>::iterator it) {
+  for(auto& table : it->second.tables) {
+    auto tableIt = m_tableEntries.find(table);
+    if(tableIt != m_tableEntries.end()) {
+      tableIt->second.erase(it->first);
+      if(tableIt->second.empty()) {
+        m_tableEntries.erase(tableIt);
+      }
+    }
+  }
+  m_dataSize -= it->second.resultSet->getDataSize();
+  m_lru.erase(it->second.lruPosition);
+  m_entries.erase(it);
+}
+
+void ResultCache::invalidateTable(const std::string& table) {
+
+  m_tableGenerations[table] ++;
+
+  auto tableIt = m_tableEntries.find(table);
+  if(tableIt == m_tableEntries.end()) {
+    return;
+  }
+
+  /* copy keys - removeEntry modifies m_tableEntries */
+  std::vector<std::string> keys(tableIt->second.begin(), tableIt->second.end());
+  for(auto& key : keys) {
+    auto it = m_entries.find(key);
+    if(it != m_entries.end()) {
+      removeEntry(it);
+      m_stats.invalidations ++;
+    }
+  }
+
+}
+
+bool ResultCache::isCacheable(const oatpp::String& templateName, const oatpp::String& query) {
+  if(!templateName || !query) {
+    return false;
+  }
+  if(!m_config.templates.empty() && m_config.templates.find(*templateName) == m_config.templates.end()) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_nonCacheableQueries.find(*query) == m_nonCacheableQueries.end();
+}
+
+void ResultCache::setNonCacheable(const oatpp::String& query) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_nonCacheableQueries.insert(*query);
+}
+
+bool ResultCache::getQueryTables(const oatpp::String& query, std::vector<std::string>& tables) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_queryTables.find(*query);
+  if(it != m_queryTables.end()) {
+    tables = it->second;
+    return true;
+  }
+  return false;
+}
+
+void ResultCache::setQueryTables(const oatpp::String& query, const std::vector<std::string>& tables) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_queryTables[*query] = tables;
+}
+
+bool ResultCache::getWrittenTables(const oatpp::String& query, std::vector<std::string>& tables) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_queryWrittenTables.find(*query);
+  if(it != m_queryWrittenTables.end()) {
+    tables = it->second;
+    return true;
+  }
+  return false;
+}
+
+void ResultCache::setWrittenTables(const oatpp::String& query, const std::vector<std::string>& tables) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_queryWrittenTables[*query] = tables;
+}
+
+void ResultCache::addChanges(sqlite3* handle, const std::vector<std::string>& tables) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto& pending = m_pendingChanges[handle];
+  for(auto& table : tables) {
+    pending.insert(table);
+  }
+}
+
+std::vector<v_uint64> ResultCache::getGenerations(const std::vector<std::string>& tables) {
+  std::vector<v_uint64> result;
+  result.reserve(tables.size());
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for(auto& table : tables) {
+    result.push_back(m_tableGenerations[table]);
+  }
+  return result;
+}
+
+std::shared_ptr<const mapping::ResultSet> ResultCache::get(const oatpp::String& key) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_entries.find(*key);
+  if(it == m_entries.end()) {
+    m_stats.misses ++;
+    return nullptr;
+  }
+  m_lru.splice(m_lru.begin(), m_lru, it->second.lruPosition);
+  m_stats.hits ++;
+  return it->second.resultSet;
+}
+
+void ResultCache::put(const oatpp::String& key,
+                      const std::vector<std::string>& tables,
+                      const std::vector<v_uint64>& generations,
+                      const std::shared_ptr<const mapping::ResultSet>& resultSet)
+{
+
+  if(tables.empty() || resultSet->getDataSize() > m_config.maxDataSize) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  for(v_uint32 i = 0; i < tables.size(); i ++) {
+    if(m_tableGenerations[tables[i]] != generations[i]) {
+      return;
+    }
+  }
+
+  auto it = m_entries.find(*key);
+  if(it != m_entries.end()) {
+    removeEntry(it);
+  }
+
+  while(!m_lru.empty() &&
+        ((v_int64) m_entries.size() >= m_config.maxEntries || m_dataSize + resultSet->getDataSize() > m_config.maxDataSize))
+  {
+    removeEntry(m_entries.find(m_lru.back()));
+    m_stats.evictions ++;
+  }
+
+  m_lru.push_front(*key);
+
+  Entry& entry = m_entries[*key];
+  entry.resultSet = resultSet;
+  entry.tables = tables;
+  entry.lruPosition = m_lru.begin();
+
+  for(auto& table : tables) {
+    m_tableEntries[table].insert(*key);
+  }
+
+  m_dataSize += resultSet->getDataSize();
+
+}
+
+void ResultCache::invalidate(const char* database, const char* table) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  invalidateTable(getTableKey(database, table));
+}
+
+void ResultCache::clear() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for(auto& table : m_tableEntries) {
+    m_tableGenerations[table.first] ++;
+  }
+  m_entries.clear();
+  m_lru.clear();
+  m_tableEntries.clear();
+  m_dataSize = 0;
+}
+
+void ResultCache::flush(sqlite3* handle) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_committedChanges.find(handle);
+  if(it == m_committedChanges.end()) {
+    return;
+  }
+  for(auto& table : it->second) {
+    invalidateTable(table);
+  }
+  m_committedChanges.erase(it);
+}
+
+ResultCache::Stats ResultCache::getStats() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  Stats stats = m_stats;
+  stats.entriesCount = m_entries.size();
+  stats.dataSize = m_dataSize;
+  return stats;
+}
+
+void ResultCache::onChange(sqlite3* handle, int operation, const char* database, const char* table, sqlite3_int64 rowId) {
+  (void) operation;
+  (void) rowId;
+  auto key = getTableKey(database, table);
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_pendingChanges[handle].insert(key);
+}
+
+void ResultCache::onCommit(sqlite3* handle) {
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  auto it = m_pendingChanges.find(handle);
+  if(it == m_pendingChanges.end()) {
+    return;
+  }
+
+  /*
+   * Invalidate now, and once again in flush() - when the commit is complete.
+   * Otherwise a reader could cache the old data between the commit hook and the end of the commit.
+   */
+  auto& committed = m_committedChanges[handle];
+  for(auto& table : it->second) {
+    invalidateTable(table);
+    committed.insert(table);
+  }
+
+  m_pendingChanges.erase(it);
+
+}
+
+void ResultCache::onRollback(sqlite3* handle) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_pendingChanges.erase(handle);
+}
+
+}}
@@ -0,0 +1,245 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef oatpp_sqlite_ResultCache_hpp
+#define oatpp_sqlite_ResultCache_hpp
+
+#include "Connection.hpp"
+#include "mapping/ResultSet.hpp"
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace oatpp { namespace sqlite {
+
+/**
+ * Cache of materialized results of read-only queries. <br>
+ * Entries are keyed by query text plus values of bound parameters, and tagged with tables the query reads.
+ * Tables are found by the authorizer callback at statement preparation. <br>
+ * Entries are invalidated when a change to one of their tables is committed - the cache listens to
+ * `sqlite3_update_hook`/`sqlite3_commit_hook` of every connection acquired through the &id:oatpp::sqlite::Executor;. <br>
+ * Changes the update hook doesn't report (WITHOUT ROWID tables, `DROP`/`ALTER TABLE`) are found by the authorizer
+ * callback as tables written by the statement. <br>
+ * Results of queries reading a &id:oatpp::sqlite::VirtualTable; are never cached - its data doesn't change through SQL. <br>
+ * Only results of deterministic queries should be cached - do not enable the cache for templates using
+ * functions like `random()` or `datetime('now')`.
+ */
+class ResultCache : public Connection::ChangeListener {
+public:
+
+  /**
+   * Cache config.
+   */
+  struct Config {
+
+    /**
+     * Max number of entries in the cache.
+     */
+    v_int64 maxEntries = 1024;
+
+    /**
+     * Max size of all cached data in bytes.
+     */
+    v_int64 maxDataSize = 64 * 1024 * 1024;
+
+    /**
+     * Names of query templates allowed to be cached. If empty - results of all read-only templates are cached.
+     */
+    std::unordered_set<std::string> templates;
+
+  };
+
+  /**
+   * Cache statistics.
+   */
+  struct Stats {
+    v_int64 hits;
+    v_int64 misses;
+    v_int64 evictions;
+    v_int64 invalidations;
+    v_int64 entriesCount;
+    v_int64 dataSize;
+  };
+
+private:
+
+  struct Entry {
+    std::shared_ptr<const mapping::ResultSet> resultSet;
+    std::vector<std::string> tables;
+    std::list<std::string>::iterator lruPosition;
+  };
+
+private:
+  void removeEntry(std::unordered_map<std::string, Entry>::iterator it);
+  void invalidateTable(const std::string& table);
+private:
+  Config m_config;
+  std::mutex m_mutex;
+  std::unordered_map<std::string, Entry> m_entries;
+  std::list<std::string> m_lru;
+  std::unordered_map<std::string, std::unordered_set<std::string>> m_tableEntries;
+  std::unordered_map<std::string, v_uint64> m_tableGenerations;
+  std::unordered_map<sqlite3*, std::unordered_set<std::string>> m_pendingChanges;
+  std::unordered_map<sqlite3*, std::unordered_set<std::string>> m_committedChanges;
+  std::unordered_map<std::string, std::vector<std::string>> m_queryTables;
+  std::unordered_map<std::string, std::vector<std::string>> m_queryWrittenTables;
+  std::unordered_set<std::string> m_nonCacheableQueries;
+  v_int64 m_dataSize;
+  Stats m_stats;
+public:
+
+  /**
+   * Constructor with default config.
+   */
+  ResultCache();
+
+  /**
+   * Constructor.
+   * @param config - &l:ResultCache::Config;.
+   */
+  ResultCache(const Config& config);
+
+  /**
+   * Get unique key of the table. Table names are case insensitive.
+   * @param database - database name. If `nullptr` - `main` database is assumed.
+   * @param table - table name.
+   * @return
+   */
+  static std::string getTableKey(const char* database, const char* table);
+
+  /**
+   * Check if results of the query template are allowed to be cached.
+   * @param templateName - name of the query template.
+   * @param query - query text.
+   * @return
+   */
+  bool isCacheable(const oatpp::String& templateName, const oatpp::String& query);
+
+  /**
+   * Mark query as not cacheable (ex.: it is not a read-only statement).
+   * @param query - query text.
+   */
+  void setNonCacheable(const oatpp::String& query);
+
+  /**
+   * Get tables read by the query as they were remembered by &l:ResultCache::setQueryTables ();.
+   * @param query - query text.
+   * @param tables - out tables.
+   * @return - `true` if tables of the query are known.
+   */
+  bool getQueryTables(const oatpp::String& query, std::vector<std::string>& tables);
+
+  /**
+   * Remember tables read by the query.
+   * @param query - query text.
+   * @param tables
+   */
+  void setQueryTables(const oatpp::String& query, const std::vector<std::string>& tables);
+
+  /**
+   * Get tables written by the query as they were remembered by &l:ResultCache::setWrittenTables ();.
+   * @param query - query text.
+   * @param tables - out tables.
+   * @return - `true` if tables written by the query are known.
+   */
+  bool getWrittenTables(const oatpp::String& query, std::vector<std::string>& tables);
+
+  /**
+   * Remember tables written by the query (empty for read-only queries).
+   * @param query - query text.
+   * @param tables
+   */
+  void setWrittenTables(const oatpp::String& query, const std::vector<std::string>& tables);
+
+  /**
+   * Add tables changed by the statement about to run on the connection. <br>
+   * Same as &l:ResultCache::onChange (); - tables are invalidated once the transaction is committed.
+   * @param handle - native connection handle.
+   * @param tables - table keys - see &l:ResultCache::getTableKey ();.
+   */
+  void addChanges(sqlite3* handle, const std::vector<std::string>& tables);
+
+  /**
+   * Get current generations of tables. Pass them to &l:ResultCache::put (); to detect changes committed
+   * while the query was executing.
+   * @param tables
+   * @return
+   */
+  std::vector<v_uint64> getGenerations(const std::vector<std::string>& tables);
+
+  /**
+   * Get cached result.
+   * @param key
+   * @return - cached result or `nullptr`.
+   */
+  std::shared_ptr<const mapping::ResultSet> get(const oatpp::String& key);
+
+  /**
+   * Put result to the cache. The result is dropped if any of the tables changed since `generations` were taken.
+   * @param key
+   * @param tables - tables read by the query.
+   * @param generations - generations of tables taken before the query execution.
+   * @param resultSet
+   */
+  void put(const oatpp::String& key,
+           const std::vector<std::string>& tables,
+           const std::vector<v_uint64>& generations,
+           const std::shared_ptr<const mapping::ResultSet>& resultSet);
+
+  /**
+   * Invalidate all entries reading the table.
+   * @param database - database name. If `nullptr` - `main` database is assumed.
+   * @param table
+   */
+  void invalidate(const char* database, const char* table);
+
+  /**
+   * Remove all entries.
+   */
+  void clear();
+
+  /**
+   * Invalidate entries of tables committed on the connection since the last call. <br>
+   * Called by &id:oatpp::sqlite::Executor; once a statement is done and its changes are visible to other connections.
+   * @param handle
+   */
+  void flush(sqlite3* handle);
+
+  /**
+   * Get cache statistics.
+   * @return
+   */
+  Stats getStats();
+
+  void onChange(sqlite3* handle, int operation, const char* database, const char* table, sqlite3_int64 rowId) override;
+  void onCommit(sqlite3* handle) override;
+  void onRollback(sqlite3* handle) override;
+
+};
+
+}}
+
+#endif // oatpp_sqlite_ResultCache_hpp
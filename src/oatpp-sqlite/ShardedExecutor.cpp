@@ -0,0 +1,413 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#include "ShardedExecutor.hpp"
+
+#include "Types.hpp"
+
+#include <future>
+
+namespace oatpp { namespace sqlite {
+
+v_int32 ShardedExecutor::hashShardFunction(const oatpp::Void& key, v_int32 shardsCount) {
+
+  std::string bytes;
+  auto id = key.getValueType()->classId.id;
+
+  if(id == data::type::__class::String::CLASS_ID.id) {
+    bytes = *static_cast<std::string*>(key.get());
+  } else if(id == data::type::__class::Int8::CLASS_ID.id) {
+    bytes = std::to_string(*static_cast<v_int8*>(key.get()));
+  } else if(id == data::type::__class::UInt8::CLASS_ID.id) {
+    bytes = std::to_string(*static_cast<v_uint8*>(key.get()));
+  } else if(id == data::type::__class::Int16::CLASS_ID.id) {
+    bytes = std::to_string(*static_cast<v_int16*>(key.get()));
+  } else if(id == data::type::__class::UInt16::CLASS_ID.id) {
+    bytes = std::to_string(*static_cast<v_uint16*>(key.get()));
+  } else if(id == data::type::__class::Int32::CLASS_ID.id) {
+    bytes = std::to_string(*static_cast<v_int32*>(key.get()));
+  } else if(id == data::type::__class::UInt32::CLASS_ID.id) {
+    bytes = std::to_string(*static_cast<v_uint32*>(key.get()));
+  } else if(id == data::type::__class::Int64::CLASS_ID.id) {
+    bytes = std::to_string(*static_cast<v_int64*>(key.get()));
+  } else if(id == data::type::__class::UInt64::CLASS_ID.id) {
+    bytes = std::to_string(*static_cast<v_uint64*>(key.get()));
+  } else {
+    throw std::runtime_error("[oatpp::sqlite::ShardedExecutor::hashShardFunction()]: "
+                             "Error. Unsupported shard key type '" + std::string(key.getValueType()->classId.name) + "'.");
+  }
+
+  /* FNV-1a - stable across platforms and runs, unlike std::hash */
+  v_uint64 hash = 14695981039346656037ULL;
+  for(auto c : bytes) {
+    hash ^= static_cast<v_uint8>(c);
+    hash *= 1099511628211ULL;
+  }
+
+  return static_cast<v_int32>(hash % static_cast<v_uint64>(shardsCount));
+
+}
+
+ShardedExecutor::ShardedExecutor(const std::vector<std::shared_ptr<sqlite::Executor>>& shards,
+                                 const oatpp::String& shardKey,
+                                 const ShardFunction& shardFunction)
+  : m_shards(shards)
+  , m_shardKey(shardKey)
+  , m_shardFunction(shardFunction)
+  , m_resultMapper(std::make_shared<mapping::ResultMapper>())
+{
+
+  if(m_shards.empty()) {
+    throw std::runtime_error("[oatpp::sqlite::ShardedExecutor::ShardedExecutor()]: Error. No shards.");
+  }
+
+  if(!m_shardFunction) {
+    m_shardFunction = &ShardedExecutor::hashShardFunction;
+  }
+
+  m_defaultTypeResolver->addKnownClasses({
+    Blob::Class::CLASS_ID,
+    Embedding::Class::CLASS_ID
+  });
+
+}
+
+v_int32 ShardedExecutor::getShardsCount() const {
+  return static_cast<v_int32>(m_shards.size());
+}
+
+std::shared_ptr<sqlite::Executor> ShardedExecutor::getShard(v_int32 index) const {
+  return m_shards.at(index);
+}
+
+v_int32 ShardedExecutor::getShardIndex(const oatpp::Void& key) const {
+  if(!key) {
+    throw std::runtime_error("[oatpp::sqlite::ShardedExecutor::getShardIndex()]: Error. Shard key is null.");
+  }
+  auto index = m_shardFunction(key, getShardsCount());
+  if(index < 0 || index >= getShardsCount()) {
+    throw std::runtime_error("[oatpp::sqlite::ShardedExecutor::getShardIndex()]: Error. Invalid shard index " + std::to_string(index) + ".");
+  }
+  return index;
+}
+
+void ShardedExecutor::loadShardFiles() {
+  m_shardFiles.clear();
+  for(auto& shard : m_shards) {
+    auto connection = shard->getConnection();
+    auto fileName = sqlite3_db_filename(std::static_pointer_cast<sqlite::Connection>(connection.object)->getHandle(), "main");
+    m_shardFiles.push_back(fileName ? fileName : "");
+  }
+}
+
+v_int32 ShardedExecutor::findShardFile(const std::string& fileName) {
+  v_int32 result = -1;
+  for(size_t i = 0; i < m_shardFiles.size(); i ++) {
+    if(m_shardFiles[i] == fileName) {
+      if(result >= 0) {
+        throw std::runtime_error("[oatpp::sqlite::ShardedExecutor::getConnectionShardIndex()]: "
+                                 "Error. Shards share the database file '" + fileName + "' - pass the shard key.");
+      }
+      result = static_cast<v_int32>(i);
+    }
+  }
+  return result;
+}
+
+v_int32 ShardedExecutor::getConnectionShardIndex(const provider::ResourceHandle<orm::Connection>& connection) {
+
+  if(!connection) {
+    throw std::runtime_error("[oatpp::sqlite::ShardedExecutor::getConnectionShardIndex()]: Error. Connection is null.");
+  }
+
+  auto handle = std::static_pointer_cast<sqlite::Connection>(connection.object)->getHandle();
+  auto name = sqlite3_db_filename(handle, "main");
+  std::string fileName = name ? name : "";
+
+  std::lock_guard<std::mutex> lock(m_shardFilesMutex);
+
+  if(m_shardFiles.empty()) {
+    loadShardFiles();
+  }
+
+  auto index = findShardFile(fileName);
+  if(index < 0) {
+    /* shard provider might have switched to another file (hot swap) - reload once */
+    loadShardFiles();
+    index = findShardFile(fileName);
+  }
+
+  if(index < 0) {
+    throw std::runtime_error("[oatpp::sqlite::ShardedExecutor::getConnectionShardIndex()]: "
+                             "Error. Connection doesn't belong to any shard.");
+  }
+
+  return index;
+
+}
+
+provider::ResourceHandle<orm::Connection> ShardedExecutor::getConnection(const oatpp::Void& key) {
+  {
+    /* resolve shard files before the connection is taken - small pools would block on it later */
+    std::lock_guard<std::mutex> lock(m_shardFilesMutex);
+    if(m_shardFiles.empty()) {
+      loadShardFiles();
+    }
+  }
+  return m_shards[getShardIndex(key)]->getConnection();
+}
+
+std::shared_ptr<data::mapping::TypeResolver> ShardedExecutor::createTypeResolver() {
+  return m_shards[0]->createTypeResolver();
+}
+
+data::share::StringTemplate ShardedExecutor::parseQueryTemplate(const oatpp::String& name,
+                                                                const oatpp::String& text,
+                                                                const ParamsTypeMap& paramsTypeMap,
+                                                                bool prepare)
+{
+  /* all shards are SQLite executors - template is the same for all of them */
+  return m_shards[0]->parseQueryTemplate(name, text, paramsTypeMap, prepare);
+}
+
+provider::ResourceHandle<orm::Connection> ShardedExecutor::getConnection() {
+  throw std::runtime_error("[oatpp::sqlite::ShardedExecutor::getConnection()]: "
+                           "Error. Connection depends on the shard key. Use getConnection(key) or getShard(index).");
+}
+
+oatpp::Void ShardedExecutor::resolveShardKey(const StringTemplate& queryTemplate,
+                                             const std::unordered_map<oatpp::String, oatpp::Void>& params,
+                                             const std::shared_ptr<const data::mapping::TypeResolver>& typeResolver)
+{
+
+  auto it = params.find(m_shardKey);
+  if(it != params.end()) {
+    return it->second;
+  }
+
+  std::shared_ptr<const data::mapping::TypeResolver> tr = typeResolver;
+  if(!tr) {
+    tr = m_defaultTypeResolver;
+  }
+
+  data::mapping::TypeResolver::Cache cache;
+
+  /* key is a property of a DTO parameter - ex.: ':row.userId' */
+  for(auto& var : queryTemplate.getTemplateVariables()) {
+
+    std::vector<std::string> path;
+    size_t start = 0;
+    size_t dot;
+    while((dot = var.name->find('.', start)) != std::string::npos) {
+      path.push_back(var.name->substr(start, dot - start));
+      start = dot + 1;
+    }
+    path.push_back(var.name->substr(start));
+
+    if(path.size() < 2 || (*var.name != *m_shardKey && path.back() != *m_shardKey)) {
+      continue;
+    }
+
+    auto paramIt = params.find(path[0]);
+    if(paramIt == params.end()) {
+      continue;
+    }
+
+    path.erase(path.begin());
+    auto value = tr->resolveObjectPropertyValue(paramIt->second, path, cache);
+    if(value.getValueType()->classId.id != oatpp::Void::Class::CLASS_ID.id) {
+      return value;
+    }
+
+  }
+
+  return nullptr;
+
+}
+
+bool ShardedExecutor::isReadOnly(const StringTemplate& queryTemplate) {
+
+  auto extra = std::static_pointer_cast<ql_template::Parser::TemplateExtra>(queryTemplate.getExtraData());
+  std::string queryName = extra->templateName ? *extra->templateName : "UnNamed";
+
+  {
+    std::lock_guard<std::mutex> lock(m_readOnlyMutex);
+    auto it = m_readOnlyTemplates.find(*extra->preparedTemplate);
+    if(it != m_readOnlyTemplates.end()) {
+      return it->second;
+    }
+  }
+
+  /* schema is the same on all shards - statement is checked on the first one */
+  auto connection = m_shards[0]->getConnection();
+  auto handle = std::static_pointer_cast<sqlite::Connection>(connection.object)->getHandle();
+
+  sqlite3_stmt* stmt = nullptr;
+  auto res = sqlite3_prepare_v2(handle, extra->preparedTemplate->c_str(), -1, &stmt, nullptr);
+  if(res != SQLITE_OK) {
+    std::string errMsg = sqlite3_errmsg(handle);
+    sqlite3_finalize(stmt);
+    throw std::runtime_error("[oatpp::sqlite::ShardedExecutor::isReadOnly()]: "
+                             "Error. Can't prepare statement of the query '" + queryName + "'. " + errMsg);
+  }
+
+  bool readOnly = sqlite3_stmt_readonly(stmt) != 0;
+  sqlite3_finalize(stmt);
+
+  std::lock_guard<std::mutex> lock(m_readOnlyMutex);
+  m_readOnlyTemplates.insert({*extra->preparedTemplate, readOnly});
+  return readOnly;
+
+}
+
+std::shared_ptr<orm::QueryResult> ShardedExecutor::scatterGather(const StringTemplate& queryTemplate,
+                                                                 const std::unordered_map<oatpp::String, oatpp::Void>& params,
+                                                                 const std::shared_ptr<const data::mapping::TypeResolver>& typeResolver)
+{
+
+  typedef std::pair<std::shared_ptr<orm::QueryResult>, std::shared_ptr<const mapping::ResultSet>> ShardResult;
+
+  auto runShard = [this, &queryTemplate, &params, &typeResolver](size_t index) -> ShardResult {
+    auto result = m_shards[index]->execute(queryTemplate, params, typeResolver, nullptr);
+    /* read rows now - connection of the shard is released as soon as possible */
+    auto resultSet = std::static_pointer_cast<QueryResult>(result)->materialize();
+    return {result, resultSet};
+  };
+
+  std::vector<std::future<ShardResult>> futures;
+  for(size_t i = 1; i < m_shards.size(); i ++) {
+    futures.push_back(std::async(std::launch::async, runShard, i));
+  }
+
+  std::vector<ShardResult> results;
+  results.push_back(runShard(0));
+  for(auto& future : futures) {
+    results.push_back(future.get());
+  }
+
+  for(auto& result : results) {
+    if(!result.second) {
+      return result.first;
+    }
+  }
+
+  auto merged = std::make_shared<mapping::ResultSet>(results[0].second->getColNames());
+  for(auto& result : results) {
+    for(v_int64 i = 0; i < result.second->getRowCount(); i ++) {
+      merged->addRow(result.second->getRow(i));
+    }
+  }
+
+  std::shared_ptr<const data::mapping::TypeResolver> tr = typeResolver;
+  if(!tr) {
+    tr = m_defaultTypeResolver;
+  }
+
+  return std::make_shared<QueryResult>(merged, nullptr, m_resultMapper, tr);
+
+}
+
+std::shared_ptr<orm::QueryResult> ShardedExecutor::execute(const StringTemplate& queryTemplate,
+                                                           const std::unordered_map<oatpp::String, oatpp::Void>& params,
+                                                           const std::shared_ptr<const data::mapping::TypeResolver>& typeResolver,
+                                                           const provider::ResourceHandle<orm::Connection>& connection)
+{
+
+  auto key = resolveShardKey(queryTemplate, params, typeResolver);
+
+  if(connection) {
+    /* query runs on the given connection - executor of the owning shard keeps its caches consistent */
+    v_int32 index = getConnectionShardIndex(connection);
+    if(key && getShardIndex(key) != index) {
+      throw std::runtime_error("[oatpp::sqlite::ShardedExecutor::execute()]: "
+                               "Error. Connection doesn't belong to the shard of the key.");
+    }
+    return m_shards[index]->execute(queryTemplate, params, typeResolver, connection);
+  }
+
+  if(key) {
+    return m_shards[getShardIndex(key)]->execute(queryTemplate, params, typeResolver, nullptr);
+  }
+
+  /* writes to all shards can't be atomic - only reads are scattered */
+  if(!isReadOnly(queryTemplate)) {
+    auto extra = std::static_pointer_cast<ql_template::Parser::TemplateExtra>(queryTemplate.getExtraData());
+    std::string queryName = extra->templateName ? *extra->templateName : "UnNamed";
+    throw std::runtime_error("[oatpp::sqlite::ShardedExecutor::execute()]: "
+                             "Error. Statement modifying data has no shard key value - query '" + queryName + "'. "
+                             "Pass the key or run it per shard.");
+  }
+
+  return scatterGather(queryTemplate, params, typeResolver);
+
+}
+
+std::shared_ptr<orm::QueryResult> ShardedExecutor::begin(const provider::ResourceHandle<orm::Connection>& connection) {
+  if(!connection) {
+    throw std::runtime_error("[oatpp::sqlite::ShardedExecutor::begin()]: "
+                             "Error. Transaction is per shard - use connection returned by getConnection(key).");
+  }
+  return m_shards[getConnectionShardIndex(connection)]->begin(connection);
+}
+
+std::shared_ptr<orm::QueryResult> ShardedExecutor::commit(const provider::ResourceHandle<orm::Connection>& connection) {
+  return m_shards[getConnectionShardIndex(connection)]->commit(connection);
+}
+
+std::shared_ptr<orm::QueryResult> ShardedExecutor::rollback(const provider::ResourceHandle<orm::Connection>& connection) {
+  return m_shards[getConnectionShardIndex(connection)]->rollback(connection);
+}
+
+v_int64 ShardedExecutor::getSchemaVersion(const oatpp::String& suffix,
+                                          const provider::ResourceHandle<orm::Connection>& connection)
+{
+  if(connection) {
+    return m_shards[getConnectionShardIndex(connection)]->getSchemaVersion(suffix, connection);
+  }
+  v_int64 result = -1;
+  for(auto& shard : m_shards) {
+    auto version = shard->getSchemaVersion(suffix, shard->getConnection());
+    if(result < 0 || version < result) {
+      result = version;
+    }
+  }
+  return result;
+}
+
+void ShardedExecutor::migrateSchema(const oatpp::String& script,
+                                    v_int64 newVersion,
+                                    const oatpp::String& suffix,
+                                    const provider::ResourceHandle<orm::Connection>& connection)
+{
+  if(connection) {
+    m_shards[getConnectionShardIndex(connection)]->migrateSchema(script, newVersion, suffix, connection);
+    return;
+  }
+  for(auto& shard : m_shards) {
+    shard->migrateSchema(script, newVersion, suffix, shard->getConnection());
+  }
+}
+
+}}
@@ -0,0 +1,185 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#ifndef oatpp_sqlite_ShardedExecutor_hpp
+#define oatpp_sqlite_ShardedExecutor_hpp
+
+#include "Executor.hpp"
+
+namespace oatpp { namespace sqlite {
+
+/**
+ * Executor partitioning data across several database files (shards). <br>
+ * Each shard is an &id:oatpp::sqlite::Executor; over its own file and pool, so writes to different shards
+ * run in parallel. <br>
+ * - Query having the shard-key parameter is routed to a single shard by the parameter value.
+ * The key is also found in a DTO parameter - template variable `:row.userId` matches the shard key `userId`. <br>
+ * - Read-only query without the shard-key value runs on all shards in parallel (scatter-gather) and rows of all shards
+ * are concatenated. `ORDER BY`, `LIMIT` and aggregates are applied per shard only.
+ * Statements modifying data without the shard-key value (or with the `null` key) are rejected -
+ * run them per shard - see &l:ShardedExecutor::getShard ();. <br>
+ * Transactions are per shard - get connection with &l:ShardedExecutor::getConnection (const oatpp::Void& key); and
+ * pass it to queries having the same shard key. Query on an explicit connection runs on the shard owning
+ * the connection (matched by the database file). <br>
+ * Run `SchemaMigration` per shard - see &l:ShardedExecutor::getShard ();.
+ * ```cpp
+ * auto executor = std::make_shared<oatpp::sqlite::ShardedExecutor>(shards, "userId");
+ *
+ * QUERY(getOrders, "SELECT * FROM orders WHERE user_id=:userId", PARAM(oatpp::Int64, userId)) // one shard
+ * QUERY(getAllOrders, "SELECT * FROM orders") // all shards
+ * ```
+ */
+class ShardedExecutor : public orm::Executor {
+public:
+
+  /**
+   * Function mapping shard key value to the shard index. Arguments are the key value and the number of shards.
+   */
+  typedef std::function<v_int32(const oatpp::Void&, v_int32)> ShardFunction;
+
+private:
+  std::vector<std::shared_ptr<sqlite::Executor>> m_shards;
+  oatpp::String m_shardKey;
+  ShardFunction m_shardFunction;
+  std::shared_ptr<mapping::ResultMapper> m_resultMapper;
+private:
+  std::mutex m_shardFilesMutex;
+  std::vector<std::string> m_shardFiles;
+private:
+  /* read-only flags of statements by prepared template text */
+  std::mutex m_readOnlyMutex;
+  std::unordered_map<std::string, bool> m_readOnlyTemplates;
+private:
+  void loadShardFiles();
+  v_int32 findShardFile(const std::string& fileName);
+  oatpp::Void resolveShardKey(const StringTemplate& queryTemplate,
+                              const std::unordered_map<oatpp::String, oatpp::Void>& params,
+                              const std::shared_ptr<const data::mapping::TypeResolver>& typeResolver);
+  bool isReadOnly(const StringTemplate& queryTemplate);
+  std::shared_ptr<orm::QueryResult> scatterGather(const StringTemplate& queryTemplate,
+                                                  const std::unordered_map<oatpp::String, oatpp::Void>& params,
+                                                  const std::shared_ptr<const data::mapping::TypeResolver>& typeResolver);
+public:
+
+  /**
+   * Default &l:ShardedExecutor::ShardFunction;. <br>
+   * Stable FNV-1a hash of the key value modulo number of shards. Integer and string keys are supported.
+   * @param key - key value.
+   * @param shardsCount - number of shards.
+   * @return - shard index.
+   */
+  static v_int32 hashShardFunction(const oatpp::Void& key, v_int32 shardsCount);
+
+public:
+
+  /**
+   * Constructor.
+   * @param shards - executors of shards. Order of shards must not change between runs.
+   * @param shardKey - name of the query parameter used as the shard key.
+   * @param shardFunction - &l:ShardedExecutor::ShardFunction;. `nullptr` - &l:ShardedExecutor::hashShardFunction ();.
+   */
+  ShardedExecutor(const std::vector<std::shared_ptr<sqlite::Executor>>& shards,
+                  const oatpp::String& shardKey,
+                  const ShardFunction& shardFunction = nullptr);
+
+  /**
+   * Get number of shards.
+   * @return
+   */
+  v_int32 getShardsCount() const;
+
+  /**
+   * Get executor of the shard.
+   * @param index - shard index.
+   * @return - &id:oatpp::sqlite::Executor;.
+   */
+  std::shared_ptr<sqlite::Executor> getShard(v_int32 index) const;
+
+  /**
+   * Get index of the shard the key belongs to.
+   * @param key - shard key value.
+   * @return - shard index.
+   */
+  v_int32 getShardIndex(const oatpp::Void& key) const;
+
+  /**
+   * Get index of the shard owning the connection. Shard is matched by the database file of the connection.
+   * @param connection - connection acquired from one of the shards.
+   * @return - shard index.
+   * @throws - `std::runtime_error` if the connection belongs to none of the shards or
+   * shards can't be told apart (for example in-memory databases).
+   */
+  v_int32 getConnectionShardIndex(const provider::ResourceHandle<orm::Connection>& connection);
+
+  /**
+   * Get connection to the shard the key belongs to. Use it for transactions.
+   * @param key - shard key value.
+   * @return - connection.
+   */
+  provider::ResourceHandle<orm::Connection> getConnection(const oatpp::Void& key);
+
+  std::shared_ptr<data::mapping::TypeResolver> createTypeResolver() override;
+
+  StringTemplate parseQueryTemplate(const oatpp::String& name,
+                                    const oatpp::String& text,
+                                    const ParamsTypeMap& paramsTypeMap,
+                                    bool prepare) override;
+
+  /**
+   * Not supported - connection depends on the shard key.
+   * @throws - `std::runtime_error`. Use &l:ShardedExecutor::getConnection (const oatpp::Void& key);.
+   */
+  provider::ResourceHandle<orm::Connection> getConnection() override;
+
+  std::shared_ptr<orm::QueryResult> execute(const StringTemplate& queryTemplate,
+                                            const std::unordered_map<oatpp::String, oatpp::Void>& params,
+                                            const std::shared_ptr<const data::mapping::TypeResolver>& typeResolver,
+                                            const provider::ResourceHandle<orm::Connection>& connection) override;
+
+  std::shared_ptr<orm::QueryResult> begin(const provider::ResourceHandle<orm::Connection>& connection = nullptr) override;
+
+  std::shared_ptr<orm::QueryResult> commit(const provider::ResourceHandle<orm::Connection>& connection) override;
+
+  std::shared_ptr<orm::QueryResult> rollback(const provider::ResourceHandle<orm::Connection>& connection) override;
+
+  /**
+   * Get schema version. If `connection` is `nullptr` - min version across all shards.
+   */
+  v_int64 getSchemaVersion(const oatpp::String& suffix = nullptr,
+                           const provider::ResourceHandle<orm::Connection>& connection = nullptr) override;
+
+  /**
+   * Migrate schema. If `connection` is `nullptr` - migrate all shards.
+   */
+  void migrateSchema(const oatpp::String& script,
+                     v_int64 newVersion,
+                     const oatpp::String& suffix = nullptr,
+                     const provider::ResourceHandle<orm::Connection>& connection = nullptr) override;
+
+};
+
+}}
+
+#endif // oatpp_sqlite_ShardedExecutor_hpp
@@ -0,0 +1,250 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#include "SpatialIndex.hpp"
+
+#include "Utils.hpp"
+
+#include "oatpp/data/stream/BufferStream.hpp"
+
+#include <set>
+
+namespace oatpp { namespace sqlite {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// SpatialIndex::Dimension
+
+SpatialIndex::Dimension SpatialIndex::Dimension::point(const oatpp::String& column) {
+  return range(column, column);
+}
+
+SpatialIndex::Dimension SpatialIndex::Dimension::range(const oatpp::String& minColumn, const oatpp::String& maxColumn) {
+  Dimension result;
+  result.minColumn = minColumn;
+  result.maxColumn = maxColumn;
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// SpatialIndex
+
+SpatialIndex::SpatialIndex(const Config& config)
+  : m_config(config)
+{
+
+  if(!m_config.table || !m_config.contentTable) {
+    throw std::runtime_error("[oatpp::sqlite::SpatialIndex::SpatialIndex()]: Error. Table names must be set.");
+  }
+
+  if(!m_config.contentRowId) {
+    throw std::runtime_error("[oatpp::sqlite::SpatialIndex::SpatialIndex()]: Error. Content rowid must be set.");
+  }
+
+  if(m_config.dimensions.empty() || m_config.dimensions.size() > 5) {
+    throw std::runtime_error("[oatpp::sqlite::SpatialIndex::SpatialIndex()]: Error. Number of dimensions must be in 1..5.");
+  }
+
+  for(auto& dimension : m_config.dimensions) {
+    if(!dimension.minColumn || !dimension.maxColumn) {
+      throw std::runtime_error("[oatpp::sqlite::SpatialIndex::SpatialIndex()]: Error. Dimension columns must be set.");
+    }
+  }
+
+}
+
+oatpp::String SpatialIndex::getIndexColumns() const {
+  data::stream::BufferOutputStream stream;
+  stream << "id";
+  for(v_uint32 i = 0; i < m_config.dimensions.size(); i ++) {
+    stream << ", min" << i << ", max" << i;
+  }
+  return stream.toString();
+}
+
+oatpp::String SpatialIndex::getContentColumns(const char* prefix) const {
+  data::stream::BufferOutputStream stream;
+  stream << Utils::getRowId(m_config.contentRowId, prefix);
+  for(auto& dimension : m_config.dimensions) {
+    stream << ", " << prefix << Utils::quoteIdentifier(dimension.minColumn)
+           << ", " << prefix << Utils::quoteIdentifier(dimension.maxColumn);
+  }
+  return stream.toString();
+}
+
+oatpp::String SpatialIndex::getNotNullCondition(const char* prefix) const {
+  std::set<std::string> columns;
+  for(auto& dimension : m_config.dimensions) {
+    columns.insert(*dimension.minColumn);
+    columns.insert(*dimension.maxColumn);
+  }
+  data::stream::BufferOutputStream stream;
+  bool first = true;
+  for(auto& column : columns) {
+    if(!first) {
+      stream << " AND ";
+    }
+    first = false;
+    stream << prefix << Utils::quoteIdentifier(column) << " IS NOT NULL";
+  }
+  return stream.toString();
+}
+
+const SpatialIndex::Config& SpatialIndex::getConfig() const {
+  return m_config;
+}
+
+oatpp::String SpatialIndex::getCreateScript() const {
+
+  auto table = Utils::quoteIdentifier(m_config.table);
+  auto contentTable = Utils::quoteIdentifier(m_config.contentTable);
+  auto indexColumns = getIndexColumns();
+
+  data::stream::BufferOutputStream stream;
+
+  stream << "CREATE VIRTUAL TABLE " << table << " USING rtree(" << indexColumns << ");\n";
+
+  stream << "CREATE TRIGGER " << Utils::quoteIdentifier(*m_config.table + "_ai") << " AFTER INSERT ON " << contentTable
+         << " WHEN " << getNotNullCondition("new.") << " BEGIN\n"
+         << "  INSERT INTO " << table << "(" << indexColumns << ") VALUES (" << getContentColumns("new.") << ");\n"
+         << "END;\n";
+
+  stream << "CREATE TRIGGER " << Utils::quoteIdentifier(*m_config.table + "_ad") << " AFTER DELETE ON " << contentTable << " BEGIN\n"
+         << "  DELETE FROM " << table << " WHERE id = " << Utils::getRowId(m_config.contentRowId, "old.") << ";\n"
+         << "END;\n";
+
+  /* fire only when indexed columns change - updates of other columns don't touch the index */
+  std::set<std::string> updateColumns;
+  for(auto& dimension : m_config.dimensions) {
+    updateColumns.insert(*dimension.minColumn);
+    updateColumns.insert(*dimension.maxColumn);
+  }
+  if(m_config.contentRowId != "rowid") {
+    updateColumns.insert(*m_config.contentRowId);
+  }
+
+  stream << "CREATE TRIGGER " << Utils::quoteIdentifier(*m_config.table + "_au") << " AFTER UPDATE OF ";
+  bool first = true;
+  for(auto& column : updateColumns) {
+    if(!first) {
+      stream << ", ";
+    }
+    first = false;
+    stream << Utils::quoteIdentifier(column);
+  }
+  stream << " ON " << contentTable << " BEGIN\n"
+         << "  DELETE FROM " << table << " WHERE id = " << Utils::getRowId(m_config.contentRowId, "old.") << ";\n"
+         << "  INSERT INTO " << table << "(" << indexColumns << ") SELECT " << getContentColumns("new.")
+         << " WHERE " << getNotNullCondition("new.") << ";\n"
+         << "END;\n";
+
+  stream << getRebuildScript();
+
+  return stream.toString();
+
+}
+
+oatpp::String SpatialIndex::getDropScript() const {
+  data::stream::BufferOutputStream stream;
+  stream << "DROP TRIGGER IF EXISTS " << Utils::quoteIdentifier(*m_config.table + "_ai") << ";\n";
+  stream << "DROP TRIGGER IF EXISTS " << Utils::quoteIdentifier(*m_config.table + "_ad") << ";\n";
+  stream << "DROP TRIGGER IF EXISTS " << Utils::quoteIdentifier(*m_config.table + "_au") << ";\n";
+  stream << "DROP TABLE IF EXISTS " << Utils::quoteIdentifier(m_config.table) << ";\n";
+  return stream.toString();
+}
+
+oatpp::String SpatialIndex::getRebuildScript() const {
+  auto table = Utils::quoteIdentifier(m_config.table);
+  data::stream::BufferOutputStream stream;
+  stream << "DELETE FROM " << table << ";\n";
+  stream << "INSERT INTO " << table << "(" << getIndexColumns() << ") SELECT " << getContentColumns("")
+         << " FROM " << Utils::quoteIdentifier(m_config.contentTable) << " WHERE " << getNotNullCondition("") << ";\n";
+  return stream.toString();
+}
+
+oatpp::String SpatialIndex::getQuery(const QueryOptions& options) const {
+
+  auto table = Utils::quoteIdentifier(m_config.table);
+
+  data::stream::BufferOutputStream stream;
+
+  stream << "SELECT " << options.resultColumns
+         << " FROM " << table << " r"
+         << " JOIN " << Utils::quoteIdentifier(m_config.contentTable) << " c ON " << Utils::getRowId(m_config.contentRowId, "c.") << " = r.id"
+         << " WHERE ";
+
+  for(v_uint32 i = 0; i < m_config.dimensions.size(); i ++) {
+    if(i > 0) {
+      stream << " AND ";
+    }
+    stream << "r.max" << i << " >= :min" << i << " AND r.min" << i << " <= :max" << i;
+  }
+
+  if(options.exact) {
+    for(v_uint32 i = 0; i < m_config.dimensions.size(); i ++) {
+      auto& dimension = m_config.dimensions[i];
+      stream << " AND c." << Utils::quoteIdentifier(dimension.maxColumn) << " >= :min" << i
+             << " AND c." << Utils::quoteIdentifier(dimension.minColumn) << " <= :max" << i;
+    }
+  }
+
+  if(options.limitParam) {
+    stream << " LIMIT :" << options.limitParam;
+  }
+
+  return stream.toString();
+
+}
+
+oatpp::String SpatialIndex::getQuery() const {
+  return getQuery(QueryOptions());
+}
+
+std::shared_ptr<orm::QueryResult> SpatialIndex::query(const std::shared_ptr<orm::Executor>& executor,
+                                                      const BoundingBox& box,
+                                                      v_int64 limit,
+                                                      const provider::ResourceHandle<orm::Connection>& connection) const
+{
+
+  if(box.size() != m_config.dimensions.size()) {
+    throw std::runtime_error("[oatpp::sqlite::SpatialIndex::query()]: Error. "
+                             "Bounding box has " + std::to_string(box.size()) + " dimensions, index has " +
+                             std::to_string(m_config.dimensions.size()) + ".");
+  }
+
+  QueryOptions options;
+  options.limitParam = "limit";
+
+  std::unordered_map<oatpp::String, oatpp::Void> params;
+  for(v_uint32 i = 0; i < box.size(); i ++) {
+    params[oatpp::String("min" + std::to_string(i))] = oatpp::Float64(box[i].min);
+    params[oatpp::String("max" + std::to_string(i))] = oatpp::Float64(box[i].max);
+  }
+  params["limit"] = oatpp::Int64(limit);
+
+  return executor->execute(getQuery(options), params, nullptr, connection);
+
+}
+
+}}
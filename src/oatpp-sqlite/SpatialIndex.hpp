@@ -0,0 +1,255 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#ifndef oatpp_sqlite_SpatialIndex_hpp
+#define oatpp_sqlite_SpatialIndex_hpp
+
+#include "oatpp/orm/Executor.hpp"
+#include "oatpp/Types.hpp"
+
+#include <vector>
+
+namespace oatpp { namespace sqlite {
+
+/**
+ * R*Tree index over a regular table - `rtree` virtual table kept in sync by triggers. <br>
+ * Turns bounding-box filters over coordinate columns into index lookups. Ex.:
+ * ```cpp
+ * oatpp::sqlite::SpatialIndex::Config config;
+ * config.table = "places_rtree";
+ * config.contentTable = "places";
+ * config.contentRowId = "id";
+ * config.dimensions = {
+ *   oatpp::sqlite::SpatialIndex::Dimension::point("lon"),
+ *   oatpp::sqlite::SpatialIndex::Dimension::point("lat")
+ * };
+ *
+ * oatpp::sqlite::SpatialIndex index(config);
+ * migration.addText(2, index.getCreateScript());
+ * ...
+ * auto places = index.find<PlaceDto>(executor, {{30.4, 30.7}, {50.3, 50.6}}); // lon range, lat range
+ * ```
+ * R*Tree must be enabled in SQLite - `SQLITE_ENABLE_RTREE`.
+ */
+class SpatialIndex {
+public:
+
+  /**
+   * Indexed dimension - pair of columns of the content table holding the extent of the row.
+   */
+  struct Dimension {
+
+    /**
+     * Create dimension of the point coordinate - min and max is the same column.
+     * @param column - column name.
+     * @return - &l:SpatialIndex::Dimension;.
+     */
+    static Dimension point(const oatpp::String& column);
+
+    /**
+     * Create dimension of the interval.
+     * @param minColumn - column holding the lower bound.
+     * @param maxColumn - column holding the upper bound.
+     * @return - &l:SpatialIndex::Dimension;.
+     */
+    static Dimension range(const oatpp::String& minColumn, const oatpp::String& maxColumn);
+
+    /**
+     * Column holding the lower bound.
+     */
+    oatpp::String minColumn;
+
+    /**
+     * Column holding the upper bound.
+     */
+    oatpp::String maxColumn;
+
+  };
+
+  /**
+   * Index configuration.
+   */
+  struct Config {
+
+    /**
+     * Name of the `rtree` table.
+     */
+    oatpp::String table;
+
+    /**
+     * Name of the content table.
+     */
+    oatpp::String contentTable;
+
+    /**
+     * Integer primary key of the content table.
+     */
+    oatpp::String contentRowId = "rowid";
+
+    /**
+     * Indexed dimensions. 1..5.
+     */
+    std::vector<Dimension> dimensions;
+
+  };
+
+  /**
+   * Range of values in one dimension.
+   */
+  struct Range {
+
+    /**
+     * Lower bound. Inclusive.
+     */
+    v_float64 min;
+
+    /**
+     * Upper bound. Inclusive.
+     */
+    v_float64 max;
+
+  };
+
+  /**
+   * Bounding box - range for each of &l:SpatialIndex::Config::dimensions;.
+   */
+  typedef std::vector<Range> BoundingBox;
+
+  /**
+   * Options of the bounding-box query.
+   */
+  struct QueryOptions {
+
+    /**
+     * Columns selected from the content table. Content table is aliased as `c`.
+     */
+    oatpp::String resultColumns = "c.*";
+
+    /**
+     * Check the box against the content columns too. <br>
+     * `rtree` stores 32-bit floats rounded outwards - without this check rows just outside the box may be returned.
+     */
+    bool exact = true;
+
+    /**
+     * Name of the `LIMIT` parameter. `nullptr` - no limit.
+     */
+    oatpp::String limitParam;
+
+  };
+
+private:
+  oatpp::String getIndexColumns() const;
+  oatpp::String getContentColumns(const char* prefix) const;
+  oatpp::String getNotNullCondition(const char* prefix) const;
+private:
+  Config m_config;
+public:
+
+  /**
+   * Constructor.
+   * @param config - &l:SpatialIndex::Config;.
+   */
+  SpatialIndex(const Config& config);
+
+  /**
+   * Get config.
+   * @return - &l:SpatialIndex::Config;.
+   */
+  const Config& getConfig() const;
+
+  /**
+   * Script creating the `rtree` table, the sync triggers and indexing the existing content. <br>
+   * Rows with `NULL` in any indexed column are not indexed. Use as schema migration - `SchemaMigration::addText`.
+   * @return
+   */
+  oatpp::String getCreateScript() const;
+
+  /**
+   * Script dropping the triggers and the `rtree` table.
+   * @return
+   */
+  oatpp::String getDropScript() const;
+
+  /**
+   * Script re-indexing the content table. Needed if the content was changed with triggers disabled.
+   * @return
+   */
+  oatpp::String getRebuildScript() const;
+
+  /**
+   * Query template selecting rows which intersect the bounding box. <br>
+   * Parameters - `:min0`, `:max0`, `:min1`, `:max1`, ... - range for each dimension.
+   * @param options - &l:SpatialIndex::QueryOptions;.
+   * @return
+   */
+  oatpp::String getQuery(const QueryOptions& options) const;
+
+  /**
+   * Query template with default &l:SpatialIndex::QueryOptions;.
+   * @return
+   */
+  oatpp::String getQuery() const;
+
+  /**
+   * Run the bounding-box query.
+   * @param executor - &id:oatpp::orm::Executor;.
+   * @param box - &l:SpatialIndex::BoundingBox;.
+   * @param limit - max number of rows. `-1` - no limit.
+   * @param connection - connection to use. `nullptr` - new connection from the executor.
+   * @return - &id:oatpp::orm::QueryResult;.
+   */
+  std::shared_ptr<orm::QueryResult> query(const std::shared_ptr<orm::Executor>& executor,
+                                          const BoundingBox& box,
+                                          v_int64 limit = -1,
+                                          const provider::ResourceHandle<orm::Connection>& connection = nullptr) const;
+
+  /**
+   * Find rows which intersect the bounding box.
+   * @tparam T - DTO class. Fields are mapped by the executor's result mapper.
+   * @param executor - &id:oatpp::orm::Executor;.
+   * @param box - &l:SpatialIndex::BoundingBox;.
+   * @param limit - max number of rows. `-1` - no limit.
+   * @param connection - connection to use. `nullptr` - new connection from the executor.
+   * @return - rows.
+   */
+  template<class T>
+  oatpp::Vector<oatpp::Object<T>> find(const std::shared_ptr<orm::Executor>& executor,
+                                       const BoundingBox& box,
+                                       v_int64 limit = -1,
+                                       const provider::ResourceHandle<orm::Connection>& connection = nullptr) const
+  {
+    auto result = query(executor, box, limit, connection);
+    if(!result->isSuccess()) {
+      throw std::runtime_error("[oatpp::sqlite::SpatialIndex::find()]: Error. " + *result->getErrorMessage());
+    }
+    return result->fetch<oatpp::Vector<oatpp::Object<T>>>();
+  }
+
+};
+
+}}
+
+#endif // oatpp_sqlite_SpatialIndex_hpp
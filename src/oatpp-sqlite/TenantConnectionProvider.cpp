@@ -0,0 +1,334 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#include "TenantConnectionProvider.hpp"
+
+#include "Executor.hpp"
+
+#include "oatpp/base/Log.hpp"
+#include "oatpp/Environment.hpp"
+
+#include <algorithm>
+
+namespace oatpp { namespace sqlite {
+
+namespace {
+  thread_local oatpp::String currentTenant;
+}
+
+TenantConnectionProvider::Scope::Scope(const oatpp::String& tenant)
+  : m_previous(currentTenant)
+{
+  currentTenant = tenant;
+}
+
+TenantConnectionProvider::Scope::~Scope() {
+  currentTenant = m_previous;
+}
+
+TenantConnectionProvider::TenantConnectionProvider(const PathResolver& pathResolver, const Config& config)
+  : m_pathResolver(pathResolver)
+  , m_config(config)
+{
+  m_stats.openTenants = 0;
+  m_stats.opensCount = 0;
+  m_stats.evictionsCount = 0;
+  m_stats.idleClosesCount = 0;
+  m_stats.migrationsCount = 0;
+}
+
+TenantConnectionProvider::TenantConnectionProvider(const PathResolver& pathResolver)
+  : TenantConnectionProvider(pathResolver, Config())
+{}
+
+oatpp::String TenantConnectionProvider::getCurrentTenant() {
+  return currentTenant;
+}
+
+oatpp::String TenantConnectionProvider::getDatabaseScope() {
+  return currentTenant ? oatpp::String("tenant:" + *currentTenant) : oatpp::String("");
+}
+
+void TenantConnectionProvider::addMigration(v_int64 version, const oatpp::String& script) {
+  {
+    std::lock_guard<std::mutex> lock(m_migrationsMutex);
+    m_migrations.push_back({version, script});
+    std::sort(m_migrations.begin(), m_migrations.end(), [](const Migration& a, const Migration& b) {
+      return a.version < b.version;
+    });
+  }
+  /* cached versions are outdated now */
+  std::lock_guard<std::mutex> lock(m_schemaVersionsMutex);
+  m_schemaVersions.clear();
+}
+
+void TenantConnectionProvider::addMigrationFile(v_int64 version, const oatpp::String& filename) {
+  auto script = oatpp::String::loadFromFile(filename->c_str());
+  if(!script) {
+    throw std::runtime_error("[oatpp::sqlite::TenantConnectionProvider::addMigrationFile()]: "
+                             "Error. Can't load file '" + *filename + "'.");
+  }
+  addMigration(version, script);
+}
+
+void TenantConnectionProvider::migrate(const std::shared_ptr<Tenant>& tenant) {
+
+  std::vector<Migration> migrations;
+  {
+    std::lock_guard<std::mutex> lock(m_migrationsMutex);
+    migrations = m_migrations;
+  }
+
+  if(migrations.empty()) {
+    return;
+  }
+
+  v_int64 cachedVersion = -1;
+  {
+    std::lock_guard<std::mutex> lock(m_schemaVersionsMutex);
+    auto it = m_schemaVersions.find(tenant->key);
+    if(it != m_schemaVersions.end()) {
+      cachedVersion = it->second;
+    }
+  }
+
+  v_int64 lastVersion = migrations.back().version;
+  if(cachedVersion >= lastVersion) {
+    return;
+  }
+
+  auto executor = std::make_shared<Executor>(tenant->pool);
+  auto connection = executor->getConnection();
+
+  for(auto& migration : migrations) {
+    if(migration.version > cachedVersion) {
+      executor->migrateSchema(migration.script, migration.version, m_config.migrationSuffix, connection);
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_schemaVersionsMutex);
+    m_schemaVersions[tenant->key] = lastVersion;
+  }
+
+  {
+    std::lock_guard<std::mutex> statsLock(m_mutex);
+    m_stats.migrationsCount ++;
+  }
+
+}
+
+std::shared_ptr<ConnectionPool> TenantConnectionProvider::openTenant(const std::shared_ptr<Tenant>& tenant) {
+
+  /* per-tenant lock - concurrent requests of the tenant wait for a single open and migration, other tenants don't */
+  std::lock_guard<std::mutex> lock(tenant->openMutex);
+
+  if(tenant->closed) {
+    throw std::runtime_error("[oatpp::sqlite::TenantConnectionProvider::openTenant()]: "
+                             "Error. Tenant '" + *tenant->key + "' was closed while opening.");
+  }
+
+  if(tenant->pool) {
+    return tenant->pool;
+  }
+
+  auto path = m_pathResolver(tenant->key);
+  if(!path) {
+    throw std::runtime_error("[oatpp::sqlite::TenantConnectionProvider::openTenant()]: "
+                             "Error. Can't resolve path of tenant '" + *tenant->key + "'.");
+  }
+
+  tenant->provider = std::make_shared<ConnectionProvider>(path, m_config.openFlags);
+  if(m_config.providerConfigurator) {
+    m_config.providerConfigurator(tenant->provider);
+  }
+  tenant->pool = ConnectionPool::createShared(tenant->provider, m_config.maxConnectionsPerTenant, m_config.maxConnectionTTL);
+
+  try {
+    migrate(tenant);
+  } catch (...) {
+    tenant->pool->stop();
+    tenant->pool.reset();
+    tenant->provider.reset();
+    throw;
+  }
+
+  {
+    std::lock_guard<std::mutex> statsLock(m_mutex);
+    m_stats.opensCount ++;
+  }
+
+  return tenant->pool;
+
+}
+
+void TenantConnectionProvider::stopTenant(const std::shared_ptr<Tenant>& tenant) {
+  /* waits for the tenant being opened */
+  std::lock_guard<std::mutex> lock(tenant->openMutex);
+  tenant->closed = true;
+  if(tenant->pool) {
+    /* stopped pool closes idle connections. Connections in use are closed when released */
+    tenant->pool->stop();
+  }
+}
+
+std::vector<std::shared_ptr<TenantConnectionProvider::Tenant>> TenantConnectionProvider::collectTenantsToClose(v_int64 now) {
+
+  std::vector<std::shared_ptr<Tenant>> result;
+
+  while(static_cast<v_int64>(m_lru.size()) > m_config.maxTenants) {
+    auto tenant = m_lru.back();
+    m_tenants.erase(tenant->key);
+    m_lru.pop_back();
+    m_stats.evictionsCount ++;
+    result.push_back(tenant);
+  }
+
+  if(m_config.tenantIdleTime.count() > 0) {
+    while(!m_lru.empty() && now - m_lru.back()->lastAccess > m_config.tenantIdleTime.count()) {
+      auto tenant = m_lru.back();
+      m_tenants.erase(tenant->key);
+      m_lru.pop_back();
+      m_stats.idleClosesCount ++;
+      result.push_back(tenant);
+    }
+  }
+
+  m_stats.openTenants = static_cast<v_int64>(m_lru.size());
+
+  return result;
+
+}
+
+provider::ResourceHandle<Connection> TenantConnectionProvider::get(const oatpp::String& tenant) {
+
+  if(!tenant) {
+    throw std::runtime_error("[oatpp::sqlite::TenantConnectionProvider::get()]: Error. Tenant is null.");
+  }
+
+  std::shared_ptr<Tenant> entry;
+  std::vector<std::shared_ptr<Tenant>> toClose;
+  v_int64 now = oatpp::Environment::getMicroTickCount();
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_tenants.find(tenant);
+    if(it != m_tenants.end()) {
+      entry = *it->second;
+      m_lru.splice(m_lru.begin(), m_lru, it->second);
+    } else {
+      entry = std::make_shared<Tenant>();
+      entry->key = tenant;
+      m_lru.push_front(entry);
+      m_tenants[tenant] = m_lru.begin();
+    }
+    entry->lastAccess = now;
+    toClose = collectTenantsToClose(now);
+  }
+
+  for(auto& t : toClose) {
+    stopTenant(t);
+  }
+
+  /* open outside of the lock - opening and migration of one tenant should not block others */
+  std::shared_ptr<ConnectionPool> pool;
+  try {
+    pool = openTenant(entry);
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_tenants.find(tenant);
+    if(it != m_tenants.end() && *it->second == entry) {
+      m_lru.erase(it->second);
+      m_tenants.erase(it);
+      m_stats.openTenants = static_cast<v_int64>(m_lru.size());
+    }
+    throw;
+  }
+
+  return pool->get();
+
+}
+
+provider::ResourceHandle<Connection> TenantConnectionProvider::get() {
+  auto tenant = getCurrentTenant();
+  if(!tenant) {
+    throw std::runtime_error("[oatpp::sqlite::TenantConnectionProvider::get()]: "
+                             "Error. No current tenant. Use TenantConnectionProvider::Scope.");
+  }
+  return get(tenant);
+}
+
+async::CoroutineStarterForResult<const provider::ResourceHandle<Connection>&> TenantConnectionProvider::getAsync() {
+  throw std::runtime_error("[oatpp::sqlite::TenantConnectionProvider::getAsync()]: Error. Not implemented!");
+}
+
+v_int64 TenantConnectionProvider::closeIdleTenants() {
+  std::vector<std::shared_ptr<Tenant>> toClose;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    toClose = collectTenantsToClose(oatpp::Environment::getMicroTickCount());
+  }
+  for(auto& tenant : toClose) {
+    stopTenant(tenant);
+  }
+  return static_cast<v_int64>(toClose.size());
+}
+
+bool TenantConnectionProvider::closeTenant(const oatpp::String& tenant) {
+  std::shared_ptr<Tenant> entry;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_tenants.find(tenant);
+    if(it == m_tenants.end()) {
+      return false;
+    }
+    entry = *it->second;
+    m_lru.erase(it->second);
+    m_tenants.erase(it);
+    m_stats.openTenants = static_cast<v_int64>(m_lru.size());
+  }
+  stopTenant(entry);
+  return true;
+}
+
+TenantConnectionProvider::Stats TenantConnectionProvider::getStats() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stats;
+}
+
+void TenantConnectionProvider::stop() {
+  std::list<std::shared_ptr<Tenant>> tenants;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    tenants.swap(m_lru);
+    m_tenants.clear();
+    m_stats.openTenants = 0;
+  }
+  for(auto& tenant : tenants) {
+    stopTenant(tenant);
+  }
+}
+
+}}
@@ -0,0 +1,303 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#ifndef oatpp_sqlite_TenantConnectionProvider_hpp
+#define oatpp_sqlite_TenantConnectionProvider_hpp
+
+#include "ConnectionProvider.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+namespace oatpp { namespace sqlite {
+
+/**
+ * Connection provider for the database-per-tenant layout. <br>
+ * Routes connections to the database file of a tenant and keeps a bounded LRU of open tenants -
+ * each open tenant has its own &id:oatpp::sqlite::ConnectionPool;. Least recently used and idle tenants are closed. <br>
+ * Tenant is selected either with &l:TenantConnectionProvider::Scope; (thread-local) for connections requested by
+ * &id:oatpp::sqlite::Executor;, or explicitly with &l:TenantConnectionProvider::get (const oatpp::String& tenant);. <br>
+ * Migrations added with &l:TenantConnectionProvider::addMigration (); run lazily when a tenant is opened the first time.
+ * Migrated schema version is cached, so reopening of an evicted tenant doesn't touch the schema version table. <br>
+ * &id:oatpp::sqlite::ResultCache; and request coalescing of &id:oatpp::sqlite::Executor; key results by the current tenant.
+ * Cache invalidation is by table name only - a write to a table of one tenant drops cached results of this table for all tenants.
+ * ```cpp
+ * auto provider = std::make_shared<oatpp::sqlite::TenantConnectionProvider>([](const oatpp::String& tenant) {
+ *   return oatpp::String("/var/data/tenants/" + *tenant + ".sqlite");
+ * });
+ * provider->addMigrationFile(1, "migration/001_init.sql");
+ * auto executor = std::make_shared<oatpp::sqlite::Executor>(provider);
+ * ...
+ * {
+ *   oatpp::sqlite::TenantConnectionProvider::Scope scope(tenantId);
+ *   auto users = client.getUsers(); // runs on the tenant database
+ * }
+ * ```
+ */
+class TenantConnectionProvider : public provider::Provider<Connection>, public DatabaseScopeProvider {
+public:
+
+  /**
+   * Resolves database file path (or URI) of a tenant. <br>
+   * *Note:* tenant keys usually come from requests - validate them before building a path.
+   */
+  typedef std::function<oatpp::String(const oatpp::String&)> PathResolver;
+
+  /**
+   * Configures provider of a tenant before its connections are opened and migrations are run. <br>
+   * Ex.: add init hooks, functions, change listeners or busy handler here.
+   */
+  typedef std::function<void(const std::shared_ptr<ConnectionProvider>&)> ProviderConfigurator;
+
+  /**
+   * Provider config.
+   */
+  struct Config {
+
+    /**
+     * Max number of simultaneously open tenants. Least recently used tenant is closed when the limit is reached.
+     */
+    v_int64 maxTenants = 256;
+
+    /**
+     * Max number of connections in the pool of each tenant.
+     */
+    v_int64 maxConnectionsPerTenant = 4;
+
+    /**
+     * Max time an idle connection stays in the pool of a tenant.
+     */
+    std::chrono::duration<v_int64, std::micro> maxConnectionTTL = std::chrono::seconds(5);
+
+    /**
+     * Tenant not accessed for this time is closed. `0` - close only when &l:TenantConnectionProvider::Config::maxTenants; is reached.
+     */
+    std::chrono::duration<v_int64, std::micro> tenantIdleTime = std::chrono::minutes(5);
+
+    /**
+     * Flags for `sqlite3_open_v2`.
+     */
+    int openFlags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+
+    /**
+     * Suffix of the schema version table used by migrations.
+     */
+    oatpp::String migrationSuffix = "tenant";
+
+    /**
+     * &l:TenantConnectionProvider::ProviderConfigurator;. Applied to the provider of each opened tenant. `nullptr` - none.
+     */
+    ProviderConfigurator providerConfigurator;
+
+  };
+
+  /**
+   * Tenant statistics.
+   */
+  struct Stats {
+
+    /**
+     * Number of currently open tenants.
+     */
+    v_int64 openTenants;
+
+    /**
+     * Number of tenant opens.
+     */
+    v_int64 opensCount;
+
+    /**
+     * Number of tenants closed because of the LRU limit.
+     */
+    v_int64 evictionsCount;
+
+    /**
+     * Number of tenants closed because they were idle.
+     */
+    v_int64 idleClosesCount;
+
+    /**
+     * Number of tenant schema migrations run.
+     */
+    v_int64 migrationsCount;
+
+  };
+
+  /**
+   * Thread-local tenant scope. Connections requested via &l:TenantConnectionProvider::get (); within the scope
+   * are connections to the tenant database. Scopes can be nested.
+   */
+  class Scope {
+  private:
+    oatpp::String m_previous;
+  public:
+
+    /**
+     * Constructor. Sets current tenant of the calling thread.
+     * @param tenant - tenant key.
+     */
+    Scope(const oatpp::String& tenant);
+
+    /**
+     * Non-virtual destructor. Restores previous tenant.
+     */
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator = (const Scope&) = delete;
+
+  };
+
+private:
+
+  struct Tenant {
+    oatpp::String key;
+    /* guards provider, pool and closed. Held while the tenant is opened and migrated */
+    std::mutex openMutex;
+    std::shared_ptr<ConnectionProvider> provider;
+    std::shared_ptr<ConnectionPool> pool;
+    bool closed = false;
+    v_int64 lastAccess;
+  };
+
+  struct Migration {
+    v_int64 version;
+    oatpp::String script;
+  };
+
+private:
+  /* returns pool of the tenant. Opens and migrates the tenant if needed */
+  std::shared_ptr<ConnectionPool> openTenant(const std::shared_ptr<Tenant>& tenant);
+  /* must be called under Tenant::openMutex */
+  void migrate(const std::shared_ptr<Tenant>& tenant);
+  static void stopTenant(const std::shared_ptr<Tenant>& tenant);
+  /* must be called under m_mutex. Returns tenants to close */
+  std::vector<std::shared_ptr<Tenant>> collectTenantsToClose(v_int64 now);
+private:
+  PathResolver m_pathResolver;
+  Config m_config;
+private:
+  std::mutex m_mutex;
+  /* front - most recently used */
+  std::list<std::shared_ptr<Tenant>> m_lru;
+  std::unordered_map<oatpp::String, std::list<std::shared_ptr<Tenant>>::iterator> m_tenants;
+  Stats m_stats;
+private:
+  std::mutex m_migrationsMutex;
+  std::vector<Migration> m_migrations;
+private:
+  std::mutex m_schemaVersionsMutex;
+  std::unordered_map<oatpp::String, v_int64> m_schemaVersions;
+public:
+
+  /**
+   * Constructor.
+   * @param pathResolver - &l:TenantConnectionProvider::PathResolver;.
+   * @param config - &l:TenantConnectionProvider::Config;.
+   */
+  TenantConnectionProvider(const PathResolver& pathResolver, const Config& config);
+
+  /**
+   * Constructor with default config.
+   * @param pathResolver - &l:TenantConnectionProvider::PathResolver;.
+   */
+  TenantConnectionProvider(const PathResolver& pathResolver);
+
+  /**
+   * Get tenant of the calling thread set by &l:TenantConnectionProvider::Scope;.
+   * @return - tenant key or `nullptr`.
+   */
+  static oatpp::String getCurrentTenant();
+
+  /**
+   * Get database scope - the current tenant. See &id:oatpp::sqlite::DatabaseScopeProvider;.
+   * @return
+   */
+  oatpp::String getDatabaseScope() override;
+
+  /**
+   * Add migration script run on tenant databases. Migrations must be added before the first connection is requested.
+   * @param version - schema version. Versions are applied in the `+1` order.
+   * @param script - SQL script.
+   */
+  void addMigration(v_int64 version, const oatpp::String& script);
+
+  /**
+   * Add migration script file.
+   * @param version - schema version.
+   * @param filename - path to SQL script.
+   */
+  void addMigrationFile(v_int64 version, const oatpp::String& filename);
+
+  /**
+   * Get connection to the database of the given tenant. Opens (and migrates) tenant if needed.
+   * @param tenant - tenant key.
+   * @return - resource.
+   */
+  provider::ResourceHandle<Connection> get(const oatpp::String& tenant);
+
+  /**
+   * Get connection to the database of the current tenant - see &l:TenantConnectionProvider::Scope;.
+   * @return - resource.
+   * @throws - `std::runtime_error` if there is no current tenant.
+   */
+  provider::ResourceHandle<Connection> get() override;
+
+  /**
+   * Get Connection in Async manner.
+   * @return - &id:oatpp::async::CoroutineStarterForResult; of `Connection`.
+   */
+  async::CoroutineStarterForResult<const provider::ResourceHandle<Connection>&> getAsync() override;
+
+  /**
+   * Close tenants which were not accessed for &l:TenantConnectionProvider::Config::tenantIdleTime;. <br>
+   * Also called from &l:TenantConnectionProvider::get (); Call it periodically to close tenants when there is no traffic.
+   * @return - number of closed tenants.
+   */
+  v_int64 closeIdleTenants();
+
+  /**
+   * Close tenant. Connections in use stay valid until released.
+   * @param tenant - tenant key.
+   * @return - `true` if tenant was open.
+   */
+  bool closeTenant(const oatpp::String& tenant);
+
+  /**
+   * Get tenant statistics.
+   * @return - &l:TenantConnectionProvider::Stats;.
+   */
+  Stats getStats();
+
+  /**
+   * Close all tenants.
+   */
+  void stop() override;
+
+};
+
+}}
+
+#endif // oatpp_sqlite_TenantConnectionProvider_hpp
@@ -26,6 +26,7 @@
 #define oatpp_sqlite_Types_hpp
 
 #include "mapping/type/Blob.hpp"
+#include "mapping/type/Embedding.hpp"
 
 namespace oatpp { namespace sqlite {
 
@@ -34,6 +35,11 @@ namespace oatpp { namespace sqlite {
  */
 typedef mapping::type::Blob Blob;
 
+/**
+ * Convenience typedef for &id:oatpp::sqlite::mapping::type::Embedding;.
+ */
+typedef mapping::type::Embedding Embedding;
+
 }}
 
 #endif // oatpp_sqlite_Types_hpp
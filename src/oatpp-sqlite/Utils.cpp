@@ -31,4 +31,41 @@ v_int64 Utils::getLastInsertRowId(const provider::ResourceHandle<orm::Connection
   return sqlite3_last_insert_rowid(c->getHandle());
 }
 
+oatpp::String Utils::quoteIdentifier(const oatpp::String& name) {
+  std::string result = "\"";
+  for(auto c : *name) {
+    if(c == '"') {
+      result += '"';
+    }
+    result += c;
+  }
+  result += "\"";
+  return result;
+}
+
+oatpp::String Utils::getRowId(const oatpp::String& column, const char* prefix) {
+  if(column == "rowid") {
+    return std::string(prefix) + "rowid";
+  }
+  return prefix + *quoteIdentifier(column);
+}
+
+void Utils::warmUpConnection(sqlite3* handle, const std::vector<oatpp::String>& queries) {
+
+  /* loads and validates database schema */
+  char* errMsg = nullptr;
+  auto res = sqlite3_exec(handle, "SELECT count(*) FROM sqlite_master", nullptr, nullptr, &errMsg);
+
+  for(auto it = queries.begin(); it != queries.end() && res == SQLITE_OK; it ++) {
+    res = sqlite3_exec(handle, (*it)->c_str(), nullptr, nullptr, &errMsg);
+  }
+
+  if(res != SQLITE_OK) {
+    std::string message = errMsg ? errMsg : sqlite3_errstr(res);
+    sqlite3_free(errMsg);
+    throw std::runtime_error("[oatpp::sqlite::Utils::warmUpConnection()]: Error. Warm-up query failed. " + message);
+  }
+
+}
+
 }}
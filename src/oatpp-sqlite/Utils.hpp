@@ -42,6 +42,30 @@ public:
    */
   static v_int64 getLastInsertRowId(const provider::ResourceHandle<orm::Connection>& connection);
 
+  /**
+   * Quote SQL identifier - ex.: table or column name. Double quotes in the name are escaped.
+   * @param name - identifier.
+   * @return - quoted identifier.
+   */
+  static oatpp::String quoteIdentifier(const oatpp::String& name);
+
+  /**
+   * Get reference to the rowid column of a table for generated SQL. <br>
+   * `rowid` is not quoted - quoted `"rowid"` would refer to a real column with such name.
+   * @param column - name of the rowid column. Ex.: `rowid` or name of the `INTEGER PRIMARY KEY` column.
+   * @param prefix - table alias with a dot. Ex.: `"new."`. Empty string - no alias.
+   * @return - column reference.
+   */
+  static oatpp::String getRowId(const oatpp::String& column, const char* prefix);
+
+  /**
+   * Warm up connection - load the database schema and run warm-up queries.
+   * @param handle - sqlite3 handle of the connection.
+   * @param queries - queries or `PRAGMA`s to run. Ex.: `PRAGMA mmap_size=268435456`.
+   * @throws - `std::runtime_error` if the schema can't be loaded or a query fails.
+   */
+  static void warmUpConnection(sqlite3* handle, const std::vector<oatpp::String>& queries);
+
 };
 
 }}
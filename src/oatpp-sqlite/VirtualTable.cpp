@@ -0,0 +1,580 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#include "VirtualTable.hpp"
+
+#include "Types.hpp"
+#include "Utils.hpp"
+
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <unordered_set>
+
+namespace oatpp { namespace sqlite {
+
+namespace {
+
+  thread_local std::unordered_map<const VirtualTable*, std::shared_ptr<const VirtualTable::Data>> scopedData;
+
+  /* names are case-insensitive in SQL - stored in lower case */
+  std::mutex installedNamesMutex;
+  std::unordered_set<std::string> installedNames;
+
+  std::string toLower(const char* name) {
+    std::string result(name);
+    for(auto& c : result) {
+      c = (char) std::tolower((unsigned char) c);
+    }
+    return result;
+  }
+
+  std::string getFloatKey(v_float64 value) {
+    /* 1.0 = 1 in SQL - integral floats share key with integers */
+    if(value == std::floor(value) && std::fabs(value) < 9.2e18) {
+      return "i" + std::to_string((v_int64) value);
+    }
+    char buff[32];
+    std::snprintf(buff, sizeof(buff), "f%.17g", value);
+    return buff;
+  }
+
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// VirtualTable::Data
+
+bool VirtualTable::Data::getKey(const oatpp::Void& value, std::string& key) {
+
+  if(!value) {
+    return false;
+  }
+
+  auto id = value.getValueType()->classId.id;
+
+  if(id == data::type::__class::Int8::CLASS_ID.id) {
+    key = "i" + std::to_string((v_int64) *value.cast<oatpp::Int8>());
+  } else if(id == data::type::__class::UInt8::CLASS_ID.id) {
+    key = "i" + std::to_string((v_int64) *value.cast<oatpp::UInt8>());
+  } else if(id == data::type::__class::Int16::CLASS_ID.id) {
+    key = "i" + std::to_string((v_int64) *value.cast<oatpp::Int16>());
+  } else if(id == data::type::__class::UInt16::CLASS_ID.id) {
+    key = "i" + std::to_string((v_int64) *value.cast<oatpp::UInt16>());
+  } else if(id == data::type::__class::Int32::CLASS_ID.id) {
+    key = "i" + std::to_string((v_int64) *value.cast<oatpp::Int32>());
+  } else if(id == data::type::__class::UInt32::CLASS_ID.id) {
+    key = "i" + std::to_string((v_int64) *value.cast<oatpp::UInt32>());
+  } else if(id == data::type::__class::Int64::CLASS_ID.id) {
+    key = "i" + std::to_string((v_int64) *value.cast<oatpp::Int64>());
+  } else if(id == data::type::__class::UInt64::CLASS_ID.id) {
+    key = "i" + std::to_string((v_int64) *value.cast<oatpp::UInt64>());
+  } else if(id == data::type::__class::Boolean::CLASS_ID.id) {
+    key = *value.cast<oatpp::Boolean>() ? "i1" : "i0";
+  } else if(id == data::type::__class::Float32::CLASS_ID.id) {
+    key = getFloatKey(*value.cast<oatpp::Float32>());
+  } else if(id == data::type::__class::Float64::CLASS_ID.id) {
+    key = getFloatKey(*value.cast<oatpp::Float64>());
+  } else if(id == data::type::__class::String::CLASS_ID.id) {
+    key = "t" + *static_cast<std::string*>(value.get());
+  } else if(id == mapping::type::__class::Blob::CLASS_ID.id) {
+    key = "b" + *static_cast<std::string*>(value.get());
+  } else {
+    return false;
+  }
+
+  return true;
+
+}
+
+bool VirtualTable::Data::getKey(sqlite3_value* value, std::string& key) {
+
+  switch(sqlite3_value_type(value)) {
+
+    case SQLITE_INTEGER:
+      key = "i" + std::to_string((v_int64) sqlite3_value_int64(value));
+      return true;
+
+    case SQLITE_FLOAT:
+      key = getFloatKey(sqlite3_value_double(value));
+      return true;
+
+    case SQLITE_TEXT: {
+      auto text = (const char*) sqlite3_value_text(value);
+      key = "t";
+      key.append(text, sqlite3_value_bytes(value));
+      return true;
+    }
+
+    case SQLITE_BLOB: {
+      auto blob = (const char*) sqlite3_value_blob(value);
+      key = "b";
+      if(blob) {
+        key.append(blob, sqlite3_value_bytes(value));
+      }
+      return true;
+    }
+
+    default:
+      return false;
+
+  }
+
+}
+
+bool VirtualTable::Data::getKey(sqlite3_value* value, const Type* columnType, std::string& key) {
+
+  auto type = sqlite3_value_type(value);
+  auto declaredType = getDeclaredType(columnType);
+
+  bool textAffinity = std::strcmp(declaredType, "TEXT") == 0;
+  bool numericAffinity = std::strcmp(declaredType, "INTEGER") == 0 || std::strcmp(declaredType, "REAL") == 0;
+
+  if(textAffinity && (type == SQLITE_INTEGER || type == SQLITE_FLOAT)) {
+    /* convert a copy - argv values of xFilter must not be changed */
+    auto copy = sqlite3_value_dup(value);
+    if(copy == nullptr) {
+      return false;
+    }
+    auto text = (const char*) sqlite3_value_text(copy);
+    key = "t";
+    if(text) {
+      key.append(text, sqlite3_value_bytes(copy));
+    }
+    sqlite3_value_free(copy);
+    return true;
+  }
+
+  if(numericAffinity && type == SQLITE_TEXT) {
+    auto copy = sqlite3_value_dup(value);
+    if(copy == nullptr) {
+      return false;
+    }
+    /* text which doesn't look like a number stays text */
+    sqlite3_value_numeric_type(copy);
+    auto result = getKey(copy, key);
+    sqlite3_value_free(copy);
+    return result;
+  }
+
+  return getKey(value, key);
+
+}
+
+const std::vector<v_int64>* VirtualTable::Data::findRows(v_int32 col, const std::string& key) const {
+
+  std::lock_guard<std::mutex> lock(m_indexMutex);
+
+  auto it = m_indices.find(col);
+  if(it == m_indices.end()) {
+    auto& index = m_indices[col];
+    std::string rowKey;
+    auto rowsCount = getRowsCount();
+    for(v_int64 row = 0; row < rowsCount; row ++) {
+      if(getKey(getValue(row, col), rowKey)) {
+        index[rowKey].push_back(row);
+      }
+    }
+    it = m_indices.find(col);
+  }
+
+  /* the index is never modified once built - pointer stays valid while Data exists */
+  auto rows = it->second.find(key);
+  if(rows == it->second.end()) {
+    return nullptr;
+  }
+  return &rows->second;
+
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// VirtualTable::ObjectData
+
+VirtualTable::ObjectData::ObjectData(const Type* objectType) {
+  auto dispatcher = static_cast<const data::type::__class::AbstractObject::PolymorphicDispatcher*>(objectType->polymorphicDispatcher);
+  for(auto& property : dispatcher->getProperties()->getList()) {
+    m_properties.push_back(property);
+  }
+}
+
+v_int32 VirtualTable::ObjectData::getColumnsCount() const {
+  return (v_int32) m_properties.size();
+}
+
+v_int64 VirtualTable::ObjectData::getRowsCount() const {
+  return (v_int64) m_rows.size();
+}
+
+oatpp::Void VirtualTable::ObjectData::getValue(v_int64 row, v_int32 col) const {
+  return m_properties[col]->get(static_cast<oatpp::BaseObject*>(m_rows[row].get()));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// VirtualTable::ColumnarData
+
+VirtualTable::ColumnarData::ColumnarData()
+  : m_rowsCount(0)
+{}
+
+v_int32 VirtualTable::ColumnarData::getColumnsCount() const {
+  return (v_int32) m_columns.size();
+}
+
+v_int64 VirtualTable::ColumnarData::getRowsCount() const {
+  return m_rowsCount;
+}
+
+oatpp::Void VirtualTable::ColumnarData::getValue(v_int64 row, v_int32 col) const {
+  return m_columns[col](row);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// VirtualTable::Scope
+
+VirtualTable::Scope::Scope(const std::shared_ptr<VirtualTable>& table, const std::shared_ptr<const Data>& data)
+  : m_table(table)
+{
+  table->checkData(data);
+  auto it = scopedData.find(table.get());
+  if(it != scopedData.end()) {
+    m_previous = it->second;
+  }
+  scopedData[table.get()] = data;
+}
+
+VirtualTable::Scope::~Scope() {
+  if(m_previous) {
+    scopedData[m_table.get()] = m_previous;
+  } else {
+    scopedData.erase(m_table.get());
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// VirtualTable
+
+struct VirtualTable::Table : public sqlite3_vtab {
+  VirtualTable* table;
+};
+
+struct VirtualTable::Cursor : public sqlite3_vtab_cursor {
+  std::shared_ptr<const Data> data;
+  const std::vector<v_int64>* rows;
+  v_int64 position;
+  v_int64 size;
+};
+
+VirtualTable::VirtualTable(const oatpp::String& name, const std::vector<Column>& columns)
+  : m_name(name)
+  , m_columns(columns)
+{}
+
+std::shared_ptr<VirtualTable> VirtualTable::createShared(const oatpp::String& name, const std::vector<Column>& columns) {
+  return std::make_shared<VirtualTable>(name, columns);
+}
+
+std::vector<VirtualTable::Column> VirtualTable::getObjectColumns(const Type* objectType, const std::vector<oatpp::String>& keyColumns) {
+
+  std::vector<Column> result;
+
+  auto dispatcher = static_cast<const data::type::__class::AbstractObject::PolymorphicDispatcher*>(objectType->polymorphicDispatcher);
+  for(auto& property : dispatcher->getProperties()->getList()) {
+    Column column;
+    column.name = property->name;
+    column.type = property->type;
+    column.isKey = false;
+    for(auto& key : keyColumns) {
+      if(key == column.name) {
+        column.isKey = true;
+        break;
+      }
+    }
+    result.push_back(column);
+  }
+
+  return result;
+
+}
+
+const char* VirtualTable::getDeclaredType(const Type* type) {
+
+  auto id = type->classId.id;
+
+  if(id == data::type::__class::String::CLASS_ID.id) {
+    return "TEXT";
+  }
+  if(id == data::type::__class::Float32::CLASS_ID.id || id == data::type::__class::Float64::CLASS_ID.id) {
+    return "REAL";
+  }
+  if(id == mapping::type::__class::Blob::CLASS_ID.id || id == mapping::type::__class::Embedding::CLASS_ID.id) {
+    return "BLOB";
+  }
+  if(id == data::type::__class::Int8::CLASS_ID.id || id == data::type::__class::UInt8::CLASS_ID.id ||
+     id == data::type::__class::Int16::CLASS_ID.id || id == data::type::__class::UInt16::CLASS_ID.id ||
+     id == data::type::__class::Int32::CLASS_ID.id || id == data::type::__class::UInt32::CLASS_ID.id ||
+     id == data::type::__class::Int64::CLASS_ID.id || id == data::type::__class::UInt64::CLASS_ID.id ||
+     id == data::type::__class::Boolean::CLASS_ID.id)
+  {
+    return "INTEGER";
+  }
+
+  return "";
+
+}
+
+const sqlite3_module* VirtualTable::getModule() {
+
+  static sqlite3_module module = [] {
+    sqlite3_module m = {};
+    m.iVersion = 1;
+    /* no xCreate - eponymous-only table */
+    m.xCreate = nullptr;
+    m.xConnect = &onConnect;
+    m.xBestIndex = &onBestIndex;
+    m.xDisconnect = &onDisconnect;
+    m.xDestroy = &onDisconnect;
+    m.xOpen = &onOpen;
+    m.xClose = &onClose;
+    m.xFilter = &onFilter;
+    m.xNext = &onNext;
+    m.xEof = &onEof;
+    m.xColumn = &onColumn;
+    m.xRowid = &onRowid;
+    return m;
+  }();
+
+  return &module;
+
+}
+
+void VirtualTable::onDestroy(void* data) {
+  delete static_cast<std::shared_ptr<VirtualTable>*>(data);
+}
+
+int VirtualTable::onConnect(sqlite3* db, void* aux, int argc, const char* const* argv, sqlite3_vtab** vtab, char** errMsg) {
+
+  (void) argc;
+  (void) argv;
+
+  auto table = static_cast<std::shared_ptr<VirtualTable>*>(aux)->get();
+
+  std::string schema = "CREATE TABLE x(";
+  for(v_uint32 i = 0; i < table->m_columns.size(); i ++) {
+    if(i > 0) {
+      schema += ", ";
+    }
+    auto& column = table->m_columns[i];
+    schema += *Utils::quoteIdentifier(column.name);
+    schema += " ";
+    schema += getDeclaredType(column.type);
+  }
+  schema += ")";
+
+  auto res = sqlite3_declare_vtab(db, schema.c_str());
+  if(res != SQLITE_OK) {
+    *errMsg = sqlite3_mprintf("%s", sqlite3_errmsg(db));
+    return res;
+  }
+
+  auto result = new Table();
+  result->pModule = nullptr;
+  result->nRef = 0;
+  result->zErrMsg = nullptr;
+  result->table = table;
+  *vtab = result;
+
+  return SQLITE_OK;
+
+}
+
+int VirtualTable::onBestIndex(sqlite3_vtab* vtab, sqlite3_index_info* info) {
+
+  auto table = static_cast<Table*>(vtab)->table;
+
+  for(int i = 0; i < info->nConstraint; i ++) {
+    auto& constraint = info->aConstraint[i];
+    /* index keys compare bytes - constraints with other collations are checked by SQLite */
+    auto collation = sqlite3_vtab_collation(info, i);
+    bool binary = collation == nullptr || sqlite3_stricmp(collation, "BINARY") == 0;
+    if(constraint.usable && constraint.op == SQLITE_INDEX_CONSTRAINT_EQ && binary &&
+       constraint.iColumn >= 0 && table->m_columns[constraint.iColumn].isKey)
+    {
+      info->idxNum = constraint.iColumn + 1;
+      info->aConstraintUsage[i].argvIndex = 1;
+      info->aConstraintUsage[i].omit = 1;
+      info->estimatedCost = 10;
+      info->estimatedRows = 10;
+      return SQLITE_OK;
+    }
+  }
+
+  auto data = table->getCurrentData();
+  v_int64 rowsCount = data ? data->getRowsCount() : 0;
+
+  info->idxNum = 0;
+  info->estimatedCost = 100 + (double) rowsCount;
+  info->estimatedRows = rowsCount;
+
+  return SQLITE_OK;
+
+}
+
+int VirtualTable::onDisconnect(sqlite3_vtab* vtab) {
+  delete static_cast<Table*>(vtab);
+  return SQLITE_OK;
+}
+
+int VirtualTable::onOpen(sqlite3_vtab* vtab, sqlite3_vtab_cursor** cursor) {
+  auto result = new Cursor();
+  result->pVtab = vtab;
+  result->rows = nullptr;
+  result->position = 0;
+  result->size = 0;
+  *cursor = result;
+  return SQLITE_OK;
+}
+
+int VirtualTable::onClose(sqlite3_vtab_cursor* cursor) {
+  delete static_cast<Cursor*>(cursor);
+  return SQLITE_OK;
+}
+
+int VirtualTable::onFilter(sqlite3_vtab_cursor* cursor, int idxNum, const char* idxStr, int argc, sqlite3_value** argv) {
+
+  (void) idxStr;
+
+  auto c = static_cast<Cursor*>(cursor);
+  auto table = static_cast<Table*>(c->pVtab)->table;
+
+  /* data is taken once per scan - it stays the same even if the table data is replaced meanwhile */
+  c->data = table->getCurrentData();
+  c->rows = nullptr;
+  c->position = 0;
+  c->size = 0;
+
+  if(!c->data) {
+    return SQLITE_OK;
+  }
+
+  if(idxNum > 0) {
+    std::string key;
+    if(argc > 0 && Data::getKey(argv[0], table->m_columns[idxNum - 1].type, key)) {
+      c->rows = c->data->findRows(idxNum - 1, key);
+      c->size = c->rows ? (v_int64) c->rows->size() : 0;
+    }
+  } else {
+    c->size = c->data->getRowsCount();
+  }
+
+  return SQLITE_OK;
+
+}
+
+int VirtualTable::onNext(sqlite3_vtab_cursor* cursor) {
+  static_cast<Cursor*>(cursor)->position ++;
+  return SQLITE_OK;
+}
+
+int VirtualTable::onEof(sqlite3_vtab_cursor* cursor) {
+  auto c = static_cast<Cursor*>(cursor);
+  return c->position >= c->size;
+}
+
+int VirtualTable::onColumn(sqlite3_vtab_cursor* cursor, sqlite3_context* context, int col) {
+  auto c = static_cast<Cursor*>(cursor);
+  auto table = static_cast<Table*>(c->pVtab)->table;
+  auto row = c->rows ? (*c->rows)[c->position] : c->position;
+  try {
+    auto value = c->data->getValue(row, col);
+    if(value) {
+      table->m_serializer.serialize(context, value);
+    } else {
+      sqlite3_result_null(context);
+    }
+  } catch (std::exception& e) {
+    sqlite3_result_error(context, e.what(), -1);
+    return SQLITE_ERROR;
+  }
+  return SQLITE_OK;
+}
+
+int VirtualTable::onRowid(sqlite3_vtab_cursor* cursor, sqlite3_int64* rowId) {
+  auto c = static_cast<Cursor*>(cursor);
+  *rowId = c->rows ? (*c->rows)[c->position] : c->position;
+  return SQLITE_OK;
+}
+
+std::shared_ptr<const VirtualTable::Data> VirtualTable::getCurrentData() {
+  auto it = scopedData.find(this);
+  if(it != scopedData.end()) {
+    return it->second;
+  }
+  std::lock_guard<std::mutex> lock(m_dataMutex);
+  return m_data;
+}
+
+void VirtualTable::checkData(const std::shared_ptr<const Data>& data) const {
+  if(data && data->getColumnsCount() != (v_int32) m_columns.size()) {
+    throw std::runtime_error("[oatpp::sqlite::VirtualTable::checkData()]: Error. "
+                             "Data has " + std::to_string(data->getColumnsCount()) + " columns, table '" + *m_name +
+                             "' has " + std::to_string(m_columns.size()) + ".");
+  }
+}
+
+oatpp::String VirtualTable::getName() const {
+  return m_name;
+}
+
+const std::vector<VirtualTable::Column>& VirtualTable::getColumns() const {
+  return m_columns;
+}
+
+void VirtualTable::setData(const std::shared_ptr<const Data>& data) {
+  checkData(data);
+  std::lock_guard<std::mutex> lock(m_dataMutex);
+  m_data = data;
+}
+
+void VirtualTable::install(sqlite3* handle) {
+  auto res = sqlite3_create_module_v2(handle, m_name->c_str(), getModule(),
+                                      new std::shared_ptr<VirtualTable>(shared_from_this()), &onDestroy);
+  if(res != SQLITE_OK) {
+    throw std::runtime_error("[oatpp::sqlite::VirtualTable::install()]: Error. Can't create module '" +
+                             *m_name + "'. " + sqlite3_errmsg(handle));
+  }
+  std::lock_guard<std::mutex> lock(installedNamesMutex);
+  installedNames.insert(toLower(m_name->c_str()));
+}
+
+bool VirtualTable::isInstalled(const char* name) {
+  if(name == nullptr) {
+    return false;
+  }
+  auto key = toLower(name);
+  std::lock_guard<std::mutex> lock(installedNamesMutex);
+  return installedNames.find(key) != installedNames.end();
+}
+
+}}
@@ -0,0 +1,362 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#ifndef oatpp_sqlite_VirtualTable_hpp
+#define oatpp_sqlite_VirtualTable_hpp
+
+#include "mapping/Serializer.hpp"
+
+#include "oatpp/Types.hpp"
+
+#include <sqlite3.h>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace oatpp { namespace sqlite {
+
+/**
+ * Read-only virtual table presenting in-process data - DTOs or columns of values - to SQL. <br>
+ * The table is eponymous - it's available by its name on every connection where it's installed, no `CREATE VIRTUAL TABLE`
+ * is needed. Install it with &id:oatpp::sqlite::ConnectionProvider::addVirtualTable;. <br>
+ * Equality constraints on key columns are pushed down to the table and served by a hash index -
+ * affinity of the column is applied to the compared value, constraints with a non-`BINARY` collation are checked by SQLite. Ex.:
+ * ```cpp
+ * auto ids = oatpp::sqlite::VirtualTable::createShared("request_ids", {{"id", oatpp::Int64::Class::getType(), true}});
+ * connectionProvider->addVirtualTable(ids);
+ * ...
+ * auto data = std::make_shared<oatpp::sqlite::VirtualTable::ColumnarData>();
+ * data->addColumn(oatpp::Vector<oatpp::Int64>({1, 2, 3}));
+ * oatpp::sqlite::VirtualTable::Scope scope(ids, data); // request-scoped data of the current thread
+ * client.getUsersByRequestIds(); // SELECT u.* FROM users u JOIN request_ids r ON r.id = u.id
+ * ```
+ */
+class VirtualTable : public std::enable_shared_from_this<VirtualTable> {
+public:
+  typedef oatpp::data::type::Type Type;
+public:
+
+  /**
+   * Column of the table.
+   */
+  struct Column {
+
+    /**
+     * Column name.
+     */
+    oatpp::String name;
+
+    /**
+     * oatpp type of values.
+     */
+    const Type* type;
+
+    /**
+     * Equality constraints on the column are served by a hash index.
+     */
+    bool isKey;
+
+  };
+
+  /**
+   * Immutable rows of the table.
+   */
+  class Data {
+  private:
+    mutable std::mutex m_indexMutex;
+    mutable std::unordered_map<v_int32, std::unordered_map<std::string, std::vector<v_int64>>> m_indices;
+  public:
+
+    /**
+     * Get key of the value in the hash index.
+     * @param value
+     * @param key - out. Key.
+     * @return - `false` if value is `null` or its type can't be used as a key.
+     */
+    static bool getKey(const oatpp::Void& value, std::string& key);
+
+    /**
+     * Get key of the native value in the hash index.
+     * @param value - `sqlite3_value*`.
+     * @param key - out. Key.
+     * @return - `false` if value is `NULL`.
+     */
+    static bool getKey(sqlite3_value* value, std::string& key);
+
+    /**
+     * Get key of the native value compared to the column. Affinity of the column is applied to the value first,
+     * as SQLite does for `column = value` - ex.: `5` is keyed as `'5'` for a `TEXT` column,
+     * `'5'` is keyed as `5` for an `INTEGER` column.
+     * @param value - `sqlite3_value*`. Not modified.
+     * @param columnType - type of the column.
+     * @param key - out. Key.
+     * @return - `false` if value is `NULL`.
+     */
+    static bool getKey(sqlite3_value* value, const Type* columnType, std::string& key);
+
+  public:
+
+    /**
+     * Virtual destructor.
+     */
+    virtual ~Data() = default;
+
+    /**
+     * Get number of columns.
+     * @return
+     */
+    virtual v_int32 getColumnsCount() const = 0;
+
+    /**
+     * Get number of rows.
+     * @return
+     */
+    virtual v_int64 getRowsCount() const = 0;
+
+    /**
+     * Get value.
+     * @param row - row index.
+     * @param col - column index.
+     * @return
+     */
+    virtual oatpp::Void getValue(v_int64 row, v_int32 col) const = 0;
+
+    /**
+     * Find rows by value of the column. The hash index of the column is built on the first call.
+     * @param col - column index.
+     * @param key - key - see &l:VirtualTable::Data::getKey ();.
+     * @return - indices of rows or `nullptr` if nothing found.
+     */
+    const std::vector<v_int64>* findRows(v_int32 col, const std::string& key) const;
+
+  };
+
+  /**
+   * Rows as DTOs. Columns of the table are DTO fields in the order of their declaration.
+   */
+  class ObjectData : public Data {
+  private:
+    std::vector<oatpp::BaseObject::Property*> m_properties;
+    std::vector<oatpp::Void> m_rows;
+  private:
+    explicit ObjectData(const Type* objectType);
+  public:
+
+    /**
+     * Constructor.
+     * @tparam T - DTO class.
+     * @param rows - rows. `nullptr` items are skipped.
+     */
+    template<class T>
+    explicit ObjectData(const oatpp::Vector<oatpp::Object<T>>& rows)
+      : ObjectData(oatpp::Object<T>::Class::getType())
+    {
+      if(rows) {
+        m_rows.reserve(rows->size());
+        for(auto& row : *rows) {
+          if(row) {
+            m_rows.push_back(row);
+          }
+        }
+      }
+    }
+
+    v_int32 getColumnsCount() const override;
+    v_int64 getRowsCount() const override;
+    oatpp::Void getValue(v_int64 row, v_int32 col) const override;
+
+  };
+
+  /**
+   * Rows as columns of values.
+   */
+  class ColumnarData : public Data {
+  private:
+    std::vector<std::function<oatpp::Void(v_int64)>> m_columns;
+    v_int64 m_rowsCount;
+  public:
+
+    /**
+     * Constructor.
+     */
+    ColumnarData();
+
+    /**
+     * Add column. All columns must have the same number of values.
+     * @tparam T - type of values. Ex.: `oatpp::Int64`.
+     * @param values - values.
+     */
+    template<class T>
+    void addColumn(const oatpp::Vector<T>& values) {
+      v_int64 size = values ? (v_int64) values->size() : 0;
+      if(!m_columns.empty() && size != m_rowsCount) {
+        throw std::runtime_error("[oatpp::sqlite::VirtualTable::ColumnarData::addColumn()]: "
+                                 "Error. Columns must have the same number of values.");
+      }
+      m_rowsCount = size;
+      m_columns.push_back([values](v_int64 row) -> oatpp::Void {
+        return values[row];
+      });
+    }
+
+    v_int32 getColumnsCount() const override;
+    v_int64 getRowsCount() const override;
+    oatpp::Void getValue(v_int64 row, v_int32 col) const override;
+
+  };
+
+  /**
+   * Bind data to the table for the current thread. Data of the innermost scope is used by queries run on the
+   * current thread - ex.: request-scoped set of IDs. Outside of scopes the data set by &l:VirtualTable::setData (); is used.
+   */
+  class Scope {
+  private:
+    std::shared_ptr<VirtualTable> m_table;
+    std::shared_ptr<const Data> m_previous;
+  public:
+
+    /**
+     * Constructor.
+     * @param table - &l:VirtualTable;.
+     * @param data - &l:VirtualTable::Data;.
+     */
+    Scope(const std::shared_ptr<VirtualTable>& table, const std::shared_ptr<const Data>& data);
+
+    /**
+     * Non-virtual destructor. Restores the previous data.
+     */
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+  };
+
+private:
+  struct Table;
+  struct Cursor;
+private:
+  static const sqlite3_module* getModule();
+  static void onDestroy(void* data);
+  static int onConnect(sqlite3* db, void* aux, int argc, const char* const* argv, sqlite3_vtab** vtab, char** errMsg);
+  static int onBestIndex(sqlite3_vtab* vtab, sqlite3_index_info* info);
+  static int onDisconnect(sqlite3_vtab* vtab);
+  static int onOpen(sqlite3_vtab* vtab, sqlite3_vtab_cursor** cursor);
+  static int onClose(sqlite3_vtab_cursor* cursor);
+  static int onFilter(sqlite3_vtab_cursor* cursor, int idxNum, const char* idxStr, int argc, sqlite3_value** argv);
+  static int onNext(sqlite3_vtab_cursor* cursor);
+  static int onEof(sqlite3_vtab_cursor* cursor);
+  static int onColumn(sqlite3_vtab_cursor* cursor, sqlite3_context* context, int col);
+  static int onRowid(sqlite3_vtab_cursor* cursor, sqlite3_int64* rowId);
+private:
+  static const char* getDeclaredType(const Type* type);
+private:
+  oatpp::String m_name;
+  std::vector<Column> m_columns;
+  mapping::Serializer m_serializer;
+  std::mutex m_dataMutex;
+  std::shared_ptr<const Data> m_data;
+private:
+  std::shared_ptr<const Data> getCurrentData();
+  void checkData(const std::shared_ptr<const Data>& data) const;
+public:
+
+  /**
+   * Constructor.
+   * @param name - table name.
+   * @param columns - &l:VirtualTable::Column;.
+   */
+  VirtualTable(const oatpp::String& name, const std::vector<Column>& columns);
+
+  /**
+   * Create shared VirtualTable.
+   * @param name - table name.
+   * @param columns - &l:VirtualTable::Column;.
+   * @return - `std::shared_ptr` to VirtualTable.
+   */
+  static std::shared_ptr<VirtualTable> createShared(const oatpp::String& name, const std::vector<Column>& columns);
+
+  /**
+   * Create table with columns of the DTO fields. Use with &l:VirtualTable::ObjectData;.
+   * @tparam T - DTO class.
+   * @param name - table name.
+   * @param keyColumns - names of key columns.
+   * @return - `std::shared_ptr` to VirtualTable.
+   */
+  template<class T>
+  static std::shared_ptr<VirtualTable> createShared(const oatpp::String& name, const std::vector<oatpp::String>& keyColumns = {}) {
+    return createShared(name, getObjectColumns(oatpp::Object<T>::Class::getType(), keyColumns));
+  }
+
+  /**
+   * Get columns of the DTO type.
+   * @param objectType - DTO type.
+   * @param keyColumns - names of key columns.
+   * @return
+   */
+  static std::vector<Column> getObjectColumns(const Type* objectType, const std::vector<oatpp::String>& keyColumns);
+
+  /**
+   * Get table name.
+   * @return
+   */
+  oatpp::String getName() const;
+
+  /**
+   * Get columns.
+   * @return
+   */
+  const std::vector<Column>& getColumns() const;
+
+  /**
+   * Set data of the table - ex.: snapshot of the in-memory cache. <br>
+   * Queries which are already running keep reading the previous data.
+   * @param data - &l:VirtualTable::Data;. `nullptr` - empty table.
+   */
+  void setData(const std::shared_ptr<const Data>& data);
+
+  /**
+   * Register the table on the connection.
+   * @param handle - native connection handle.
+   */
+  void install(sqlite3* handle);
+
+  /**
+   * Check if a virtual table with such name was installed on any connection. <br>
+   * Data of virtual tables is set by the application and may be scoped to the calling thread -
+   * &id:oatpp::sqlite::Executor; never shares results of queries reading them.
+   * @param name - table name. Case-insensitive.
+   * @return
+   */
+  static bool isInstalled(const char* name);
+
+};
+
+}}
+
+#endif // oatpp_sqlite_VirtualTable_hpp
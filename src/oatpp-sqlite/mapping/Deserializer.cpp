@@ -25,6 +25,9 @@
 #include "Deserializer.hpp"
 #include "oatpp-sqlite/Types.hpp"
 
+#include <cstdlib>
+#include <cstring>
+
 namespace oatpp { namespace sqlite { namespace mapping {
 
 Deserializer::InData::InData(sqlite3_stmt* pStmt,
@@ -33,11 +36,124 @@ Deserializer::InData::InData(sqlite3_stmt* pStmt,
 {
   stmt = pStmt;
   col = pCol;
+  value = nullptr;
+  nativeValue = nullptr;
   typeResolver = pTypeResolver;
   oid = sqlite3_column_type(stmt, col);
   isNull = (oid == SQLITE_NULL);
 }
 
+Deserializer::InData::InData(const ResultSet::Value* pValue,
+                             const std::shared_ptr<const data::mapping::TypeResolver>& pTypeResolver)
+{
+  stmt = nullptr;
+  col = -1;
+  value = pValue;
+  nativeValue = nullptr;
+  typeResolver = pTypeResolver;
+  oid = value->type;
+  isNull = (oid == SQLITE_NULL);
+}
+
+Deserializer::InData::InData(sqlite3_value* pNativeValue,
+                             const std::shared_ptr<const data::mapping::TypeResolver>& pTypeResolver)
+{
+  stmt = nullptr;
+  col = -1;
+  value = nullptr;
+  nativeValue = pNativeValue;
+  typeResolver = pTypeResolver;
+  oid = sqlite3_value_type(nativeValue);
+  isNull = (oid == SQLITE_NULL);
+}
+
+v_int64 Deserializer::InData::getInt64() const {
+  if(value) {
+    switch(value->type) {
+      case SQLITE_INTEGER: return value->intValue;
+      case SQLITE_FLOAT: return (v_int64) value->floatValue;
+      case SQLITE_TEXT: return std::strtoll(value->bytes.c_str(), nullptr, 10);
+      default: return 0;
+    }
+  }
+  if(nativeValue) {
+    return sqlite3_value_int64(nativeValue);
+  }
+  return sqlite3_column_int64(stmt, col);
+}
+
+v_float64 Deserializer::InData::getDouble() const {
+  if(value) {
+    switch(value->type) {
+      case SQLITE_INTEGER: return (v_float64) value->intValue;
+      case SQLITE_FLOAT: return value->floatValue;
+      case SQLITE_TEXT: return std::strtod(value->bytes.c_str(), nullptr);
+      default: return 0;
+    }
+  }
+  if(nativeValue) {
+    return sqlite3_value_double(nativeValue);
+  }
+  return sqlite3_column_double(stmt, col);
+}
+
+const char* Deserializer::InData::getText() const {
+  if(value) {
+    switch(value->type) {
+      case SQLITE_INTEGER:
+        m_buffer = std::to_string(value->intValue);
+        return m_buffer.c_str();
+      case SQLITE_FLOAT: {
+        char buff[64];
+        sqlite3_snprintf(sizeof(buff), buff, "%!.15g", value->floatValue);
+        m_buffer = buff;
+        return m_buffer.c_str();
+      }
+      case SQLITE_TEXT:
+      case SQLITE_BLOB:
+        return value->bytes.c_str();
+      default:
+        return nullptr;
+    }
+  }
+  if(nativeValue) {
+    return (const char*) sqlite3_value_text(nativeValue);
+  }
+  return (const char*) sqlite3_column_text(stmt, col);
+}
+
+const void* Deserializer::InData::getBlob() const {
+  if(value) {
+    if(value->type == SQLITE_TEXT || value->type == SQLITE_BLOB) {
+      return value->bytes.data();
+    }
+    return getText();
+  }
+  if(nativeValue) {
+    return sqlite3_value_blob(nativeValue);
+  }
+  return sqlite3_column_blob(stmt, col);
+}
+
+int Deserializer::InData::getBytes() const {
+  if(value) {
+    switch(value->type) {
+      case SQLITE_INTEGER:
+      case SQLITE_FLOAT:
+        return (int) m_buffer.size();
+      case SQLITE_TEXT:
+      case SQLITE_BLOB:
+        return (int) value->bytes.size();
+      default:
+        return 0;
+    }
+  }
+  if(nativeValue) {
+    return sqlite3_value_bytes(nativeValue);
+  }
+  return sqlite3_column_bytes(stmt, col);
+}
+
 Deserializer::Deserializer() {
 
   m_methods.resize(data::type::ClassId::getClassCount(), nullptr);
@@ -74,6 +190,7 @@ Deserializer::Deserializer() {
   // sqlite
 
   setDeserializerMethod(mapping::type::__class::Blob::CLASS_ID, &Deserializer::deserializeBlob);
+  setDeserializerMethod(mapping::type::__class::Embedding::CLASS_ID, &Deserializer::deserializeEmbedding);
 
 }
 
@@ -106,7 +223,7 @@ oatpp::Void Deserializer::deserialize(const InData& data, const Type* type) cons
 
 v_int64 Deserializer::deInt(const InData& data) {
   switch(data.oid) {
-    case SQLITE_INTEGER: return sqlite3_column_int64(data.stmt, data.col);
+    case SQLITE_INTEGER: return data.getInt64();
   }
   throw std::runtime_error("[oatpp::sqlite::mapping::Deserializer::deInt()]: Error. Unknown OID.");
 }
@@ -121,8 +238,8 @@ oatpp::Void Deserializer::deserializeString(const Deserializer* _this, const InD
     return oatpp::String();
   }
 
-  auto ptr = (const char*) sqlite3_column_text(data.stmt, data.col);
-  auto size = sqlite3_column_bytes(data.stmt, data.col);
+  auto ptr = data.getText();
+  auto size = data.getBytes();
   return oatpp::String(ptr, size);
 
 }
@@ -136,12 +253,40 @@ oatpp::Void Deserializer::deserializeBlob(const Deserializer* _this, const InDat
     return oatpp::String();
   }
 
-  auto ptr = (const char*) sqlite3_column_blob(data.stmt, data.col);
-  auto size = sqlite3_column_bytes(data.stmt, data.col);
+  auto ptr = (const char*) data.getBlob();
+  auto size = data.getBytes();
   return sqlite::Blob(std::make_shared<std::string>(ptr, size));
 
 }
 
+oatpp::Void Deserializer::deserializeEmbedding(const Deserializer* _this, const InData& data, const Type* type) {
+
+  (void) _this;
+  (void) type;
+
+  if(data.isNull) {
+    return sqlite::Embedding();
+  }
+
+  if(data.oid != SQLITE_BLOB) {
+    throw std::runtime_error("[oatpp::sqlite::mapping::Deserializer::deserializeEmbedding()]: Error. Embedding must be a BLOB.");
+  }
+
+  auto ptr = data.getBlob();
+  auto size = data.getBytes();
+  if(size % sizeof(v_float32) != 0) {
+    throw std::runtime_error("[oatpp::sqlite::mapping::Deserializer::deserializeEmbedding()]: "
+                             "Error. Invalid BLOB size - " + std::to_string(size) + " bytes.");
+  }
+
+  auto result = std::make_shared<std::vector<v_float32>>(size / sizeof(v_float32));
+  if(size > 0) {
+    std::memcpy(result->data(), ptr, size);
+  }
+  return sqlite::Embedding(result);
+
+}
+
 oatpp::Void Deserializer::deserializeFloat32(const Deserializer* _this, const InData& data, const Type* type) {
 
   (void) _this;
@@ -153,7 +298,7 @@ oatpp::Void Deserializer::deserializeFloat32(const Deserializer* _this, const In
 
   switch(data.oid) {
     case SQLITE_INTEGER:
-    case SQLITE_FLOAT: return oatpp::Float32(sqlite3_column_double(data.stmt, data.col));
+    case SQLITE_FLOAT: return oatpp::Float32(data.getDouble());
   }
 
   throw std::runtime_error("[oatpp::sqlite::mapping::Deserializer::deserializeFloat32()]: Error. Unknown OID.");
@@ -171,7 +316,7 @@ oatpp::Void Deserializer::deserializeFloat64(const Deserializer* _this, const In
 
   switch(data.oid) {
     case SQLITE_INTEGER:
-    case SQLITE_FLOAT: return oatpp::Float64(sqlite3_column_double(data.stmt, data.col));
+    case SQLITE_FLOAT: return oatpp::Float64(data.getDouble());
   }
 
   throw std::runtime_error("[oatpp::sqlite::mapping::Deserializer::deserializeFloat64()]: Error. Unknown OID.");
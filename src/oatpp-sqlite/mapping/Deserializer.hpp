@@ -25,6 +25,8 @@
 #ifndef oatpp_sqlite_mapping_Deserializer_hpp
 #define oatpp_sqlite_mapping_Deserializer_hpp
 
+#include "ResultSet.hpp"
+
 #include "oatpp/data/mapping/TypeResolver.hpp"
 #include "oatpp/Types.hpp"
 
@@ -44,14 +46,52 @@ public:
 
     InData(sqlite3_stmt* pStmt, int pCol, const std::shared_ptr<const data::mapping::TypeResolver>& pTypeResolver);
 
+    InData(const ResultSet::Value* pValue, const std::shared_ptr<const data::mapping::TypeResolver>& pTypeResolver);
+
+    /**
+     * Constructor over native value - ex.: argument of the SQL function.
+     * @param pNativeValue - `sqlite3_value*`.
+     * @param pTypeResolver
+     */
+    InData(sqlite3_value* pNativeValue, const std::shared_ptr<const data::mapping::TypeResolver>& pTypeResolver);
+
     sqlite3_stmt* stmt;
     int col;
 
+    /**
+     * Materialized value. If set, the value is read from here instead of the `stmt`.
+     */
+    const ResultSet::Value* value;
+
+    /**
+     * Native value. If set, the value is read from here instead of the `stmt`.
+     */
+    sqlite3_value* nativeValue;
+
     std::shared_ptr<const data::mapping::TypeResolver> typeResolver;
 
     int oid;
     bool isNull;
 
+    v_int64 getInt64() const;
+    v_float64 getDouble() const;
+
+    /**
+     * Get value as text. Call &l:Deserializer::InData::getBytes (); after this method to get the size of the text.
+     * @return
+     */
+    const char* getText() const;
+
+    /**
+     * Get value as blob. Call &l:Deserializer::InData::getBytes (); after this method to get the size of the blob.
+     * @return
+     */
+    const void* getBlob() const;
+
+    int getBytes() const;
+
+  private:
+    mutable std::string m_buffer;
   };
 
 public:
@@ -74,6 +114,8 @@ private:
 
   static oatpp::Void deserializeBlob(const Deserializer* _this, const InData& data, const Type* type);
 
+  static oatpp::Void deserializeEmbedding(const Deserializer* _this, const InData& data, const Type* type);
+
   template<class IntWrapper>
   static oatpp::Void deserializeInt(const Deserializer* _this, const InData& data, const Type* type) {
     (void) _this;
@@ -29,6 +29,7 @@ namespace oatpp { namespace sqlite { namespace mapping {
 
 ResultMapper::ResultData::ResultData(sqlite3_stmt* pStmt, const std::shared_ptr<const data::mapping::TypeResolver>& pTypeResolver)
   : stmt(pStmt)
+  , resultSet(nullptr)
   , typeResolver(pTypeResolver)
 {
 
@@ -46,8 +47,35 @@ ResultMapper::ResultData::ResultData(sqlite3_stmt* pStmt, const std::shared_ptr<
 
 }
 
+ResultMapper::ResultData::ResultData(const std::shared_ptr<const ResultSet>& pResultSet,
+                                     const std::shared_ptr<const data::mapping::TypeResolver>& pTypeResolver)
+  : stmt(nullptr)
+  , resultSet(pResultSet)
+  , typeResolver(pTypeResolver)
+{
+
+  rowIndex = 0;
+  isSuccess = true;
+  hasMore = resultSet->getRowCount() > 0;
+
+  {
+    colCount = resultSet->getColCount();
+    const auto& names = resultSet->getColNames();
+    for (v_int32 i = 0; i < colCount; i++) {
+      colNames.push_back(names[i]);
+      colIndices.insert({names[i], i});
+    }
+  }
+
+}
+
 void ResultMapper::ResultData::next() {
 
+  if(resultSet) {
+    hasMore = rowIndex < resultSet->getRowCount();
+    return;
+  }
+
   auto res = sqlite3_step(stmt);
 
   switch(res) {
@@ -73,6 +101,27 @@ void ResultMapper::ResultData::next() {
 
 }
 
+Deserializer::InData ResultMapper::ResultData::getColumn(v_int32 col) const {
+  if(resultSet) {
+    return Deserializer::InData(&resultSet->getRow(rowIndex)[col], typeResolver);
+  }
+  return Deserializer::InData(stmt, col, typeResolver);
+}
+
+std::shared_ptr<ResultSet> ResultMapper::ResultData::materialize() {
+  auto result = std::make_shared<ResultSet>(colNames);
+  while(hasMore) {
+    if(resultSet) {
+      result->addRow(resultSet->getRow(rowIndex));
+    } else {
+      result->addRow(stmt);
+    }
+    ++rowIndex;
+    next();
+  }
+  return result;
+}
+
 ResultMapper::ResultMapper() {
 
   {
@@ -124,7 +173,7 @@ oatpp::Void ResultMapper::readOneRowAsCollection(ResultMapper* _this, ResultData
   const Type* itemType = dispatcher->getItemType();
 
   for(v_int32 i = 0; i < dbData->colCount; i ++) {
-    mapping::Deserializer::InData inData(dbData->stmt, i, dbData->typeResolver);
+    auto inData = dbData->getColumn(i);
     dispatcher->addItem(collection, _this->m_deserializer.deserialize(inData, itemType));
   }
 
@@ -144,7 +193,7 @@ oatpp::Void ResultMapper::readOneRowAsMap(ResultMapper* _this, ResultData* dbDat
 
   const Type* valueType = dispatcher->getValueType();
   for(v_int32 i = 0; i < dbData->colCount; i ++) {
-    mapping::Deserializer::InData inData(dbData->stmt, i, dbData->typeResolver);
+    auto inData = dbData->getColumn(i);
     dispatcher->addItem(map, dbData->colNames[i], _this->m_deserializer.deserialize(inData, valueType));
   }
 
@@ -169,7 +218,7 @@ oatpp::Void ResultMapper::readOneRowAsObject(ResultMapper* _this, ResultData* db
       if(field->info.typeSelector && field->type == oatpp::Any::Class::getType()) {
         polymorphs.push_back({field, i});
       } else {
-        mapping::Deserializer::InData inData(dbData->stmt, i, dbData->typeResolver);
+        auto inData = dbData->getColumn(i);
         field->set(static_cast<oatpp::BaseObject *>(object.get()),
                    _this->m_deserializer.deserialize(inData, field->type));
       }
@@ -186,7 +235,7 @@ oatpp::Void ResultMapper::readOneRowAsObject(ResultMapper* _this, ResultData* db
 
   for(auto& p : polymorphs) {
     v_int32 index = p.second;
-    mapping::Deserializer::InData inData(dbData->stmt, index, dbData->typeResolver);
+    auto inData = dbData->getColumn(index);
     auto selectedType = p.first->info.typeSelector->selectType(static_cast<oatpp::BaseObject *>(object.get()));
     auto value = _this->m_deserializer.deserialize(inData, selectedType);
     oatpp::Any any(value);
@@ -51,11 +51,24 @@ public:
      */
     ResultData(sqlite3_stmt* pStmt, const std::shared_ptr<const data::mapping::TypeResolver>& pTypeResolver);
 
+    /**
+     * Constructor.
+     * @param pResultSet - materialized result.
+     * @param pTypeResolver
+     */
+    ResultData(const std::shared_ptr<const ResultSet>& pResultSet,
+               const std::shared_ptr<const data::mapping::TypeResolver>& pTypeResolver);
+
     /**
      * SQLite statement.
      */
     sqlite3_stmt* stmt;
 
+    /**
+     * Materialized result. If set, rows are read from here instead of the `stmt`.
+     */
+    std::shared_ptr<const ResultSet> resultSet;
+
     /**
      * &id:oatpp::data::mapping::TypeResolver;.
      */
@@ -98,6 +111,19 @@ public:
      */
     void next();
 
+    /**
+     * Get column of the current row.
+     * @param col - column index.
+     * @return - &id:oatpp::sqlite::mapping::Deserializer::InData;.
+     */
+    Deserializer::InData getColumn(v_int32 col) const;
+
+    /**
+     * Read all remaining rows of the statement to &id:oatpp::sqlite::mapping::ResultSet;.
+     * @return - materialized result. Check `isSuccess` after the call.
+     */
+    std::shared_ptr<ResultSet> materialize();
+
   };
 
 private:
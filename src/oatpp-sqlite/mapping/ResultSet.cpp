@@ -0,0 +1,161 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "ResultSet.hpp"
+
+namespace oatpp { namespace sqlite { namespace mapping {
+
+ResultSet::ResultSet(const std::vector<oatpp::String>& colNames)
+  : m_colNames(colNames)
+  , m_dataSize(0)
+{
+  for(auto& name : m_colNames) {
+    m_dataSize += name->size();
+  }
+}
+
+ResultSet::Value ResultSet::readValue(sqlite3_value* value) {
+
+  Value result;
+  result.type = sqlite3_value_type(value);
+  result.intValue = 0;
+  result.floatValue = 0;
+
+  switch(result.type) {
+
+    case SQLITE_INTEGER:
+      result.intValue = sqlite3_value_int64(value);
+      break;
+
+    case SQLITE_FLOAT:
+      result.floatValue = sqlite3_value_double(value);
+      break;
+
+    case SQLITE_TEXT: {
+      auto ptr = (const char*) sqlite3_value_text(value);
+      auto size = sqlite3_value_bytes(value);
+      result.bytes.assign(ptr, size);
+      break;
+    }
+
+    case SQLITE_BLOB: {
+      auto ptr = (const char*) sqlite3_value_blob(value);
+      auto size = sqlite3_value_bytes(value);
+      if(size > 0) {
+        result.bytes.assign(ptr, size);
+      }
+      break;
+    }
+
+    default:
+      break;
+
+  }
+
+  return result;
+
+}
+
+void ResultSet::addRow(sqlite3_stmt* stmt) {
+
+  Row row;
+  row.resize(m_colNames.size());
+
+  for(v_uint32 i = 0; i < row.size(); i ++) {
+
+    auto& value = row[i];
+    value.type = sqlite3_column_type(stmt, i);
+    value.intValue = 0;
+    value.floatValue = 0;
+
+    switch(value.type) {
+
+      case SQLITE_INTEGER:
+        value.intValue = sqlite3_column_int64(stmt, i);
+        break;
+
+      case SQLITE_FLOAT:
+        value.floatValue = sqlite3_column_double(stmt, i);
+        break;
+
+      case SQLITE_TEXT: {
+        auto ptr = (const char*) sqlite3_column_text(stmt, i);
+        auto size = sqlite3_column_bytes(stmt, i);
+        value.bytes.assign(ptr, size);
+        break;
+      }
+
+      case SQLITE_BLOB: {
+        auto ptr = (const char*) sqlite3_column_blob(stmt, i);
+        auto size = sqlite3_column_bytes(stmt, i);
+        if(size > 0) {
+          value.bytes.assign(ptr, size);
+        }
+        break;
+      }
+
+      default:
+        break;
+
+    }
+
+    m_dataSize += sizeof(Value) + value.bytes.size();
+
+  }
+
+  m_rows.push_back(std::move(row));
+
+}
+
+void ResultSet::addRow(const Row& row) {
+  if(row.size() != m_colNames.size()) {
+    throw std::runtime_error("[oatpp::sqlite::mapping::ResultSet::addRow()]: Error. Invalid number of columns.");
+  }
+  for(auto& value : row) {
+    m_dataSize += sizeof(Value) + value.bytes.size();
+  }
+  m_rows.push_back(row);
+}
+
+const std::vector<oatpp::String>& ResultSet::getColNames() const {
+  return m_colNames;
+}
+
+v_int64 ResultSet::getColCount() const {
+  return m_colNames.size();
+}
+
+v_int64 ResultSet::getRowCount() const {
+  return m_rows.size();
+}
+
+const ResultSet::Row& ResultSet::getRow(v_int64 index) const {
+  return m_rows[index];
+}
+
+v_int64 ResultSet::getDataSize() const {
+  return m_dataSize;
+}
+
+}}}
@@ -0,0 +1,140 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef oatpp_sqlite_mapping_ResultSet_hpp
+#define oatpp_sqlite_mapping_ResultSet_hpp
+
+#include "oatpp/Types.hpp"
+
+#include <sqlite3.h>
+
+namespace oatpp { namespace sqlite { namespace mapping {
+
+/**
+ * Materialized query result. <br>
+ * Holds column names and copies of column values of all rows. <br>
+ * Once filled, it is immutable and can be shared between threads and mapped to oatpp objects multiple times.
+ */
+class ResultSet {
+public:
+
+  /**
+   * Copy of a single column value.
+   */
+  struct Value {
+
+    /**
+     * SQLite fundamental datatype - `SQLITE_INTEGER`, `SQLITE_FLOAT`, `SQLITE_TEXT`, `SQLITE_BLOB` or `SQLITE_NULL`.
+     */
+    int type;
+
+    /**
+     * Value of `SQLITE_INTEGER`.
+     */
+    v_int64 intValue;
+
+    /**
+     * Value of `SQLITE_FLOAT`.
+     */
+    v_float64 floatValue;
+
+    /**
+     * Value of `SQLITE_TEXT` and `SQLITE_BLOB`.
+     */
+    std::string bytes;
+
+  };
+
+  /**
+   * Row of values.
+   */
+  typedef std::vector<Value> Row;
+
+  /**
+   * Copy native value.
+   * @param value - `sqlite3_value*`.
+   * @return - &l:ResultSet::Value;.
+   */
+  static Value readValue(sqlite3_value* value);
+
+private:
+  std::vector<oatpp::String> m_colNames;
+  std::vector<Row> m_rows;
+  v_int64 m_dataSize;
+public:
+
+  /**
+   * Constructor.
+   * @param colNames - names of columns.
+   */
+  explicit ResultSet(const std::vector<oatpp::String>& colNames);
+
+  /**
+   * Copy values of the current row of the statement and append them as a new row.
+   * @param stmt - statement positioned at a row.
+   */
+  void addRow(sqlite3_stmt* stmt);
+
+  /**
+   * Append a copy of the row.
+   * @param row
+   */
+  void addRow(const Row& row);
+
+  /**
+   * Get names of columns.
+   * @return
+   */
+  const std::vector<oatpp::String>& getColNames() const;
+
+  /**
+   * Get number of columns.
+   * @return
+   */
+  v_int64 getColCount() const;
+
+  /**
+   * Get number of rows.
+   * @return
+   */
+  v_int64 getRowCount() const;
+
+  /**
+   * Get row by index.
+   * @param index
+   * @return
+   */
+  const Row& getRow(v_int64 index) const;
+
+  /**
+   * Get approximate size of memory occupied by values (in bytes).
+   * @return
+   */
+  v_int64 getDataSize() const;
+
+};
+
+}}}
+
+#endif // oatpp_sqlite_mapping_ResultSet_hpp
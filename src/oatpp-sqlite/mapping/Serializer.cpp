@@ -70,6 +70,107 @@ Serializer::Serializer() {
   // sqlite
 
   setSerializerMethod(mapping::type::__class::Blob::CLASS_ID, &Serializer::serializeBlob);
+  setSerializerMethod(mapping::type::__class::Embedding::CLASS_ID, &Serializer::serializeEmbedding);
+
+  // function results
+
+  m_resultMethods.resize(data::type::ClassId::getClassCount(), nullptr);
+
+  setResultMethod(data::type::__class::String::CLASS_ID, &Serializer::resultString);
+
+  setResultMethod(data::type::__class::Int8::CLASS_ID, &Serializer::resultInt<oatpp::Int8>);
+  setResultMethod(data::type::__class::UInt8::CLASS_ID, &Serializer::resultInt<oatpp::UInt8>);
+
+  setResultMethod(data::type::__class::Int16::CLASS_ID, &Serializer::resultInt<oatpp::Int16>);
+  setResultMethod(data::type::__class::UInt16::CLASS_ID, &Serializer::resultInt<oatpp::UInt16>);
+
+  setResultMethod(data::type::__class::Int32::CLASS_ID, &Serializer::resultInt<oatpp::Int32>);
+  setResultMethod(data::type::__class::UInt32::CLASS_ID, &Serializer::resultInt<oatpp::UInt32>);
+
+  setResultMethod(data::type::__class::Int64::CLASS_ID, &Serializer::resultInt<oatpp::Int64>);
+  setResultMethod(data::type::__class::UInt64::CLASS_ID, &Serializer::resultInt<oatpp::UInt64>);
+
+  setResultMethod(data::type::__class::Float32::CLASS_ID, &Serializer::resultFloat<oatpp::Float32>);
+  setResultMethod(data::type::__class::Float64::CLASS_ID, &Serializer::resultFloat<oatpp::Float64>);
+  setResultMethod(data::type::__class::Boolean::CLASS_ID, &Serializer::resultInt<oatpp::Boolean>);
+
+  setResultMethod(data::type::__class::AbstractEnum::CLASS_ID, &Serializer::resultEnum);
+
+  setResultMethod(mapping::type::__class::Blob::CLASS_ID, &Serializer::resultBlob);
+  setResultMethod(mapping::type::__class::Embedding::CLASS_ID, &Serializer::resultEmbedding);
+
+}
+
+void Serializer::setResultMethod(const data::type::ClassId& classId, ResultMethod method) {
+  const v_uint32 id = classId.id;
+  if(id >= m_resultMethods.size()) {
+    m_resultMethods.resize(id + 1, nullptr);
+  }
+  m_resultMethods[id] = method;
+}
+
+void Serializer::serialize(sqlite3_context* context, const oatpp::Void& polymorph) const {
+  auto id = polymorph.getValueType()->classId.id;
+  ResultMethod method = id < m_resultMethods.size() ? m_resultMethods[id] : nullptr;
+  if(method) {
+    (*method)(this, context, polymorph);
+  } else {
+    throw std::runtime_error("[oatpp::sqlite::mapping::Serializer::serialize()]: "
+                             "Error. No result method for type '" + std::string(polymorph.getValueType()->classId.name) +
+                             "'");
+  }
+}
+
+void Serializer::resultString(const Serializer* _this, sqlite3_context* context, const oatpp::Void& polymorph) {
+  (void) _this;
+  if(polymorph) {
+    std::string *buff = static_cast<std::string*>(polymorph.get());
+    sqlite3_result_text64(context, buff->data(), buff->size(), SQLITE_TRANSIENT, SQLITE_UTF8);
+  } else {
+    sqlite3_result_null(context);
+  }
+}
+
+void Serializer::resultBlob(const Serializer* _this, sqlite3_context* context, const oatpp::Void& polymorph) {
+  (void) _this;
+  if(polymorph) {
+    std::string *buff = static_cast<std::string*>(polymorph.get());
+    sqlite3_result_blob64(context, buff->data(), buff->size(), SQLITE_TRANSIENT);
+  } else {
+    sqlite3_result_null(context);
+  }
+}
+
+void Serializer::resultEmbedding(const Serializer* _this, sqlite3_context* context, const oatpp::Void& polymorph) {
+  (void) _this;
+  if(polymorph) {
+    auto buff = static_cast<std::vector<v_float32>*>(polymorph.get());
+    sqlite3_result_blob64(context, buff->data(), buff->size() * sizeof(v_float32), SQLITE_TRANSIENT);
+  } else {
+    sqlite3_result_null(context);
+  }
+}
+
+void Serializer::resultEnum(const Serializer* _this, sqlite3_context* context, const oatpp::Void& polymorph) {
+
+  auto polymorphicDispatcher = static_cast<const data::type::__class::AbstractEnum::PolymorphicDispatcher*>(
+    polymorph.getValueType()->polymorphicDispatcher
+  );
+
+  data::type::EnumInterpreterError e = data::type::EnumInterpreterError::OK;
+  const auto& enumInterpretation = polymorphicDispatcher->toInterpretation(polymorph, false, e);
+
+  if(e == data::type::EnumInterpreterError::OK) {
+    _this->serialize(context, enumInterpretation);
+    return;
+  }
+
+  switch(e) {
+    case data::type::EnumInterpreterError::CONSTRAINT_NOT_NULL:
+      throw std::runtime_error("[oatpp::sqlite::mapping::Serializer::resultEnum()]: Error. Enum constraint violated - 'NotNull'.");
+    default:
+      throw std::runtime_error("[oatpp::sqlite::mapping::Serializer::resultEnum()]: Error. Can't serialize Enum.");
+  }
 
 }
 
@@ -116,6 +217,16 @@ void Serializer::serializeBlob(const Serializer* _this, sqlite3_stmt* stmt, v_ui
   }
 }
 
+void Serializer::serializeEmbedding(const Serializer* _this, sqlite3_stmt* stmt, v_uint32 paramIndex, const oatpp::Void& polymorph) {
+  (void) _this;
+  if(polymorph) {
+    auto buff = static_cast<std::vector<v_float32>*>(polymorph.get());
+    sqlite3_bind_blob64(stmt, paramIndex, buff->data(), buff->size() * sizeof(v_float32), SQLITE_TRANSIENT);
+  } else {
+    sqlite3_bind_null(stmt, paramIndex);
+  }
+}
+
 void Serializer::serializeInt8(const Serializer* _this, sqlite3_stmt* stmt, v_uint32 paramIndex, const oatpp::Void& polymorph) {
   (void) _this;
   if(polymorph) {
@@ -36,22 +36,76 @@ namespace oatpp { namespace sqlite { namespace mapping {
 class Serializer {
 public:
   typedef void (*SerializerMethod)(const Serializer*, sqlite3_stmt*, v_uint32, const oatpp::Void&);
+
+  /**
+   * Method setting value as the result of the SQL function - `sqlite3_result_*`.
+   */
+  typedef void (*ResultMethod)(const Serializer*, sqlite3_context*, const oatpp::Void&);
 private:
   std::vector<SerializerMethod> m_methods;
+  std::vector<ResultMethod> m_resultMethods;
 public:
 
   Serializer();
 
   void setSerializerMethod(const data::type::ClassId& classId, SerializerMethod method);
 
+  /**
+   * Set method used to return values of this type from SQL functions.
+   * @param classId
+   * @param method - &l:Serializer::ResultMethod;.
+   */
+  void setResultMethod(const data::type::ClassId& classId, ResultMethod method);
+
   void serialize(sqlite3_stmt* stmt, v_uint32 paramIndex, const oatpp::Void& polymorph) const;
 
+  /**
+   * Set value as the result of the SQL function.
+   * @param context - `sqlite3_context*` of the function call.
+   * @param polymorph - value.
+   */
+  void serialize(sqlite3_context* context, const oatpp::Void& polymorph) const;
+
+private:
+
+  template<class IntWrapper>
+  static void resultInt(const Serializer* _this, sqlite3_context* context, const oatpp::Void& polymorph) {
+    (void) _this;
+    if(polymorph) {
+      auto v = polymorph.cast<IntWrapper>();
+      sqlite3_result_int64(context, (sqlite3_int64) *v);
+    } else {
+      sqlite3_result_null(context);
+    }
+  }
+
+  template<class FloatWrapper>
+  static void resultFloat(const Serializer* _this, sqlite3_context* context, const oatpp::Void& polymorph) {
+    (void) _this;
+    if(polymorph) {
+      auto v = polymorph.cast<FloatWrapper>();
+      sqlite3_result_double(context, *v);
+    } else {
+      sqlite3_result_null(context);
+    }
+  }
+
+  static void resultString(const Serializer* _this, sqlite3_context* context, const oatpp::Void& polymorph);
+
+  static void resultBlob(const Serializer* _this, sqlite3_context* context, const oatpp::Void& polymorph);
+
+  static void resultEmbedding(const Serializer* _this, sqlite3_context* context, const oatpp::Void& polymorph);
+
+  static void resultEnum(const Serializer* _this, sqlite3_context* context, const oatpp::Void& polymorph);
+
 private:
 
   static void serializeString(const Serializer* _this, sqlite3_stmt* stmt, v_uint32 paramIndex, const oatpp::Void& polymorph);
 
   static void serializeBlob(const Serializer* _this, sqlite3_stmt* stmt, v_uint32 paramIndex, const oatpp::Void& polymorph);
 
+  static void serializeEmbedding(const Serializer* _this, sqlite3_stmt* stmt, v_uint32 paramIndex, const oatpp::Void& polymorph);
+
   static void serializeInt8(const Serializer* _this, sqlite3_stmt* stmt, v_uint32 paramIndex, const oatpp::Void& polymorph);
 
   static void serializeUInt8(const Serializer* _this, sqlite3_stmt* stmt, v_uint32 paramIndex, const oatpp::Void& polymorph);
@@ -0,0 +1,91 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#ifndef oatpp_sqlite_mapping_type_Embedding_hpp
+#define oatpp_sqlite_mapping_type_Embedding_hpp
+
+#include "oatpp/Types.hpp"
+
+namespace oatpp { namespace sqlite { namespace mapping { namespace type {
+
+namespace __class {
+  class Embedding;
+}
+
+/**
+ * Embedding type - vector of `v_float32`. <br>
+ * Stored in SQLite as BLOB of packed floats in the native byte order - 4 bytes per component, no encoding. <br>
+ * Use SQL functions of &id:oatpp::sqlite::EmbeddingFunctions; to compare embeddings inside the query.
+ */
+typedef oatpp::data::type::ObjectWrapper<std::vector<v_float32>, __class::Embedding> Embedding;
+
+namespace __class {
+
+class Embedding {
+public:
+
+  class Inter : public oatpp::Type::Interpretation<type::Embedding, oatpp::Vector<oatpp::Float32>>  {
+  public:
+
+    oatpp::Vector<oatpp::Float32> interpret(const type::Embedding& value) const override {
+      if(value) {
+        oatpp::Vector<oatpp::Float32> result({});
+        result->reserve(value->size());
+        for(auto v : *value) {
+          result->push_back(v);
+        }
+        return result;
+      }
+      return nullptr;
+    }
+
+    type::Embedding reproduce(const oatpp::Vector<oatpp::Float32>& value) const override {
+      if(value) {
+        auto result = std::make_shared<std::vector<v_float32>>();
+        result->reserve(value->size());
+        for(auto& v : *value) {
+          result->push_back(v ? *v : 0.0f);
+        }
+        return result;
+      }
+      return nullptr;
+    }
+
+  };
+
+private:
+  static oatpp::Type* createType();
+public:
+
+  static const oatpp::ClassId CLASS_ID;
+  static oatpp::Type* getType();
+
+};
+
+}
+
+}}}}
+
+#endif // oatpp_sqlite_mapping_type_Embedding_hpp
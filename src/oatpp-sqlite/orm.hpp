@@ -27,8 +27,23 @@
  * This is just a header file which includes all oatpp-sqlite components:
  *
  * ```cpp
+ * #include "Backup.hpp"
+ * #include "BusyHandler.hpp"
+ * #include "ChangeFeed.hpp"
+ * #include "CheckpointManager.hpp"
+ * #include "DataLoader.hpp"
+ * #include "EmbeddingFunctions.hpp"
  * #include "Executor.hpp"
+ * #include "FullTextSearch.hpp"
+ * #include "Function.hpp"
+ * #include "HotSwapConnectionProvider.hpp"
+ * #include "ImageConnectionProvider.hpp"
+ * #include "MaintenanceScheduler.hpp"
+ * #include "ShardedExecutor.hpp"
+ * #include "SpatialIndex.hpp"
+ * #include "TenantConnectionProvider.hpp"
  * #include "Types.hpp"
+ * #include "VirtualTable.hpp"
  * #include "Utils.hpp"
  *
  * #include "oatpp/orm/SchemaMigration.hpp"
@@ -40,8 +55,23 @@
 #ifndef oatpp_sqlite_orm_hpp
 #define oatpp_sqlite_orm_hpp
 
+#include "Backup.hpp"
+#include "BusyHandler.hpp"
+#include "ChangeFeed.hpp"
+#include "CheckpointManager.hpp"
+#include "DataLoader.hpp"
+#include "EmbeddingFunctions.hpp"
 #include "Executor.hpp"
+#include "FullTextSearch.hpp"
+#include "Function.hpp"
+#include "HotSwapConnectionProvider.hpp"
+#include "ImageConnectionProvider.hpp"
+#include "MaintenanceScheduler.hpp"
+#include "ShardedExecutor.hpp"
+#include "SpatialIndex.hpp"
+#include "TenantConnectionProvider.hpp"
 #include "Types.hpp"
+#include "VirtualTable.hpp"
 #include "Utils.hpp"
 
 #include "oatpp/orm/SchemaMigration.hpp"
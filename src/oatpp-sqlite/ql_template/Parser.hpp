@@ -30,6 +30,9 @@
 
 #include <sqlite3.h>
 
+#include <mutex>
+#include <unordered_map>
+
 namespace oatpp { namespace sqlite { namespace ql_template {
 
 /**
@@ -57,6 +60,18 @@ public:
      * Use prepared statement for this query.
      */
     bool prepare;
+
+    /**
+     * Variants of the prepared template with collection parameters expanded to lists of placeholders. <br>
+     * Key - arities of template variables (see &id:oatpp::sqlite::ql_template::TemplateValueProvider;).
+     */
+    std::unordered_map<std::string, oatpp::String> expandedTemplates;
+
+    /**
+     * Mutex guarding `expandedTemplates`.
+     */
+    std::mutex expandedTemplatesMutex;
+
   };
 
 public:
@@ -26,9 +26,27 @@
 
 namespace oatpp { namespace sqlite { namespace ql_template {
 
+TemplateValueProvider::TemplateValueProvider()
+  : m_arities(nullptr)
+{}
+
+TemplateValueProvider::TemplateValueProvider(const std::vector<v_int64>* arities)
+  : m_arities(arities)
+{}
+
 oatpp::String TemplateValueProvider::getValue(const data::share::StringTemplate::Variable& variable, v_uint32 index) {
   m_buffStream.setCurrentPosition(0);
-  m_buffStream << "?";
+  if(m_arities && index < m_arities->size() && (*m_arities)[index] >= 0) {
+    auto arity = (*m_arities)[index];
+    for(v_int64 i = 0; i < arity; i ++) {
+      if(i > 0) {
+        m_buffStream << ", ";
+      }
+      m_buffStream << "?";
+    }
+  } else {
+    m_buffStream << "?";
+  }
   return m_buffStream.toString();
 }
 
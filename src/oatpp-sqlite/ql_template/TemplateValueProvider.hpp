@@ -31,13 +31,29 @@
 namespace oatpp { namespace sqlite { namespace ql_template {
 
 /**
- * &id:oatpp::data::share::StringTemplate::ValueProvider;
+ * &id:oatpp::data::share::StringTemplate::ValueProvider;. <br>
+ * Substitutes template variables with SQLite parameter placeholders.
  */
 class TemplateValueProvider : public data::share::StringTemplate::ValueProvider {
 private:
   data::stream::BufferOutputStream m_buffStream;
+  const std::vector<v_int64>* m_arities;
 public:
+
+  /**
+   * Constructor. Each variable is substituted with a single placeholder.
+   */
+  TemplateValueProvider();
+
+  /**
+   * Constructor.
+   * @param arities - number of placeholders per variable. Negative - a single placeholder (scalar parameter),
+   * `N >= 0` - comma separated list of `N` placeholders (collection parameter).
+   */
+  TemplateValueProvider(const std::vector<v_int64>* arities);
+
   oatpp::String getValue(const data::share::StringTemplate::Variable& variable, v_uint32 index) override;
+
 };
 
 }}}
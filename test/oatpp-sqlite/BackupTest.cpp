@@ -0,0 +1,198 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "BackupTest.hpp"
+
+#include "oatpp-sqlite/orm.hpp"
+
+#include <cstdio>
+#include <string>
+
+namespace oatpp { namespace test { namespace sqlite {
+
+namespace {
+
+#include OATPP_CODEGEN_BEGIN(DTO)
+
+class CountRow : public oatpp::DTO {
+
+  DTO_INIT(CountRow, DTO);
+
+  DTO_FIELD(Int64, count);
+
+};
+
+#include OATPP_CODEGEN_END(DTO)
+
+#include OATPP_CODEGEN_BEGIN(DbClient)
+
+class MyClient : public oatpp::orm::DbClient {
+public:
+
+  MyClient(const std::shared_ptr<oatpp::orm::Executor>& executor, bool migrate)
+    : oatpp::orm::DbClient(executor)
+  {
+    if(migrate) {
+      oatpp::orm::SchemaMigration migration(executor, "BackupTest");
+      migration.addFile(1, TEST_DB_MIGRATION "BackupTest.sql");
+      migration.migrate();
+    }
+  }
+
+  QUERY(insertRow,
+        "INSERT INTO test_backup (f_data) VALUES (:f_data)",
+        PARAM(String, f_data))
+
+  QUERY(countRows, "SELECT count(*) AS count FROM test_backup")
+
+};
+
+#include OATPP_CODEGEN_END(DbClient)
+
+v_int64 countRows(MyClient& client) {
+  auto rows = client.countRows()->fetch<oatpp::Vector<oatpp::Object<CountRow>>>();
+  OATPP_ASSERT(rows->size() == 1);
+  return rows[0]->count;
+}
+
+}
+
+void BackupTest::onRun() {
+
+  OATPP_LOGi(TAG, "DB-File='{}'", TEST_DB_FILE);
+  std::remove(TEST_DB_FILE);
+
+  oatpp::String backupFile = TEST_DB_FILE ".backup";
+  std::remove(backupFile->c_str());
+
+  auto connectionProvider = std::make_shared<oatpp::sqlite::ConnectionProvider>(TEST_DB_FILE);
+  auto executor = std::make_shared<oatpp::sqlite::Executor>(connectionProvider);
+
+  auto client = MyClient(executor, true);
+
+  {
+    auto connection = client.getConnection();
+    for(v_int32 i = 0; i < 1000; i ++) {
+      client.insertRow(oatpp::String("Some data to fill database pages - " + std::to_string(i)), connection);
+    }
+  }
+
+  OATPP_ASSERT(countRows(client) == 1000);
+
+  {
+    oatpp::sqlite::Backup::Config config;
+    config.pagesPerStep = 4;
+    config.stepInterval = std::chrono::milliseconds(0);
+
+    v_int64 callbacksCount = 0;
+    v_int64 lastRemaining = -1;
+
+    bool complete = oatpp::sqlite::Backup::copyToFile(client.getConnection(), backupFile, config,
+                                                     [&](const oatpp::sqlite::Backup::Progress& progress) {
+      callbacksCount ++;
+      lastRemaining = progress.remainingPages;
+      return true;
+    });
+
+    OATPP_ASSERT(complete);
+    OATPP_ASSERT(callbacksCount > 1);
+    OATPP_ASSERT(lastRemaining == 0);
+  }
+
+  {
+    auto backupProvider = std::make_shared<oatpp::sqlite::ConnectionProvider>(backupFile);
+    auto backupExecutor = std::make_shared<oatpp::sqlite::Executor>(backupProvider);
+    auto backupClient = MyClient(backupExecutor, false);
+    OATPP_ASSERT(countRows(backupClient) == 1000);
+  }
+
+  /* source is modified by another connection between steps - each write restarts the copy */
+  {
+    oatpp::sqlite::Backup::Config config;
+    config.pagesPerStep = 4;
+    config.stepInterval = std::chrono::milliseconds(0);
+
+    v_int64 writesCount = 0;
+    v_int64 restarts = 0;
+
+    bool complete = oatpp::sqlite::Backup::copyToFile(client.getConnection(), backupFile, config,
+                                                     [&](const oatpp::sqlite::Backup::Progress& progress) {
+      restarts = progress.restarts;
+      if(progress.remainingPages > 0 && writesCount < 3) {
+        client.insertRow("written during backup");
+        writesCount ++;
+      }
+      return true;
+    });
+
+    OATPP_ASSERT(complete);
+    OATPP_ASSERT(restarts == 3);
+
+    auto backupProvider = std::make_shared<oatpp::sqlite::ConnectionProvider>(backupFile);
+    auto backupExecutor = std::make_shared<oatpp::sqlite::Executor>(backupProvider);
+    auto backupClient = MyClient(backupExecutor, false);
+    OATPP_ASSERT(countRows(backupClient) == 1003);
+  }
+
+  /* source is modified between all steps - backup fails once max restarts are exceeded */
+  {
+    oatpp::sqlite::Backup::Config config;
+    config.pagesPerStep = 4;
+    config.stepInterval = std::chrono::milliseconds(0);
+    config.maxRestarts = 5;
+
+    v_int64 writesCount = 0;
+    bool failed = false;
+
+    try {
+      oatpp::sqlite::Backup::copyToFile(client.getConnection(), backupFile, config,
+                                        [&](const oatpp::sqlite::Backup::Progress& progress) {
+        (void) progress;
+        client.insertRow("written during backup");
+        writesCount ++;
+        return true;
+      });
+    } catch (const std::runtime_error& e) {
+      OATPP_LOGd(TAG, "expected error: {}", e.what());
+      failed = true;
+    }
+
+    OATPP_ASSERT(failed);
+    OATPP_ASSERT(writesCount == config.maxRestarts + 1);
+  }
+
+  {
+    bool complete = oatpp::sqlite::Backup::copyToFile(client.getConnection(), backupFile, oatpp::sqlite::Backup::Config(),
+                                                     [](const oatpp::sqlite::Backup::Progress& progress) {
+      (void) progress;
+      return false;
+    });
+    OATPP_ASSERT(!complete);
+  }
+
+  std::remove(backupFile->c_str());
+
+}
+
+}}}
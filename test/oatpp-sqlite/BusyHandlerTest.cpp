@@ -0,0 +1,153 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "BusyHandlerTest.hpp"
+
+#include "oatpp-sqlite/orm.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+namespace oatpp { namespace test { namespace sqlite {
+
+namespace {
+
+#include OATPP_CODEGEN_BEGIN(DbClient)
+
+class MyClient : public oatpp::orm::DbClient {
+public:
+
+  MyClient(const std::shared_ptr<oatpp::orm::Executor>& executor)
+    : oatpp::orm::DbClient(executor)
+  {}
+
+  QUERY(createTable,
+        "CREATE TABLE IF NOT EXISTS test_busy (f_id INTEGER PRIMARY KEY, f_name VARCHAR)")
+
+  QUERY(insertRow,
+        "INSERT INTO test_busy (f_id, f_name) VALUES (:f_id, :f_name)",
+        PARAM(Int64, f_id),
+        PARAM(String, f_name))
+
+  QUERY(insertOtherRow,
+        "INSERT INTO test_busy (f_id, f_name) VALUES (:f_id, 'other')",
+        PARAM(Int64, f_id))
+
+};
+
+#include OATPP_CODEGEN_END(DbClient)
+
+}
+
+void BusyHandlerTest::onRun() {
+
+  oatpp::String file = TEST_DB_FILE ".busy";
+  std::remove(file->c_str());
+
+  {
+
+    oatpp::sqlite::BusyHandler::Config config;
+    config.maxWait = std::chrono::milliseconds(100);
+    auto busyHandler = std::make_shared<oatpp::sqlite::BusyHandler>(config);
+
+    auto connectionProvider = std::make_shared<oatpp::sqlite::ConnectionProvider>(file);
+    connectionProvider->setBusyHandler(busyHandler);
+    OATPP_ASSERT(connectionProvider->getBusyHandler() == busyHandler);
+
+    auto executor = std::make_shared<oatpp::sqlite::Executor>(connectionProvider);
+
+    MyClient client(executor);
+    OATPP_ASSERT(client.createTable()->isSuccess());
+    busyHandler->resetStats();
+
+    /* write lock is held by another connection longer than maxWait - query fails with SQLITE_BUSY */
+    {
+      auto holder = executor->getConnection();
+      OATPP_ASSERT(executor->begin(oatpp::sqlite::Executor::TransactionMode::IMMEDIATE, holder)->isSuccess());
+
+      auto start = std::chrono::steady_clock::now();
+      auto result = client.insertRow(1, "one");
+      auto elapsed = std::chrono::steady_clock::now() - start;
+
+      OATPP_ASSERT(result->isSuccess() == false);
+      OATPP_ASSERT(std::static_pointer_cast<oatpp::sqlite::QueryResult>(result)->getErrorCode() == SQLITE_BUSY);
+      OATPP_ASSERT(elapsed >= std::chrono::milliseconds(100));
+
+      auto stats = busyHandler->getStats();
+      OATPP_ASSERT(stats.size() == 1);
+      auto& insertStats = stats.at("insertRow");
+      OATPP_ASSERT(insertStats.waitsCount == 1);
+      OATPP_ASSERT(insertStats.timeoutsCount == 1);
+      OATPP_ASSERT(insertStats.maxWaitTime >= 100 * 1000);
+
+      OATPP_ASSERT(executor->rollback(holder)->isSuccess());
+    }
+
+    /* lock is released within maxWait - query waits and succeeds */
+    {
+      auto holder = executor->getConnection();
+      OATPP_ASSERT(executor->begin(oatpp::sqlite::Executor::TransactionMode::IMMEDIATE, holder)->isSuccess());
+
+      std::thread releaser([executor, holder]{
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        executor->commit(holder);
+      });
+
+      auto result = client.insertOtherRow(2);
+      releaser.join();
+
+      OATPP_ASSERT(result->isSuccess());
+
+      auto stats = busyHandler->getStats();
+      OATPP_ASSERT(stats.size() == 2);
+      auto& insertStats = stats.at("insertRow");
+      OATPP_ASSERT(insertStats.waitsCount == 1);
+      OATPP_ASSERT(insertStats.timeoutsCount == 1);
+      auto& otherStats = stats.at("insertOtherRow");
+      OATPP_ASSERT(otherStats.waitsCount == 1);
+      OATPP_ASSERT(otherStats.timeoutsCount == 0);
+      OATPP_ASSERT(otherStats.totalWaitTime > 0);
+    }
+
+    /* handler removed - existing and new connections fail right away */
+    {
+      connectionProvider->setBusyHandler(nullptr);
+      busyHandler->resetStats();
+
+      auto holder = executor->getConnection();
+      OATPP_ASSERT(executor->begin(oatpp::sqlite::Executor::TransactionMode::IMMEDIATE, holder)->isSuccess());
+      auto result = client.insertRow(3, "three");
+      OATPP_ASSERT(std::static_pointer_cast<oatpp::sqlite::QueryResult>(result)->getErrorCode() == SQLITE_BUSY);
+      OATPP_ASSERT(busyHandler->getStats().empty());
+      OATPP_ASSERT(executor->rollback(holder)->isSuccess());
+    }
+
+  }
+
+  std::remove(file->c_str());
+
+}
+
+}}}
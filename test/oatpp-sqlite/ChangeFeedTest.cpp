@@ -0,0 +1,191 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#include "ChangeFeedTest.hpp"
+
+#include "oatpp-sqlite/orm.hpp"
+
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+namespace oatpp { namespace test { namespace sqlite {
+
+namespace {
+
+#include OATPP_CODEGEN_BEGIN(DbClient)
+
+class MyClient : public oatpp::orm::DbClient {
+public:
+
+  MyClient(const std::shared_ptr<oatpp::orm::Executor>& executor)
+    : oatpp::orm::DbClient(executor)
+  {}
+
+  QUERY(createTable,
+        "CREATE TABLE IF NOT EXISTS test_feed (f_id INTEGER PRIMARY KEY, f_name VARCHAR)")
+
+  QUERY(insertRow,
+        "INSERT INTO test_feed (f_id, f_name) VALUES (:f_id, :f_name)",
+        PARAM(Int64, f_id),
+        PARAM(String, f_name))
+
+  QUERY(countRows, "SELECT count(*) FROM test_feed")
+
+};
+
+#include OATPP_CODEGEN_END(DbClient)
+
+class BatchCollector {
+private:
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  std::vector<oatpp::sqlite::ChangeFeed::Batch> m_batches;
+public:
+
+  void onBatch(const oatpp::sqlite::ChangeFeed::Batch& batch) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_batches.push_back(batch);
+    }
+    m_condition.notify_all();
+  }
+
+  std::vector<oatpp::sqlite::ChangeFeed::Batch> waitFor(size_t count) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condition.wait_for(lock, std::chrono::seconds(5), [this, count]{
+      return m_batches.size() >= count;
+    });
+    return m_batches;
+  }
+
+};
+
+void assertInserted(const oatpp::sqlite::ChangeFeed::Batch& batch, const std::vector<v_int64>& rowIds) {
+  OATPP_ASSERT(batch.overflow == false);
+  OATPP_ASSERT(batch.tables.size() == 1);
+  OATPP_ASSERT(batch.tables.find("test_feed") != batch.tables.end());
+  OATPP_ASSERT(batch.changes.size() == rowIds.size());
+  for(size_t i = 0; i < rowIds.size(); i ++) {
+    OATPP_ASSERT(batch.changes[i].operation == SQLITE_INSERT);
+    OATPP_ASSERT(batch.changes[i].table == "test_feed");
+    OATPP_ASSERT(batch.changes[i].rowId == rowIds[i]);
+  }
+}
+
+}
+
+void ChangeFeedTest::onRun() {
+
+  oatpp::String file = TEST_DB_FILE ".feed";
+  std::remove(file->c_str());
+
+  auto feed = std::make_shared<oatpp::sqlite::ChangeFeed>();
+  auto collector = std::make_shared<BatchCollector>();
+  feed->subscribe({"test_feed"}, [collector](const oatpp::sqlite::ChangeFeed::Batch& batch) {
+    collector->onBatch(batch);
+  });
+
+  {
+
+    auto connectionProvider = std::make_shared<oatpp::sqlite::ConnectionProvider>(file);
+    connectionProvider->addChangeListener(feed);
+    auto executor = std::make_shared<oatpp::sqlite::Executor>(connectionProvider);
+
+    MyClient client(executor);
+    OATPP_ASSERT(client.createTable()->isSuccess());
+
+    /* rolled back - nothing is published */
+    {
+      auto connection = executor->getConnection();
+      OATPP_ASSERT(executor->begin(connection)->isSuccess());
+      OATPP_ASSERT(client.insertRow(1, "one", connection)->isSuccess());
+      OATPP_ASSERT(client.insertRow(2, "two", connection)->isSuccess());
+      OATPP_ASSERT(executor->rollback(connection)->isSuccess());
+    }
+
+    /* committed - published with the rowids of the transaction */
+    {
+      auto connection = executor->getConnection();
+      OATPP_ASSERT(executor->begin(connection)->isSuccess());
+      OATPP_ASSERT(client.insertRow(3, "three", connection)->isSuccess());
+      OATPP_ASSERT(client.insertRow(4, "four", connection)->isSuccess());
+      OATPP_ASSERT(executor->commit(connection)->isSuccess());
+    }
+
+    {
+      auto batches = collector->waitFor(1);
+      OATPP_ASSERT(batches.size() == 1);
+      assertInserted(batches[0], {3, 4});
+    }
+
+    /* COMMIT fails with SQLITE_BUSY - nothing is published until COMMIT is retried */
+    {
+
+      auto reader = executor->getConnection();
+      auto writer = executor->getConnection();
+
+      OATPP_ASSERT(executor->begin(oatpp::sqlite::Executor::TransactionMode::DEFERRED, reader)->isSuccess());
+      OATPP_ASSERT(client.countRows(reader)->isSuccess());
+
+      OATPP_ASSERT(executor->begin(oatpp::sqlite::Executor::TransactionMode::DEFERRED, writer)->isSuccess());
+      OATPP_ASSERT(client.insertRow(5, "five", writer)->isSuccess());
+
+      auto res = executor->commit(writer);
+      OATPP_ASSERT(!res->isSuccess());
+      OATPP_ASSERT((std::static_pointer_cast<oatpp::sqlite::QueryResult>(res)->getErrorCode() & 0xFF) == SQLITE_BUSY);
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      OATPP_ASSERT(collector->waitFor(1).size() == 1);
+
+      OATPP_ASSERT(executor->rollback(reader)->isSuccess());
+      OATPP_ASSERT(executor->commit(writer)->isSuccess());
+
+      auto batches = collector->waitFor(2);
+      OATPP_ASSERT(batches.size() == 2);
+      assertInserted(batches[1], {5});
+
+    }
+
+    /* autocommit statement */
+    {
+      OATPP_ASSERT(client.insertRow(6, "six")->isSuccess());
+      auto batches = collector->waitFor(3);
+      OATPP_ASSERT(batches.size() == 3);
+      assertInserted(batches[2], {6});
+    }
+
+    auto count = client.countRows()->fetch<oatpp::Vector<oatpp::Vector<oatpp::Int64>>>();
+    OATPP_ASSERT(count[0][0] == 4);
+
+  }
+
+  feed->stop();
+  OATPP_ASSERT(collector->waitFor(4).size() == 3);
+
+}
+
+}}}
@@ -0,0 +1,141 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#include "CheckpointManagerTest.hpp"
+
+#include "oatpp-sqlite/orm.hpp"
+
+#include <cstdio>
+#include <functional>
+#include <thread>
+
+namespace oatpp { namespace test { namespace sqlite {
+
+namespace {
+
+#include OATPP_CODEGEN_BEGIN(DbClient)
+
+class MyClient : public oatpp::orm::DbClient {
+public:
+
+  MyClient(const std::shared_ptr<oatpp::orm::Executor>& executor)
+    : oatpp::orm::DbClient(executor)
+  {}
+
+  QUERY(createTable,
+        "CREATE TABLE IF NOT EXISTS test_checkpoint (f_id INTEGER PRIMARY KEY, f_data BLOB)")
+
+  QUERY(insertRow,
+        "INSERT INTO test_checkpoint (f_data) VALUES (randomblob(16))")
+
+  /* every row takes at least one page - at least :count WAL frames per call */
+  QUERY(insertPages,
+        "WITH RECURSIVE seq(n) AS (SELECT 1 UNION ALL SELECT n + 1 FROM seq WHERE n < :count) "
+        "INSERT INTO test_checkpoint (f_data) SELECT randomblob(3000) FROM seq",
+        PARAM(Int64, count))
+
+};
+
+#include OATPP_CODEGEN_END(DbClient)
+
+bool waitFor(const std::function<bool()>& condition) {
+  for(v_int32 i = 0; i < 500; i ++) {
+    if(condition()) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return condition();
+}
+
+}
+
+void CheckpointManagerTest::onRun() {
+
+  oatpp::String file = TEST_DB_FILE ".checkpoint";
+  std::remove(file->c_str());
+
+  {
+
+    auto connectionProvider = std::make_shared<oatpp::sqlite::ConnectionProvider>(file);
+    connectionProvider->addInitHook("wal", [](sqlite3* handle) {
+      sqlite3_exec(handle, "PRAGMA journal_mode=WAL", nullptr, nullptr, nullptr);
+    });
+
+    oatpp::sqlite::CheckpointManager::Config config;
+    config.passiveFrames = 10;
+    config.restartFrames = 50;
+    config.truncateFrames = 200;
+    config.interval = std::chrono::hours(1); // checkpoints are triggered by WAL size only
+
+    auto manager = std::make_shared<oatpp::sqlite::CheckpointManager>(connectionProvider, config);
+    connectionProvider->addChangeListener(manager);
+
+    auto pool = oatpp::sqlite::ConnectionPool::createShared(connectionProvider, 2, std::chrono::seconds(60));
+    auto executor = std::make_shared<oatpp::sqlite::Executor>(pool);
+
+    MyClient client(executor);
+    OATPP_ASSERT(client.createTable()->isSuccess());
+
+    /* below the passive threshold - nothing runs */
+    OATPP_ASSERT(client.insertRow()->isSuccess());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    {
+      auto stats = manager->getStats();
+      OATPP_ASSERT(stats.walFrames > 0 && stats.walFrames < config.passiveFrames);
+      OATPP_ASSERT(stats.passiveCount == 0);
+    }
+
+    /* small commits pass the passive threshold */
+    for(v_int32 i = 0; i < 20; i ++) {
+      OATPP_ASSERT(client.insertRow()->isSuccess());
+    }
+    OATPP_ASSERT(waitFor([&manager]{ return manager->getStats().passiveCount > 0; }));
+
+    /* single commit passes the restart threshold */
+    OATPP_ASSERT(client.insertPages(100)->isSuccess());
+    OATPP_ASSERT(waitFor([&manager]{ return manager->getStats().restartCount > 0; }));
+
+    /* single commit passes the truncate threshold */
+    OATPP_ASSERT(client.insertPages(300)->isSuccess());
+    OATPP_ASSERT(waitFor([&manager]{ return manager->getStats().truncateCount > 0; }));
+
+    {
+      auto stats = manager->getStats();
+      OATPP_LOGd(TAG, "passive={}, restart={}, truncate={}, busy={}, maxDuration={}us",
+                 stats.passiveCount, stats.restartCount, stats.truncateCount, stats.busyCount, stats.maxDuration);
+      OATPP_ASSERT(stats.errorCount == 0);
+      OATPP_ASSERT(stats.walFrames == 0);
+      OATPP_ASSERT(stats.walSize == 0);
+    }
+
+    manager->stop();
+    pool->stop();
+
+  }
+
+}
+
+}}}
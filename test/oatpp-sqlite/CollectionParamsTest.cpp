@@ -0,0 +1,143 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#include "CollectionParamsTest.hpp"
+
+#include "oatpp-sqlite/orm.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+namespace oatpp { namespace test { namespace sqlite {
+
+namespace {
+
+#include OATPP_CODEGEN_BEGIN(DbClient)
+
+class MyClient : public oatpp::orm::DbClient {
+public:
+
+  MyClient(const std::shared_ptr<oatpp::orm::Executor>& executor)
+    : oatpp::orm::DbClient(executor)
+  {}
+
+  QUERY(createTable,
+        "CREATE TABLE IF NOT EXISTS test_in (f_id INTEGER PRIMARY KEY)")
+
+  QUERY(fillTable,
+        "WITH RECURSIVE seq(n) AS (SELECT 1 UNION ALL SELECT n + 1 FROM seq WHERE n < 10) "
+        "INSERT INTO test_in (f_id) SELECT n FROM seq")
+
+  QUERY(selectByIds,
+        "SELECT f_id FROM test_in WHERE f_id IN (:ids) ORDER BY f_id",
+        PARAM(oatpp::Vector<oatpp::Int64>, ids))
+
+};
+
+#include OATPP_CODEGEN_END(DbClient)
+
+std::vector<v_int64> selectByIds(MyClient& client,
+                                 const oatpp::Vector<oatpp::Int64>& ids,
+                                 const oatpp::provider::ResourceHandle<oatpp::orm::Connection>& connection)
+{
+  auto res = client.selectByIds(ids, connection);
+  OATPP_ASSERT(res->isSuccess());
+  auto rows = res->fetch<oatpp::Vector<oatpp::Vector<oatpp::Int64>>>();
+  std::vector<v_int64> result;
+  for(auto& row : *rows) {
+    result.push_back(*row[0]);
+  }
+  return result;
+}
+
+/*
+ * Number of statements prepared on the connection for selectByIds - including cached ones.
+ */
+v_int32 countStatements(const oatpp::provider::ResourceHandle<oatpp::orm::Connection>& connection) {
+  auto handle = std::static_pointer_cast<oatpp::sqlite::Connection>(connection.object)->getHandle();
+  v_int32 count = 0;
+  sqlite3_stmt* stmt = sqlite3_next_stmt(handle, nullptr);
+  while(stmt) {
+    if(std::strstr(sqlite3_sql(stmt), "WHERE f_id IN (") != nullptr) {
+      count ++;
+    }
+    stmt = sqlite3_next_stmt(handle, stmt);
+  }
+  return count;
+}
+
+}
+
+void CollectionParamsTest::onRun() {
+
+  oatpp::String file = TEST_DB_FILE ".collection";
+  std::remove(file->c_str());
+
+  auto connectionProvider = std::make_shared<oatpp::sqlite::ConnectionProvider>(file);
+
+  {
+
+    auto executor = std::make_shared<oatpp::sqlite::Executor>(connectionProvider);
+    MyClient client(executor);
+
+    auto connection = executor->getConnection();
+
+    OATPP_ASSERT(client.createTable(connection)->isSuccess());
+    OATPP_ASSERT(client.fillTable(connection)->isSuccess());
+
+    /* 3 and 4 items are padded to the same arity - one statement */
+    OATPP_ASSERT(selectByIds(client, {3, 1, 7}, connection) == std::vector<v_int64>({1, 3, 7}));
+    OATPP_ASSERT(selectByIds(client, {1, 2, 3, 4}, connection) == std::vector<v_int64>({1, 2, 3, 4}));
+    OATPP_ASSERT(selectByIds(client, {8, 2, 9}, connection) == std::vector<v_int64>({2, 8, 9}));
+    OATPP_ASSERT(countStatements(connection) == 1);
+
+    OATPP_ASSERT(selectByIds(client, {5}, connection) == std::vector<v_int64>({5}));
+    OATPP_ASSERT(countStatements(connection) == 2);
+
+    /* empty and null collections expand to IN () */
+    OATPP_ASSERT(selectByIds(client, oatpp::Vector<oatpp::Int64>::createShared(), connection).empty());
+    OATPP_ASSERT(selectByIds(client, nullptr, connection).empty());
+    OATPP_ASSERT(countStatements(connection) == 3);
+
+  }
+
+  /* padded arity exceeds SQLITE_LIMIT_VARIABLE_NUMBER - exact size is used */
+  {
+
+    auto executor = std::make_shared<oatpp::sqlite::Executor>(connectionProvider);
+    MyClient client(executor);
+
+    auto connection = executor->getConnection();
+    sqlite3_limit(std::static_pointer_cast<oatpp::sqlite::Connection>(connection.object)->getHandle(),
+                  SQLITE_LIMIT_VARIABLE_NUMBER, 6);
+
+    OATPP_ASSERT(selectByIds(client, {1, 2, 3, 4, 5}, connection) == std::vector<v_int64>({1, 2, 3, 4, 5}));
+    OATPP_ASSERT(selectByIds(client, {2, 3}, connection) == std::vector<v_int64>({2, 3}));
+
+  }
+
+}
+
+}}}
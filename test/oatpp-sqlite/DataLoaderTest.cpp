@@ -0,0 +1,147 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "DataLoaderTest.hpp"
+
+#include "oatpp-sqlite/orm.hpp"
+
+#include <cstdio>
+
+namespace oatpp { namespace test { namespace sqlite {
+
+namespace {
+
+#include OATPP_CODEGEN_BEGIN(DTO)
+
+class UserRow : public oatpp::DTO {
+
+  DTO_INIT(UserRow, DTO);
+
+  DTO_FIELD(Int64, id);
+  DTO_FIELD(String, name);
+
+};
+
+#include OATPP_CODEGEN_END(DTO)
+
+#include OATPP_CODEGEN_BEGIN(DbClient)
+
+class MyClient : public oatpp::orm::DbClient {
+public:
+
+  MyClient(const std::shared_ptr<oatpp::orm::Executor>& executor)
+    : oatpp::orm::DbClient(executor)
+  {
+    oatpp::orm::SchemaMigration migration(executor, "DataLoaderTest");
+    migration.addFile(1, TEST_DB_MIGRATION "DataLoaderTest.sql");
+    migration.migrate();
+  }
+
+  QUERY(getUsersByIds,
+        "SELECT * FROM test_loader_users WHERE id IN (SELECT value FROM json_each(:ids))",
+        PARAM(String, ids))
+
+};
+
+#include OATPP_CODEGEN_END(DbClient)
+
+typedef oatpp::sqlite::DataLoader<oatpp::Int64, oatpp::Object<UserRow>> UserLoader;
+
+}
+
+void DataLoaderTest::onRun() {
+
+  OATPP_LOGi(TAG, "DB-File='{}'", TEST_DB_FILE);
+  std::remove(TEST_DB_FILE);
+
+  auto connectionProvider = std::make_shared<oatpp::sqlite::ConnectionProvider>(TEST_DB_FILE);
+  auto executor = std::make_shared<oatpp::sqlite::Executor>(connectionProvider);
+
+  auto client = MyClient(executor);
+
+  v_int64 batchesCount = 0;
+
+  UserLoader loader([&](const oatpp::Vector<oatpp::Int64>& ids) {
+    batchesCount ++;
+    auto res = client.getUsersByIds(UserLoader::toJsonArray(ids));
+    OATPP_ASSERT(res->isSuccess());
+    return res->fetch<oatpp::Vector<oatpp::Object<UserRow>>>();
+  }, [](const oatpp::Object<UserRow>& user) {
+    return user->id;
+  });
+
+  {
+    auto u3 = loader.load(3);
+    auto u1 = loader.load(1);
+    auto u404 = loader.load(404);
+    auto u1Again = loader.load(1);
+
+    loader.dispatch();
+
+    OATPP_ASSERT(batchesCount == 1);
+    OATPP_ASSERT(u3.get()->name == "three");
+    OATPP_ASSERT(u1.get()->name == "one");
+    OATPP_ASSERT(u1Again.get()->name == "one");
+    OATPP_ASSERT(u404.get() == nullptr);
+  }
+
+  {
+    auto user = loader.get(1);
+    OATPP_ASSERT(user->name == "one");
+    OATPP_ASSERT(batchesCount == 1);
+  }
+
+  {
+    auto user = loader.get(2);
+    OATPP_ASSERT(user->name == "two");
+    OATPP_ASSERT(batchesCount == 2);
+  }
+
+  {
+    UserLoader::Config config;
+    config.maxBatchSize = 2;
+
+    v_int64 smallBatchesCount = 0;
+    UserLoader smallLoader([&](const oatpp::Vector<oatpp::Int64>& ids) {
+      smallBatchesCount ++;
+      OATPP_ASSERT(ids->size() <= 2);
+      return client.getUsersByIds(UserLoader::toJsonArray(ids))->fetch<oatpp::Vector<oatpp::Object<UserRow>>>();
+    }, [](const oatpp::Object<UserRow>& user) {
+      return user->id;
+    }, config);
+
+    auto u1 = smallLoader.load(1);
+    auto u2 = smallLoader.load(2);
+    OATPP_ASSERT(smallBatchesCount == 1);
+    auto u3 = smallLoader.load(3);
+    smallLoader.dispatch();
+    OATPP_ASSERT(smallBatchesCount == 2);
+    OATPP_ASSERT(u1.get()->name == "one");
+    OATPP_ASSERT(u2.get()->name == "two");
+    OATPP_ASSERT(u3.get()->name == "three");
+  }
+
+}
+
+}}}
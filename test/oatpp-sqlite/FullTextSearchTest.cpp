@@ -0,0 +1,266 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#include "FullTextSearchTest.hpp"
+
+#include "oatpp-sqlite/orm.hpp"
+
+#include <cstdio>
+
+namespace oatpp { namespace test { namespace sqlite {
+
+namespace {
+
+const oatpp::sqlite::FullTextSearch& getFts() {
+  static oatpp::sqlite::FullTextSearch fts([] {
+    oatpp::sqlite::FullTextSearch::Config config;
+    config.table = "test_docs_fts";
+    config.contentTable = "test_docs";
+    config.contentRowId = "f_id";
+    config.columns = {"f_title", "f_body"};
+    config.tokenize = "porter unicode61";
+    return config;
+  }());
+  return fts;
+}
+
+oatpp::sqlite::FullTextSearch::SearchOptions getSearchOptions() {
+  oatpp::sqlite::FullTextSearch::SearchOptions options;
+  options.resultColumns = "c.f_id, c.f_title";
+  options.weights = {10.0, 1.0};
+  options.snippetColumn = "f_body";
+  options.snippetTokens = 4;
+  options.highlightColumn = "f_title";
+  options.open = "[";
+  options.close = "]";
+  return options;
+}
+
+#include OATPP_CODEGEN_BEGIN(DTO)
+
+class SearchRow : public oatpp::DTO {
+
+  DTO_INIT(SearchRow, DTO);
+
+  DTO_FIELD(Int64, f_id);
+  DTO_FIELD(String, f_title);
+  DTO_FIELD(Float64, rank);
+  DTO_FIELD(String, snippet);
+  DTO_FIELD(String, highlight);
+
+};
+
+class CountRow : public oatpp::DTO {
+
+  DTO_INIT(CountRow, DTO);
+
+  DTO_FIELD(Int64, f_count);
+
+};
+
+#include OATPP_CODEGEN_END(DTO)
+
+#include OATPP_CODEGEN_BEGIN(DbClient)
+
+class MyClient : public oatpp::orm::DbClient {
+public:
+
+  MyClient(const std::shared_ptr<oatpp::orm::Executor>& executor)
+    : oatpp::orm::DbClient(executor)
+  {}
+
+  QUERY(insertDoc,
+        "INSERT INTO test_docs (f_title, f_body) VALUES (:title, :body)",
+        PARAM(String, title),
+        PARAM(String, body))
+
+  QUERY(generateDocs,
+        "WITH RECURSIVE seq(n) AS (SELECT 1 UNION ALL SELECT n + 1 FROM seq WHERE n < :count) "
+        "INSERT INTO test_docs (f_title, f_body) "
+        "SELECT printf('generated %d', n), printf('text alpha%d beta%d gamma%d end', n % 1000, n % 1013, n % 997) FROM seq",
+        PARAM(Int64, count))
+
+  QUERY(updateTitle,
+        "UPDATE test_docs SET f_title=:title WHERE f_id=:id",
+        PARAM(Int64, id),
+        PARAM(String, title))
+
+  QUERY(updateViews,
+        "UPDATE test_docs SET f_views=f_views + 1 WHERE f_id=:id",
+        PARAM(Int64, id))
+
+  QUERY(deleteDoc,
+        "DELETE FROM test_docs WHERE f_id=:id",
+        PARAM(Int64, id))
+
+  QUERY(search,
+        getFts().getSearchQuery(getSearchOptions()),
+        PARAM(String, query),
+        PARAM(Int64, limit))
+
+  QUERY(countMatch,
+        "SELECT count(*) AS f_count FROM test_docs_fts WHERE test_docs_fts MATCH :query",
+        PARAM(String, query))
+
+  QUERY(countLike,
+        "SELECT count(*) AS f_count FROM test_docs WHERE f_body LIKE :pattern",
+        PARAM(String, pattern))
+
+};
+
+#include OATPP_CODEGEN_END(DbClient)
+
+}
+
+void FullTextSearchTest::onRun() {
+
+  oatpp::String file = TEST_DB_FILE ".fts";
+  std::remove(file->c_str());
+
+  {
+
+    OATPP_ASSERT(oatpp::sqlite::FullTextSearch::escapeQuery("  hello \"big\" world ") == "\"hello\" \"\"\"big\"\"\" \"world\"");
+    OATPP_ASSERT(oatpp::sqlite::FullTextSearch::escapeQuery("fo", true) == "\"fo\"*");
+    OATPP_ASSERT(oatpp::sqlite::FullTextSearch::escapeQuery("   ", true) == "");
+
+    auto connectionProvider = std::make_shared<oatpp::sqlite::ConnectionProvider>(file);
+    auto pool = oatpp::sqlite::ConnectionPool::createShared(connectionProvider, 2, std::chrono::seconds(60));
+    auto executor = std::make_shared<oatpp::sqlite::Executor>(pool);
+
+    oatpp::orm::SchemaMigration migration(executor, "FullTextSearchTest");
+    migration.addFile(1, TEST_DB_MIGRATION "FullTextSearchTest.sql");
+    migration.addText(2, getFts().getCreateScript());
+    migration.migrate();
+
+    MyClient client(executor);
+
+    {
+      auto rows = client.search("\"rebuild\"", 10)->fetch<oatpp::Vector<oatpp::Object<SearchRow>>>();
+      OATPP_ASSERT(rows->size() == 1);
+      OATPP_ASSERT(*rows[0]->f_id == 1);
+    }
+
+    OATPP_ASSERT(client.insertDoc("fox news", "nothing to see here")->isSuccess());
+    OATPP_ASSERT(client.insertDoc("hello world", "the quick brown fox jumps over the lazy dog again and again")->isSuccess());
+
+    {
+      auto rows = client.search(oatpp::sqlite::FullTextSearch::escapeQuery("fox"), 10)->fetch<oatpp::Vector<oatpp::Object<SearchRow>>>();
+      OATPP_ASSERT(rows->size() == 2);
+
+      /* match in the title weighs more */
+      OATPP_ASSERT(*rows[0]->f_id == 2);
+      OATPP_ASSERT(*rows[0]->rank <= *rows[1]->rank);
+      OATPP_ASSERT(rows[0]->highlight == "[fox] news");
+
+      OATPP_ASSERT(*rows[1]->f_id == 3);
+      OATPP_LOGd(TAG, "snippet='{}'", rows[1]->snippet);
+      OATPP_ASSERT(rows[1]->snippet == "the quick brown [fox]...");
+    }
+
+    {
+      auto rows = client.search(oatpp::sqlite::FullTextSearch::escapeQuery("jump"), 10)->fetch<oatpp::Vector<oatpp::Object<SearchRow>>>();
+      OATPP_ASSERT(rows->size() == 1); // porter stemmer
+    }
+
+    {
+      OATPP_ASSERT(client.updateTitle(2, "weather report")->isSuccess());
+      OATPP_ASSERT(client.updateViews(3)->isSuccess());
+      OATPP_ASSERT(client.deleteDoc(1)->isSuccess());
+
+      auto count = client.countMatch("\"fox\"")->fetch<oatpp::Vector<oatpp::Object<CountRow>>>();
+      OATPP_ASSERT(*count[0]->f_count == 1);
+      count = client.countMatch("\"weather\"")->fetch<oatpp::Vector<oatpp::Object<CountRow>>>();
+      OATPP_ASSERT(*count[0]->f_count == 1);
+      count = client.countMatch("\"rebuild\"")->fetch<oatpp::Vector<oatpp::Object<CountRow>>>();
+      OATPP_ASSERT(*count[0]->f_count == 0);
+    }
+
+    /* benchmark - LIKE scan vs FTS5 index. Small corpus checks results only - see OATPP_SQLITE_BENCHMARKS */
+
+#ifdef OATPP_SQLITE_BENCHMARKS
+    const v_int64 corpusSize = 50000;
+    const v_int32 iterations = 10;
+#else
+    const v_int64 corpusSize = 2000;
+    const v_int32 iterations = 1;
+#endif
+
+    {
+      v_int64 start = oatpp::Environment::getMicroTickCount();
+      auto connection = client.getConnection();
+      OATPP_ASSERT(client.executeQuery("BEGIN", {}, connection)->isSuccess());
+      OATPP_ASSERT(client.generateDocs(corpusSize, connection)->isSuccess());
+      OATPP_ASSERT(client.executeQuery("COMMIT", {}, connection)->isSuccess());
+      OATPP_LOGi(TAG, "Corpus of {} documents indexed in {} ms", corpusSize, (oatpp::Environment::getMicroTickCount() - start) / 1000);
+    }
+
+    v_int64 likeCount = 0;
+    v_int64 likeTime = 0;
+    {
+      v_int64 start = oatpp::Environment::getMicroTickCount();
+      for(v_int32 i = 0; i < iterations; i ++) {
+        auto count = client.countLike("% alpha7 %")->fetch<oatpp::Vector<oatpp::Object<CountRow>>>();
+        likeCount = *count[0]->f_count;
+      }
+      likeTime = (oatpp::Environment::getMicroTickCount() - start) / iterations;
+    }
+
+    v_int64 matchCount = 0;
+    v_int64 matchTime = 0;
+    {
+      v_int64 start = oatpp::Environment::getMicroTickCount();
+      for(v_int32 i = 0; i < iterations; i ++) {
+        auto count = client.countMatch("\"alpha7\"")->fetch<oatpp::Vector<oatpp::Object<CountRow>>>();
+        matchCount = *count[0]->f_count;
+      }
+      matchTime = (oatpp::Environment::getMicroTickCount() - start) / iterations;
+    }
+
+    v_int64 searchTime = 0;
+    {
+      v_int64 start = oatpp::Environment::getMicroTickCount();
+      for(v_int32 i = 0; i < iterations; i ++) {
+        auto rows = client.search("\"alpha7\" \"beta7\"", 10)->fetch<oatpp::Vector<oatpp::Object<SearchRow>>>();
+        OATPP_ASSERT(rows->size() > 0);
+        OATPP_ASSERT(rows->size() <= 10);
+      }
+      searchTime = (oatpp::Environment::getMicroTickCount() - start) / iterations;
+    }
+
+    OATPP_LOGi(TAG, "Corpus={}, matches={}: LIKE {} us, MATCH {} us, ranked search with snippets {} us",
+               corpusSize, matchCount, likeTime, matchTime, searchTime);
+
+    OATPP_ASSERT(matchCount == corpusSize / 1000);
+    OATPP_ASSERT(likeCount == matchCount);
+
+    pool->stop();
+
+  }
+
+  std::remove(file->c_str());
+
+}
+
+}}}
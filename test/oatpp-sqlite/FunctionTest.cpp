@@ -0,0 +1,239 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#include "FunctionTest.hpp"
+
+#include "oatpp-sqlite/orm.hpp"
+
+#include <cstdio>
+
+namespace oatpp { namespace test { namespace sqlite {
+
+namespace {
+
+#include OATPP_CODEGEN_BEGIN(DTO)
+
+class Row : public oatpp::DTO {
+
+  DTO_INIT(Row, DTO);
+
+  DTO_FIELD(Int64, f_id);
+  DTO_FIELD(String, f_name);
+  DTO_FIELD(Float64, f_value);
+
+};
+
+class ResultRow : public oatpp::DTO {
+
+  DTO_INIT(ResultRow, DTO);
+
+  DTO_FIELD(String, f_string);
+  DTO_FIELD(Float64, f_float);
+
+};
+
+#include OATPP_CODEGEN_END(DTO)
+
+#include OATPP_CODEGEN_BEGIN(DbClient)
+
+class MyClient : public oatpp::orm::DbClient {
+public:
+
+  MyClient(const std::shared_ptr<oatpp::orm::Executor>& executor)
+    : oatpp::orm::DbClient(executor)
+  {}
+
+  QUERY(insertRow,
+        "INSERT INTO test_function (f_name, f_value) VALUES (:row.f_name, :row.f_value)",
+        PARAM(oatpp::Object<Row>, row))
+
+  QUERY(getRepeated,
+        "SELECT repeat_string(f_name, :count) AS f_string FROM test_function ORDER BY f_id",
+        PARAM(Int64, count))
+
+  QUERY(getSumOfSquares,
+        "SELECT sum_sq(f_value) AS f_float FROM test_function")
+
+  QUERY(getSumOfSquaresEmpty,
+        "SELECT sum_sq(f_value) AS f_float FROM test_function WHERE f_id < 0")
+
+  QUERY(getMovingSum,
+        "SELECT moving_sum(f_value) OVER (ORDER BY f_id ROWS BETWEEN 1 PRECEDING AND CURRENT ROW) AS f_float "
+        "FROM test_function ORDER BY f_id")
+
+  QUERY(getNamesByLength,
+        "SELECT f_name AS f_string FROM test_function ORDER BY f_name COLLATE by_length, f_id")
+
+  QUERY(getFailing,
+        "SELECT fail() AS f_string")
+
+};
+
+#include OATPP_CODEGEN_END(DbClient)
+
+}
+
+void FunctionTest::onRun() {
+
+  oatpp::String file = TEST_DB_FILE ".function";
+  std::remove(file->c_str());
+
+  {
+
+    auto connectionProvider = std::make_shared<oatpp::sqlite::ConnectionProvider>(file);
+
+    v_int32 hookRuns = 0;
+    connectionProvider->addInitHook("cache_size", [&hookRuns](sqlite3* handle) {
+      hookRuns ++;
+      sqlite3_exec(handle, "PRAGMA cache_size=-2000", nullptr, nullptr, nullptr);
+    });
+
+    connectionProvider->addFunction(oatpp::sqlite::ScalarFunction::createShared("repeat_string",
+      [](const oatpp::String& str, const oatpp::Int64& count) -> oatpp::String {
+        if(!str || !count) {
+          return nullptr;
+        }
+        std::string result;
+        for(v_int64 i = 0; i < *count; i ++) {
+          result += *str;
+        }
+        return result;
+      }
+    ));
+
+    connectionProvider->addFunction(oatpp::sqlite::ScalarFunction::createShared("fail",
+      []() -> oatpp::String {
+        throw std::runtime_error("function failed");
+      }
+    ));
+
+    connectionProvider->addFunction(oatpp::sqlite::AggregateFunction::createShared("sum_sq",
+      [](v_float64& sum, const oatpp::Float64& x) {
+        if(x) {
+          sum += *x * *x;
+        }
+      },
+      [](const v_float64& sum) -> oatpp::Float64 {
+        return sum;
+      }
+    ));
+
+    connectionProvider->addFunction(oatpp::sqlite::WindowFunction::createShared("moving_sum",
+      [](v_float64& sum, const oatpp::Float64& x) {
+        sum += *x;
+      },
+      [](v_float64& sum, const oatpp::Float64& x) {
+        sum -= *x;
+      },
+      [](const v_float64& sum) -> oatpp::Float64 {
+        return sum;
+      }
+    ));
+
+    connectionProvider->addCollation("by_length", [](const char* a, v_int32 aSize, const char* b, v_int32 bSize) {
+      (void) a;
+      (void) b;
+      return aSize - bSize;
+    });
+
+    auto pool = oatpp::sqlite::ConnectionPool::createShared(connectionProvider, 2, std::chrono::seconds(60));
+    auto executor = std::make_shared<oatpp::sqlite::Executor>(pool);
+
+    oatpp::orm::SchemaMigration migration(executor, "FunctionTest");
+    migration.addFile(1, TEST_DB_MIGRATION "FunctionTest.sql");
+    migration.migrate();
+
+    MyClient client(executor);
+
+    const char* names[] = {"ccc", "a", "bb"};
+    for(v_int32 i = 0; i < 3; i ++) {
+      auto row = Row::createShared();
+      row->f_name = names[i];
+      row->f_value = (v_float64) (i + 1);
+      OATPP_ASSERT(client.insertRow(row)->isSuccess());
+    }
+
+    {
+      auto rows = client.getRepeated(2)->fetch<oatpp::Vector<oatpp::Object<ResultRow>>>();
+      OATPP_ASSERT(rows->size() == 3);
+      OATPP_ASSERT(rows[0]->f_string == "cccccc");
+      OATPP_ASSERT(rows[1]->f_string == "aa");
+      OATPP_ASSERT(rows[2]->f_string == "bbbb");
+    }
+
+    {
+      auto rows = client.getSumOfSquares()->fetch<oatpp::Vector<oatpp::Object<ResultRow>>>();
+      OATPP_ASSERT(rows->size() == 1);
+      OATPP_ASSERT(*rows[0]->f_float == 14.0);
+    }
+
+    {
+      auto rows = client.getSumOfSquaresEmpty()->fetch<oatpp::Vector<oatpp::Object<ResultRow>>>();
+      OATPP_ASSERT(rows->size() == 1);
+      OATPP_ASSERT(*rows[0]->f_float == 0.0);
+    }
+
+    {
+      auto rows = client.getMovingSum()->fetch<oatpp::Vector<oatpp::Object<ResultRow>>>();
+      OATPP_ASSERT(rows->size() == 3);
+      OATPP_ASSERT(*rows[0]->f_float == 1.0);
+      OATPP_ASSERT(*rows[1]->f_float == 3.0);
+      OATPP_ASSERT(*rows[2]->f_float == 5.0);
+    }
+
+    {
+      auto rows = client.getNamesByLength()->fetch<oatpp::Vector<oatpp::Object<ResultRow>>>();
+      OATPP_ASSERT(rows->size() == 3);
+      OATPP_ASSERT(rows[0]->f_string == "a");
+      OATPP_ASSERT(rows[1]->f_string == "bb");
+      OATPP_ASSERT(rows[2]->f_string == "ccc");
+    }
+
+    {
+      auto res = client.getFailing();
+      OATPP_ASSERT(!res->isSuccess());
+      OATPP_LOGd(TAG, "error='{}'", res->getErrorMessage()->c_str());
+      OATPP_ASSERT(res->getErrorMessage() == "function failed");
+    }
+
+    auto stats = connectionProvider->getInitHookStats();
+    OATPP_ASSERT(stats.size() == 6);
+    OATPP_ASSERT(stats[0].name == "cache_size");
+    OATPP_ASSERT(stats[0].runsCount == hookRuns);
+    OATPP_ASSERT(stats[1].name == "function:repeat_string");
+    for(auto& s : stats) {
+      OATPP_ASSERT(s.runsCount > 0);
+      OATPP_ASSERT(s.failuresCount == 0);
+    }
+
+    pool->stop();
+
+  }
+
+  std::remove(file->c_str());
+
+}
+
+}}}
@@ -0,0 +1,178 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "HotSwapTest.hpp"
+
+#include "oatpp-sqlite/orm.hpp"
+
+#include <cstdio>
+#include <string>
+
+namespace oatpp { namespace test { namespace sqlite {
+
+namespace {
+
+#include OATPP_CODEGEN_BEGIN(DTO)
+
+class CountRow : public oatpp::DTO {
+
+  DTO_INIT(CountRow, DTO);
+
+  DTO_FIELD(Int64, count);
+
+};
+
+#include OATPP_CODEGEN_END(DTO)
+
+#include OATPP_CODEGEN_BEGIN(DbClient)
+
+class MyClient : public oatpp::orm::DbClient {
+public:
+
+  MyClient(const std::shared_ptr<oatpp::orm::Executor>& executor, bool migrate)
+    : oatpp::orm::DbClient(executor)
+  {
+    if(migrate) {
+      oatpp::orm::SchemaMigration migration(executor, "HotSwapTest");
+      migration.addFile(1, TEST_DB_MIGRATION "HotSwapTest.sql");
+      migration.migrate();
+    }
+  }
+
+  QUERY(insertRow,
+        "INSERT INTO test_hot_swap (f_data) VALUES (:f_data)",
+        PARAM(String, f_data))
+
+  QUERY(countRows, "SELECT count(*) AS count FROM test_hot_swap")
+
+  QUERY(getCacheSize, "PRAGMA cache_size")
+
+};
+
+#include OATPP_CODEGEN_END(DbClient)
+
+void createDatabase(const oatpp::String& filePath, v_int32 rowsCount) {
+  std::remove(filePath->c_str());
+  auto connectionProvider = std::make_shared<oatpp::sqlite::ConnectionProvider>(filePath);
+  auto executor = std::make_shared<oatpp::sqlite::Executor>(connectionProvider);
+  auto client = MyClient(executor, true);
+  auto connection = client.getConnection();
+  for(v_int32 i = 0; i < rowsCount; i ++) {
+    client.insertRow(oatpp::String("row - " + std::to_string(i)), connection);
+  }
+}
+
+v_int64 countRows(MyClient& client) {
+  auto rows = client.countRows()->fetch<oatpp::Vector<oatpp::Object<CountRow>>>();
+  OATPP_ASSERT(rows->size() == 1);
+  return rows[0]->count;
+}
+
+v_int64 getCacheSize(MyClient& client) {
+  auto rows = client.getCacheSize()->fetch<oatpp::Vector<oatpp::Vector<oatpp::Int64>>>();
+  OATPP_ASSERT(rows->size() == 1);
+  return *rows[0][0];
+}
+
+}
+
+void HotSwapTest::onRun() {
+
+  oatpp::String fileA = TEST_DB_FILE ".a";
+  oatpp::String fileB = TEST_DB_FILE ".b";
+
+  createDatabase(fileA, 10);
+  createDatabase(fileB, 20);
+
+  oatpp::sqlite::HotSwapConnectionProvider::Config config;
+  config.pollInterval = std::chrono::microseconds::zero();
+  config.warmUpConnections = 2;
+  config.warmUpQueries.push_back("SELECT count(*) FROM test_hot_swap");
+
+  /* providers of all generations are configured the same way */
+  config.providerConfigurator = [](const std::shared_ptr<oatpp::sqlite::ConnectionProvider>& provider) {
+    provider->addInitHook("cache_size", [](sqlite3* handle) {
+      sqlite3_exec(handle, "PRAGMA cache_size=-1234", nullptr, nullptr, nullptr);
+    });
+  };
+
+  auto connectionProvider = std::make_shared<oatpp::sqlite::HotSwapConnectionProvider>(fileA, config);
+  auto executor = std::make_shared<oatpp::sqlite::Executor>(connectionProvider);
+  executor->setResultCache(std::make_shared<oatpp::sqlite::ResultCache>());
+  auto client = MyClient(executor, false);
+
+  v_int64 swappedTo = -1;
+  connectionProvider->setSwapCallback([&swappedTo](v_int64 generation) {
+    swappedTo = generation;
+  });
+
+  OATPP_ASSERT(countRows(client) == 10);
+  OATPP_ASSERT(getCacheSize(client) == -1234);
+
+  /* cached result of the current generation */
+  OATPP_ASSERT(countRows(client) == 10);
+  OATPP_ASSERT(executor->getResultCache()->getStats().hits == 1);
+
+  {
+    /* connection of the old generation stays usable until released */
+    auto oldConnection = client.getConnection();
+
+    OATPP_ASSERT(connectionProvider->swap(fileB));
+    OATPP_ASSERT(swappedTo == 1);
+    OATPP_ASSERT(countRows(client) == 20);
+    OATPP_ASSERT(getCacheSize(client) == -1234);
+
+    auto rows = client.countRows(oldConnection)->fetch<oatpp::Vector<oatpp::Object<CountRow>>>();
+    OATPP_ASSERT(rows[0]->count == 10);
+  }
+
+  /* nothing changed - no swap */
+  OATPP_ASSERT(!connectionProvider->swap());
+
+  /* broken file - current generation stays active */
+  {
+    oatpp::String brokenFile = TEST_DB_FILE ".broken";
+    std::FILE* file = std::fopen(brokenFile->c_str(), "wb");
+    std::fputs("not a database", file);
+    std::fclose(file);
+
+    OATPP_ASSERT(!connectionProvider->swap(brokenFile));
+    OATPP_ASSERT(countRows(client) == 20);
+
+    std::remove(brokenFile->c_str());
+  }
+
+  auto stats = connectionProvider->getStats();
+  OATPP_ASSERT(stats.generation == 1);
+  OATPP_ASSERT(stats.swapsCount == 1);
+  OATPP_ASSERT(stats.failedSwapsCount == 1);
+
+  connectionProvider->stop();
+
+  std::remove(fileA->c_str());
+  std::remove(fileB->c_str());
+
+}
+
+}}}
@@ -0,0 +1,163 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#include "ImageConnectionProviderTest.hpp"
+
+#include "oatpp-sqlite/orm.hpp"
+
+#include <cstdio>
+
+namespace oatpp { namespace test { namespace sqlite {
+
+namespace {
+
+#include OATPP_CODEGEN_BEGIN(DbClient)
+
+class MyClient : public oatpp::orm::DbClient {
+public:
+
+  MyClient(const std::shared_ptr<oatpp::orm::Executor>& executor)
+    : oatpp::orm::DbClient(executor)
+  {}
+
+  QUERY(createTable,
+        "CREATE TABLE IF NOT EXISTS test_image (f_id INTEGER PRIMARY KEY, f_name VARCHAR)")
+
+  QUERY(insertRow,
+        "INSERT INTO test_image (f_name) VALUES (:f_name)",
+        PARAM(String, f_name))
+
+  QUERY(selectNames, "SELECT f_name FROM test_image ORDER BY f_id")
+
+};
+
+#include OATPP_CODEGEN_END(DbClient)
+
+void createFile(const oatpp::String& file, const std::vector<oatpp::String>& names) {
+  std::remove(file->c_str());
+  auto executor = std::make_shared<oatpp::sqlite::Executor>(std::make_shared<oatpp::sqlite::ConnectionProvider>(file));
+  MyClient client(executor);
+  OATPP_ASSERT(client.createTable()->isSuccess());
+  for(auto& name : names) {
+    OATPP_ASSERT(client.insertRow(name)->isSuccess());
+  }
+}
+
+std::vector<std::string> selectNames(MyClient& client,
+                                     const oatpp::provider::ResourceHandle<oatpp::orm::Connection>& connection = nullptr)
+{
+  auto res = client.selectNames(connection);
+  OATPP_ASSERT(res->isSuccess());
+  auto rows = res->fetch<oatpp::Vector<oatpp::Vector<oatpp::String>>>();
+  std::vector<std::string> result;
+  for(auto& row : *rows) {
+    result.push_back(*row[0]);
+  }
+  return result;
+}
+
+v_int64 getFileSize(const oatpp::String& file) {
+  std::FILE* f = std::fopen(file->c_str(), "rb");
+  OATPP_ASSERT(f != nullptr);
+  std::fseek(f, 0, SEEK_END);
+  v_int64 size = std::ftell(f);
+  std::fclose(f);
+  return size;
+}
+
+}
+
+void ImageConnectionProviderTest::onRun() {
+
+  oatpp::String fileA = TEST_DB_FILE ".image-a";
+  oatpp::String fileB = TEST_DB_FILE ".image-b";
+
+  createFile(fileA, {"one", "two"});
+  createFile(fileB, {"three"});
+
+  {
+
+    auto connectionProvider = std::make_shared<oatpp::sqlite::ImageConnectionProvider>(fileA);
+    OATPP_ASSERT(connectionProvider->getImageSize() == getFileSize(fileA));
+
+    auto pool = oatpp::sqlite::ConnectionPool::createShared(connectionProvider, 2, std::chrono::seconds(60));
+    auto executor = std::make_shared<oatpp::sqlite::Executor>(pool);
+    executor->setResultCache(std::make_shared<oatpp::sqlite::ResultCache>());
+    executor->setDatabaseScopeProvider(connectionProvider);
+    MyClient client(executor);
+
+    /* the image file is not read after load */
+    std::remove(fileA->c_str());
+
+    /* two pooled connections share the same image */
+    {
+
+      auto connection1 = executor->getConnection();
+      auto connection2 = executor->getConnection();
+
+      auto handle1 = std::static_pointer_cast<oatpp::sqlite::Connection>(connection1.object)->getHandle();
+      auto handle2 = std::static_pointer_cast<oatpp::sqlite::Connection>(connection2.object)->getHandle();
+      OATPP_ASSERT(handle1 != handle2);
+
+      OATPP_ASSERT(selectNames(client, connection1) == std::vector<std::string>({"one", "two"}));
+      OATPP_ASSERT(selectNames(client, connection2) == std::vector<std::string>({"one", "two"}));
+
+      /* image is read-only */
+      bool rejected = false;
+      try {
+        client.insertRow("four", connection1);
+      } catch (const std::runtime_error&) {
+        rejected = true;
+      }
+      OATPP_ASSERT(rejected);
+
+    }
+
+    /* cached result of the current image */
+    OATPP_ASSERT(selectNames(client) == std::vector<std::string>({"one", "two"}));
+    OATPP_ASSERT(selectNames(client) == std::vector<std::string>({"one", "two"}));
+    OATPP_ASSERT(executor->getResultCache()->getStats().hits == 1);
+
+    /* reload replaces content for all connections */
+    connectionProvider->reload(fileB);
+    OATPP_ASSERT(selectNames(client) == std::vector<std::string>({"three"}));
+    OATPP_ASSERT(connectionProvider->getImageSize() == getFileSize(fileB));
+
+    {
+      auto connection1 = executor->getConnection();
+      auto connection2 = executor->getConnection();
+      OATPP_ASSERT(selectNames(client, connection1) == std::vector<std::string>({"three"}));
+      OATPP_ASSERT(selectNames(client, connection2) == std::vector<std::string>({"three"}));
+    }
+
+    pool->stop();
+
+  }
+
+  std::remove(fileB->c_str());
+
+}
+
+}}}
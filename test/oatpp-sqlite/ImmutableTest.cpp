@@ -0,0 +1,129 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#include "ImmutableTest.hpp"
+
+#include "oatpp-sqlite/orm.hpp"
+
+#include <cstdio>
+#include <functional>
+
+namespace oatpp { namespace test { namespace sqlite {
+
+namespace {
+
+#include OATPP_CODEGEN_BEGIN(DbClient)
+
+class MyClient : public oatpp::orm::DbClient {
+public:
+
+  MyClient(const std::shared_ptr<oatpp::orm::Executor>& executor)
+    : oatpp::orm::DbClient(executor)
+  {}
+
+  QUERY(insertRow,
+        "INSERT INTO test_immutable (f_name) VALUES (:f_name)",
+        PARAM(String, f_name))
+
+  QUERY(selectNames, "SELECT f_name FROM test_immutable ORDER BY f_id")
+
+};
+
+#include OATPP_CODEGEN_END(DbClient)
+
+bool throws(const std::function<void()>& call) {
+  try {
+    call();
+  } catch (const std::runtime_error&) {
+    return true;
+  }
+  return false;
+}
+
+}
+
+void ImmutableTest::onRun() {
+
+  oatpp::String file = TEST_DB_FILE ".immutable";
+  std::remove(file->c_str());
+
+  /* create the database with a regular provider */
+  {
+    auto executor = std::make_shared<oatpp::sqlite::Executor>(std::make_shared<oatpp::sqlite::ConnectionProvider>(file));
+    oatpp::orm::SchemaMigration migration(executor, "ImmutableTest");
+    migration.addText(1, "CREATE TABLE test_immutable (f_id INTEGER PRIMARY KEY, f_name VARCHAR);");
+    migration.migrate();
+    MyClient client(executor);
+    OATPP_ASSERT(client.insertRow("one")->isSuccess());
+    OATPP_ASSERT(client.insertRow("two")->isSuccess());
+  }
+
+  {
+
+    auto connectionProvider = oatpp::sqlite::ConnectionProvider::createImmutable(file);
+    auto executor = std::make_shared<oatpp::sqlite::Executor>(connectionProvider);
+    MyClient client(executor);
+
+    /* reads succeed */
+    {
+      auto res = client.selectNames();
+      OATPP_ASSERT(res->isSuccess());
+      auto rows = res->fetch<oatpp::Vector<oatpp::Vector<oatpp::String>>>();
+      OATPP_ASSERT(rows->size() == 2);
+      OATPP_ASSERT(rows[0][0] == "one");
+      OATPP_ASSERT(rows[1][0] == "two");
+    }
+
+    /* writes are rejected before they run */
+    OATPP_ASSERT(throws([&client]{ client.insertRow("three"); }));
+
+    /* schema version is read without creating the version table */
+    OATPP_ASSERT(executor->getSchemaVersion("ImmutableTest") == 1);
+    OATPP_ASSERT(executor->getSchemaVersion("ImmutableTestOther") == 0);
+
+    /* migration refuses to run */
+    OATPP_ASSERT(throws([&executor]{
+      executor->migrateSchema("CREATE TABLE test_other (f_id INTEGER PRIMARY KEY);", 2, "ImmutableTest");
+    }));
+    OATPP_ASSERT(throws([&executor]{
+      oatpp::orm::SchemaMigration migration(executor, "ImmutableTest");
+      migration.addText(2, "CREATE TABLE test_other (f_id INTEGER PRIMARY KEY);");
+      migration.migrate();
+    }));
+
+  }
+
+  /* nothing was written to the file */
+  {
+    auto executor = std::make_shared<oatpp::sqlite::Executor>(std::make_shared<oatpp::sqlite::ConnectionProvider>(file));
+    MyClient client(executor);
+    OATPP_ASSERT(executor->getSchemaVersion("ImmutableTest") == 1);
+    auto rows = client.selectNames()->fetch<oatpp::Vector<oatpp::Vector<oatpp::String>>>();
+    OATPP_ASSERT(rows->size() == 2);
+  }
+
+}
+
+}}}
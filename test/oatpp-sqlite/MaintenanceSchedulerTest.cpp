@@ -0,0 +1,235 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#include "MaintenanceSchedulerTest.hpp"
+
+#include "oatpp-sqlite/orm.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <functional>
+#include <thread>
+
+namespace oatpp { namespace test { namespace sqlite {
+
+namespace {
+
+#include OATPP_CODEGEN_BEGIN(DbClient)
+
+class MyClient : public oatpp::orm::DbClient {
+public:
+
+  MyClient(const std::shared_ptr<oatpp::orm::Executor>& executor)
+    : oatpp::orm::DbClient(executor)
+  {}
+
+  QUERY(createTable,
+        "CREATE TABLE IF NOT EXISTS test_maintenance (f_id INTEGER PRIMARY KEY, f_data BLOB)")
+
+  QUERY(insertRow,
+        "INSERT INTO test_maintenance (f_data) VALUES (randomblob(16))")
+
+  QUERY(insertPages,
+        "WITH RECURSIVE seq(n) AS (SELECT 1 UNION ALL SELECT n + 1 FROM seq WHERE n < :count) "
+        "INSERT INTO test_maintenance (f_data) SELECT randomblob(3000) FROM seq",
+        PARAM(Int64, count))
+
+  QUERY(deleteAll, "DELETE FROM test_maintenance")
+
+  QUERY(getFreePages, "PRAGMA freelist_count")
+
+  QUERY(setAnalysisLimit, "PRAGMA analysis_limit=77")
+
+  QUERY(getAnalysisLimit, "PRAGMA analysis_limit")
+
+  QUERY(countSequence,
+        "WITH RECURSIVE seq(n) AS (SELECT 1 UNION ALL SELECT n + 1 FROM seq WHERE n < 1000) SELECT count(*) FROM seq")
+
+};
+
+#include OATPP_CODEGEN_END(DbClient)
+
+v_int64 getFreePages(MyClient& client) {
+  auto rows = client.getFreePages()->fetch<oatpp::Vector<oatpp::Vector<oatpp::Int64>>>();
+  return *rows[0][0];
+}
+
+/* every row takes one page - deleting them all puts the pages to the freelist */
+v_int64 makeFreePages(MyClient& client) {
+  OATPP_ASSERT(client.insertPages(1000)->isSuccess());
+  OATPP_ASSERT(client.deleteAll()->isSuccess());
+  return getFreePages(client);
+}
+
+bool waitFor(const std::function<bool()>& condition) {
+  for(v_int32 i = 0; i < 500; i ++) {
+    if(condition()) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return condition();
+}
+
+}
+
+void MaintenanceSchedulerTest::onRun() {
+
+  oatpp::String file = TEST_DB_FILE ".maintenance";
+  std::remove(file->c_str());
+
+  {
+
+    auto connectionProvider = std::make_shared<oatpp::sqlite::ConnectionProvider>(file);
+    connectionProvider->addInitHook("auto_vacuum", [](sqlite3* handle) {
+      sqlite3_exec(handle, "PRAGMA auto_vacuum=INCREMENTAL", nullptr, nullptr, nullptr);
+    });
+
+    auto pool = oatpp::sqlite::ConnectionPool::createShared(connectionProvider, 2, std::chrono::seconds(60));
+    auto executor = std::make_shared<oatpp::sqlite::Executor>(pool);
+
+    MyClient client(executor);
+    OATPP_ASSERT(client.createTable()->isSuccess());
+
+    /* idle detection - vacuum runs only once commits stop */
+    {
+
+      OATPP_ASSERT(makeFreePages(client) >= 1000);
+
+      oatpp::sqlite::MaintenanceScheduler::Config config;
+      config.idleTime = std::chrono::milliseconds(300);
+      config.checkInterval = std::chrono::milliseconds(20);
+      config.optimizeInterval = std::chrono::milliseconds(0);
+
+      auto scheduler = std::make_shared<oatpp::sqlite::MaintenanceScheduler>(executor, config);
+      connectionProvider->addChangeListener(scheduler);
+
+      for(v_int32 i = 0; i < 30; i ++) {
+        OATPP_ASSERT(client.insertRow()->isSuccess());
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      }
+      OATPP_ASSERT(scheduler->getStats().vacuumSlices == 0);
+
+      OATPP_ASSERT(waitFor([&scheduler]{ return scheduler->getStats().vacuumSlices > 0; }));
+
+      scheduler->stop();
+      connectionProvider->removeChangeListener(scheduler);
+
+      auto stats = scheduler->getStats();
+      OATPP_LOGd(TAG, "idle vacuum: slices={}, pages={}", stats.vacuumSlices, stats.vacuumedPages);
+      OATPP_ASSERT(stats.vacuumedPages <= stats.vacuumSlices * config.vacuumPagesPerSlice);
+      OATPP_ASSERT(stats.errorCount == 0);
+
+    }
+
+    /* no time budget - nothing is vacuumed */
+    {
+
+      auto freePages = makeFreePages(client);
+      OATPP_ASSERT(freePages >= 1000);
+
+      oatpp::sqlite::MaintenanceScheduler::Config config;
+      config.checkInterval = std::chrono::hours(1);
+      config.timeBudget = std::chrono::milliseconds(0);
+
+      oatpp::sqlite::MaintenanceScheduler scheduler(executor, config);
+      OATPP_ASSERT(scheduler.runIncrementalVacuum() == 0);
+      OATPP_ASSERT(getFreePages(client) == freePages);
+      OATPP_ASSERT(scheduler.getStats().vacuumSlices == 0);
+
+    }
+
+    /* vacuum in bounded slices until the freelist is empty, then optimize */
+    {
+
+      auto freePages = getFreePages(client);
+
+      oatpp::sqlite::MaintenanceScheduler::Config config;
+      config.checkInterval = std::chrono::hours(1);
+      config.timeBudget = std::chrono::seconds(10);
+      config.vacuumPagesPerSlice = 64;
+      config.vacuumMinFreePages = 1;
+
+      oatpp::sqlite::MaintenanceScheduler scheduler(executor, config);
+      OATPP_ASSERT(scheduler.runIncrementalVacuum() == freePages);
+      OATPP_ASSERT(getFreePages(client) == 0);
+
+      auto stats = scheduler.getStats();
+      OATPP_ASSERT(stats.vacuumedPages == freePages);
+      OATPP_ASSERT(stats.vacuumSlices == (freePages + config.vacuumPagesPerSlice - 1) / config.vacuumPagesPerSlice);
+
+      OATPP_ASSERT(scheduler.runOptimize());
+      OATPP_ASSERT(scheduler.getStats().optimizeCount == 1);
+      OATPP_ASSERT(scheduler.getStats().interruptedCount == 0);
+
+    }
+
+    pool->stop();
+
+    /* pooled connection gets its own progress handler and analysis_limit back */
+    {
+
+      auto singlePool = oatpp::sqlite::ConnectionPool::createShared(connectionProvider, 1, std::chrono::seconds(60));
+      auto singleExecutor = std::make_shared<oatpp::sqlite::Executor>(singlePool);
+      MyClient singleClient(singleExecutor);
+
+      std::atomic<v_int64> progressCalls(0);
+
+      {
+        auto connection = singleExecutor->getConnection();
+        oatpp::sqlite::Connection::ProgressHandler handler;
+        handler.instructions = 10;
+        handler.callback = [&progressCalls]() {
+          progressCalls ++;
+          return 0;
+        };
+        std::static_pointer_cast<oatpp::sqlite::Connection>(connection.object)->setProgressHandler(handler);
+        OATPP_ASSERT(singleClient.setAnalysisLimit(connection)->isSuccess());
+      }
+
+      oatpp::sqlite::MaintenanceScheduler::Config config;
+      config.checkInterval = std::chrono::hours(1);
+      config.analysisLimit = 400;
+
+      oatpp::sqlite::MaintenanceScheduler scheduler(singleExecutor, config);
+      OATPP_ASSERT(scheduler.runOptimize());
+      OATPP_ASSERT(scheduler.runIncrementalVacuum() == 0);
+
+      progressCalls = 0;
+      auto rows = singleClient.getAnalysisLimit()->fetch<oatpp::Vector<oatpp::Vector<oatpp::Int64>>>();
+      OATPP_ASSERT(*rows[0][0] == 77);
+      rows = singleClient.countSequence()->fetch<oatpp::Vector<oatpp::Vector<oatpp::Int64>>>();
+      OATPP_ASSERT(*rows[0][0] == 1000);
+      OATPP_ASSERT(progressCalls > 0);
+
+      singlePool->stop();
+
+    }
+
+  }
+
+}
+
+}}}
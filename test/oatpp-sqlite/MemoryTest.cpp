@@ -0,0 +1,150 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#include "MemoryTest.hpp"
+
+#include "oatpp-sqlite/orm.hpp"
+
+#include <cstdio>
+
+namespace oatpp { namespace test { namespace sqlite {
+
+namespace {
+
+#include OATPP_CODEGEN_BEGIN(DbClient)
+
+class MyClient : public oatpp::orm::DbClient {
+public:
+
+  MyClient(const std::shared_ptr<oatpp::orm::Executor>& executor)
+    : oatpp::orm::DbClient(executor)
+  {}
+
+  QUERY(createTable,
+        "CREATE TABLE IF NOT EXISTS test_memory (f_id INTEGER PRIMARY KEY, f_data VARCHAR)")
+
+  QUERY(fillTable,
+        "WITH RECURSIVE seq(n) AS (SELECT 1 UNION ALL SELECT n + 1 FROM seq WHERE n < 1000) "
+        "INSERT INTO test_memory (f_data) SELECT printf('row - %d', n) FROM seq")
+
+  QUERY(readTable,
+        "SELECT count(*) FROM test_memory WHERE f_data LIKE '%9%'")
+
+};
+
+#include OATPP_CODEGEN_END(DbClient)
+
+}
+
+void MemoryTest::onRun() {
+
+  oatpp::String file = TEST_DB_FILE ".memory";
+  std::remove(file->c_str());
+
+  {
+
+    auto connectionProvider = std::make_shared<oatpp::sqlite::ConnectionProvider>(file);
+    auto pool = oatpp::sqlite::ConnectionPool::createShared(connectionProvider, 2, std::chrono::seconds(60));
+    auto executor = std::make_shared<oatpp::sqlite::Executor>(pool);
+
+    MyClient client(executor);
+    OATPP_ASSERT(client.createTable()->isSuccess());
+    OATPP_ASSERT(client.fillTable()->isSuccess());
+
+    {
+      auto stats = connectionProvider->getMemoryStats();
+      OATPP_ASSERT(stats.connectionsCount == 1);
+      OATPP_ASSERT(stats.idleConnectionsCount == 1);
+      OATPP_ASSERT(stats.heapUsed > 0);
+    }
+
+    {
+      auto connection = client.getConnection();
+      OATPP_ASSERT(client.readTable(connection)->isSuccess());
+
+      auto stats = connectionProvider->getMemoryStats();
+      OATPP_ASSERT(stats.connectionsCount == 1);
+      OATPP_ASSERT(stats.idleConnectionsCount == 0);
+      OATPP_ASSERT(stats.idleCacheUsed == 0);
+      OATPP_ASSERT(stats.cacheUsed > 0);
+
+      /* acquired connection is not trimmed */
+      OATPP_ASSERT(connectionProvider->releaseIdleMemory() == 0);
+    }
+
+    {
+      auto stats = connectionProvider->getMemoryStats();
+      OATPP_ASSERT(stats.idleConnectionsCount == 1);
+      OATPP_ASSERT(stats.idleCacheUsed == stats.cacheUsed);
+
+      /* connection has just been returned - not idle for long enough */
+      OATPP_ASSERT(connectionProvider->releaseIdleMemory(std::chrono::hours(1)) == 0);
+
+      auto freed = connectionProvider->releaseIdleMemory();
+      OATPP_LOGd(TAG, "freed={}", freed);
+      OATPP_ASSERT(freed > 0);
+      OATPP_ASSERT(connectionProvider->getMemoryStats().idleCacheUsed < stats.idleCacheUsed);
+    }
+
+    {
+      v_int64 alarms = 0;
+      v_int64 alarmHeapUsed = 0;
+      auto callback = [&alarms, &alarmHeapUsed](v_int64 heapUsed, v_int64 limit) {
+        (void) limit;
+        alarms ++;
+        alarmHeapUsed = heapUsed;
+      };
+
+      auto heapUsed = connectionProvider->getMemoryStats().heapUsed;
+
+      /* far below the threshold - no alarm */
+      connectionProvider->setSoftHeapLimit(heapUsed * 100, 0.9, callback);
+      OATPP_ASSERT(connectionProvider->getMemoryStats().softHeapLimit == heapUsed * 100);
+      OATPP_ASSERT(client.readTable()->isSuccess());
+      connectionProvider->releaseIdleMemory(std::chrono::hours(1));
+      OATPP_ASSERT(alarms == 0);
+
+      /* over the threshold - alarm fires and idle connections are trimmed regardless of idle time */
+      connectionProvider->setSoftHeapLimit(heapUsed * 2, 0.1, callback);
+      OATPP_ASSERT(client.readTable()->isSuccess());
+      auto idleCacheUsed = connectionProvider->getMemoryStats().idleCacheUsed;
+      OATPP_ASSERT(connectionProvider->releaseIdleMemory(std::chrono::hours(1)) > 0);
+      OATPP_ASSERT(alarms > 0);
+      OATPP_ASSERT(alarmHeapUsed > 0);
+      OATPP_ASSERT(connectionProvider->getMemoryStats().idleCacheUsed < idleCacheUsed);
+
+      /* soft heap limit is process-wide - reset it */
+      connectionProvider->setSoftHeapLimit(0);
+    }
+
+    pool->stop();
+
+  }
+
+  std::remove(file->c_str());
+
+}
+
+}}}
@@ -0,0 +1,161 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "PoolMetricsTest.hpp"
+
+#include "oatpp-sqlite/orm.hpp"
+
+#include <cstdio>
+
+namespace oatpp { namespace test { namespace sqlite {
+
+void PoolMetricsTest::onRun() {
+
+  /* histogram buckets - upper bounds are exclusive */
+  {
+    oatpp::sqlite::PoolMetrics::Histogram histogram;
+    histogram.record(0);
+    histogram.record(9);
+    histogram.record(10);
+    histogram.record(999);
+    histogram.record(1000);
+    histogram.record(99999);
+    histogram.record(9999999);
+    histogram.record(10000000);
+    histogram.record(50000000);
+
+    auto snapshot = histogram.getSnapshot();
+    OATPP_ASSERT(snapshot.count == 9);
+    OATPP_ASSERT(snapshot.totalTime == 0 + 9 + 10 + 999 + 1000 + 99999 + 9999999 + 10000000 + 50000000);
+    OATPP_ASSERT(snapshot.maxTime == 50000000);
+    OATPP_ASSERT(snapshot.buckets.size() == oatpp::sqlite::PoolMetrics::BUCKETS_COUNT);
+
+    std::vector<v_int64> expected = {2, 1, 1, 1, 1, 0, 1, 2};
+    OATPP_ASSERT(snapshot.buckets == expected);
+  }
+
+  /* failed acquisitions are counted and still recorded in the histogram */
+  {
+    oatpp::sqlite::PoolMetrics metrics;
+    metrics.recordAcquire(50, true);
+    metrics.recordAcquire(5000, false);
+    metrics.recordClose();
+    auto snapshot = metrics.getSnapshot();
+    OATPP_ASSERT(snapshot.acquireWait.count == 2);
+    OATPP_ASSERT(snapshot.acquireFailures == 1);
+    OATPP_ASSERT(snapshot.closes == 1);
+    OATPP_ASSERT(snapshot.open.count == 0);
+    OATPP_ASSERT(snapshot.connectionsCount == 0);
+  }
+
+  /* open failure on a bad path */
+  {
+    auto connectionProvider = std::make_shared<oatpp::sqlite::ConnectionProvider>(TEST_DB_FILE ".no-such-dir/db.sqlite");
+    auto executor = std::make_shared<oatpp::sqlite::Executor>(connectionProvider);
+    executor->setPoolMetrics(connectionProvider->getPoolMetrics());
+
+    bool thrown = false;
+    try {
+      executor->getConnection();
+    } catch (const std::runtime_error&) {
+      thrown = true;
+    }
+    OATPP_ASSERT(thrown);
+
+    auto stats = connectionProvider->getPoolStats();
+    OATPP_ASSERT(stats.open.count == 1);
+    OATPP_ASSERT(stats.openFailures == 1);
+    OATPP_ASSERT(stats.acquireWait.count == 1);
+    OATPP_ASSERT(stats.acquireFailures == 1);
+    OATPP_ASSERT(stats.connectionsCount == 0);
+  }
+
+  /* pooled acquire and release */
+  {
+    oatpp::String file = TEST_DB_FILE ".pool-metrics";
+    std::remove(file->c_str());
+
+    auto connectionProvider = std::make_shared<oatpp::sqlite::ConnectionProvider>(file);
+    auto pool = oatpp::sqlite::ConnectionPool::createShared(connectionProvider, 2, std::chrono::seconds(60));
+    auto executor = std::make_shared<oatpp::sqlite::Executor>(pool);
+
+    /* acquisition is not recorded until metrics are set */
+    executor->getConnection();
+    OATPP_ASSERT(connectionProvider->getPoolStats().acquireWait.count == 0);
+
+    executor->setPoolMetrics(connectionProvider->getPoolMetrics());
+    OATPP_ASSERT(executor->getPoolMetrics() == connectionProvider->getPoolMetrics());
+
+    {
+      auto stats = connectionProvider->getPoolStats();
+      OATPP_ASSERT(stats.open.count == 1);
+      OATPP_ASSERT(stats.openFailures == 0);
+      OATPP_ASSERT(stats.connectionsCount == 1);
+      OATPP_ASSERT(stats.activeCount == 0);
+      OATPP_ASSERT(stats.idleCount == 1);
+    }
+
+    {
+      auto connection1 = executor->getConnection();
+
+      auto stats = connectionProvider->getPoolStats();
+      OATPP_ASSERT(stats.acquireWait.count == 1);
+      OATPP_ASSERT(stats.acquireFailures == 0);
+      /* idle connection is reused - nothing opened */
+      OATPP_ASSERT(stats.open.count == 1);
+      OATPP_ASSERT(stats.connectionsCount == 1);
+      OATPP_ASSERT(stats.activeCount == 1);
+      OATPP_ASSERT(stats.idleCount == 0);
+
+      auto connection2 = executor->getConnection();
+
+      stats = connectionProvider->getPoolStats();
+      OATPP_ASSERT(stats.acquireWait.count == 2);
+      OATPP_ASSERT(stats.open.count == 2);
+      OATPP_ASSERT(stats.connectionsCount == 2);
+      OATPP_ASSERT(stats.activeCount == 2);
+      OATPP_ASSERT(stats.idleCount == 0);
+    }
+
+    {
+      auto stats = connectionProvider->getPoolStats();
+      OATPP_ASSERT(stats.connectionsCount == 2);
+      OATPP_ASSERT(stats.activeCount == 0);
+      OATPP_ASSERT(stats.idleCount == 2);
+      OATPP_ASSERT(stats.closes == 0);
+    }
+
+    /* stopped pool drops its connections */
+    pool->stop();
+    executor.reset();
+    pool.reset();
+
+    OATPP_ASSERT(connectionProvider->getPoolStats().connectionsCount == 0);
+
+    std::remove(file->c_str());
+  }
+
+}
+
+}}}
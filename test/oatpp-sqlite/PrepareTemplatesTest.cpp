@@ -0,0 +1,196 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#include "PrepareTemplatesTest.hpp"
+
+#include "oatpp-sqlite/orm.hpp"
+
+#include <cstdio>
+
+namespace oatpp { namespace test { namespace sqlite {
+
+namespace {
+
+#include OATPP_CODEGEN_BEGIN(DTO)
+
+class CountRow : public oatpp::DTO {
+
+  DTO_INIT(CountRow, DTO);
+
+  DTO_FIELD(Int64, f_count);
+
+};
+
+#include OATPP_CODEGEN_END(DTO)
+
+#include OATPP_CODEGEN_BEGIN(DbClient)
+
+class MyClient : public oatpp::orm::DbClient {
+public:
+
+  MyClient(const std::shared_ptr<oatpp::orm::Executor>& executor)
+    : oatpp::orm::DbClient(executor)
+  {}
+
+  QUERY(insertRow,
+        "INSERT INTO test_prepare (f_name) VALUES (:f_name)",
+        PARAM(String, f_name))
+
+  QUERY(getRows,
+        "SELECT f_id, f_name, count(*) AS f_count FROM test_prepare WHERE f_name=:f_name",
+        PARAM(String, f_name))
+
+};
+
+class BrokenClient : public oatpp::orm::DbClient {
+public:
+
+  BrokenClient(const std::shared_ptr<oatpp::orm::Executor>& executor)
+    : oatpp::orm::DbClient(executor)
+  {}
+
+  QUERY(getRows, "SELECT * FROM test_prepare")
+
+  QUERY(getMissing, "SELECT * FROM test_prepare_missing")
+
+};
+
+#include OATPP_CODEGEN_END(DbClient)
+
+}
+
+void PrepareTemplatesTest::onRun() {
+
+  oatpp::String file = TEST_DB_FILE ".prepare";
+  std::remove(file->c_str());
+
+  {
+
+    auto connectionProvider = std::make_shared<oatpp::sqlite::ConnectionProvider>(file);
+    auto pool = oatpp::sqlite::ConnectionPool::createShared(connectionProvider, 4, std::chrono::seconds(60));
+
+    auto executor = std::make_shared<oatpp::sqlite::Executor>(pool);
+    oatpp::orm::SchemaMigration migration(executor, "PrepareTemplatesTest");
+    migration.addFile(1, TEST_DB_MIGRATION "PrepareTemplatesTest.sql");
+    migration.migrate();
+
+    MyClient client(executor);
+    MyClient client2(executor);
+
+    {
+      auto info = executor->validateTemplates();
+      OATPP_ASSERT(info.size() == 2);
+      for(auto& t : info) {
+        OATPP_ASSERT(t.isValid);
+        OATPP_ASSERT(t.paramsCount == 1);
+        if(t.name == "getRows") {
+          OATPP_ASSERT(t.isReadOnly);
+          OATPP_ASSERT(t.columns.size() == 3);
+          OATPP_ASSERT(t.columns[0].name == "f_id");
+          OATPP_ASSERT(t.columns[0].declaredType == "INTEGER");
+          OATPP_ASSERT(t.columns[1].name == "f_name");
+          OATPP_ASSERT(t.columns[1].declaredType == "VARCHAR");
+          OATPP_ASSERT(t.columns[2].name == "f_count");
+          OATPP_ASSERT(t.columns[2].declaredType == nullptr);
+        } else {
+          OATPP_ASSERT(t.name == "insertRow");
+          OATPP_ASSERT(!t.isReadOnly);
+          OATPP_ASSERT(t.columns.empty());
+        }
+      }
+    }
+
+    {
+      oatpp::sqlite::Executor::WarmUpConfig config;
+      config.connectionsCount = 8;
+      config.maxConnections = 4;
+      config.queries = {"PRAGMA cache_size=-4000"};
+      executor->warmUp(config);
+    }
+
+    for(v_int32 i = 0; i < 10; i ++) {
+      auto res = client.insertRow("name");
+      OATPP_ASSERT(res->isSuccess());
+    }
+
+    {
+      auto res = client.getRows("name");
+      OATPP_ASSERT(res->isSuccess());
+      auto rows = res->fetch<oatpp::Vector<oatpp::Object<CountRow>>>();
+      OATPP_ASSERT(rows->size() == 1);
+      OATPP_ASSERT(rows[0]->f_count == 10);
+    }
+
+    /* statement returned to the cache is reset */
+    {
+      auto res = client.getRows("other");
+      auto rows = res->fetch<oatpp::Vector<oatpp::Object<CountRow>>>();
+      OATPP_ASSERT(rows->size() == 1);
+      OATPP_ASSERT(*rows[0]->f_count == 0);
+    }
+
+    BrokenClient brokenClient(executor);
+
+    {
+      bool thrown = false;
+      try {
+        executor->validateTemplates();
+      } catch (std::runtime_error& e) {
+        thrown = true;
+        OATPP_LOGd(TAG, "{}", e.what());
+        OATPP_ASSERT(std::string(e.what()).find("'getMissing'") != std::string::npos);
+      }
+      OATPP_ASSERT(thrown);
+    }
+
+    {
+      auto info = executor->prepareTemplates();
+      OATPP_ASSERT(info.size() == 4);
+      v_int32 invalidCount = 0;
+      for(auto& t : info) {
+        if(!t.isValid) {
+          invalidCount ++;
+          OATPP_ASSERT(t.name == "getMissing");
+          OATPP_ASSERT(t.errorMessage);
+        }
+      }
+      OATPP_ASSERT(invalidCount == 1);
+    }
+
+    {
+      auto res = brokenClient.getMissing();
+      OATPP_ASSERT(!res->isSuccess());
+      OATPP_LOGd(TAG, "error='{}'", res->getErrorMessage()->c_str());
+    }
+
+    pool->stop();
+
+  }
+
+  std::remove(file->c_str());
+
+}
+
+}}}
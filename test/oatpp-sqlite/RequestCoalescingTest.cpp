@@ -0,0 +1,198 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#include "RequestCoalescingTest.hpp"
+
+#include "oatpp-sqlite/orm.hpp"
+
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+namespace oatpp { namespace test { namespace sqlite {
+
+namespace {
+
+#include OATPP_CODEGEN_BEGIN(DbClient)
+
+class MyClient : public oatpp::orm::DbClient {
+public:
+
+  MyClient(const std::shared_ptr<oatpp::orm::Executor>& executor)
+    : oatpp::orm::DbClient(executor)
+  {}
+
+  QUERY(createTable,
+        "CREATE TABLE IF NOT EXISTS test_coalescing (f_id INTEGER PRIMARY KEY, f_value INTEGER)")
+
+  QUERY(insertRow,
+        "INSERT INTO test_coalescing (f_value) VALUES (:f_value)",
+        PARAM(Int64, f_value))
+
+  QUERY(slowRead, "SELECT slow_read() AS f_value")
+
+};
+
+#include OATPP_CODEGEN_END(DbClient)
+
+/*
+ * Gate of the slow_read() function - every run blocks until the gate is open.
+ */
+class Gate {
+private:
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  v_int32 m_runs = 0;
+  bool m_open = false;
+public:
+
+  void enter() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_runs ++;
+    m_condition.notify_all();
+    m_condition.wait(lock, [this]{
+      return m_open;
+    });
+  }
+
+  void waitRuns(v_int32 runs) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condition.wait_for(lock, std::chrono::seconds(5), [this, runs]{
+      return m_runs >= runs;
+    });
+  }
+
+  void open() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_open = true;
+    }
+    m_condition.notify_all();
+  }
+
+  v_int32 getRuns() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_runs;
+  }
+
+};
+
+v_int64 readValue(const std::shared_ptr<oatpp::orm::QueryResult>& result) {
+  OATPP_ASSERT(result->isSuccess());
+  auto rows = result->fetch<oatpp::Vector<oatpp::Vector<oatpp::Int64>>>();
+  OATPP_ASSERT(rows->size() == 1);
+  return *rows[0][0];
+}
+
+}
+
+void RequestCoalescingTest::onRun() {
+
+  oatpp::String file = TEST_DB_FILE ".coalescing";
+  std::remove(file->c_str());
+
+  {
+
+    auto gate = std::make_shared<Gate>();
+
+    auto connectionProvider = std::make_shared<oatpp::sqlite::ConnectionProvider>(file);
+    connectionProvider->addFunction(oatpp::sqlite::ScalarFunction::createShared("slow_read",
+      [gate]() -> oatpp::Int64 {
+        gate->enter();
+        return 42;
+      },
+      false
+    ));
+
+    auto pool = oatpp::sqlite::ConnectionPool::createShared(connectionProvider, 10, std::chrono::seconds(60));
+    auto executor = std::make_shared<oatpp::sqlite::Executor>(pool);
+    executor->setRequestCoalescing(true);
+
+    MyClient client(executor);
+    OATPP_ASSERT(client.createTable()->isSuccess());
+
+    const v_int32 followersCount = 4;
+    std::vector<v_int64> values(followersCount + 2, 0);
+    std::vector<std::thread> threads;
+
+    /* leader - registers the flight and blocks in slow_read() */
+    threads.push_back(std::thread([&client, &values]{
+      values[0] = readValue(client.slowRead());
+    }));
+    gate->waitRuns(1);
+
+    /* identical reads - wait for the leader */
+    for(v_int32 i = 0; i < followersCount; i ++) {
+      threads.push_back(std::thread([&client, &values, i]{
+        values[i + 1] = readValue(client.slowRead());
+      }));
+    }
+
+    /* explicit connection - never coalesced */
+    threads.push_back(std::thread([&client, &executor, &values, followersCount]{
+      auto connection = executor->getConnection();
+      values[followersCount + 1] = readValue(client.slowRead(connection));
+    }));
+    gate->waitRuns(2);
+
+    /* give followers time to join the flight */
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    gate->open();
+
+    for(auto& thread : threads) {
+      thread.join();
+    }
+
+    OATPP_LOGd(TAG, "slow_read() runs={}", gate->getRuns());
+    OATPP_ASSERT(gate->getRuns() == 2);
+    for(auto value : values) {
+      OATPP_ASSERT(value == 42);
+    }
+
+    /* writes are marked non-coalescable */
+    oatpp::String insertText;
+    oatpp::String readText;
+    for(auto& info : executor->prepareTemplates()) {
+      if(info.name == "insertRow") {
+        insertText = info.text;
+      } else if(info.name == "slowRead") {
+        readText = info.text;
+      }
+    }
+    OATPP_ASSERT(insertText && readText);
+
+    OATPP_ASSERT(executor->isCoalescable(insertText));
+    OATPP_ASSERT(client.insertRow(1)->isSuccess());
+    OATPP_ASSERT(!executor->isCoalescable(insertText));
+    OATPP_ASSERT(executor->isCoalescable(readText));
+
+    pool->stop();
+
+  }
+
+}
+
+}}}
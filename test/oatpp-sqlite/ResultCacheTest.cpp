@@ -0,0 +1,251 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "ResultCacheTest.hpp"
+
+#include "oatpp-sqlite/orm.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+namespace oatpp { namespace test { namespace sqlite {
+
+namespace {
+
+#include OATPP_CODEGEN_BEGIN(DTO)
+
+class CacheRow : public oatpp::DTO {
+
+  DTO_INIT(CacheRow, DTO);
+
+  DTO_FIELD(Int64, f_id);
+  DTO_FIELD(String, f_name);
+
+};
+
+#include OATPP_CODEGEN_END(DTO)
+
+#include OATPP_CODEGEN_BEGIN(DbClient)
+
+class MyClient : public oatpp::orm::DbClient {
+public:
+
+  MyClient(const std::shared_ptr<oatpp::orm::Executor>& executor)
+    : oatpp::orm::DbClient(executor)
+  {
+    oatpp::orm::SchemaMigration migration(executor, "ResultCacheTest");
+    migration.addFile(1, TEST_DB_MIGRATION "ResultCacheTest.sql");
+    migration.migrate();
+  }
+
+  QUERY(insertRow,
+        "INSERT INTO test_cache (f_id, f_name) VALUES (:f_id, :f_name)",
+        PARAM(Int64, f_id),
+        PARAM(String, f_name))
+
+  QUERY(selectById,
+        "SELECT * FROM test_cache WHERE f_id=:f_id",
+        PARAM(Int64, f_id))
+
+  QUERY(selectAll, "SELECT * FROM test_cache ORDER BY f_id")
+
+  QUERY(countAll, "SELECT count(*) FROM test_cache")
+
+  QUERY(dropTable, "DROP TABLE test_cache")
+
+  QUERY(deleteAll, "DELETE FROM test_cache")
+
+  QUERY(createKeysTable,
+        "CREATE TABLE IF NOT EXISTS test_cache_keys (f_key TEXT PRIMARY KEY, f_value INTEGER) WITHOUT ROWID")
+
+  QUERY(insertKey,
+        "INSERT INTO test_cache_keys (f_key, f_value) VALUES (:f_key, :f_value)",
+        PARAM(String, f_key),
+        PARAM(Int64, f_value))
+
+  QUERY(countKeys, "SELECT count(*) FROM test_cache_keys")
+
+};
+
+#include OATPP_CODEGEN_END(DbClient)
+
+}
+
+void ResultCacheTest::onRun() {
+
+  OATPP_LOGi(TAG, "DB-File='{}'", TEST_DB_FILE);
+  std::remove(TEST_DB_FILE);
+
+  auto connectionProvider = std::make_shared<oatpp::sqlite::ConnectionProvider>(TEST_DB_FILE);
+  auto executor = std::make_shared<oatpp::sqlite::Executor>(connectionProvider);
+
+  auto cache = std::make_shared<oatpp::sqlite::ResultCache>();
+  executor->setResultCache(cache);
+
+  auto client = MyClient(executor);
+
+  client.insertRow(1, "one");
+  client.insertRow(2, "two");
+
+  {
+    auto rows = client.selectAll()->fetch<oatpp::Vector<oatpp::Object<CacheRow>>>();
+    OATPP_ASSERT(rows->size() == 2);
+  }
+
+  {
+    auto res = client.selectAll();
+    OATPP_ASSERT(res->isSuccess());
+    OATPP_ASSERT(res->getKnownCount() == 2);
+    auto rows = res->fetch<oatpp::Vector<oatpp::Object<CacheRow>>>();
+    OATPP_ASSERT(rows->size() == 2);
+    OATPP_ASSERT(rows[0]->f_id == 1);
+    OATPP_ASSERT(rows[0]->f_name == "one");
+    OATPP_ASSERT(rows[1]->f_id == 2);
+    OATPP_ASSERT(rows[1]->f_name == "two");
+  }
+
+  {
+    auto stats = cache->getStats();
+    OATPP_LOGd(TAG, "hits={}, misses={}", stats.hits, stats.misses);
+    OATPP_ASSERT(stats.hits == 1);
+    OATPP_ASSERT(stats.entriesCount == 1);
+  }
+
+  {
+    auto rows1 = client.selectById(1)->fetch<oatpp::Vector<oatpp::Object<CacheRow>>>();
+    auto rows2 = client.selectById(2)->fetch<oatpp::Vector<oatpp::Object<CacheRow>>>();
+    OATPP_ASSERT(rows1->size() == 1 && rows1[0]->f_name == "one");
+    OATPP_ASSERT(rows2->size() == 1 && rows2[0]->f_name == "two");
+    OATPP_ASSERT(cache->getStats().entriesCount == 3);
+  }
+
+  client.insertRow(3, "three");
+
+  {
+    auto stats = cache->getStats();
+    OATPP_ASSERT(stats.entriesCount == 0);
+    OATPP_ASSERT(stats.invalidations == 3);
+  }
+
+  {
+    auto rows = client.selectAll()->fetch<oatpp::Vector<oatpp::Object<CacheRow>>>();
+    OATPP_ASSERT(rows->size() == 3);
+  }
+
+  {
+    auto transaction = client.beginTransaction();
+    client.insertRow(4, "four", transaction.getConnection());
+    auto rows = client.selectAll(transaction.getConnection())->fetch<oatpp::Vector<oatpp::Object<CacheRow>>>();
+    OATPP_ASSERT(rows->size() == 4);
+    transaction.rollback();
+  }
+
+  {
+    auto rows = client.selectAll()->fetch<oatpp::Vector<oatpp::Object<CacheRow>>>();
+    OATPP_ASSERT(rows->size() == 3);
+  }
+
+  /* statements of cached queries are kept in the statement cache of the connection */
+  {
+    auto connection = executor->getConnection();
+    auto sqliteConnection = std::static_pointer_cast<oatpp::sqlite::Connection>(connection.object);
+    oatpp::String query = "SELECT count(*) FROM test_cache";
+
+    /* first run - tables of the query are collected by a fresh prepare */
+    auto count = client.countAll(connection)->fetch<oatpp::Vector<oatpp::Vector<oatpp::Int64>>>();
+    OATPP_ASSERT(*count[0][0] == 3);
+    OATPP_ASSERT(sqliteConnection->hasCachedStatement(query));
+
+    client.insertRow(5, "five", connection);
+
+    /* tables are known - cached statement is reused and returned */
+    count = client.countAll(connection)->fetch<oatpp::Vector<oatpp::Vector<oatpp::Int64>>>();
+    OATPP_ASSERT(*count[0][0] == 4);
+    OATPP_ASSERT(sqliteConnection->hasCachedStatement(query));
+
+    auto stats = cache->getStats();
+    count = client.countAll(connection)->fetch<oatpp::Vector<oatpp::Vector<oatpp::Int64>>>();
+    OATPP_ASSERT(*count[0][0] == 4);
+    OATPP_ASSERT(cache->getStats().hits == stats.hits + 1);
+  }
+
+  /* application authorizer stays installed after tables of cached queries are collected */
+  {
+    connectionProvider->setAuthorizer([](int action, const char* arg1, const char* arg2, const char* database, const char* trigger) {
+      (void) arg2;
+      (void) database;
+      (void) trigger;
+      return action == SQLITE_DROP_TABLE && std::strcmp(arg1, "test_cache") == 0 ? SQLITE_DENY : SQLITE_OK;
+    });
+
+    auto rows = client.selectById(2)->fetch<oatpp::Vector<oatpp::Object<CacheRow>>>();
+    OATPP_ASSERT(rows->size() == 1);
+
+    auto res = client.dropTable();
+    OATPP_ASSERT(!res->isSuccess());
+
+    connectionProvider->setAuthorizer(nullptr);
+  }
+
+  /* DELETE without WHERE - rows are not deleted by the truncate optimization, the update hook sees them */
+  {
+    auto rows = client.selectAll()->fetch<oatpp::Vector<oatpp::Object<CacheRow>>>();
+    OATPP_ASSERT(rows->size() == 4);
+    rows = client.selectAll()->fetch<oatpp::Vector<oatpp::Object<CacheRow>>>();
+    OATPP_ASSERT(rows->size() == 4);
+
+    OATPP_ASSERT(client.deleteAll()->isSuccess());
+
+    rows = client.selectAll()->fetch<oatpp::Vector<oatpp::Object<CacheRow>>>();
+    OATPP_ASSERT(rows->size() == 0);
+  }
+
+  /* WITHOUT ROWID table - changes are not reported by the update hook, written tables are collected by the authorizer */
+  {
+    OATPP_ASSERT(client.createKeysTable()->isSuccess());
+    client.insertKey("a", 1);
+
+    auto count = client.countKeys()->fetch<oatpp::Vector<oatpp::Vector<oatpp::Int64>>>();
+    OATPP_ASSERT(*count[0][0] == 1);
+
+    auto stats = cache->getStats();
+    count = client.countKeys()->fetch<oatpp::Vector<oatpp::Vector<oatpp::Int64>>>();
+    OATPP_ASSERT(*count[0][0] == 1);
+    OATPP_ASSERT(cache->getStats().hits == stats.hits + 1);
+
+    client.insertKey("b", 2);
+
+    count = client.countKeys()->fetch<oatpp::Vector<oatpp::Vector<oatpp::Int64>>>();
+    OATPP_ASSERT(*count[0][0] == 2);
+
+    /* statement is taken from the statement cache - written tables are still reported */
+    client.insertKey("c", 3);
+
+    count = client.countKeys()->fetch<oatpp::Vector<oatpp::Vector<oatpp::Int64>>>();
+    OATPP_ASSERT(*count[0][0] == 3);
+  }
+
+}
+
+}}}
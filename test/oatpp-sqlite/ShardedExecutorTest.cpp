@@ -0,0 +1,264 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "ShardedExecutorTest.hpp"
+
+#include "oatpp-sqlite/orm.hpp"
+
+#include <cstdio>
+#include <string>
+
+namespace oatpp { namespace test { namespace sqlite {
+
+namespace {
+
+#include OATPP_CODEGEN_BEGIN(DTO)
+
+class Row : public oatpp::DTO {
+
+  DTO_INIT(Row, DTO);
+
+  DTO_FIELD(Int64, f_user);
+  DTO_FIELD(String, f_data);
+
+};
+
+class UserRow : public oatpp::DTO {
+
+  DTO_INIT(UserRow, DTO);
+
+  DTO_FIELD(Int64, user);
+  DTO_FIELD(String, f_data);
+
+};
+
+#include OATPP_CODEGEN_END(DTO)
+
+#include OATPP_CODEGEN_BEGIN(DbClient)
+
+class MyClient : public oatpp::orm::DbClient {
+public:
+
+  MyClient(const std::shared_ptr<oatpp::orm::Executor>& executor)
+    : oatpp::orm::DbClient(executor)
+  {}
+
+  QUERY(insertRow,
+        "INSERT INTO test_shard (f_user, f_data) VALUES (:user, :f_data)",
+        PARAM(Int64, user),
+        PARAM(String, f_data))
+
+  QUERY(getUserRows,
+        "SELECT * FROM test_shard WHERE f_user=:user",
+        PARAM(Int64, user))
+
+  QUERY(getAllRows, "SELECT * FROM test_shard")
+
+  QUERY(countRows, "SELECT count(*) FROM test_shard")
+
+  QUERY(insertUserRow,
+        "INSERT INTO test_shard (f_user, f_data) VALUES (:row.user, :row.f_data)",
+        PARAM(oatpp::Object<UserRow>, row))
+
+  QUERY(deleteAll, "DELETE FROM test_shard")
+
+};
+
+#include OATPP_CODEGEN_END(DbClient)
+
+}
+
+void ShardedExecutorTest::onRun() {
+
+  const v_int32 shardsCount = 3;
+
+  std::vector<oatpp::String> files;
+  std::vector<std::shared_ptr<oatpp::sqlite::Executor>> shards;
+
+  for(v_int32 i = 0; i < shardsCount; i ++) {
+    oatpp::String file = TEST_DB_FILE ".shard" + std::to_string(i);
+    std::remove(file->c_str());
+    files.push_back(file);
+    auto connectionProvider = std::make_shared<oatpp::sqlite::ConnectionProvider>(file);
+    auto executor = std::make_shared<oatpp::sqlite::Executor>(connectionProvider);
+    oatpp::orm::SchemaMigration migration(executor, "ShardedExecutorTest");
+    migration.addFile(1, TEST_DB_MIGRATION "ShardedExecutorTest.sql");
+    migration.migrate();
+    shards.push_back(executor);
+  }
+
+  auto executor = std::make_shared<oatpp::sqlite::ShardedExecutor>(shards, "user");
+  auto client = MyClient(executor);
+
+  for(v_int64 user = 0; user < 30; user ++) {
+    for(v_int32 i = 0; i < 2; i ++) {
+      auto res = client.insertRow(user, "data - " + std::to_string(i));
+      OATPP_ASSERT(res->isSuccess());
+    }
+  }
+
+  {
+    auto rows = client.getUserRows(7)->fetch<oatpp::Vector<oatpp::Object<Row>>>();
+    OATPP_ASSERT(rows->size() == 2);
+    OATPP_ASSERT(rows[0]->f_user == 7);
+  }
+
+  {
+    auto rows = client.getAllRows()->fetch<oatpp::Vector<oatpp::Object<Row>>>();
+    OATPP_ASSERT(rows->size() == 60);
+  }
+
+  /* rows are actually spread across shards */
+  for(v_int32 i = 0; i < shardsCount; i ++) {
+    auto shardClient = MyClient(executor->getShard(i));
+    auto rows = shardClient.getAllRows()->fetch<oatpp::Vector<oatpp::Object<Row>>>();
+    OATPP_ASSERT(rows->size() > 0 && rows->size() < 60);
+    for(auto& row : *rows) {
+      OATPP_ASSERT(executor->getShardIndex(row->f_user) == i);
+    }
+  }
+
+  /* shard key is a property of the DTO parameter - row goes to a single shard */
+  {
+    auto row = UserRow::createShared();
+    row->user = 31;
+    row->f_data = "from dto";
+    OATPP_ASSERT(client.insertUserRow(row)->isSuccess());
+
+    auto rows = client.getUserRows(31)->fetch<oatpp::Vector<oatpp::Object<Row>>>();
+    OATPP_ASSERT(rows->size() == 1);
+    OATPP_ASSERT(rows[0]->f_data == "from dto");
+
+    auto shardClient = MyClient(executor->getShard(executor->getShardIndex(oatpp::Int64(31))));
+    rows = shardClient.getUserRows(31)->fetch<oatpp::Vector<oatpp::Object<Row>>>();
+    OATPP_ASSERT(rows->size() == 1);
+  }
+
+  /* statements modifying data without the shard key value are not broadcast to all shards */
+  {
+    bool thrown = false;
+    try {
+      client.insertRow(nullptr, "null key");
+    } catch (const std::runtime_error&) {
+      thrown = true;
+    }
+    OATPP_ASSERT(thrown);
+
+    auto row = UserRow::createShared();
+    row->f_data = "null key in dto";
+    thrown = false;
+    try {
+      client.insertUserRow(row);
+    } catch (const std::runtime_error&) {
+      thrown = true;
+    }
+    OATPP_ASSERT(thrown);
+
+    thrown = false;
+    try {
+      client.deleteAll();
+    } catch (const std::runtime_error&) {
+      thrown = true;
+    }
+    OATPP_ASSERT(thrown);
+
+    auto rows = client.getAllRows()->fetch<oatpp::Vector<oatpp::Object<Row>>>();
+    OATPP_ASSERT(rows->size() == 61);
+  }
+
+  /* per-shard transaction */
+  {
+    oatpp::Int64 user = 11;
+    auto connection = executor->getConnection(user);
+    auto transaction = client.beginTransaction(connection);
+    client.insertRow(user, "in transaction", connection);
+    transaction.rollback();
+    auto rows = client.getUserRows(user)->fetch<oatpp::Vector<oatpp::Object<Row>>>();
+    OATPP_ASSERT(rows->size() == 2);
+  }
+
+  /* explicit connection without the shard key runs on the shard owning the connection */
+  for(v_int32 i = 0; i < shardsCount; i ++) {
+    OATPP_ASSERT(executor->getConnectionShardIndex(executor->getShard(i)->getConnection()) == i);
+  }
+
+  {
+    oatpp::Int64 user = 11;
+    v_int32 index = executor->getShardIndex(user);
+    auto connection = executor->getShard(index)->getConnection();
+    auto shardClient = MyClient(executor->getShard(index));
+    auto expected = shardClient.getAllRows()->fetch<oatpp::Vector<oatpp::Object<Row>>>()->size();
+    auto count = client.countRows(connection)->fetch<oatpp::Vector<oatpp::Vector<oatpp::Int64>>>();
+    OATPP_ASSERT(*count[0][0] == static_cast<v_int64>(expected));
+
+    /* transaction is begun and committed on the owning shard */
+    auto transaction = client.beginTransaction(connection);
+    client.insertRow(user, "in transaction", connection);
+    OATPP_ASSERT(transaction.commit()->isSuccess());
+    auto rows = client.getUserRows(user)->fetch<oatpp::Vector<oatpp::Object<Row>>>();
+    OATPP_ASSERT(rows->size() == 3);
+
+    /* key of another shard on this connection is an error */
+    oatpp::Int64 otherUser;
+    for(v_int64 u = 0; u < 30; u ++) {
+      if(executor->getShardIndex(oatpp::Int64(u)) != index) {
+        otherUser = u;
+        break;
+      }
+    }
+    bool thrown = false;
+    try {
+      client.insertRow(otherUser, "wrong shard", connection);
+    } catch (const std::runtime_error&) {
+      thrown = true;
+    }
+    OATPP_ASSERT(thrown);
+  }
+
+  /* connection of a database outside of the shards is rejected */
+  {
+    oatpp::String file = TEST_DB_FILE ".shard-other";
+    std::remove(file->c_str());
+    auto other = std::make_shared<oatpp::sqlite::Executor>(std::make_shared<oatpp::sqlite::ConnectionProvider>(file));
+    bool thrown = false;
+    try {
+      executor->getConnectionShardIndex(other->getConnection());
+    } catch (const std::runtime_error&) {
+      thrown = true;
+    }
+    OATPP_ASSERT(thrown);
+    other.reset();
+    std::remove(file->c_str());
+  }
+
+  shards.clear();
+  executor.reset();
+
+  for(auto& file : files) {
+    std::remove(file->c_str());
+  }
+
+}
+
+}}}
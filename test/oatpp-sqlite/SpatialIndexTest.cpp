@@ -0,0 +1,217 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#include "SpatialIndexTest.hpp"
+
+#include "oatpp-sqlite/orm.hpp"
+
+#include <cstdio>
+
+namespace oatpp { namespace test { namespace sqlite {
+
+namespace {
+
+#include OATPP_CODEGEN_BEGIN(DTO)
+
+class Place : public oatpp::DTO {
+
+  DTO_INIT(Place, DTO);
+
+  DTO_FIELD(Int64, f_id);
+  DTO_FIELD(String, f_name);
+  DTO_FIELD(Float64, f_lon);
+  DTO_FIELD(Float64, f_lat);
+
+};
+
+class CountRow : public oatpp::DTO {
+
+  DTO_INIT(CountRow, DTO);
+
+  DTO_FIELD(Int64, f_count);
+
+};
+
+#include OATPP_CODEGEN_END(DTO)
+
+#include OATPP_CODEGEN_BEGIN(DbClient)
+
+class MyClient : public oatpp::orm::DbClient {
+public:
+
+  MyClient(const std::shared_ptr<oatpp::orm::Executor>& executor)
+    : oatpp::orm::DbClient(executor)
+  {}
+
+  QUERY(generateGrid,
+        "WITH RECURSIVE seq(n) AS (SELECT 0 UNION ALL SELECT n + 1 FROM seq WHERE n < :count - 1) "
+        "INSERT INTO test_places (f_name, f_lon, f_lat) "
+        "SELECT printf('grid %d', n), (n % 100) * 0.01, (n / 100) * 0.01 FROM seq",
+        PARAM(Int64, count))
+
+  QUERY(movePlace,
+        "UPDATE test_places SET f_lon=:lon, f_lat=:lat WHERE f_id=:id",
+        PARAM(Int64, id),
+        PARAM(Float64, lon),
+        PARAM(Float64, lat))
+
+  QUERY(renamePlace,
+        "UPDATE test_places SET f_name=:name WHERE f_id=:id",
+        PARAM(Int64, id),
+        PARAM(String, name))
+
+  QUERY(deletePlace,
+        "DELETE FROM test_places WHERE f_id=:id",
+        PARAM(Int64, id))
+
+  QUERY(countInBoxScan,
+        "SELECT count(*) AS f_count FROM test_places "
+        "WHERE f_lon >= :minLon AND f_lon <= :maxLon AND f_lat >= :minLat AND f_lat <= :maxLat",
+        PARAM(Float64, minLon),
+        PARAM(Float64, maxLon),
+        PARAM(Float64, minLat),
+        PARAM(Float64, maxLat))
+
+};
+
+#include OATPP_CODEGEN_END(DbClient)
+
+}
+
+void SpatialIndexTest::onRun() {
+
+  oatpp::String file = TEST_DB_FILE ".rtree";
+  std::remove(file->c_str());
+
+  {
+
+    oatpp::sqlite::SpatialIndex::Config config;
+    config.table = "test_places_rtree";
+    config.contentTable = "test_places";
+    config.contentRowId = "f_id";
+    config.dimensions = {
+      oatpp::sqlite::SpatialIndex::Dimension::point("f_lon"),
+      oatpp::sqlite::SpatialIndex::Dimension::point("f_lat")
+    };
+
+    oatpp::sqlite::SpatialIndex index(config);
+
+    auto connectionProvider = std::make_shared<oatpp::sqlite::ConnectionProvider>(file);
+    auto pool = oatpp::sqlite::ConnectionPool::createShared(connectionProvider, 2, std::chrono::seconds(60));
+    auto executor = std::make_shared<oatpp::sqlite::Executor>(pool);
+
+    oatpp::orm::SchemaMigration migration(executor, "SpatialIndexTest");
+    migration.addFile(1, TEST_DB_MIGRATION "SpatialIndexTest.sql");
+    migration.addText(2, index.getCreateScript());
+    migration.migrate();
+
+    MyClient client(executor);
+
+    {
+      auto places = index.find<Place>(executor, {{10, 11}, {20, 21}});
+      OATPP_ASSERT(places->size() == 1);
+      OATPP_ASSERT(places[0]->f_name == "existing");
+    }
+
+    OATPP_ASSERT(client.generateGrid(10000)->isSuccess());
+
+    {
+      auto places = index.find<Place>(executor, {{0.095, 0.195}, {0.095, 0.195}});
+      OATPP_ASSERT(places->size() == 100);
+      for(auto& place : *places) {
+        OATPP_ASSERT(*place->f_lon >= 0.095 && *place->f_lon <= 0.195);
+        OATPP_ASSERT(*place->f_lat >= 0.095 && *place->f_lat <= 0.195);
+      }
+
+      places = index.find<Place>(executor, {{0.095, 0.195}, {0.095, 0.195}}, 7);
+      OATPP_ASSERT(places->size() == 7);
+    }
+
+    {
+      OATPP_ASSERT(client.movePlace(1, 50.0, 50.0)->isSuccess());
+      OATPP_ASSERT(client.movePlace(2, 60.0, 60.0)->isSuccess());
+      OATPP_ASSERT(client.renamePlace(1, "moved")->isSuccess());
+
+      OATPP_ASSERT(index.find<Place>(executor, {{10, 11}, {20, 21}})->size() == 0);
+
+      auto places = index.find<Place>(executor, {{49, 61}, {49, 61}});
+      OATPP_ASSERT(places->size() == 2);
+
+      OATPP_ASSERT(client.deletePlace(1)->isSuccess());
+      places = index.find<Place>(executor, {{49, 61}, {49, 61}});
+      OATPP_ASSERT(places->size() == 1);
+      OATPP_ASSERT(*places[0]->f_id == 2);
+    }
+
+    bool thrown = false;
+    try {
+      index.find<Place>(executor, {{0, 1}});
+    } catch (std::runtime_error& e) {
+      OATPP_LOGd(TAG, "error='{}'", e.what());
+      thrown = true;
+    }
+    OATPP_ASSERT(thrown);
+
+    /* benchmark - full scan vs R*Tree. Single run checks results only - see OATPP_SQLITE_BENCHMARKS */
+
+#ifdef OATPP_SQLITE_BENCHMARKS
+    const v_int32 iterations = 20;
+#else
+    const v_int32 iterations = 1;
+#endif
+
+    v_int64 scanTime = 0;
+    v_int64 scanCount = 0;
+    {
+      v_int64 start = oatpp::Environment::getMicroTickCount();
+      for(v_int32 i = 0; i < iterations; i ++) {
+        auto count = client.countInBoxScan(0.5, 0.55, 0.5, 0.55)->fetch<oatpp::Vector<oatpp::Object<CountRow>>>();
+        scanCount = *count[0]->f_count;
+      }
+      scanTime = (oatpp::Environment::getMicroTickCount() - start) / iterations;
+    }
+
+    v_int64 indexTime = 0;
+    v_int64 indexCount = 0;
+    {
+      v_int64 start = oatpp::Environment::getMicroTickCount();
+      for(v_int32 i = 0; i < iterations; i ++) {
+        indexCount = index.find<Place>(executor, {{0.5, 0.55}, {0.5, 0.55}})->size();
+      }
+      indexTime = (oatpp::Environment::getMicroTickCount() - start) / iterations;
+    }
+
+    OATPP_LOGi(TAG, "Places=10000, in box={}: scan {} us, R*Tree {} us", indexCount, scanTime, indexTime);
+    OATPP_ASSERT(indexCount == scanCount);
+
+    pool->stop();
+
+  }
+
+  std::remove(file->c_str());
+
+}
+
+}}}
@@ -0,0 +1,250 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#include "TenantConnectionProviderTest.hpp"
+
+#include "oatpp-sqlite/orm.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+namespace oatpp { namespace test { namespace sqlite {
+
+namespace {
+
+#include OATPP_CODEGEN_BEGIN(DbClient)
+
+class MyClient : public oatpp::orm::DbClient {
+public:
+
+  MyClient(const std::shared_ptr<oatpp::orm::Executor>& executor)
+    : oatpp::orm::DbClient(executor)
+  {}
+
+  QUERY(insertRow,
+        "INSERT INTO test_tenant (f_name) VALUES (:f_name)",
+        PARAM(String, f_name))
+
+  QUERY(selectNames, "SELECT f_name FROM test_tenant ORDER BY f_id")
+
+  QUERY(getCacheSize, "PRAGMA cache_size")
+
+};
+
+#include OATPP_CODEGEN_END(DbClient)
+
+const char* const TENANTS[] = {"a", "b", "c", "idle"};
+
+oatpp::String getTenantFile(const oatpp::String& tenant) {
+  return TEST_DB_FILE ".tenant-" + *tenant;
+}
+
+std::vector<std::string> selectNames(MyClient& client,
+                                     const oatpp::provider::ResourceHandle<oatpp::orm::Connection>& connection = nullptr)
+{
+  auto res = client.selectNames(connection);
+  OATPP_ASSERT(res->isSuccess());
+  auto rows = res->fetch<oatpp::Vector<oatpp::Vector<oatpp::String>>>();
+  std::vector<std::string> result;
+  for(auto& row : *rows) {
+    result.push_back(*row[0]);
+  }
+  return result;
+}
+
+}
+
+void TenantConnectionProviderTest::onRun() {
+
+  typedef oatpp::sqlite::TenantConnectionProvider::Scope Scope;
+
+  for(auto tenant : TENANTS) {
+    std::remove(getTenantFile(tenant)->c_str());
+  }
+
+  {
+
+    oatpp::sqlite::TenantConnectionProvider::Config config;
+    config.maxTenants = 2;
+    config.tenantIdleTime = std::chrono::microseconds(0);
+
+    std::atomic<v_int32> configuredCount(0);
+    config.providerConfigurator = [&configuredCount](const std::shared_ptr<oatpp::sqlite::ConnectionProvider>& provider) {
+      configuredCount ++;
+      provider->addInitHook("cache_size", [](sqlite3* handle) {
+        sqlite3_exec(handle, "PRAGMA cache_size=-1234", nullptr, nullptr, nullptr);
+      });
+    };
+
+    auto connectionProvider = std::make_shared<oatpp::sqlite::TenantConnectionProvider>(&getTenantFile, config);
+    connectionProvider->addMigration(1, "CREATE TABLE test_tenant (f_id INTEGER PRIMARY KEY, f_name VARCHAR);");
+
+    auto executor = std::make_shared<oatpp::sqlite::Executor>(connectionProvider);
+    executor->setResultCache(std::make_shared<oatpp::sqlite::ResultCache>());
+    executor->setRequestCoalescing(true);
+
+    MyClient client(executor);
+
+    /* no current tenant */
+    {
+      bool thrown = false;
+      try {
+        client.selectNames();
+      } catch (const std::runtime_error&) {
+        thrown = true;
+      }
+      OATPP_ASSERT(thrown);
+    }
+
+    /* routing and lazy migration */
+    {
+      Scope scope("a");
+      OATPP_ASSERT(client.insertRow("alpha")->isSuccess());
+    }
+    {
+      Scope scope("b");
+      OATPP_ASSERT(client.insertRow("beta")->isSuccess());
+    }
+
+    {
+      auto stats = connectionProvider->getStats();
+      OATPP_ASSERT(stats.openTenants == 2);
+      OATPP_ASSERT(stats.opensCount == 2);
+      OATPP_ASSERT(stats.migrationsCount == 2);
+    }
+
+    /* tenant providers are configured before use */
+    {
+      OATPP_ASSERT(configuredCount == 2);
+      Scope scope("a");
+      auto rows = client.getCacheSize()->fetch<oatpp::Vector<oatpp::Vector<oatpp::Int64>>>();
+      OATPP_ASSERT(*rows[0][0] == -1234);
+    }
+
+    /* cached results are not shared between tenants */
+    for(v_int32 i = 0; i < 2; i ++) {
+      {
+        Scope scope("a");
+        OATPP_ASSERT(selectNames(client) == std::vector<std::string>({"alpha"}));
+      }
+      {
+        Scope scope("b");
+        OATPP_ASSERT(selectNames(client) == std::vector<std::string>({"beta"}));
+      }
+    }
+    OATPP_ASSERT(executor->getResultCache()->getStats().hits == 2);
+
+    /* explicit connections of different tenants */
+    {
+      oatpp::provider::ResourceHandle<oatpp::orm::Connection> connectionA;
+      oatpp::provider::ResourceHandle<oatpp::orm::Connection> connectionB;
+      {
+        Scope scope("a");
+        connectionA = executor->getConnection();
+      }
+      {
+        Scope scope("b");
+        connectionB = executor->getConnection();
+      }
+      OATPP_ASSERT(selectNames(client, connectionA) == std::vector<std::string>({"alpha"}));
+      OATPP_ASSERT(selectNames(client, connectionB) == std::vector<std::string>({"beta"}));
+    }
+
+    /* explicit tenant */
+    {
+      auto connection = connectionProvider->get("a");
+      auto fileName = sqlite3_db_filename(connection.object->getHandle(), "main");
+      OATPP_ASSERT(std::strstr(fileName, ".tenant-a") != nullptr);
+    }
+
+    /* LRU eviction - "b" is the least recently used */
+    {
+      Scope scope("c");
+      OATPP_ASSERT(client.insertRow("gamma")->isSuccess());
+    }
+
+    {
+      auto stats = connectionProvider->getStats();
+      OATPP_ASSERT(stats.openTenants == 2);
+      OATPP_ASSERT(stats.evictionsCount == 1);
+      OATPP_ASSERT(stats.migrationsCount == 3);
+    }
+
+    /* reopened tenant keeps its data and is not migrated again */
+    {
+      Scope scope("b");
+      OATPP_ASSERT(client.insertRow("beta-2")->isSuccess());
+      OATPP_ASSERT(selectNames(client) == std::vector<std::string>({"beta", "beta-2"}));
+    }
+
+    {
+      auto stats = connectionProvider->getStats();
+      OATPP_ASSERT(stats.opensCount == 4);
+      OATPP_ASSERT(stats.evictionsCount == 2);
+      OATPP_ASSERT(stats.migrationsCount == 3);
+    }
+
+    OATPP_ASSERT(connectionProvider->closeTenant("b"));
+    OATPP_ASSERT(!connectionProvider->closeTenant("b"));
+    OATPP_ASSERT(connectionProvider->getStats().openTenants == 1);
+
+    connectionProvider->stop();
+
+  }
+
+  /* idle close */
+  {
+
+    oatpp::sqlite::TenantConnectionProvider::Config config;
+    config.tenantIdleTime = std::chrono::milliseconds(100);
+
+    auto connectionProvider = std::make_shared<oatpp::sqlite::TenantConnectionProvider>(&getTenantFile, config);
+
+    {
+      auto connection = connectionProvider->get("idle");
+      OATPP_ASSERT(connection);
+    }
+
+    OATPP_ASSERT(connectionProvider->closeIdleTenants() == 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    OATPP_ASSERT(connectionProvider->closeIdleTenants() == 1);
+
+    auto stats = connectionProvider->getStats();
+    OATPP_ASSERT(stats.openTenants == 0);
+    OATPP_ASSERT(stats.idleClosesCount == 1);
+
+    connectionProvider->stop();
+
+  }
+
+  for(auto tenant : TENANTS) {
+    std::remove(getTenantFile(tenant)->c_str());
+  }
+
+}
+
+}}}
@@ -0,0 +1,230 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "TransactionTest.hpp"
+
+#include "oatpp-sqlite/orm.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+namespace oatpp { namespace test { namespace sqlite {
+
+namespace {
+
+#include OATPP_CODEGEN_BEGIN(DbClient)
+
+class MyClient : public oatpp::orm::DbClient {
+public:
+
+  MyClient(const std::shared_ptr<oatpp::orm::Executor>& executor)
+    : oatpp::orm::DbClient(executor)
+  {}
+
+  QUERY(createTable,
+        "CREATE TABLE IF NOT EXISTS test_transaction (f_id INTEGER PRIMARY KEY, f_name VARCHAR)")
+
+  QUERY(insertRow,
+        "INSERT INTO test_transaction (f_id, f_name) VALUES (:f_id, :f_name)",
+        PARAM(Int64, f_id),
+        PARAM(String, f_name))
+
+  QUERY(insertRowOrRollback,
+        "INSERT OR ROLLBACK INTO test_transaction (f_id, f_name) VALUES (:f_id, :f_name)",
+        PARAM(Int64, f_id),
+        PARAM(String, f_name))
+
+  QUERY(deleteAll, "DELETE FROM test_transaction")
+
+  QUERY(countRows, "SELECT count(*) FROM test_transaction")
+
+};
+
+#include OATPP_CODEGEN_END(DbClient)
+
+v_int64 countRows(MyClient& client) {
+  auto rows = client.countRows()->fetch<oatpp::Vector<oatpp::Vector<oatpp::Int64>>>();
+  return *rows[0][0];
+}
+
+v_int32 getDepth(const oatpp::provider::ResourceHandle<oatpp::orm::Connection>& connection) {
+  return std::static_pointer_cast<oatpp::sqlite::Connection>(connection.object)->getTransactionDepth();
+}
+
+}
+
+void TransactionTest::onRun() {
+
+  oatpp::String file = TEST_DB_FILE ".transaction";
+  std::remove(file->c_str());
+
+  {
+
+    auto connectionProvider = std::make_shared<oatpp::sqlite::ConnectionProvider>(file);
+    auto executor = std::make_shared<oatpp::sqlite::Executor>(connectionProvider);
+
+    MyClient client(executor);
+    OATPP_ASSERT(client.createTable()->isSuccess());
+
+    /* nested begin is a SAVEPOINT - rolling back the inner level keeps the outer work */
+    {
+      auto connection = executor->getConnection();
+
+      OATPP_ASSERT(executor->begin(connection)->isSuccess());
+      OATPP_ASSERT(getDepth(connection) == 1);
+      OATPP_ASSERT(client.insertRow(1, "outer", connection)->isSuccess());
+
+      OATPP_ASSERT(executor->begin(connection)->isSuccess());
+      OATPP_ASSERT(getDepth(connection) == 2);
+      OATPP_ASSERT(client.insertRow(2, "inner", connection)->isSuccess());
+      OATPP_ASSERT(executor->rollback(connection)->isSuccess());
+      OATPP_ASSERT(getDepth(connection) == 1);
+
+      /* still in the outer transaction */
+      OATPP_ASSERT(sqlite3_get_autocommit(std::static_pointer_cast<oatpp::sqlite::Connection>(connection.object)->getHandle()) == 0);
+
+      OATPP_ASSERT(executor->begin(connection)->isSuccess());
+      OATPP_ASSERT(client.insertRow(3, "inner", connection)->isSuccess());
+      OATPP_ASSERT(executor->commit(connection)->isSuccess());
+      OATPP_ASSERT(getDepth(connection) == 1);
+
+      OATPP_ASSERT(executor->commit(connection)->isSuccess());
+      OATPP_ASSERT(getDepth(connection) == 0);
+
+      OATPP_ASSERT(countRows(client) == 2);
+    }
+
+    /* inner work is gone with the outer rollback even if the inner level was released */
+    {
+      auto connection = executor->getConnection();
+      OATPP_ASSERT(executor->begin(connection)->isSuccess());
+      OATPP_ASSERT(executor->begin(connection)->isSuccess());
+      OATPP_ASSERT(client.insertRow(4, "inner", connection)->isSuccess());
+      OATPP_ASSERT(executor->commit(connection)->isSuccess());
+      OATPP_ASSERT(executor->rollback(connection)->isSuccess());
+      OATPP_ASSERT(getDepth(connection) == 0);
+      OATPP_ASSERT(countRows(client) == 2);
+    }
+
+    /* depth is reset after SQLite rolled the transaction back by itself */
+    {
+      auto connection = executor->getConnection();
+      OATPP_ASSERT(executor->begin(connection)->isSuccess());
+      OATPP_ASSERT(executor->begin(connection)->isSuccess());
+      OATPP_ASSERT(getDepth(connection) == 2);
+
+      /* conflict resolution ROLLBACK ends the whole transaction */
+      OATPP_ASSERT(client.insertRowOrRollback(1, "duplicate", connection)->isSuccess() == false);
+      OATPP_ASSERT(sqlite3_get_autocommit(std::static_pointer_cast<oatpp::sqlite::Connection>(connection.object)->getHandle()) != 0);
+
+      /* next begin starts a new transaction - not a SAVEPOINT of the gone one */
+      OATPP_ASSERT(executor->begin(connection)->isSuccess());
+      OATPP_ASSERT(getDepth(connection) == 1);
+      OATPP_ASSERT(client.insertRow(5, "after", connection)->isSuccess());
+      OATPP_ASSERT(executor->commit(connection)->isSuccess());
+      OATPP_ASSERT(getDepth(connection) == 0);
+      OATPP_ASSERT(countRows(client) == 3);
+    }
+
+    OATPP_ASSERT(client.deleteAll()->isSuccess());
+
+    /* runTransaction retries while another connection holds the write lock */
+    {
+      auto holder = executor->getConnection();
+      OATPP_ASSERT(executor->begin(oatpp::sqlite::Executor::TransactionMode::IMMEDIATE, holder)->isSuccess());
+
+      std::chrono::milliseconds holdTime(200);
+
+      std::thread releaser([executor, holder, holdTime]{
+        std::this_thread::sleep_for(holdTime);
+        executor->commit(holder);
+      });
+
+      v_int32 calls = 0;
+      auto start = std::chrono::steady_clock::now();
+
+      oatpp::sqlite::Executor::RetryPolicy policy;
+      policy.maxAttempts = 1000;
+      policy.maxBackoff = std::chrono::milliseconds(10);
+
+      /* DEFERRED - begin succeeds, the write in the body fails with SQLITE_BUSY and the body is run again */
+      bool committed = executor->runTransaction([&client, &calls](const oatpp::provider::ResourceHandle<oatpp::orm::Connection>& connection) {
+        calls ++;
+        auto result = client.insertRow(1, "retried", connection);
+        if(!result->isSuccess()) {
+          throw std::runtime_error(*result->getErrorMessage());
+        }
+        return true;
+      }, oatpp::sqlite::Executor::TransactionMode::DEFERRED, policy);
+
+      auto elapsed = std::chrono::steady_clock::now() - start;
+      releaser.join();
+
+      OATPP_ASSERT(committed);
+      OATPP_ASSERT(calls > 1);
+      OATPP_ASSERT(elapsed >= holdTime - std::chrono::milliseconds(10));
+      OATPP_ASSERT(countRows(client) == 1);
+      OATPP_LOGd(TAG, "body calls={}", calls)
+    }
+
+    /* runTransaction gives up after maxAttempts */
+    {
+      auto holder = executor->getConnection();
+      OATPP_ASSERT(executor->begin(oatpp::sqlite::Executor::TransactionMode::IMMEDIATE, holder)->isSuccess());
+
+      oatpp::sqlite::Executor::RetryPolicy policy;
+      policy.maxAttempts = 3;
+
+      v_int32 calls = 0;
+      bool thrown = false;
+      try {
+        executor->runTransaction([&calls](const oatpp::provider::ResourceHandle<oatpp::orm::Connection>& connection) {
+          calls ++;
+          return true;
+        }, oatpp::sqlite::Executor::TransactionMode::IMMEDIATE, policy);
+      } catch (const std::runtime_error&) {
+        thrown = true;
+      }
+
+      OATPP_ASSERT(thrown);
+      /* BEGIN IMMEDIATE never got the lock - body was not run */
+      OATPP_ASSERT(calls == 0);
+
+      OATPP_ASSERT(executor->rollback(holder)->isSuccess());
+
+      /* lock is released - transaction goes through */
+      OATPP_ASSERT(executor->runTransaction([&client](const oatpp::provider::ResourceHandle<oatpp::orm::Connection>& connection) {
+        return client.insertRow(2, "after", connection)->isSuccess();
+      }, oatpp::sqlite::Executor::TransactionMode::IMMEDIATE, policy));
+      OATPP_ASSERT(countRows(client) == 2);
+    }
+
+  }
+
+  std::remove(file->c_str());
+
+}
+
+}}}
@@ -0,0 +1,272 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#include "VirtualTableTest.hpp"
+
+#include "oatpp-sqlite/orm.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+namespace oatpp { namespace test { namespace sqlite {
+
+namespace {
+
+#include OATPP_CODEGEN_BEGIN(DTO)
+
+class Item : public oatpp::DTO {
+
+  DTO_INIT(Item, DTO);
+
+  DTO_FIELD(Int64, f_id);
+  DTO_FIELD(String, f_name);
+  DTO_FIELD(Float64, f_price);
+
+};
+
+#include OATPP_CODEGEN_END(DTO)
+
+#include OATPP_CODEGEN_BEGIN(DbClient)
+
+class MyClient : public oatpp::orm::DbClient {
+public:
+
+  MyClient(const std::shared_ptr<oatpp::orm::Executor>& executor)
+    : oatpp::orm::DbClient(executor)
+  {}
+
+  QUERY(getAllItems,
+        "SELECT * FROM items ORDER BY f_id")
+
+  QUERY(getItemById,
+        "SELECT * FROM items WHERE f_id=:id",
+        PARAM(Int64, id))
+
+  QUERY(getItemsByName,
+        "SELECT * FROM items WHERE f_name=:name ORDER BY f_id",
+        PARAM(String, name))
+
+  QUERY(getRequestedItems,
+        "SELECT i.* FROM request_ids r JOIN items i ON i.f_id = r.id ORDER BY i.f_id")
+
+  QUERY(getNumbersByIntCode, "SELECT n FROM codes WHERE code = 5 ORDER BY n")
+
+  QUERY(getNumbersByRealCode, "SELECT n FROM codes WHERE code = 5.0 ORDER BY n")
+
+  QUERY(getNumbersByTextNumber,
+        "SELECT n FROM codes WHERE n = :n ORDER BY n",
+        PARAM(String, n))
+
+  QUERY(getNumbersByCodeNoCase, "SELECT n FROM codes WHERE code = 'x' COLLATE NOCASE ORDER BY n")
+
+  QUERY(getNumbersByCode,
+        "SELECT n FROM codes WHERE code = :code ORDER BY n",
+        PARAM(String, code))
+
+};
+
+#include OATPP_CODEGEN_END(DbClient)
+
+std::shared_ptr<const oatpp::sqlite::VirtualTable::Data> createIds(const oatpp::Vector<oatpp::Int64>& ids) {
+  auto data = std::make_shared<oatpp::sqlite::VirtualTable::ColumnarData>();
+  data->addColumn(ids);
+  return data;
+}
+
+std::vector<v_int64> selectNumbers(const std::shared_ptr<oatpp::orm::QueryResult>& result) {
+  OATPP_ASSERT(result->isSuccess());
+  auto rows = result->fetch<oatpp::Vector<oatpp::Vector<oatpp::Int64>>>();
+  std::vector<v_int64> numbers;
+  for(auto& row : *rows) {
+    numbers.push_back(*row[0]);
+  }
+  return numbers;
+}
+
+}
+
+void VirtualTableTest::onRun() {
+
+  oatpp::String file = TEST_DB_FILE ".vtab";
+  std::remove(file->c_str());
+
+  {
+
+    auto items = oatpp::sqlite::VirtualTable::createShared<Item>("items", {"f_id"});
+    auto requestIds = oatpp::sqlite::VirtualTable::createShared("request_ids", {
+      {"id", oatpp::Int64::Class::getType(), true}
+    });
+    auto codes = oatpp::sqlite::VirtualTable::createShared("codes", {
+      {"code", oatpp::String::Class::getType(), true},
+      {"n", oatpp::Int64::Class::getType(), true}
+    });
+
+    auto connectionProvider = std::make_shared<oatpp::sqlite::ConnectionProvider>(file);
+    connectionProvider->addVirtualTable(items);
+    connectionProvider->addVirtualTable(requestIds);
+    connectionProvider->addVirtualTable(codes);
+
+    auto pool = oatpp::sqlite::ConnectionPool::createShared(connectionProvider, 2, std::chrono::seconds(60));
+    auto executor = std::make_shared<oatpp::sqlite::Executor>(pool);
+
+    MyClient client(executor);
+
+    {
+      auto rows = client.getAllItems()->fetch<oatpp::Vector<oatpp::Object<Item>>>();
+      OATPP_ASSERT(rows->size() == 0);
+    }
+
+    auto list = oatpp::Vector<oatpp::Object<Item>>::createShared();
+    const char* names[] = {"apple", "pear", "apple", "plum"};
+    for(v_int32 i = 0; i < 4; i ++) {
+      auto item = Item::createShared();
+      item->f_id = (v_int64) (i + 1);
+      item->f_name = names[i];
+      item->f_price = 0.5 * (i + 1);
+      list->push_back(item);
+    }
+    items->setData(std::make_shared<oatpp::sqlite::VirtualTable::ObjectData>(list));
+
+    {
+      auto rows = client.getAllItems()->fetch<oatpp::Vector<oatpp::Object<Item>>>();
+      OATPP_ASSERT(rows->size() == 4);
+      OATPP_ASSERT(*rows[3]->f_id == 4);
+      OATPP_ASSERT(rows[3]->f_name == "plum");
+      OATPP_ASSERT(*rows[3]->f_price == 2.0);
+    }
+
+    {
+      auto rows = client.getItemById(3)->fetch<oatpp::Vector<oatpp::Object<Item>>>();
+      OATPP_ASSERT(rows->size() == 1);
+      OATPP_ASSERT(rows[0]->f_name == "apple");
+
+      rows = client.getItemById(10)->fetch<oatpp::Vector<oatpp::Object<Item>>>();
+      OATPP_ASSERT(rows->size() == 0);
+    }
+
+    {
+      auto rows = client.getItemsByName("apple")->fetch<oatpp::Vector<oatpp::Object<Item>>>();
+      OATPP_ASSERT(rows->size() == 2);
+      OATPP_ASSERT(*rows[0]->f_id == 1);
+      OATPP_ASSERT(*rows[1]->f_id == 3);
+    }
+
+    {
+      oatpp::sqlite::VirtualTable::Scope scope(requestIds, createIds({4, 2, 7}));
+      auto rows = client.getRequestedItems()->fetch<oatpp::Vector<oatpp::Object<Item>>>();
+      OATPP_ASSERT(rows->size() == 2);
+      OATPP_ASSERT(*rows[0]->f_id == 2);
+      OATPP_ASSERT(*rows[1]->f_id == 4);
+
+      {
+        oatpp::sqlite::VirtualTable::Scope inner(requestIds, createIds({1}));
+        rows = client.getRequestedItems()->fetch<oatpp::Vector<oatpp::Object<Item>>>();
+        OATPP_ASSERT(rows->size() == 1);
+        OATPP_ASSERT(*rows[0]->f_id == 1);
+      }
+
+      rows = client.getRequestedItems()->fetch<oatpp::Vector<oatpp::Object<Item>>>();
+      OATPP_ASSERT(rows->size() == 2);
+    }
+
+    {
+      auto rows = client.getRequestedItems()->fetch<oatpp::Vector<oatpp::Object<Item>>>();
+      OATPP_ASSERT(rows->size() == 0);
+    }
+
+    /* pushed down constraints compare as SQLite would on a regular table */
+    {
+      auto data = std::make_shared<oatpp::sqlite::VirtualTable::ColumnarData>();
+      data->addColumn(oatpp::Vector<oatpp::String>({"5", "05", "x", "X"}));
+      data->addColumn(oatpp::Vector<oatpp::Int64>({1, 2, 5, 6}));
+      codes->setData(data);
+
+      /* TEXT affinity - 5 is compared as '5', 5.0 as '5.0' */
+      OATPP_ASSERT(selectNumbers(client.getNumbersByIntCode()) == std::vector<v_int64>({1}));
+      OATPP_ASSERT(selectNumbers(client.getNumbersByRealCode()).empty());
+
+      /* INTEGER affinity - numeric text is compared as a number */
+      OATPP_ASSERT(selectNumbers(client.getNumbersByTextNumber("5")) == std::vector<v_int64>({5}));
+      OATPP_ASSERT(selectNumbers(client.getNumbersByTextNumber("05")) == std::vector<v_int64>({5}));
+      OATPP_ASSERT(selectNumbers(client.getNumbersByTextNumber("5.0")) == std::vector<v_int64>({5}));
+      OATPP_ASSERT(selectNumbers(client.getNumbersByTextNumber("five")).empty());
+
+      /* non-BINARY collation is not pushed down */
+      OATPP_ASSERT(selectNumbers(client.getNumbersByCodeNoCase()) == std::vector<v_int64>({5, 6}));
+      OATPP_ASSERT(selectNumbers(client.getNumbersByCode("x")) == std::vector<v_int64>({5}));
+    }
+
+    /* results of queries reading virtual tables are never shared - scoped data differs between threads */
+    {
+      auto cache = std::make_shared<oatpp::sqlite::ResultCache>();
+      auto sharedExecutor = std::make_shared<oatpp::sqlite::Executor>(pool);
+      sharedExecutor->setResultCache(cache);
+      sharedExecutor->setRequestCoalescing(true);
+      MyClient sharedClient(sharedExecutor);
+
+      std::atomic<v_int32> mismatches(0);
+      std::vector<std::thread> threads;
+      for(v_int64 id = 1; id <= 4; id ++) {
+        threads.push_back(std::thread([id, &requestIds, &sharedClient, &mismatches] {
+          oatpp::sqlite::VirtualTable::Scope scope(requestIds, createIds({id}));
+          for(v_int32 i = 0; i < 50; i ++) {
+            auto rows = sharedClient.getRequestedItems()->fetch<oatpp::Vector<oatpp::Object<Item>>>();
+            if(rows->size() != 1 || *rows[0]->f_id != id) {
+              mismatches ++;
+            }
+          }
+        }));
+      }
+      for(auto& thread : threads) {
+        thread.join();
+      }
+
+      OATPP_LOGd(TAG, "mismatches={}", mismatches.load());
+      OATPP_ASSERT(mismatches == 0);
+      OATPP_ASSERT(cache->getStats().entriesCount == 0);
+    }
+
+    bool thrown = false;
+    try {
+      auto data = std::make_shared<oatpp::sqlite::VirtualTable::ColumnarData>();
+      data->addColumn(oatpp::Vector<oatpp::Int64>({1}));
+      data->addColumn(oatpp::Vector<oatpp::Int64>({2}));
+      requestIds->setData(data);
+    } catch (std::runtime_error& e) {
+      OATPP_LOGd(TAG, "error='{}'", e.what());
+      thrown = true;
+    }
+    OATPP_ASSERT(thrown);
+
+    pool->stop();
+
+  }
+
+  std::remove(file->c_str());
+
+}
+
+}}}
@@ -0,0 +1,4 @@
+CREATE TABLE test_backup (
+  f_id      INTEGER PRIMARY KEY,
+  f_data    VARCHAR
+);
@@ -0,0 +1,8 @@
+CREATE TABLE test_loader_users (
+  id        INTEGER PRIMARY KEY,
+  name      VARCHAR
+);
+
+INSERT INTO test_loader_users (id, name) VALUES (1, 'one');
+INSERT INTO test_loader_users (id, name) VALUES (2, 'two');
+INSERT INTO test_loader_users (id, name) VALUES (3, 'three');
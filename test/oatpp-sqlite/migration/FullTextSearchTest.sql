@@ -0,0 +1,9 @@
+CREATE TABLE test_docs (
+  f_id          INTEGER PRIMARY KEY,
+  f_title       VARCHAR,
+  f_body        VARCHAR,
+  f_views       INTEGER DEFAULT 0
+);
+
+INSERT INTO test_docs
+(f_title, f_body) VALUES ('existing document', 'indexed by the rebuild step');
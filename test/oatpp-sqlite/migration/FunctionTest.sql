@@ -0,0 +1,5 @@
+CREATE TABLE test_function (
+  f_id      INTEGER PRIMARY KEY,
+  f_name    VARCHAR,
+  f_value   REAL
+);
@@ -0,0 +1,4 @@
+CREATE TABLE test_hot_swap (
+  f_id      INTEGER PRIMARY KEY,
+  f_data    VARCHAR
+);
@@ -0,0 +1,4 @@
+CREATE TABLE test_prepare (
+  f_id      INTEGER PRIMARY KEY,
+  f_name    VARCHAR
+);
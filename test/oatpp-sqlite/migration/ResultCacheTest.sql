@@ -0,0 +1,4 @@
+CREATE TABLE test_cache (
+  f_id      INTEGER PRIMARY KEY,
+  f_name    VARCHAR
+);
@@ -0,0 +1,5 @@
+CREATE TABLE test_shard (
+  f_id      INTEGER PRIMARY KEY,
+  f_user    INTEGER,
+  f_data    VARCHAR
+);
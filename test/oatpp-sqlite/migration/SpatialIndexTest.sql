@@ -0,0 +1,12 @@
+CREATE TABLE test_places (
+  f_id          INTEGER PRIMARY KEY,
+  f_name        VARCHAR,
+  f_lon         REAL,
+  f_lat         REAL
+);
+
+INSERT INTO test_places
+(f_name, f_lon, f_lat) VALUES ('existing', 10.5, 20.5);
+
+INSERT INTO test_places
+(f_name, f_lon, f_lat) VALUES ('nowhere', null, null);
@@ -2,10 +2,34 @@
 #include "ql_template/ParserTest.hpp"
 
 #include "types/BlobTest.hpp"
+#include "types/EmbeddingTest.hpp"
 #include "types/IntTest.hpp"
 #include "types/NumericTest.hpp"
 #include "types/InterpretationTest.hpp"
 
+#include "BackupTest.hpp"
+#include "BusyHandlerTest.hpp"
+#include "ChangeFeedTest.hpp"
+#include "CheckpointManagerTest.hpp"
+#include "CollectionParamsTest.hpp"
+#include "DataLoaderTest.hpp"
+#include "FullTextSearchTest.hpp"
+#include "FunctionTest.hpp"
+#include "HotSwapTest.hpp"
+#include "ImageConnectionProviderTest.hpp"
+#include "ImmutableTest.hpp"
+#include "MaintenanceSchedulerTest.hpp"
+#include "MemoryTest.hpp"
+#include "PoolMetricsTest.hpp"
+#include "PrepareTemplatesTest.hpp"
+#include "RequestCoalescingTest.hpp"
+#include "ResultCacheTest.hpp"
+#include "ShardedExecutorTest.hpp"
+#include "SpatialIndexTest.hpp"
+#include "TenantConnectionProviderTest.hpp"
+#include "TransactionTest.hpp"
+#include "VirtualTableTest.hpp"
+
 #include "oatpp/Environment.hpp"
 
 namespace {
@@ -17,8 +41,32 @@ void runTests() {
   OATPP_RUN_TEST(oatpp::test::sqlite::types::IntTest);
   OATPP_RUN_TEST(oatpp::test::sqlite::types::NumericTest);
   OATPP_RUN_TEST(oatpp::test::sqlite::types::BlobTest);
+  OATPP_RUN_TEST(oatpp::test::sqlite::types::EmbeddingTest);
   OATPP_RUN_TEST(oatpp::test::sqlite::types::InterpretationTest);
 
+  OATPP_RUN_TEST(oatpp::test::sqlite::CollectionParamsTest);
+  OATPP_RUN_TEST(oatpp::test::sqlite::MemoryTest);
+  OATPP_RUN_TEST(oatpp::test::sqlite::CheckpointManagerTest);
+  OATPP_RUN_TEST(oatpp::test::sqlite::MaintenanceSchedulerTest);
+  OATPP_RUN_TEST(oatpp::test::sqlite::TransactionTest);
+  OATPP_RUN_TEST(oatpp::test::sqlite::BusyHandlerTest);
+  OATPP_RUN_TEST(oatpp::test::sqlite::PoolMetricsTest);
+  OATPP_RUN_TEST(oatpp::test::sqlite::ResultCacheTest);
+  OATPP_RUN_TEST(oatpp::test::sqlite::RequestCoalescingTest);
+  OATPP_RUN_TEST(oatpp::test::sqlite::ChangeFeedTest);
+  OATPP_RUN_TEST(oatpp::test::sqlite::DataLoaderTest);
+  OATPP_RUN_TEST(oatpp::test::sqlite::BackupTest);
+  OATPP_RUN_TEST(oatpp::test::sqlite::HotSwapTest);
+  OATPP_RUN_TEST(oatpp::test::sqlite::ImageConnectionProviderTest);
+  OATPP_RUN_TEST(oatpp::test::sqlite::ImmutableTest);
+  OATPP_RUN_TEST(oatpp::test::sqlite::ShardedExecutorTest);
+  OATPP_RUN_TEST(oatpp::test::sqlite::TenantConnectionProviderTest);
+  OATPP_RUN_TEST(oatpp::test::sqlite::PrepareTemplatesTest);
+  OATPP_RUN_TEST(oatpp::test::sqlite::FunctionTest);
+  OATPP_RUN_TEST(oatpp::test::sqlite::VirtualTableTest);
+  OATPP_RUN_TEST(oatpp::test::sqlite::FullTextSearchTest);
+  OATPP_RUN_TEST(oatpp::test::sqlite::SpatialIndexTest);
+
 }
 
 }
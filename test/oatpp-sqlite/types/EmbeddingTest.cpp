@@ -0,0 +1,193 @@
+/***************************************************************************
+ *
+ * Project         _____    __   ____   _      _
+ *                (  _  )  /__\ (_  _)_| |_  _| |_
+ *                 )(_)(  /(__)\  )( (_   _)(_   _)
+ *                (_____)(__)(__)(__)  |_|    |_|
+ *
+ *
+ * Copyright 2018-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+
+#include "EmbeddingTest.hpp"
+
+#include "oatpp-sqlite/orm.hpp"
+#include "oatpp/json/ObjectMapper.hpp"
+
+#include <cmath>
+#include <cstdio>
+
+namespace oatpp { namespace test { namespace sqlite { namespace types {
+
+namespace {
+
+#include OATPP_CODEGEN_BEGIN(DTO)
+
+class EmbeddingsRow : public oatpp::DTO {
+
+  DTO_INIT(EmbeddingsRow, DTO);
+
+  DTO_FIELD(Int64, f_id);
+  DTO_FIELD(String, f_name);
+  DTO_FIELD(oatpp::sqlite::Embedding, f_embedding);
+
+};
+
+class ScoreRow : public oatpp::DTO {
+
+  DTO_INIT(ScoreRow, DTO);
+
+  DTO_FIELD(String, f_name);
+  DTO_FIELD(Float64, f_score);
+
+};
+
+#include OATPP_CODEGEN_END(DTO)
+
+#include OATPP_CODEGEN_BEGIN(DbClient)
+
+class MyClient : public oatpp::orm::DbClient {
+public:
+
+  MyClient(const std::shared_ptr<oatpp::orm::Executor>& executor)
+    : oatpp::orm::DbClient(executor)
+  {
+    oatpp::orm::SchemaMigration migration(executor, "EmbeddingTest");
+    migration.addFile(1, TEST_DB_MIGRATION "EmbeddingTest.sql");
+    migration.migrate();
+  }
+
+  QUERY(insertEmbedding,
+        "INSERT INTO test_embeddings (f_name, f_embedding) VALUES (:row.f_name, :row.f_embedding);",
+        PARAM(oatpp::Object<EmbeddingsRow>, row))
+
+  QUERY(selectAllEmbeddings,
+        "SELECT * FROM test_embeddings ORDER BY f_id;")
+
+  QUERY(selectNearest,
+        "SELECT f_name, vec_cosine(f_embedding, :query) AS f_score FROM test_embeddings "
+        "ORDER BY f_score DESC LIMIT :limit;",
+        PARAM(oatpp::sqlite::Embedding, query),
+        PARAM(Int64, limit))
+
+  QUERY(selectDistances,
+        "SELECT f_name, vec_l2(f_embedding, :query) AS f_score FROM test_embeddings ORDER BY f_id;",
+        PARAM(oatpp::sqlite::Embedding, query))
+
+  QUERY(selectDots,
+        "SELECT f_name, vec_dot(f_embedding, :query) AS f_score FROM test_embeddings ORDER BY f_id;",
+        PARAM(oatpp::sqlite::Embedding, query))
+
+};
+
+#include OATPP_CODEGEN_END(DbClient)
+
+oatpp::sqlite::Embedding createEmbedding(v_int32 size, v_float32 a, v_float32 b) {
+  auto result = std::make_shared<std::vector<v_float32>>(size, 0.0f);
+  (*result)[0] = a;
+  (*result)[size - 1] = b;
+  return result;
+}
+
+}
+
+void EmbeddingTest::onRun() {
+
+  /* 37 - not a multiple of the accumulator lanes, exercises the tail loop */
+  const v_int32 size = 37;
+
+  oatpp::String file = TEST_DB_FILE ".embedding";
+  std::remove(file->c_str());
+
+  {
+
+    auto connectionProvider = std::make_shared<oatpp::sqlite::ConnectionProvider>(file);
+    connectionProvider->addEmbeddingFunctions();
+
+    auto connectionPool = oatpp::sqlite::ConnectionPool::createShared(connectionProvider, 2, std::chrono::seconds(3));
+    auto executor = std::make_shared<oatpp::sqlite::Executor>(connectionPool);
+
+    auto client = MyClient(executor);
+
+    const char* names[] = {"x", "y", "xy", "empty"};
+    oatpp::sqlite::Embedding embeddings[] = {
+      createEmbedding(size, 1, 0),
+      createEmbedding(size, 0, 2),
+      createEmbedding(size, 3, 3),
+      nullptr
+    };
+
+    for(v_int32 i = 0; i < 4; i ++) {
+      auto row = EmbeddingsRow::createShared();
+      row->f_name = names[i];
+      row->f_embedding = embeddings[i];
+      OATPP_ASSERT(client.insertEmbedding(row)->isSuccess());
+    }
+
+    {
+      auto dataset = client.selectAllEmbeddings()->fetch<oatpp::Vector<oatpp::Object<EmbeddingsRow>>>();
+      OATPP_ASSERT(dataset->size() == 4);
+      OATPP_ASSERT(dataset[0]->f_embedding->size() == static_cast<size_t>(size));
+      OATPP_ASSERT(*dataset[2]->f_embedding == *embeddings[2]);
+      OATPP_ASSERT(dataset[3]->f_embedding == nullptr);
+
+      oatpp::json::ObjectMapper om;
+      om.serializerConfig().mapper.enabledInterpretations = {"sqlite"};
+      auto str = om.writeToString(dataset[0]);
+      OATPP_LOGd(TAG, "res={}", str);
+    }
+
+    {
+      auto dataset = client.selectNearest(createEmbedding(size, 1, 0.1f), 2)->fetch<oatpp::Vector<oatpp::Object<ScoreRow>>>();
+      OATPP_ASSERT(dataset->size() == 2);
+      OATPP_ASSERT(dataset[0]->f_name == "x");
+      OATPP_ASSERT(dataset[1]->f_name == "xy");
+      OATPP_ASSERT(*dataset[0]->f_score > *dataset[1]->f_score);
+    }
+
+    {
+      auto dataset = client.selectDistances(createEmbedding(size, 0, 0))->fetch<oatpp::Vector<oatpp::Object<ScoreRow>>>();
+      OATPP_ASSERT(dataset->size() == 4);
+      OATPP_ASSERT(std::fabs(*dataset[0]->f_score - 1.0) < 1e-6);
+      OATPP_ASSERT(std::fabs(*dataset[1]->f_score - 2.0) < 1e-6);
+      OATPP_ASSERT(std::fabs(*dataset[2]->f_score - std::sqrt(18.0)) < 1e-6);
+      OATPP_ASSERT(dataset[3]->f_score == nullptr);
+    }
+
+    {
+      auto dataset = client.selectDots(createEmbedding(size, 2, 1))->fetch<oatpp::Vector<oatpp::Object<ScoreRow>>>();
+      OATPP_ASSERT(dataset->size() == 4);
+      OATPP_ASSERT(*dataset[0]->f_score == 2.0);
+      OATPP_ASSERT(*dataset[1]->f_score == 2.0);
+      OATPP_ASSERT(*dataset[2]->f_score == 9.0);
+    }
+
+    {
+      auto res = client.selectDots(createEmbedding(size + 1, 1, 1));
+      OATPP_ASSERT(!res->isSuccess());
+      OATPP_LOGd(TAG, "error='{}'", res->getErrorMessage());
+    }
+
+    connectionPool->stop();
+
+  }
+
+  std::remove(file->c_str());
+
+}
+
+}}}}